@@ -53,6 +53,63 @@ dai_free(Dai* dai) {
     free(dai);
 }
 
+void
+dai_set_gc_threads(Dai* dai, int thread_count) {
+    DaiVM_setGCThreads(&dai->vm, thread_count);
+}
+
+void
+dai_set_gc_threshold(Dai* dai, uint64_t threshold) {
+    DaiVM_setGCThreshold(&dai->vm, threshold);
+}
+
+void
+dai_set_gc_grow_factor(Dai* dai, double factor) {
+    DaiVM_setGCGrowFactor(&dai->vm, factor);
+}
+
+void
+dai_set_heap_limit(Dai* dai, uint64_t limit) {
+    DaiVM_setHeapLimit(&dai->vm, limit);
+}
+
+_Static_assert(DAI_GC_PAUSE_HISTOGRAM_SIZE == DAI_GC_PAUSE_BUCKETS,
+               "DAI_GC_PAUSE_HISTOGRAM_SIZE must match DAI_GC_PAUSE_BUCKETS");
+
+void
+dai_get_gc_stats(Dai* dai, dai_gc_stats_t* stats) {
+    const DaiGCStats* gc_stats = DaiVM_getGCStats(&dai->vm);
+    stats->collections         = gc_stats->fullCollections;
+    stats->young_collections   = gc_stats->youngCollections;
+    stats->incremental_steps   = gc_stats->incrementalSteps;
+    stats->pauses              = gc_stats->pauses;
+    stats->pause_total_ns      = gc_stats->pauseTotalNs;
+    stats->pause_max_ns        = gc_stats->pauseMaxNs;
+    for (int i = 0; i < DAI_GC_PAUSE_HISTOGRAM_SIZE; i++) {
+        stats->pause_histogram[i] = gc_stats->pauseHistogram[i];
+    }
+    stats->bytes_freed      = gc_stats->bytesFreed;
+    stats->last_bytes_freed = gc_stats->lastBytesFreed;
+    stats->heap_bytes       = DaiVM_bytesAllocated(&dai->vm);
+}
+
+int
+dai_get_gc_heap_stats(Dai* dai, dai_gc_type_stats_t* stats, int max) {
+    DaiHeapTypeStats heap_stats[DaiObjType_count];
+    DaiVM_getHeapStats(&dai->vm, heap_stats);
+    int n = 0;
+    for (int i = 0; i < DaiObjType_count && n < max; i++) {
+        if (heap_stats[i].count == 0) {
+            continue;
+        }
+        stats[n].type  = dai_object_type_name(i);
+        stats[n].count = heap_stats[i].count;
+        stats[n].bytes = heap_stats[i].bytes;
+        n++;
+    }
+    return n;
+}
+
 void
 dai_load_file(Dai* dai, const char* filename) {
     if (dai->loaded) {
@@ -86,7 +143,7 @@ dai_get_int(Dai* dai, const char* name) {
 
 void
 dai_set_int(Dai* dai, const char* name, int64_t value) {
-    if (!DaiObjModule_set_global(dai->module, name, INTEGER_VAL(value))) {
+    if (!DaiObjModule_set_global(dai->module, name, INTEGER_VAL_VM(&dai->vm, value))) {
         fprintf(stderr, "dai_set_int: variable '%s' not found.\n", name);
         abort();
     }
@@ -131,7 +188,7 @@ dai_get_string(Dai* dai, const char* name) {
                 dai_value_ts(value));
         abort();
     }
-    return AS_CSTRING(value);
+    return DaiObjString_cstring(&dai->vm, AS_STRING(value));
 }
 
 void
@@ -171,7 +228,7 @@ daicall_push_function(Dai* dai, dai_func_t func) {
 // push argument to function call
 void
 daicall_pusharg_int(Dai* dai, int64_t value) {
-    DaiVM_push1(&dai->vm, INTEGER_VAL(value));
+    DaiVM_push1(&dai->vm, INTEGER_VAL_VM(&dai->vm, value));
     dai->argc++;
 }
 void
@@ -240,7 +297,7 @@ daicall_getrv_string(Dai* dai) {
                 dai_value_ts(dai->ret));
         abort();
     }
-    return AS_CSTRING(dai->ret);
+    return DaiObjString_cstring(&dai->vm, AS_STRING(dai->ret));
 }
 
 dai_func_t
@@ -332,7 +389,7 @@ daicall_poparg_string(Dai* dai) {
                 dai_value_ts(dai->argv[dai->pop_arg_index]));
         abort();
     }
-    return AS_CSTRING(dai->argv[dai->pop_arg_index++]);
+    return DaiObjString_cstring(&dai->vm, AS_STRING(dai->argv[dai->pop_arg_index++]));
 }
 
 void
@@ -341,7 +398,7 @@ daicall_setrv_int(Dai* dai, int64_t value) {
         fprintf(stderr, "dai_call_push_return_int: return value already set.\n");
         abort();
     }
-    dai->ret = INTEGER_VAL(value);
+    dai->ret = INTEGER_VAL_VM(&dai->vm, value);
 }
 
 void
@@ -52,6 +52,77 @@ dai_get_string(Dai* dai, const char* name);
 void
 dai_set_string(Dai* dai, const char* name, const char* value);
 
+/**
+ * @brief set the number of threads (including the calling thread) used by full garbage
+ *        collections to mark and sweep in parallel. Default is 1 (no extra threads).
+ */
+void
+dai_set_gc_threads(Dai* dai, int thread_count);
+
+/**
+ * @brief set the heap size in bytes at which the next full garbage collection starts.
+ *        Called before dai_load_file it is the first threshold. Default is 1 MB.
+ */
+void
+dai_set_gc_threshold(Dai* dai, uint64_t threshold);
+
+/**
+ * @brief set the heap growth factor. After a full collection the next threshold is the live
+ *        heap size multiplied by factor. Values below 1 are treated as 1. Default is 2.
+ */
+void
+dai_set_gc_grow_factor(Dai* dai, double factor);
+
+/**
+ * @brief set a hard cap on the heap size in bytes, 0 means unlimited (default).
+ *        When an allocation exceeds the cap an emergency full collection runs first; if the heap
+ *        is still over the cap, the running script fails with an "out of memory" runtime error
+ *        instead of growing further.
+ */
+void
+dai_set_heap_limit(Dai* dai, uint64_t limit);
+
+// #region GC telemetry
+
+// Number of buckets in the pause time histogram. Bucket 0 counts pauses shorter than 1us,
+// bucket i counts pauses in [2^(i-1), 2^i) us, the last bucket also counts longer pauses.
+#define DAI_GC_PAUSE_HISTOGRAM_SIZE 24
+
+typedef struct {
+    uint64_t collections;         // completed full collections (including incremental ones)
+    uint64_t young_collections;   // young generation collections
+    uint64_t incremental_steps;   // incremental collection steps
+    uint64_t pauses;              // every collection or incremental step is one pause
+    uint64_t pause_total_ns;
+    uint64_t pause_max_ns;
+    uint64_t pause_histogram[DAI_GC_PAUSE_HISTOGRAM_SIZE];
+    uint64_t bytes_freed;        // total bytes freed by the collector
+    uint64_t last_bytes_freed;   // bytes freed by the last completed collection
+    uint64_t heap_bytes;         // bytes currently managed by the VM
+} dai_gc_stats_t;
+
+typedef struct {
+    const char* type;   // object type name, e.g. "string", "array"
+    uint64_t count;
+    uint64_t bytes;   // bytes of the objects themselves, excluding separately allocated buffers
+} dai_gc_type_stats_t;
+
+/**
+ * @brief get GC statistics. Cheap, the statistics are always collected.
+ */
+void
+dai_get_gc_stats(Dai* dai, dai_gc_stats_t* stats);
+
+/**
+ * @brief count objects in the heap by type. It walks the whole heap, the result may include
+ *        garbage that has not been collected yet. Only types with objects are reported.
+ * @return the number of entries written to stats (at most max).
+ */
+int
+dai_get_gc_heap_stats(Dai* dai, dai_gc_type_stats_t* stats, int max);
+
+// #endregion
+
 // #region Call function in dai script.
 /*
  * Example:
@@ -311,11 +311,12 @@ END:
 
 int
 daicmd_runfile(int argc, char* argv[]) {
-    if (argc != 2) {
-        printf("Usage: %s <filename>\n", argv[0]);
+    bool jit = argc == 3 && strcmp(argv[1], "--jit") == 0;
+    if (argc != 2 && !jit) {
+        printf("Usage: %s [--jit] <filename>\n", argv[0]);
         return 1;
     }
-    const char* filename = argv[1];
+    const char* filename = argv[argc - 1];
     char* filepath       = realpath(filename, NULL);
     if (filepath == NULL) {
         perror("Error: cannot read file");
@@ -324,6 +325,9 @@ daicmd_runfile(int argc, char* argv[]) {
     DaiObjError* err = NULL;
     DaiVM vm;
     DaiVM_init(&vm);
+    if (jit && !DaiVM_enableJIT(&vm)) {
+        fprintf(stderr, "Warning: JIT is not supported on this platform\n");
+    }
     if (!daistd_init(&vm)) {
         fprintf(stderr, "Error: cannot initialize std\n");
         goto END;
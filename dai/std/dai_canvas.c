@@ -421,6 +421,7 @@ Canvas_addEventListener(DaiVM* vm, DaiValue receiver, int argc, DaiValue* argv)
             DaiObjTuple* callbacks = Canvas_get_event_callbacks(canvas, event_type);
             assert(callbacks != NULL);
             DaiObjTuple_append(callbacks, argv[1]);
+            dai_gc_write_barrier(vm, (DaiObj*)callbacks, argv[1]);
             index = DaiObjTuple_length(callbacks) - 1;
             break;
         }
@@ -782,7 +783,7 @@ Canvas_loadImage(DaiVM* vm, __attribute__((unused)) DaiValue receiver, int argc,
         return OBJ_VAL(err);
     }
     CanvasStruct* canvas = (CanvasStruct*)AS_STRUCT(receiver);
-    const char* path     = AS_CSTRING(argv[0]);
+    const char* path     = DaiObjString_cstring(vm, AS_STRING(argv[0]));
     SDL_Texture* texture = IMG_LoadTexture(canvas->renderer, path);
     if (texture == NULL) {
         DaiObjError* err =
@@ -844,6 +845,9 @@ Canvas_run(DaiVM* vm, DaiValue receiver, int argc, DaiValue* argv) {
     DaiValue ret;
     uint64_t interval = AS_NUMBER(argv[0]);
 
+    // 完整回收的停顿会让帧卡顿，帧循环里使用增量回收
+    DaiVM_enableIncrementalGC(vm, 0);
+
     SDL_Renderer* renderer = canvas->renderer;
     while (canvas->running) {
         uint64_t start_time = SDL_GetTicks();
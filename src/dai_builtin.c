@@ -13,11 +13,14 @@
 
 #include "cwalk.h"
 
+#include "dai_malloc.h"
+#include "dai_memory.h"
 #include "dai_object.h"
 #include "dai_objects/dai_object_base.h"
 #include "dai_objects/dai_object_error.h"
 #include "dai_objects/dai_object_string.h"
 #include "dai_objects/dai_object_struct.h"
+#include "dai_stringbuffer.h"
 #include "dai_utils.h"
 #include "dai_value.h"
 #include "dai_vm.h"
@@ -56,7 +59,7 @@ PathStruct_New(DaiVM* vm, __attribute__((unused)) DaiValue receiver, int argc, D
     }
     PathStruct* path = (PathStruct*)DaiObjStruct_New(
         vm, path_name, &path_struct_operation, sizeof(PathStruct), PathStruct_destructor);
-    path->path = strdup(AS_STRING(argv[0])->chars);
+    path->path = strdup(DaiObjString_cstring(vm, AS_STRING(argv[0])));
     return OBJ_VAL(path);
 }
 
@@ -90,7 +93,7 @@ builtin_path_write_text(DaiVM* vm, DaiValue receiver, int argc, DaiValue* argv)
             vm, "Path.write_text() expected string arguments, but got %s", dai_value_ts(argv[0]));
         return OBJ_VAL(err);
     }
-    const char* text = AS_STRING(argv[0])->chars;
+    const char* text = DaiObjString_cstring(vm, AS_STRING(argv[0]));
     FILE* fp         = fopen(path->path, "w");
     if (fp == NULL) {
         DaiObjError* err =
@@ -105,7 +108,7 @@ builtin_path_write_text(DaiVM* vm, DaiValue receiver, int argc, DaiValue* argv)
             DaiObjError_Newf(vm, "Path.write_text() failed: %s(%s)", path->path, strerror(errno));
         return OBJ_VAL(err);
     }
-    return INTEGER_VAL(n);
+    return INTEGER_VAL_VM(vm, n);
 }
 
 static DaiValue
@@ -211,7 +214,7 @@ builtin_path_joinpath(DaiVM* vm, DaiValue receiver, int argc, DaiValue* argv) {
                 vm, "Path.joinpath() expected string arguments, but got %s", dai_value_ts(argv[i]));
             return OBJ_VAL(err);
         }
-        const char* arg = AS_STRING(argv[i])->chars;
+        const char* arg = DaiObjString_cstring(vm, AS_STRING(argv[i]));
         cwk_path_join(path_res, arg, path_buf, sizeof(path_buf));
         strcpy(path_res, path_buf);
     }
@@ -327,6 +330,242 @@ static struct DaiObjOperation path_struct_operation = {
 
 // #endregion
 
+// #region 内置对象 StringBuilder
+
+static char* string_builder_name = "StringBuilder";
+static struct DaiObjOperation string_builder_struct_operation;
+
+// 缓冲区由 DaiStringBuffer 管理，accounted 是已经记到虚拟机上的缓冲区大小
+typedef struct {
+    DAI_OBJ_STRUCT_BASE
+    DaiStringBuffer* sb;
+    size_t accounted;
+} StringBuilderStruct;
+
+// 缓冲区扩容之后记账
+static void
+StringBuilderStruct_account(DaiVM* vm, StringBuilderStruct* builder) {
+    size_t capacity = DaiStringBuffer_capacity(builder->sb);
+    if (capacity != builder->accounted) {
+        vm_account_nogc(vm, builder->accounted, capacity);
+        builder->accounted = capacity;
+    }
+}
+
+static void
+StringBuilderStruct_destructor(DaiVM* vm, DaiObjStruct* st) {
+    StringBuilderStruct* builder = (StringBuilderStruct*)st;
+    if (builder->sb != NULL) {
+        vm_account_nogc(vm, builder->accounted, 0);
+        DaiStringBuffer_free(builder->sb);
+        builder->sb = NULL;
+    }
+}
+
+static DaiValue
+StringBuilderStruct_New(DaiVM* vm, __attribute__((unused)) DaiValue receiver, int argc,
+                        DaiValue* argv) {
+    if (argc > 1) {
+        DaiObjError* err =
+            DaiObjError_Newf(vm, "StringBuilder() expected 0 or 1 arguments, but got %d", argc);
+        return OBJ_VAL(err);
+    }
+    if (argc == 1 && !(IS_INTEGER(argv[0]) && AS_INTEGER(argv[0]) >= 0)) {
+        DaiObjError* err = DaiObjError_Newf(
+            vm, "StringBuilder() expected non-negative int arguments, but got %s",
+            dai_value_ts(argv[0]));
+        return OBJ_VAL(err);
+    }
+    StringBuilderStruct* builder =
+        (StringBuilderStruct*)DaiObjStruct_New(vm,
+                                               string_builder_name,
+                                               &string_builder_struct_operation,
+                                               sizeof(StringBuilderStruct),
+                                               StringBuilderStruct_destructor);
+    builder->sb        = DaiStringBuffer_New();
+    builder->accounted = 0;
+    // 预先分配容量，避免写入过程中反复扩容
+    if (argc == 1 && AS_INTEGER(argv[0]) > 0) {
+        DaiStringBuffer_grow(builder->sb, AS_INTEGER(argv[0]) + 1);
+        StringBuilderStruct_account(vm, builder);
+    }
+    return OBJ_VAL(builder);
+}
+
+// 写入值的字符串形式，字符串直接写入内容
+static void
+StringBuilderStruct_writeValue(DaiVM* vm, StringBuilderStruct* builder, DaiValue value) {
+    if (IS_STRING(value)) {
+        DaiObjString* s = DaiObjString_flatten(vm, AS_STRING(value));
+        DaiStringBuffer_writen(builder->sb, s->chars, s->length);
+    } else {
+        char* s = dai_value_string(value);
+        DaiStringBuffer_write(builder->sb, s);
+        free(s);
+    }
+}
+
+static DaiValue
+builtin_string_builder_write(DaiVM* vm, DaiValue receiver, int argc, DaiValue* argv) {
+    StringBuilderStruct* builder = (StringBuilderStruct*)AS_STRUCT(receiver);
+    for (int i = 0; i < argc; i++) {
+        StringBuilderStruct_writeValue(vm, builder, argv[i]);
+    }
+    StringBuilderStruct_account(vm, builder);
+    return receiver;
+}
+
+static DaiValue
+builtin_string_builder_writef(DaiVM* vm, DaiValue receiver, int argc, DaiValue* argv) {
+    if (argc == 0 || !IS_STRING(argv[0])) {
+        DaiObjError* err = DaiObjError_Newf(
+            vm, "StringBuilder.writef() expected format string as first argument");
+        return OBJ_VAL(err);
+    }
+    StringBuilderStruct* builder = (StringBuilderStruct*)AS_STRUCT(receiver);
+    size_t length                = DaiStringBuffer_length(builder->sb);
+    DaiObjError* err             = DaiObjString_formatTo(
+        vm, builder->sb, AS_STRING(argv[0]), argc - 1, argv + 1, "StringBuilder.writef");
+    StringBuilderStruct_account(vm, builder);
+    if (err != NULL) {
+        // 出错时丢弃已经写入的部分
+        if (DaiStringBuffer_length(builder->sb) > length) {
+            DaiStringBuffer_back(builder->sb, DaiStringBuffer_length(builder->sb) - length);
+        }
+        return OBJ_VAL(err);
+    }
+    return receiver;
+}
+
+static DaiValue
+builtin_string_builder_writelines(DaiVM* vm, DaiValue receiver, int argc, DaiValue* argv) {
+    if (argc != 1) {
+        DaiObjError* err = DaiObjError_Newf(
+            vm, "StringBuilder.writelines() expected 1 argument, but got %d", argc);
+        return OBJ_VAL(err);
+    }
+    if (!IS_ARRAY(argv[0])) {
+        DaiObjError* err =
+            DaiObjError_Newf(vm,
+                             "StringBuilder.writelines() expected array arguments, but got %s",
+                             dai_value_ts(argv[0]));
+        return OBJ_VAL(err);
+    }
+    StringBuilderStruct* builder = (StringBuilderStruct*)AS_STRUCT(receiver);
+    DaiObjArray* array           = AS_ARRAY(argv[0]);
+    // 先算出字符串的总长度，一次扩容到位
+    size_t total = DaiStringBuffer_length(builder->sb) + 1;
+    for (int i = 0; i < array->length; i++) {
+        if (IS_STRING(array->elements[i])) {
+            total += AS_STRING(array->elements[i])->length;
+        }
+    }
+    if (total > DaiStringBuffer_capacity(builder->sb)) {
+        DaiStringBuffer_grow(builder->sb, total);
+    }
+    for (int i = 0; i < array->length; i++) {
+        StringBuilderStruct_writeValue(vm, builder, array->elements[i]);
+    }
+    StringBuilderStruct_account(vm, builder);
+    return receiver;
+}
+
+static DaiValue
+builtin_string_builder_length(DaiVM* vm, DaiValue receiver, int argc, DaiValue* argv) {
+    if (argc != 0) {
+        DaiObjError* err = DaiObjError_Newf(
+            vm, "StringBuilder.length() expected no arguments, but got %d", argc);
+        return OBJ_VAL(err);
+    }
+    StringBuilderStruct* builder = (StringBuilderStruct*)AS_STRUCT(receiver);
+    return INTEGER_VAL_VM(vm, DaiStringBuffer_length(builder->sb));
+}
+
+// 把缓冲区直接交给新的字符串，不复制内容，之后 StringBuilder 变成空的
+static DaiValue
+builtin_string_builder_build(DaiVM* vm, DaiValue receiver, int argc, DaiValue* argv) {
+    if (argc != 0) {
+        DaiObjError* err = DaiObjError_Newf(
+            vm, "StringBuilder.build() expected no arguments, but got %d", argc);
+        return OBJ_VAL(err);
+    }
+    StringBuilderStruct* builder = (StringBuilderStruct*)AS_STRUCT(receiver);
+    if (DaiStringBuffer_length(builder->sb) > INT_MAX) {
+        DaiObjError* err = DaiObjError_Newf(vm, "StringBuilder.build() string too long");
+        return OBJ_VAL(err);
+    }
+    size_t capacity = DaiStringBuffer_capacity(builder->sb);
+    size_t length   = 0;
+    char* chars     = DaiStringBuffer_getAndFree(builder->sb, &length);
+    builder->sb     = DaiStringBuffer_New();
+    // 收缩到字符串的大小（原地收缩，不复制），字符串释放时按 length + 1 记账
+    if (capacity > length + 1) {
+        chars = dai_realloc(chars, length + 1);
+    }
+    vm_account_nogc(vm, builder->accounted, length + 1);
+    builder->accounted = 0;
+    return OBJ_VAL(dai_take_string(vm, chars, length));
+}
+
+static DaiObjBuiltinFunction builtin_string_builder_methods[] = {
+    {
+        {.type = DaiObjType_builtinFn, .operation = &builtin_function_operation},
+        .name     = "write",
+        .function = builtin_string_builder_write,
+    },
+    {
+        {.type = DaiObjType_builtinFn, .operation = &builtin_function_operation},
+        .name     = "writef",
+        .function = builtin_string_builder_writef,
+    },
+    {
+        {.type = DaiObjType_builtinFn, .operation = &builtin_function_operation},
+        .name     = "writelines",
+        .function = builtin_string_builder_writelines,
+    },
+    {
+        {.type = DaiObjType_builtinFn, .operation = &builtin_function_operation},
+        .name     = "length",
+        .function = builtin_string_builder_length,
+    },
+    {
+        {.type = DaiObjType_builtinFn, .operation = &builtin_function_operation},
+        .name     = "build",
+        .function = builtin_string_builder_build,
+    },
+    {
+        {.type = DaiObjType_builtinFn, .operation = &builtin_function_operation},
+        .name = NULL,
+    },
+};
+
+static DaiValue
+StringBuilderStruct_get_method(DaiVM* vm, DaiValue receiver, DaiObjString* name) {
+    for (int i = 0; builtin_string_builder_methods[i].name != NULL; i++) {
+        if (strcmp(name->chars, builtin_string_builder_methods[i].name) == 0) {
+            return OBJ_VAL(&builtin_string_builder_methods[i]);
+        }
+    }
+    DaiObjError* err =
+        DaiObjError_Newf(vm, "'StringBuilder' object has not property '%s'", name->chars);
+    return OBJ_VAL(err);
+}
+
+static struct DaiObjOperation string_builder_struct_operation = {
+    .get_property_func  = NULL,
+    .set_property_func  = NULL,
+    .subscript_get_func = NULL,
+    .subscript_set_func = NULL,
+    .string_func        = NULL,
+    .equal_func         = dai_default_equal,
+    .hash_func          = dai_default_hash,
+    .iter_init_func     = NULL,
+    .iter_next_func     = NULL,
+    .get_method_func    = StringBuilderStruct_get_method,
+};
+
+// #endregion
+
 // #region 内置函数
 static DaiValue
 builtin_print(__attribute__((unused)) DaiVM* vm, __attribute__((unused)) DaiValue receiver,
@@ -348,9 +587,9 @@ builtin_len(__attribute__((unused)) DaiVM* vm, __attribute__((unused)) DaiValue
     }
     const DaiValue arg = argv[0];
     if (IS_STRING(arg)) {
-        return INTEGER_VAL(AS_STRING(arg)->length);
+        return INTEGER_VAL_VM(vm, AS_STRING(arg)->length);
     } else if (IS_ARRAY(arg)) {
-        return INTEGER_VAL(AS_ARRAY(arg)->length);
+        return INTEGER_VAL_VM(vm, AS_ARRAY(arg)->length);
     } else {
         DaiObjError* err = DaiObjError_Newf(vm, "'len' not supported '%s'", dai_value_ts(arg));
         return OBJ_VAL(err);
@@ -386,7 +625,8 @@ builtin_assert(__attribute__((unused)) DaiVM* vm, __attribute__((unused)) DaiVal
             DaiObjError* err = DaiObjError_Newf(vm, "assertion failed");
             return OBJ_VAL(err);
         }
-        DaiObjError* err = DaiObjError_Newf(vm, "assertion failed: %s", AS_STRING(argv[1])->chars);
+        DaiObjError* err = DaiObjError_Newf(
+            vm, "assertion failed: %s", DaiObjString_cstring(vm, AS_STRING(argv[1])));
         return OBJ_VAL(err);
     }
     return NIL_VAL;
@@ -411,8 +651,11 @@ builtin_assert_eq(__attribute__((unused)) DaiVM* vm, __attribute__((unused)) Dai
         if (argc == 2) {
             err = DaiObjError_Newf(vm, "assertion failed: %s != %s", s1, s2);
         } else {
-            err = DaiObjError_Newf(
-                vm, "assertion failed: %s != %s %s", s1, s2, AS_STRING(argv[2])->chars);
+            err = DaiObjError_Newf(vm,
+                                   "assertion failed: %s != %s %s",
+                                   s1,
+                                   s2,
+                                   DaiObjString_cstring(vm, AS_STRING(argv[2])));
         }
         free(s1);
         free(s2);
@@ -458,7 +701,7 @@ builtin_abs(__attribute__((unused)) DaiVM* vm, __attribute__((unused)) DaiValue
         return OBJ_VAL(err);
     }
     if (IS_INTEGER(argv[0])) {
-        return INTEGER_VAL(llabs(AS_INTEGER(argv[0])));
+        return INTEGER_VAL_VM(vm, llabs(AS_INTEGER(argv[0])));
     } else if (IS_FLOAT(argv[0])) {
         return FLOAT_VAL(fabs(AS_FLOAT(argv[0])));
     } else {
@@ -481,7 +724,7 @@ builtin_import(DaiVM* vm, DaiValue receiver, int argc, DaiValue* argv) {
         return OBJ_VAL(err);
     }
     char abs_path[PATH_MAX];
-    const char* path             = AS_STRING(argv[0])->chars;
+    const char* path             = DaiObjString_cstring(vm, AS_STRING(argv[0]));
     const char* current_filename = DaiVM_getCurrentFilePos(vm).filename;
     size_t length;
     cwk_path_get_dirname(current_filename, &length);
@@ -521,11 +764,11 @@ builtin_int(DaiVM* vm, DaiValue receiver, int argc, DaiValue* argv) {
     if (IS_INTEGER(argv[0])) {
         return argv[0];
     } else if (IS_FLOAT(argv[0])) {
-        return INTEGER_VAL((int64_t)AS_FLOAT(argv[0]));
+        return INTEGER_VAL_VM(vm, (int64_t)AS_FLOAT(argv[0]));
     } else if (IS_STRING(argv[0])) {
         char* endptr;
         errno    = 0;
-        long val = strtol(AS_STRING(argv[0])->chars, &endptr, 10);
+        long val = strtol(DaiObjString_cstring(vm, AS_STRING(argv[0])), &endptr, 10);
         if (errno != 0) {
             DaiObjError* err =
                 DaiObjError_Newf(vm, "int() failed to convert string to int: %s", strerror(errno));
@@ -537,7 +780,7 @@ builtin_int(DaiVM* vm, DaiValue receiver, int argc, DaiValue* argv) {
                 "int() failed to convert string to int: invalid literal for int() with base 10");
             return OBJ_VAL(err);
         }
-        return INTEGER_VAL(val);
+        return INTEGER_VAL_VM(vm, val);
     } else {
         DaiObjError* err = DaiObjError_Newf(
             vm, "int() expected number argument, but got %s", dai_value_ts(argv[0]));
@@ -545,6 +788,23 @@ builtin_int(DaiVM* vm, DaiValue receiver, int argc, DaiValue* argv) {
     }
 }
 
+// 驻留字符串，内容相同的字符串返回同一个对象。
+// 运行时产生的字符串默认不驻留，需要大量重复使用的字符串（比如作为字典的键）可以显式驻留
+static DaiValue
+builtin_intern(__attribute__((unused)) DaiVM* vm, __attribute__((unused)) DaiValue receiver,
+               int argc, DaiValue* argv) {
+    if (argc != 1) {
+        DaiObjError* err = DaiObjError_Newf(vm, "intern() expected 1 argument, but got %d", argc);
+        return OBJ_VAL(err);
+    }
+    if (!IS_STRING(argv[0])) {
+        DaiObjError* err = DaiObjError_Newf(
+            vm, "intern() expected string argument, but got %s", dai_value_ts(argv[0]));
+        return OBJ_VAL(err);
+    }
+    return OBJ_VAL(dai_intern_string(vm, AS_STRING(argv[0])));
+}
+
 static DaiObjBuiltinFunction builtin_funcs[] = {
     {
         {.type = DaiObjType_builtinFn, .operation = &builtin_function_operation},
@@ -596,6 +856,16 @@ static DaiObjBuiltinFunction builtin_funcs[] = {
         .name     = "Path",
         .function = PathStruct_New,
     },
+    {
+        {.type = DaiObjType_builtinFn, .operation = &builtin_function_operation},
+        .name     = "intern",
+        .function = builtin_intern,
+    },
+    {
+        {.type = DaiObjType_builtinFn, .operation = &builtin_function_operation},
+        .name     = "StringBuilder",
+        .function = StringBuilderStruct_New,
+    },
     {
         .name = NULL,
     },
@@ -615,7 +885,7 @@ builtin_time_time(__attribute__((unused)) DaiVM* vm, __attribute__((unused)) Dai
     }
     struct timespec ts;
     clock_gettime(CLOCK_REALTIME, &ts);
-    return INTEGER_VAL(ts.tv_sec);
+    return INTEGER_VAL_VM(vm, ts.tv_sec);
 }
 
 static DaiValue
@@ -829,7 +1099,7 @@ builtin_math_floor(__attribute__((unused)) DaiVM* vm, __attribute__((unused)) Da
         return argv[0];
     } else if (IS_FLOAT(argv[0])) {
         double n = floor(AS_FLOAT(argv[0]));
-        return INTEGER_VAL(n);
+        return INTEGER_VAL_VM(vm, n);
     } else {
         DaiObjError* err = DaiObjError_Newf(
             vm, "math.floor() expected number arguments, but got %s", dai_value_ts(argv[0]));
@@ -849,7 +1119,7 @@ builtin_math_ceil(__attribute__((unused)) DaiVM* vm, __attribute__((unused)) Dai
         return argv[0];
     } else if (IS_FLOAT(argv[0])) {
         double n = ceil(AS_FLOAT(argv[0]));
-        return INTEGER_VAL(n);
+        return INTEGER_VAL_VM(vm, n);
     } else {
         DaiObjError* err = DaiObjError_Newf(
             vm, "math.ceil() expected number arguments, but got %s", dai_value_ts(argv[0]));
@@ -960,9 +1230,9 @@ builtin_os_system(__attribute__((unused)) DaiVM* vm, __attribute__((unused)) Dai
             vm, "os.system() expected string arguments, but got %s", dai_value_ts(argv[0]));
         return OBJ_VAL(err);
     }
-    const char* cmd = AS_STRING(argv[0])->chars;
+    const char* cmd = DaiObjString_cstring(vm, AS_STRING(argv[0]));
     int ret         = system(cmd);
-    return INTEGER_VAL(ret);
+    return INTEGER_VAL_VM(vm, ret);
 }
 
 static DaiValue
@@ -977,9 +1247,9 @@ builtin_os_chdir(__attribute__((unused)) DaiVM* vm, __attribute__((unused)) DaiV
             vm, "os.chdir() expected string arguments, but got %s", dai_value_ts(argv[0]));
         return OBJ_VAL(err);
     }
-    const char* path = AS_STRING(argv[0])->chars;
+    const char* path = DaiObjString_cstring(vm, AS_STRING(argv[0]));
     int ret          = chdir(path);
-    return INTEGER_VAL(ret);
+    return INTEGER_VAL_VM(vm, ret);
 }
 
 static DaiObjBuiltinFunction builtin_os_funcs[] = {
@@ -1026,7 +1296,7 @@ builtin_sys_memory(__attribute__((unused)) DaiVM* vm, __attribute__((unused)) Da
             DaiObjError_Newf(vm, "sys.memory() expected no arguments, but got %d", argc);
         return OBJ_VAL(err);
     }
-    return INTEGER_VAL(DaiVM_bytesAllocated(vm));
+    return INTEGER_VAL_VM(vm, DaiVM_bytesAllocated(vm));
 }
 
 static DaiObjBuiltinFunction builtin_sys_funcs[] = {
@@ -1052,6 +1322,195 @@ builtin_sys_module(DaiVM* vm) {
 
 // #endregion
 
+// #region 内置模块 gc
+
+// 往结果 map 里放一个键值对，返回创建的键。
+// map 需要调用方通过 DaiVM_addGCRef 保持存活，创建键时可能触发回收，value 不能是还没有被引用的对象。
+// 需要放新创建的对象时，先放 nil 占住键，创建对象之后再用返回的键放一次
+static DaiValue
+builtin_gc_set(DaiVM* vm, DaiObjMap* map, const char* key, DaiValue value) {
+    DaiValue k = OBJ_VAL(dai_copy_string_intern(vm, key, strlen(key)));
+    DaiObjMap_cset(map, k, value);
+    dai_gc_write_barrier(vm, (DaiObj*)map, k);
+    return k;
+}
+
+static DaiValue
+builtin_gc_stats(__attribute__((unused)) DaiVM* vm, __attribute__((unused)) DaiValue receiver,
+                 int argc, DaiValue* argv) {
+    if (argc != 0) {
+        DaiObjError* err =
+            DaiObjError_Newf(vm, "gc.stats() expected no arguments, but got %d", argc);
+        return OBJ_VAL(err);
+    }
+    // 构造结果时也可能触发回收，先复制一份
+    const DaiGCStats snapshot = *DaiVM_getGCStats(vm);
+    const DaiGCStats* stats   = &snapshot;
+    size_t heap_bytes         = DaiVM_bytesAllocated(vm);
+    DaiObjMap* map;
+    DaiObjError* err = DaiObjMap_New(vm, NULL, 0, &map);
+    if (err != NULL) {
+        return OBJ_VAL(err);
+    }
+    DaiVM_addGCRef(vm, OBJ_VAL(map));
+    {
+        DaiValue key = builtin_gc_set(vm, map, "pause_histogram", NIL_VAL);
+        DaiValue histogram[DAI_GC_PAUSE_BUCKETS];
+        for (int i = 0; i < DAI_GC_PAUSE_BUCKETS; i++) {
+            histogram[i] = INTEGER_VAL_VM(vm, stats->pauseHistogram[i]);
+        }
+        DaiValue array = OBJ_VAL(DaiObjArray_New(vm, histogram, DAI_GC_PAUSE_BUCKETS));
+        DaiObjMap_cset(map, key, array);
+        dai_gc_write_barrier(vm, (DaiObj*)map, array);
+    }
+    builtin_gc_set(vm, map, "collections", INTEGER_VAL_VM(vm, stats->fullCollections));
+    builtin_gc_set(vm, map, "young_collections", INTEGER_VAL_VM(vm, stats->youngCollections));
+    builtin_gc_set(vm, map, "incremental_steps", INTEGER_VAL_VM(vm, stats->incrementalSteps));
+    builtin_gc_set(vm, map, "pauses", INTEGER_VAL_VM(vm, stats->pauses));
+    builtin_gc_set(vm, map, "pause_total_ns", INTEGER_VAL_VM(vm, stats->pauseTotalNs));
+    builtin_gc_set(vm, map, "pause_max_ns", INTEGER_VAL_VM(vm, stats->pauseMaxNs));
+    builtin_gc_set(vm, map, "bytes_freed", INTEGER_VAL_VM(vm, stats->bytesFreed));
+    builtin_gc_set(vm, map, "last_bytes_freed", INTEGER_VAL_VM(vm, stats->lastBytesFreed));
+    builtin_gc_set(vm, map, "heap_bytes", INTEGER_VAL_VM(vm, heap_bytes));
+    DaiVM_resetGCRef(vm);
+    return OBJ_VAL(map);
+}
+
+static DaiValue
+builtin_gc_heap(__attribute__((unused)) DaiVM* vm, __attribute__((unused)) DaiValue receiver,
+                int argc, DaiValue* argv) {
+    if (argc != 0) {
+        DaiObjError* err =
+            DaiObjError_Newf(vm, "gc.heap() expected no arguments, but got %d", argc);
+        return OBJ_VAL(err);
+    }
+    DaiHeapTypeStats stats[DaiObjType_count];
+    DaiVM_getHeapStats(vm, stats);
+    DaiObjMap* map;
+    DaiObjError* err = DaiObjMap_New(vm, NULL, 0, &map);
+    if (err != NULL) {
+        return OBJ_VAL(err);
+    }
+    DaiVM_addGCRef(vm, OBJ_VAL(map));
+    for (int i = 0; i < DaiObjType_count; i++) {
+        if (stats[i].count == 0) {
+            continue;
+        }
+        DaiValue key = builtin_gc_set(vm, map, dai_object_type_name(i), NIL_VAL);
+        DaiObjMap* entry;
+        err = DaiObjMap_New(vm, NULL, 0, &entry);
+        if (err != NULL) {
+            DaiVM_resetGCRef(vm);
+            return OBJ_VAL(err);
+        }
+        // 先放进结果里，后面创建键的时候 entry 不会被回收
+        DaiObjMap_cset(map, key, OBJ_VAL(entry));
+        dai_gc_write_barrier(vm, (DaiObj*)map, OBJ_VAL(entry));
+        builtin_gc_set(vm, entry, "count", INTEGER_VAL_VM(vm, stats[i].count));
+        builtin_gc_set(vm, entry, "bytes", INTEGER_VAL_VM(vm, stats[i].bytes));
+    }
+    DaiVM_resetGCRef(vm);
+    return OBJ_VAL(map);
+}
+
+// 进行一次完整回收，返回释放的字节数
+static DaiValue
+builtin_gc_collect(__attribute__((unused)) DaiVM* vm, __attribute__((unused)) DaiValue receiver,
+                   int argc, DaiValue* argv) {
+    if (argc != 0) {
+        DaiObjError* err =
+            DaiObjError_Newf(vm, "gc.collect() expected no arguments, but got %d", argc);
+        return OBJ_VAL(err);
+    }
+    size_t before = vm->bytesAllocated;
+    collectGarbage(vm);
+    return INTEGER_VAL_VM(vm, before > vm->bytesAllocated ? before - vm->bytesAllocated : 0);
+}
+
+// 暂停自动回收，gc.collect() 和堆上限触发的紧急回收不受影响
+static DaiValue
+builtin_gc_disable(__attribute__((unused)) DaiVM* vm, __attribute__((unused)) DaiValue receiver,
+                   int argc, DaiValue* argv) {
+    if (argc != 0) {
+        DaiObjError* err =
+            DaiObjError_Newf(vm, "gc.disable() expected no arguments, but got %d", argc);
+        return OBJ_VAL(err);
+    }
+    DaiVM_disableGC(vm);
+    return NIL_VAL;
+}
+
+static DaiValue
+builtin_gc_enable(__attribute__((unused)) DaiVM* vm, __attribute__((unused)) DaiValue receiver,
+                  int argc, DaiValue* argv) {
+    if (argc != 0) {
+        DaiObjError* err =
+            DaiObjError_Newf(vm, "gc.enable() expected no arguments, but got %d", argc);
+        return OBJ_VAL(err);
+    }
+    DaiVM_enableGC(vm);
+    return NIL_VAL;
+}
+
+static DaiValue
+builtin_gc_is_enabled(__attribute__((unused)) DaiVM* vm,
+                      __attribute__((unused)) DaiValue receiver, int argc, DaiValue* argv) {
+    if (argc != 0) {
+        DaiObjError* err =
+            DaiObjError_Newf(vm, "gc.is_enabled() expected no arguments, but got %d", argc);
+        return OBJ_VAL(err);
+    }
+    return BOOL_VAL(!vm->gcDisabled);
+}
+
+static DaiObjBuiltinFunction builtin_gc_funcs[] = {
+    {
+        {.type = DaiObjType_builtinFn, .operation = &builtin_function_operation},
+        .name     = "stats",
+        .function = builtin_gc_stats,
+    },
+    {
+        {.type = DaiObjType_builtinFn, .operation = &builtin_function_operation},
+        .name     = "heap",
+        .function = builtin_gc_heap,
+    },
+    {
+        {.type = DaiObjType_builtinFn, .operation = &builtin_function_operation},
+        .name     = "collect",
+        .function = builtin_gc_collect,
+    },
+    {
+        {.type = DaiObjType_builtinFn, .operation = &builtin_function_operation},
+        .name     = "disable",
+        .function = builtin_gc_disable,
+    },
+    {
+        {.type = DaiObjType_builtinFn, .operation = &builtin_function_operation},
+        .name     = "enable",
+        .function = builtin_gc_enable,
+    },
+    {
+        {.type = DaiObjType_builtinFn, .operation = &builtin_function_operation},
+        .name     = "is_enabled",
+        .function = builtin_gc_is_enabled,
+    },
+    {
+        {.type = DaiObjType_builtinFn, .operation = &builtin_function_operation},
+        .name = NULL,
+    },
+};
+
+static DaiObjModule*
+builtin_gc_module(DaiVM* vm) {
+    DaiObjModule* module = DaiObjModule_New(vm, strdup("gc"), strdup("<builtin>"));
+    for (int i = 0; builtin_gc_funcs[i].name != NULL; i++) {
+        DaiObjModule_add_global(module, builtin_gc_funcs[i].name, OBJ_VAL(&builtin_gc_funcs[i]));
+    }
+    return module;
+}
+
+// #endregion
+
 const char* builtin_names[BUILTIN_OBJECT_MAX_COUNT]               = {};
 static DaiBuiltinObject builtin_objects[BUILTIN_OBJECT_MAX_COUNT] = {};
 
@@ -1093,6 +1552,7 @@ init_builtin_objects(DaiVM* vm, int* count) {
     i++;
 
     REGISTER_BUILTIN_MODULE(sys);
+    REGISTER_BUILTIN_MODULE(gc);
 
     *count = i;
     return builtin_objects;
@@ -3,13 +3,14 @@
 */
 
 #include "dai_chunk.h"
+#include "dai_jit.h"
 #include "dai_memory.h"
 #include <stdint.h>
+#include <string.h>
 
 #ifdef DISASSEMBLE_VARIABLE_NAME
 #    include <assert.h>
 #    include <stdio.h>
-#    include <string.h>
 #endif
 
 static DaiOpCodeDefinition definitions[] = {
@@ -69,8 +70,12 @@ static DaiOpCodeDefinition definitions[] = {
 
     // 操作数：uint8 迭代器的索引
     [DaiOpIterInit] = {.name = "DaiOpIterInit", .operand_bytes = 1, .stack_size_change = -1},
-    // 操作数：uint8 迭代器的索引， uint16 循环末尾的偏移量
-    [DaiOpIterNext] = {.name = "DaiOpIterNext", .operand_bytes = 3, .stack_size_change = 0},
+    // 操作数：uint8 迭代器的索引， uint8 标志位， uint16 循环末尾的偏移量
+    [DaiOpIterNext] = {.name = "DaiOpIterNext", .operand_bytes = 4, .stack_size_change = 0},
+    // 操作数：uint8 计数器的索引（后面依次是下标、元素、 end 、 step 、内部下标），弹出 start, end, step
+    [DaiOpRangeInit] = {.name = "DaiOpRangeInit", .operand_bytes = 1, .stack_size_change = -3},
+    // 操作数：uint8 计数器的索引， uint8 标志位， uint16 循环末尾的偏移量
+    [DaiOpRangeNext] = {.name = "DaiOpRangeNext", .operand_bytes = 4, .stack_size_change = 0},
 
 
     [DaiOpPop] = {.name = "DaiOpPop", .operand_bytes = 0, .stack_size_change = -1},
@@ -125,36 +130,72 @@ static DaiOpCodeDefinition definitions[] = {
     [DaiOpDefineClassMethod] = {.name              = "DaiOpDefineClassMethod",
                                 .operand_bytes     = 2,
                                 .stack_size_change = -1},
-    // 操作数：属性名的常量索引
-    [DaiOpGetProperty] = {.name = "DaiOpGetProperty", .operand_bytes = 2, .stack_size_change = 0},
-    // 操作数：属性名的常量索引
-    [DaiOpSetProperty] = {.name = "DaiOpSetProperty", .operand_bytes = 2, .stack_size_change = -2},
-    // 操作数：属性名的常量索引
+    // 操作数：uint16 属性名的常量索引， uint16 内联缓存的索引
+    [DaiOpGetProperty] = {.name = "DaiOpGetProperty", .operand_bytes = 4, .stack_size_change = 0},
+    // 操作数：uint16 属性名的常量索引， uint16 内联缓存的索引
+    [DaiOpSetProperty] = {.name = "DaiOpSetProperty", .operand_bytes = 4, .stack_size_change = -2},
+    // 操作数：uint16 属性名的常量索引， uint16 内联缓存的索引
     [DaiOpGetSelfProperty] = {.name              = "DaiOpGetSelfProperty",
-                              .operand_bytes     = 2,
+                              .operand_bytes     = 4,
                               .stack_size_change = 1},
-    // 操作数：属性名的常量索引
+    // 操作数：uint16 属性名的常量索引， uint16 内联缓存的索引
     [DaiOpSetSelfProperty] = {.name              = "DaiOpSetSelfProperty",
-                              .operand_bytes     = 2,
+                              .operand_bytes     = 4,
                               .stack_size_change = -1},
     // 操作数：属性名的常量索引
     [DaiOpGetSuperProperty] = {.name              = "DaiOpGetSuperProperty",
                                .operand_bytes     = 2,
                                .stack_size_change = 1},
     [DaiOpInherit]          = {.name = "DaiOpInherit", .operand_bytes = 0, .stack_size_change = -1},
-    // 操作数：uint16 方法名的常量索引、uint8 参数个数
+    // 操作数：uint16 方法名的常量索引、uint8 参数个数、uint16 内联缓存的索引
     [DaiOpCallMethod] = {.name              = "DaiOpCallMethod",
-                         .operand_bytes     = 3,
+                         .operand_bytes     = 5,
                          .stack_size_change = STACK_SIZE_CHANGE_DEPENDS_ON_OPERAND},
-    // 操作数：uint16 方法名的常量索引、uint8 参数个数
+    // 操作数：uint16 方法名的常量索引、uint8 参数个数、uint16 内联缓存的索引
     [DaiOpCallSelfMethod] = {.name              = "DaiOpCallSelfMethod",
-                             .operand_bytes     = 3,
+                             .operand_bytes     = 5,
                              .stack_size_change = STACK_SIZE_CHANGE_DEPENDS_ON_OPERAND},
     // 操作数：uint16 方法名的常量索引、uint8 参数个数
     [DaiOpCallSuperMethod] = {.name              = "DaiOpCallSuperMethod",
                               .operand_bytes     = 3,
                               .stack_size_change = STACK_SIZE_CHANGE_DEPENDS_ON_OPERAND},
 
+    // 操作数：融合前的 GetLocal a; GetLocal b; Add 除去第一个字节
+    [DaiOpAddLocalLocal] = {.name              = "DaiOpAddLocalLocal",
+                            .operand_bytes     = 4,
+                            .stack_size_change = 1},
+    // 操作数：融合前的 GetLocal a; Constant k; Add 除去第一个字节
+    [DaiOpAddLocalConstant] = {.name              = "DaiOpAddLocalConstant",
+                               .operand_bytes     = 5,
+                               .stack_size_change = 1},
+    // 操作数：融合前的 GetLocal a; Constant k; Sub 除去第一个字节
+    [DaiOpSubLocalConstant] = {.name              = "DaiOpSubLocalConstant",
+                               .operand_bytes     = 5,
+                               .stack_size_change = 1},
+    // 操作数：融合前的 GreaterThan; JumpIfFalse offset 除去第一个字节
+    [DaiOpGreaterThanJumpIfFalse] = {.name              = "DaiOpGreaterThanJumpIfFalse",
+                                     .operand_bytes     = 3,
+                                     .stack_size_change = -2},
+
+    [DaiOpAddInt]   = {.name = "DaiOpAddInt", .operand_bytes = 0, .stack_size_change = -2 + 1},
+    [DaiOpAddFloat] = {.name = "DaiOpAddFloat", .operand_bytes = 0, .stack_size_change = -2 + 1},
+    [DaiOpSubInt]   = {.name = "DaiOpSubInt", .operand_bytes = 0, .stack_size_change = -2 + 1},
+    [DaiOpSubFloat] = {.name = "DaiOpSubFloat", .operand_bytes = 0, .stack_size_change = -2 + 1},
+    [DaiOpMulInt]   = {.name = "DaiOpMulInt", .operand_bytes = 0, .stack_size_change = -2 + 1},
+    [DaiOpMulFloat] = {.name = "DaiOpMulFloat", .operand_bytes = 0, .stack_size_change = -2 + 1},
+
+    [DaiOpGreaterThanInt]   = {.name              = "DaiOpGreaterThanInt",
+                               .operand_bytes     = 0,
+                               .stack_size_change = -2 + 1},
+    [DaiOpGreaterThanFloat] = {.name              = "DaiOpGreaterThanFloat",
+                               .operand_bytes     = 0,
+                               .stack_size_change = -2 + 1},
+
+    [DaiOpEqualInt]   = {.name = "DaiOpEqualInt", .operand_bytes = 0, .stack_size_change = -2 + 1},
+    [DaiOpEqualFloat] = {.name              = "DaiOpEqualFloat",
+                         .operand_bytes     = 0,
+                         .stack_size_change = -2 + 1},
+
     [DaiOpEnd] = {.name = "DaiOpEnd", .operand_bytes = 0, .stack_size_change = 0},
 };
 
@@ -200,6 +241,14 @@ DaiChunk_init(DaiChunk* chunk, const char* filename) {
     chunk->code     = NULL;
     chunk->lines    = NULL;
     DaiValueArray_init(&chunk->constants);
+    chunk->property_caches         = NULL;
+    chunk->property_cache_count    = 0;
+    chunk->property_cache_capacity = 0;
+    chunk->method_caches           = NULL;
+    chunk->method_cache_count      = 0;
+    chunk->method_cache_capacity   = 0;
+    chunk->jit_code                = NULL;
+    chunk->jit_counter             = 0;
 
 #ifdef DISASSEMBLE_VARIABLE_NAME
     chunk->names = NULL;
@@ -246,6 +295,9 @@ DaiChunk_reset(DaiChunk* chunk) {
     FREE_ARRAY(uint8_t, chunk->code, chunk->capacity);
     FREE_ARRAY(int, chunk->lines, chunk->capacity);
     DaiValueArray_reset(&chunk->constants);
+    FREE_ARRAY(DaiPropertyCache, chunk->property_caches, chunk->property_cache_capacity);
+    FREE_ARRAY(DaiMethodCache, chunk->method_caches, chunk->method_cache_capacity);
+    DaiJit_free(chunk);
 
 #ifdef DISASSEMBLE_VARIABLE_NAME
     for (int i = 0; i < chunk->count; i++) {
@@ -265,6 +317,30 @@ DaiChunk_addConstant(DaiChunk* chunk, DaiValue value) {
     return chunk->constants.count - 1;
 }
 
+int
+DaiChunk_addPropertyCache(DaiChunk* chunk) {
+    if (chunk->property_cache_capacity < chunk->property_cache_count + 1) {
+        int oldCapacity                = chunk->property_cache_capacity;
+        chunk->property_cache_capacity = GROW_CAPACITY(oldCapacity);
+        chunk->property_caches         = GROW_ARRAY(
+            DaiPropertyCache, chunk->property_caches, oldCapacity, chunk->property_cache_capacity);
+    }
+    memset(&chunk->property_caches[chunk->property_cache_count], 0, sizeof(DaiPropertyCache));
+    return chunk->property_cache_count++;
+}
+
+int
+DaiChunk_addMethodCache(DaiChunk* chunk) {
+    if (chunk->method_cache_capacity < chunk->method_cache_count + 1) {
+        int oldCapacity              = chunk->method_cache_capacity;
+        chunk->method_cache_capacity = GROW_CAPACITY(oldCapacity);
+        chunk->method_caches         = GROW_ARRAY(
+            DaiMethodCache, chunk->method_caches, oldCapacity, chunk->method_cache_capacity);
+    }
+    memset(&chunk->method_caches[chunk->method_cache_count], 0, sizeof(DaiMethodCache));
+    return chunk->method_cache_count++;
+}
+
 uint8_t
 DaiChunk_read(const DaiChunk* chunk, int offset) {
     return chunk->code[offset];
@@ -81,6 +81,8 @@ typedef enum __attribute__((__packed__)) {
 
     DaiOpIterInit,
     DaiOpIterNext,
+    DaiOpRangeInit,   // for-in range(...) ，不创建迭代器对象
+    DaiOpRangeNext,
 
     DaiOpPop,
     DaiOpPopN,
@@ -119,15 +121,124 @@ typedef enum __attribute__((__packed__)) {
     DaiOpCallSelfMethod,
     DaiOpCallSuperMethod,
 
+    // 超级指令：由常见的指令序列融合而成，见 dai_compile.c:fuse_superinstructions
+    // 融合只改写序列的第一个字节，后面原指令的字节保持不变，作为超级指令的操作数
+    DaiOpAddLocalLocal,            // GetLocal a; GetLocal b; Add
+    DaiOpAddLocalConstant,         // GetLocal a; Constant k; Add
+    DaiOpSubLocalConstant,         // GetLocal a; Constant k; Sub
+    DaiOpGreaterThanJumpIfFalse,   // GreaterThan; JumpIfFalse offset
+
+    // 特化指令：通用指令执行时根据操作数类型把自己改写成特化指令（quickening），
+    // 特化指令的类型检查失败时再改写回通用指令
+    DaiOpAddInt,
+    DaiOpAddFloat,
+    DaiOpSubInt,
+    DaiOpSubFloat,
+    DaiOpMulInt,
+    DaiOpMulFloat,
+    DaiOpGreaterThanInt,
+    DaiOpGreaterThanFloat,
+    DaiOpEqualInt,
+    DaiOpEqualFloat,
+
     DaiOpEnd,
 } DaiOpCode;
 
+// for-in 循环使用的局部变量相对迭代器的位置
+enum {
+    DAI_ITER_ITERATOR,   // 迭代器，数组和字典直接放容器本身
+    DAI_ITER_I,          // 循环变量 i
+    DAI_ITER_E,          // 循环变量 e
+    DAI_ITER_CURSOR,     // 遍历数组和字典的游标（整数）
+    DAI_ITER_SLOT_COUNT,
+};
+
+// DaiOpIterNext/DaiOpRangeNext 的标志位
+// 循环变量 i 省略或者是 _ 时不写入下标
+#define DAI_ITER_SKIP_INDEX 0x1
+
+// DaiOpRangeInit/DaiOpRangeNext 使用的局部变量相对计数器的位置
+// 前三个和 for-in 循环的迭代器、下标、元素一致
+enum {
+    DAI_RANGE_COUNTER,   // 当前值
+    DAI_RANGE_I,         // 循环变量 i
+    DAI_RANGE_E,         // 循环变量 e
+    DAI_RANGE_END,
+    DAI_RANGE_STEP,
+    DAI_RANGE_INDEX,   // 下一次的下标，循环体修改 i 不影响迭代
+    DAI_RANGE_SLOT_COUNT,
+};
+
 DaiOpCodeDefinition*
 dai_opcode_lookup(const DaiOpCode op);
 
 const char*
 dai_opcode_name(const DaiOpCode op);
 
+// 内联缓存的路数，同一条指令上交替出现超过这个数量的类时会互相淘汰
+#define INLINE_CACHE_WAYS 4
+
+// 属性访问指令的内联缓存，每条属性访问指令独占一个
+// 按接收者所属类的形状（shape）缓存实例属性在 fields 中的索引，最近命中的放在最前面
+typedef struct {
+    uint32_t shapes[INLINE_CACHE_WAYS];   // 0 表示空
+    int indexes[INLINE_CACHE_WAYS];
+} DaiPropertyCache;
+
+// 查找形状对应的属性索引，没有缓存返回 -1
+static inline int
+DaiPropertyCache_lookup(const DaiPropertyCache* cache, uint32_t shape) {
+    for (int i = 0; i < INLINE_CACHE_WAYS; i++) {
+        if (cache->shapes[i] == shape) {
+            return cache->indexes[i];
+        }
+    }
+    return -1;
+}
+
+// 缓存形状对应的属性索引，淘汰最旧的一项
+static inline void
+DaiPropertyCache_update(DaiPropertyCache* cache, uint32_t shape, int index) {
+    for (int i = INLINE_CACHE_WAYS - 1; i > 0; i--) {
+        cache->shapes[i]  = cache->shapes[i - 1];
+        cache->indexes[i] = cache->indexes[i - 1];
+    }
+    cache->shapes[0]  = shape;
+    cache->indexes[0] = index;
+}
+
+// 方法调用指令的内联缓存，每条方法调用指令独占一个
+// 按接收者所属类的形状缓存查找到的方法（函数或者闭包），最近命中的放在最前面
+typedef struct {
+    uint32_t shapes[INLINE_CACHE_WAYS];   // 0 表示空
+    DaiValue methods[INLINE_CACHE_WAYS];
+} DaiMethodCache;
+
+// 查找形状对应的方法，没有缓存返回 false
+static inline bool
+DaiMethodCache_lookup(const DaiMethodCache* cache, uint32_t shape, DaiValue* method) {
+    for (int i = 0; i < INLINE_CACHE_WAYS; i++) {
+        if (cache->shapes[i] == shape) {
+            *method = cache->methods[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+// 缓存形状对应的方法，淘汰最旧的一项
+static inline void
+DaiMethodCache_update(DaiMethodCache* cache, uint32_t shape, DaiValue method) {
+    for (int i = INLINE_CACHE_WAYS - 1; i > 0; i--) {
+        cache->shapes[i]  = cache->shapes[i - 1];
+        cache->methods[i] = cache->methods[i - 1];
+    }
+    cache->shapes[0]  = shape;
+    cache->methods[0] = method;
+}
+
+typedef struct DaiJitCode DaiJitCode;
+
 typedef struct {
     // filename 不归 DaiChunk 所有
     const char* filename;
@@ -136,6 +247,14 @@ typedef struct {
     uint8_t* code;
     int* lines;
     DaiValueArray constants;
+    DaiPropertyCache* property_caches;   // 属性访问指令的内联缓存
+    int property_cache_count;
+    int property_cache_capacity;
+    DaiMethodCache* method_caches;   // 方法调用指令的内联缓存
+    int method_cache_count;
+    int method_cache_capacity;
+    DaiJitCode* jit_code;          // JIT 编译出来的机器码，还没有编译时为 NULL
+    int jit_counter;               // 热度计数（循环回跳次数），-1 表示编译失败不再尝试
 #ifdef DISASSEMBLE_VARIABLE_NAME
     char** names;
 #endif
@@ -158,6 +277,13 @@ DaiChunk_reset(DaiChunk* chunk);
 int
 DaiChunk_addConstant(DaiChunk* chunk, DaiValue value);
 
+// 分配一个属性内联缓存，返回它的索引
+int
+DaiChunk_addPropertyCache(DaiChunk* chunk);
+// 分配一个方法内联缓存，返回它的索引
+int
+DaiChunk_addMethodCache(DaiChunk* chunk);
+
 uint8_t
 DaiChunk_read(const DaiChunk* chunk, int offset);
 uint16_t
@@ -17,6 +17,19 @@
 #    define DAI_UNUSED
 #endif
 
+// 使用 computed goto 分派字节码（GCC/Clang 扩展）
+// 定义 DAI_NO_COMPUTED_GOTO 可以回退到 switch 分派
+#if defined(__GNUC__) && !defined(DAI_NO_COMPUTED_GOTO)
+#    define DAI_COMPUTED_GOTO
+#endif
+
+// 基线 JIT ，目前只支持 x86-64 Linux ，并且生成的机器码依赖 DaiValue 的结构体布局
+// 定义 DAI_NO_JIT 可以关闭
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__) && \
+    !defined(DAI_NAN_BOXING) && !defined(DAI_NO_JIT)
+#    define DAI_JIT
+#endif
+
 #define unreachable() assert(false)
 #define dai_log(...) printf(__VA_ARGS__)
 #define dai_error(fmt, ...) fprintf(stderr, fmt " [%s:%d]", ##__VA_ARGS__, __FILE__, __LINE__)
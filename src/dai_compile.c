@@ -205,7 +205,13 @@ static int
 DaiCompiler_emit3(const DaiCompiler* compiler, DaiOpCode op, uint16_t operand1, uint8_t operand2,
                   int line);
 static int
-DaiCompiler_emitIterNext(const DaiCompiler* compiler, uint8_t operand1, int line);
+DaiCompiler_emitIterNext(const DaiCompiler* compiler, DaiOpCode op, uint8_t operand1,
+                         uint8_t operand2, int line);
+static int
+DaiCompiler_emitProperty(const DaiCompiler* compiler, DaiOpCode op, uint16_t name_index, int line);
+static int
+DaiCompiler_emitCallMethod(const DaiCompiler* compiler, DaiOpCode op, uint16_t name_index,
+                           uint8_t argc, int line);
 static void
 DaiCompiler_patchJump(const DaiCompiler* compiler, int offset);
 static void
@@ -374,13 +380,120 @@ DaiCompiler_leaveLoop(DaiCompiler* compiler, int loop_start) {
     IntArray_leave(&compiler->continue_array);
 }
 
+// #region 超级指令
+// 把常见的指令序列融合成一条超级指令，减少分派次数。
+// 融合只改写序列的第一个字节，后面原指令的字节保持不变，
+// 所以指令长度、跳转偏移量和行号都不需要调整。
+// 超级指令的慢路径（比如操作数不是整数）只执行第一条原指令，然后接着执行后面的原指令。
+// 指令序列是根据 daibenchmarks 和 test/vm_testcases 的指令对出现次数选取的
+typedef struct {
+    DaiOpCode fused;
+    DaiOpCode head;   // 第一条原指令
+    int count;        // 原指令个数
+    DaiOpCode ops[3];
+} SuperInstruction;
+
+static const SuperInstruction superinstructions[] = {
+    {DaiOpAddLocalLocal, DaiOpGetLocal, 3, {DaiOpGetLocal, DaiOpGetLocal, DaiOpAdd}},
+    {DaiOpAddLocalConstant, DaiOpGetLocal, 3, {DaiOpGetLocal, DaiOpConstant, DaiOpAdd}},
+    {DaiOpSubLocalConstant, DaiOpGetLocal, 3, {DaiOpGetLocal, DaiOpConstant, DaiOpSub}},
+    {DaiOpGreaterThanJumpIfFalse, DaiOpGreaterThan, 2, {DaiOpGreaterThan, DaiOpJumpIfFalse}},
+};
+
+static int
+instruction_length(const DaiChunk* chunk, int offset) {
+    return dai_opcode_lookup(chunk->code[offset])->operand_bytes + 1;
+}
+
+// 返回超级指令的第一条原指令，普通指令原样返回
+static DaiOpCode
+superinstruction_head(DaiOpCode op) {
+    for (size_t i = 0; i < sizeof(superinstructions) / sizeof(superinstructions[0]); i++) {
+        if (superinstructions[i].fused == op) {
+            return superinstructions[i].head;
+        }
+    }
+    return op;
+}
+
+// 匹配成功返回序列的字节数，否则返回 0
+static int
+match_superinstruction(const DaiChunk* chunk, int offset, const SuperInstruction* super,
+                       const bool* is_jump_target) {
+    int pos = offset;
+    for (int i = 0; i < super->count; i++) {
+        if (pos >= chunk->count || chunk->code[pos] != super->ops[i]) {
+            return 0;
+        }
+        // 有跳转指令跳到序列中间，不能融合
+        if (i > 0 && is_jump_target[pos]) {
+            return 0;
+        }
+        pos += instruction_length(chunk, pos);
+    }
+    return pos - offset;
+}
+
+static void
+fuse_superinstructions(DaiChunk* chunk) {
+    if (chunk->count == 0) {
+        return;
+    }
+    // 标记所有跳转目标
+    bool* is_jump_target = ALLOCATE(bool, chunk->count + 1);
+    memset(is_jump_target, 0, sizeof(bool) * (chunk->count + 1));
+    for (int offset = 0; offset < chunk->count;) {
+        int target = -1;
+        switch (chunk->code[offset]) {
+            case DaiOpJumpIfFalse:
+            case DaiOpJump:
+            case DaiOpAndJump:
+            case DaiOpOrJump: {
+                target = offset + 3 + DaiChunk_readu16(chunk, offset + 1);
+                break;
+            }
+            case DaiOpJumpBack: {
+                target = offset + 3 - DaiChunk_readu16(chunk, offset + 1);
+                break;
+            }
+            case DaiOpIterNext:
+            case DaiOpRangeNext: {
+                target = offset + 5 + DaiChunk_readu16(chunk, offset + 3);
+                break;
+            }
+            default: break;
+        }
+        if (target >= 0 && target <= chunk->count) {
+            is_jump_target[target] = true;
+        }
+        offset += instruction_length(chunk, offset);
+    }
+
+    for (int offset = 0; offset < chunk->count;) {
+        int length = instruction_length(chunk, offset);
+        for (size_t i = 0; i < sizeof(superinstructions) / sizeof(superinstructions[0]); i++) {
+            const SuperInstruction* super = &superinstructions[i];
+            int n = match_superinstruction(chunk, offset, super, is_jump_target);
+            if (n > 0) {
+                chunk->code[offset] = super->fused;
+                length              = n;
+                break;
+            }
+        }
+        offset += length;
+    }
+    FREE_ARRAY(bool, is_jump_target, chunk->count + 1);
+}
+// #endregion
+
 // 计算执行字节码需要的最大栈空间
 static int
 calculate_max_stack_size(DaiChunk* chunk) {
     int max_stack_size = 0;
     int stack_size     = 0;
     for (int offset = 0; offset < chunk->count;) {
-        const DaiOpCode instruction         = chunk->code[offset];
+        // 超级指令的慢路径会逐条执行原指令，所以按原指令计算
+        const DaiOpCode instruction         = superinstruction_head(chunk->code[offset]);
         const DaiOpCodeDefinition* code_def = dai_opcode_lookup(instruction);
         int stack_size_change               = code_def->stack_size_change;
         if (stack_size_change == STACK_SIZE_CHANGE_DEPENDS_ON_OPERAND) {
@@ -581,6 +694,7 @@ DaiCompiler_compileFunction(DaiCompiler* compiler, DaiAstBase* node) {
         DaiCompiler_emit1(compiler, DaiOpSetFunctionDefault, DaiArray_length(defaults), start_line);
     }
 
+    fuse_superinstructions(&function->chunk);
     function->max_local_count = subcompiler.max_local_count;
     // 局部变量是预先分配在栈上的，同样需要占用栈空间
     function->max_stack_size =
@@ -839,7 +953,7 @@ DaiCompiler_compileAssignStatement(DaiCompiler* compiler, DaiAstBase* node) {
             DaiObjString* name =
                 dai_copy_string_intern(compiler->vm, expr->name->value, strlen(expr->name->value));
             int index = DaiChunk_addConstant(compiler->chunk, OBJ_VAL(name));
-            DaiCompiler_emit2(compiler, DaiOpSetProperty, index, stmt->start_line);
+            DaiCompiler_emitProperty(compiler, DaiOpSetProperty, index, stmt->start_line);
             break;
         }
         case DaiAstType_ClassExpression: {
@@ -856,19 +970,19 @@ DaiCompiler_compileAssignStatement(DaiCompiler* compiler, DaiAstBase* node) {
                 DaiObjString* name = dai_copy_string_intern(
                     compiler->vm, expr->name->value, strlen(expr->name->value));
                 int index = DaiChunk_addConstant(compiler->chunk, OBJ_VAL(name));
-                DaiCompiler_emit2(compiler, DaiOpSetSelfProperty, index, stmt->start_line);
+                DaiCompiler_emitProperty(compiler, DaiOpSetSelfProperty, index, stmt->start_line);
             } else {
                 // 在实例方法里面，我们要从 self 里面获取类对象
                 DaiObjString* name_class =
                     dai_copy_string_intern(compiler->vm, "__class__", strlen("__class__"));
                 int index = DaiChunk_addConstant(compiler->chunk, OBJ_VAL(name_class));
-                DaiCompiler_emit2(compiler, DaiOpGetSelfProperty, index, expr->start_line);
+                DaiCompiler_emitProperty(compiler, DaiOpGetSelfProperty, index, expr->start_line);
 
 
                 DaiObjString* name = dai_copy_string_intern(
                     compiler->vm, expr->name->value, strlen(expr->name->value));
                 index = DaiChunk_addConstant(compiler->chunk, OBJ_VAL(name));
-                DaiCompiler_emit2(compiler, DaiOpSetProperty, index, stmt->start_line);
+                DaiCompiler_emitProperty(compiler, DaiOpSetProperty, index, stmt->start_line);
             }
             break;
         }
@@ -883,7 +997,7 @@ DaiCompiler_compileAssignStatement(DaiCompiler* compiler, DaiAstBase* node) {
             DaiObjString* name =
                 dai_copy_string_intern(compiler->vm, expr->name->value, strlen(expr->name->value));
             int index = DaiChunk_addConstant(compiler->chunk, OBJ_VAL(name));
-            DaiCompiler_emit2(compiler, DaiOpSetSelfProperty, index, stmt->start_line);
+            DaiCompiler_emitProperty(compiler, DaiOpSetSelfProperty, index, stmt->start_line);
             break;
         }
         case DaiAstType_SubscriptExpression: {
@@ -1143,12 +1257,64 @@ DaiCompiler_compileBreakStatement(DaiCompiler* compiler, DaiAstBase* node) {
     IntArray_push(&compiler->break_array, jump);
     return NULL;
 }
+// for-in 循环的对象是不是调用内置的 range 函数（没有被同名变量覆盖），参数个数是否正确
+static bool
+DaiCompiler_isRangeCall(DaiCompiler* compiler, DaiAstExpression* expression) {
+    if (expression->type != DaiAstType_CallExpression) {
+        return false;
+    }
+    DaiAstCallExpression* call = (DaiAstCallExpression*)expression;
+    if (call->function->type != DaiAstType_Identifier || call->arguments_count < 1 ||
+        call->arguments_count > 3) {
+        return false;
+    }
+    DaiAstIdentifier* id = (DaiAstIdentifier*)call->function;
+    if (strcmp(id->value, "range") != 0) {
+        return false;
+    }
+    DaiSymbol symbol;
+    return DaiSymbolTable_resolve(compiler->symbolTable, id->value, &symbol) &&
+           symbol.type == DaiSymbolType_builtin;
+}
+
+// 把 range 的参数补齐成 start, end, step 三个压栈
+static DaiCompileError*
+DaiCompiler_compileRangeArguments(DaiCompiler* compiler, DaiAstCallExpression* call) {
+    DaiCompileError* err = NULL;
+    if (call->arguments_count == 1) {
+        DaiCompiler_emit2(compiler,
+                          DaiOpConstant,
+                          DaiCompiler_addConstant(compiler, INTEGER_VAL(0)),
+                          call->start_line);
+    }
+    for (int i = 0; i < call->arguments_count; i++) {
+        err = DaiCompiler_compile(compiler, (DaiAstBase*)call->arguments[i]);
+        if (err != NULL) {
+            return err;
+        }
+    }
+    if (call->arguments_count < 3) {
+        DaiCompiler_emit2(compiler,
+                          DaiOpConstant,
+                          DaiCompiler_addConstant(compiler, INTEGER_VAL(1)),
+                          call->start_line);
+    }
+    return NULL;
+}
+
 static DaiCompileError*
 DaiCompiler_compileForInStatement(DaiCompiler* compiler, DaiAstBase* node) {
     IntArray_push(&compiler->scope_stack, ScopeType_for);
     DaiCompiler_enterLoop(compiler);
     DaiAstForInStatement* stmt = (DaiAstForInStatement*)node;
-    DaiCompileError* err       = DaiCompiler_compile(compiler, (DaiAstBase*)stmt->expression);
+    // for-in range(...) 不创建迭代器对象，计数器直接放在局部变量里
+    bool is_range        = DaiCompiler_isRangeCall(compiler, stmt->expression);
+    DaiCompileError* err = NULL;
+    if (is_range) {
+        err = DaiCompiler_compileRangeArguments(compiler, (DaiAstCallExpression*)stmt->expression);
+    } else {
+        err = DaiCompiler_compile(compiler, (DaiAstBase*)stmt->expression);
+    }
     if (err != NULL) {
         return err;
     }
@@ -1158,18 +1324,38 @@ DaiCompiler_compileForInStatement(DaiCompiler* compiler, DaiAstBase* node) {
     compiler->symbolTable            = blockSymbolTable;
     DaiSymbol iterator_symbol =
         DaiSymbolTable_define(blockSymbolTable, "//iterator", true);   // 一个特殊的变量名表示迭代器
-    if (stmt->i == NULL) {
+    // 循环变量 i 省略或者是 _ 时不需要写入下标
+    bool skip_index = stmt->i == NULL || strcmp(stmt->i->value, "_") == 0;
+    if (skip_index) {
         DaiSymbolTable_define(blockSymbolTable, "//i", true);   // 占个位置保持一致
     } else {
         DaiSymbolTable_define(blockSymbolTable, stmt->i->value, false);
     }
     DaiSymbolTable_define(blockSymbolTable, stmt->e->value, false);
-    compiler->max_local_count = MAX(compiler->max_local_count, iterator_symbol.index + 3);
+    int slot_count = DAI_ITER_SLOT_COUNT;
+    if (is_range) {
+        // range 循环的迭代器位置放当前值，后面再跟着 end 、 step 和下标
+        DaiSymbolTable_define(blockSymbolTable, "//end", true);
+        DaiSymbolTable_define(blockSymbolTable, "//step", true);
+        DaiSymbolTable_define(blockSymbolTable, "//index", true);
+        slot_count = DAI_RANGE_SLOT_COUNT;
+    } else {
+        // 遍历数组和字典时不创建迭代器对象，用游标记录位置
+        DaiSymbolTable_define(blockSymbolTable, "//cursor", true);
+    }
+    compiler->max_local_count =
+        MAX(compiler->max_local_count, iterator_symbol.index + slot_count);
     // 编译 for-in 循环
-    DaiCompiler_emit1(compiler, DaiOpIterInit, iterator_symbol.index, stmt->start_line);
-    int for_start = compiler->chunk->count;
-    int jump_if_end_offset =
-        DaiCompiler_emitIterNext(compiler, iterator_symbol.index, stmt->start_line);
+    DaiCompiler_emit1(compiler,
+                      is_range ? DaiOpRangeInit : DaiOpIterInit,
+                      iterator_symbol.index,
+                      stmt->start_line);
+    int for_start          = compiler->chunk->count;
+    int jump_if_end_offset = DaiCompiler_emitIterNext(compiler,
+                                                      is_range ? DaiOpRangeNext : DaiOpIterNext,
+                                                      iterator_symbol.index,
+                                                      skip_index ? DAI_ITER_SKIP_INDEX : 0,
+                                                      stmt->start_line);
     err = DaiCompiler_compile(compiler, (DaiAstBase*)stmt->body);
     if (err != NULL) {
         return err;
@@ -1180,8 +1366,8 @@ DaiCompiler_compileForInStatement(DaiCompiler* compiler, DaiAstBase* node) {
             DaiCompiler_emit2(compiler, DaiOpJumpBack, JUMP_PLACEHOLDER, stmt->start_line);
         DaiCompiler_patchJumpBack(compiler, jump_back, for_start);
         // 更新 jump 到循环末尾的偏移量
-        // DaiOpIterNext 比 jump 指令长度多 1 ，所以这里加 1 适配 jump 格式
-        DaiCompiler_patchJump(compiler, jump_if_end_offset + 1);
+        // DaiOpIterNext 比 jump 指令长度多 2 ，所以这里加 2 适配 jump 格式
+        DaiCompiler_patchJump(compiler, jump_if_end_offset + 2);
     }
     DaiCompiler_leaveLoop(compiler, for_start);
     IntArray_pop(&compiler->scope_stack);
@@ -1192,7 +1378,7 @@ DaiCompiler_compileForInStatement(DaiCompiler* compiler, DaiAstBase* node) {
 static DaiCompileError*
 DaiCompiler_compileIntegerLiteral(DaiCompiler* compiler, DaiAstBase* node) {
     DaiAstIntegerLiteral* lit = (DaiAstIntegerLiteral*)node;
-    DaiValue integer          = INTEGER_VAL(lit->value);
+    DaiValue integer          = INTEGER_VAL_VM(compiler->vm, lit->value);
     DaiCompiler_emit2(
         compiler, DaiOpConstant, DaiCompiler_addConstant(compiler, integer), lit->start_line);
     return NULL;
@@ -1398,7 +1584,7 @@ DaiCompiler_compileCallExpression(DaiCompiler* compiler, DaiAstBase* node) {
             DaiObjString* name =
                 dai_copy_string_intern(compiler->vm, dot->name->value, strlen(dot->name->value));
             int index = DaiChunk_addConstant(compiler->chunk, OBJ_VAL(name));
-            DaiCompiler_emit3(
+            DaiCompiler_emitCallMethod(
                 compiler, DaiOpCallMethod, index, expr->arguments_count, expr->start_line);
             return NULL;
         }
@@ -1424,19 +1610,19 @@ DaiCompiler_compileCallExpression(DaiCompiler* compiler, DaiAstBase* node) {
                 DaiObjString* name = dai_copy_string_intern(
                     compiler->vm, classexpr->name->value, strlen(classexpr->name->value));
                 int index = DaiChunk_addConstant(compiler->chunk, OBJ_VAL(name));
-                DaiCompiler_emit3(
+                DaiCompiler_emitCallMethod(
                     compiler, DaiOpCallSelfMethod, index, expr->arguments_count, expr->start_line);
             } else {
                 // 在实例方法里面，我们要从 self 里面获取类对象
                 DaiObjString* name_class =
                     dai_copy_string_intern(compiler->vm, "__class__", strlen("__class__"));
                 int index = DaiChunk_addConstant(compiler->chunk, OBJ_VAL(name_class));
-                DaiCompiler_emit2(compiler, DaiOpGetSelfProperty, index, expr->start_line);
+                DaiCompiler_emitProperty(compiler, DaiOpGetSelfProperty, index, expr->start_line);
                 // 调用对象方法
                 DaiObjString* name = dai_copy_string_intern(
                     compiler->vm, classexpr->name->value, strlen(classexpr->name->value));
                 index = DaiChunk_addConstant(compiler->chunk, OBJ_VAL(name));
-                DaiCompiler_emit3(
+                DaiCompiler_emitCallMethod(
                     compiler, DaiOpCallMethod, index, expr->arguments_count, expr->start_line);
                 return NULL;
             }
@@ -1462,7 +1648,7 @@ DaiCompiler_compileCallExpression(DaiCompiler* compiler, DaiAstBase* node) {
             DaiObjString* name             = dai_copy_string_intern(
                 compiler->vm, selfexpr->name->value, strlen(selfexpr->name->value));
             int index = DaiChunk_addConstant(compiler->chunk, OBJ_VAL(name));
-            DaiCompiler_emit3(
+            DaiCompiler_emitCallMethod(
                 compiler, DaiOpCallSelfMethod, index, expr->arguments_count, expr->start_line);
             return NULL;
         }
@@ -1511,7 +1697,7 @@ DaiCompiler_compileDotExpression(DaiCompiler* compiler, DaiAstBase* node) {
     DaiObjString* name =
         dai_copy_string_intern(compiler->vm, expr->name->value, strlen(expr->name->value));
     int index = DaiChunk_addConstant(compiler->chunk, OBJ_VAL(name));
-    DaiCompiler_emit2(compiler, DaiOpGetProperty, index, expr->start_line);
+    DaiCompiler_emitProperty(compiler, DaiOpGetProperty, index, expr->start_line);
     return NULL;
 }
 static DaiCompileError*
@@ -1527,7 +1713,7 @@ DaiCompiler_compileSelfExpression(DaiCompiler* compiler, DaiAstBase* node) {
         DaiObjString* name =
             dai_copy_string_intern(compiler->vm, expr->name->value, strlen(expr->name->value));
         int index = DaiChunk_addConstant(compiler->chunk, OBJ_VAL(name));
-        DaiCompiler_emit2(compiler, DaiOpGetSelfProperty, index, expr->start_line);
+        DaiCompiler_emitProperty(compiler, DaiOpGetSelfProperty, index, expr->start_line);
     } else {
         DaiCompiler_emit1(compiler, DaiOpGetLocal, 0, expr->start_line);
     }
@@ -1548,7 +1734,7 @@ DaiCompiler_compileClassExpression(DaiCompiler* compiler, DaiAstBase* node) {
             DaiObjString* name =
                 dai_copy_string_intern(compiler->vm, expr->name->value, strlen(expr->name->value));
             int index = DaiChunk_addConstant(compiler->chunk, OBJ_VAL(name));
-            DaiCompiler_emit2(compiler, DaiOpGetSelfProperty, index, expr->start_line);
+            DaiCompiler_emitProperty(compiler, DaiOpGetSelfProperty, index, expr->start_line);
         } else {
             DaiCompiler_emit1(compiler, DaiOpGetLocal, 0, expr->start_line);
         }
@@ -1557,12 +1743,12 @@ DaiCompiler_compileClassExpression(DaiCompiler* compiler, DaiAstBase* node) {
         DaiObjString* name_class =
             dai_copy_string_intern(compiler->vm, "__class__", strlen("__class__"));
         int index = DaiChunk_addConstant(compiler->chunk, OBJ_VAL(name_class));
-        DaiCompiler_emit2(compiler, DaiOpGetSelfProperty, index, expr->start_line);
+        DaiCompiler_emitProperty(compiler, DaiOpGetSelfProperty, index, expr->start_line);
         if (expr->name) {
             DaiObjString* name =
                 dai_copy_string_intern(compiler->vm, expr->name->value, strlen(expr->name->value));
             index = DaiChunk_addConstant(compiler->chunk, OBJ_VAL(name));
-            DaiCompiler_emit2(compiler, DaiOpGetProperty, index, expr->start_line);
+            DaiCompiler_emitProperty(compiler, DaiOpGetProperty, index, expr->start_line);
         }
     }
     return NULL;
@@ -1694,12 +1880,44 @@ DaiCompiler_emit3(const DaiCompiler* compiler, DaiOpCode op, uint16_t operand1,
 }
 
 static int
-DaiCompiler_emitIterNext(const DaiCompiler* compiler, uint8_t operand1, int line) {
+DaiCompiler_emitIterNext(const DaiCompiler* compiler, DaiOpCode op, uint8_t operand1,
+                         uint8_t operand2, int line) {
     DaiChunk* chunk = compiler->chunk;
-    DaiChunk_write(chunk, DaiOpIterNext, line);
+    DaiChunk_write(chunk, op, line);
     DaiChunk_write(chunk, operand1, line);
+    DaiChunk_write(chunk, operand2, line);
     DaiChunk_write2(chunk, 65535, line);
-    return chunk->count - 4;
+    return chunk->count - 5;
+}
+
+// 属性访问指令，第二个操作数是这条指令独占的内联缓存
+static int
+DaiCompiler_emitProperty(const DaiCompiler* compiler, DaiOpCode op, uint16_t name_index, int line) {
+    DaiChunk* chunk = compiler->chunk;
+    int cache_index = DaiChunk_addPropertyCache(chunk);
+    if (cache_index > UINT16_MAX) {
+        fprintf(stderr, "too many property accesses in one function\n");
+        abort();
+    }
+    DaiChunk_writeu16(chunk, op, name_index, line);
+    DaiChunk_write2(chunk, cache_index, line);
+    return chunk->count - 5;
+}
+
+// 方法调用指令，最后一个操作数是这条指令独占的内联缓存
+static int
+DaiCompiler_emitCallMethod(const DaiCompiler* compiler, DaiOpCode op, uint16_t name_index,
+                           uint8_t argc, int line) {
+    DaiChunk* chunk = compiler->chunk;
+    int cache_index = DaiChunk_addMethodCache(chunk);
+    if (cache_index > UINT16_MAX) {
+        fprintf(stderr, "too many method calls in one function\n");
+        abort();
+    }
+    DaiChunk_writeu16(chunk, op, name_index, line);
+    DaiChunk_write(chunk, argc, line);
+    DaiChunk_write2(chunk, cache_index, line);
+    return chunk->count - 6;
 }
 
 static void
@@ -1749,6 +1967,7 @@ dai_compile(DaiAstProgram* program, DaiObjModule* module, DaiVM* vm) {
         goto END;
     }
     err = DaiCompiler_compile(&compiler, (DaiAstBase*)program);
+    fuse_superinstructions(&module->chunk);
     // 局部变量是预先分配在栈上的，同样需要占用栈空间
     module->max_local_count = compiler.max_local_count;
     module->max_stack_size  = module->max_local_count + calculate_max_stack_size(&module->chunk);
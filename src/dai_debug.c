@@ -75,9 +75,10 @@ simple_instruction2(const char* name, const DaiChunk* chunk, const int offset) {
 static int
 iter_next_instruction(const char* name, const DaiChunk* chunk, const int offset) {
     uint8_t n           = DaiChunk_read(chunk, offset + 1);
-    uint16_t end_offset = DaiChunk_readu16(chunk, offset + 2);
-    printf("%s %d %d\n", name, n, end_offset);
-    return offset + 4;
+    uint8_t flags       = DaiChunk_read(chunk, offset + 2);
+    uint16_t end_offset = DaiChunk_readu16(chunk, offset + 3);
+    printf("%s %d %d %d\n", name, n, flags, end_offset);
+    return offset + 5;
 }
 
 static int
@@ -156,6 +157,16 @@ property_instruction(const char* name, DaiChunk* chunk, int offset) {
     return offset + 3;
 }
 
+static int
+cached_property_instruction(const char* name, DaiChunk* chunk, int offset) {
+    uint16_t constant    = DaiChunk_readu16(chunk, offset + 1);
+    uint16_t cache_index = DaiChunk_readu16(chunk, offset + 3);
+    printf("%-32s %4d '", name, constant);
+    dai_print_value(chunk->constants.values[constant]);
+    printf("' cache=%d\n", cache_index);
+    return offset + 5;
+}
+
 static int
 property_instruction1(const char* name, DaiChunk* chunk, int offset) {
     uint16_t constant = DaiChunk_readu16(chunk, offset + 1);
@@ -176,6 +187,43 @@ call_method_instruction(const char* name, DaiChunk* chunk, int offset) {
     return offset + 4;
 }
 
+static int
+cached_call_method_instruction(const char* name, DaiChunk* chunk, int offset) {
+    uint16_t constant    = DaiChunk_readu16(chunk, offset + 1);
+    int argCount         = DaiChunk_read(chunk, offset + 3);
+    uint16_t cache_index = DaiChunk_readu16(chunk, offset + 4);
+    printf("%-32s %4d %d '", name, constant, argCount);
+    dai_print_value(chunk->constants.values[constant]);
+    printf("' cache=%d\n", cache_index);
+    return offset + 6;
+}
+
+static int
+local_local_instruction(const char* name, DaiChunk* chunk, int offset) {
+    // GetLocal a; GetLocal b; op
+    int a = DaiChunk_read(chunk, offset + 1);
+    int b = DaiChunk_read(chunk, offset + 3);
+    printf("%-32s %4d %4d\n", name, a, b);
+    return offset + 5;
+}
+
+static int
+local_constant_instruction(const char* name, DaiChunk* chunk, int offset) {
+    // GetLocal a; Constant k; op
+    int index         = DaiChunk_read(chunk, offset + 1);
+    uint16_t constant = DaiChunk_readu16(chunk, offset + 3);
+    printf("%-32s %4d %4d\n", name, index, constant);
+    return offset + 6;
+}
+
+static int
+compare_jump_instruction(const char* name, DaiChunk* chunk, int offset) {
+    // op; JumpIfFalse offset
+    uint16_t jump_offset = DaiChunk_readu16(chunk, offset + 2);
+    printf("%-32s %4d -> %d\n", name, jump_offset, offset + 4 + jump_offset);
+    return offset + 4;
+}
+
 int
 DaiChunk_disassembleInstruction(DaiChunk* chunk, int offset) {
     printf("%04d ", offset);
@@ -220,6 +268,8 @@ DaiChunk_disassembleInstruction(DaiChunk* chunk, int offset) {
 
         case DaiOpIterInit: return simple_instruction1("OP_ITER", chunk, offset);
         case DaiOpIterNext: return iter_next_instruction("OP_ITER_NEXT", chunk, offset);
+        case DaiOpRangeInit: return simple_instruction1("OP_RANGE", chunk, offset);
+        case DaiOpRangeNext: return iter_next_instruction("OP_RANGE_NEXT", chunk, offset);
 
         case DaiOpPop: return simple_instruction("OP_POP", offset);
         case DaiOpPopN: return simple_instruction1("OP_POP_N", chunk, offset);
@@ -251,21 +301,42 @@ DaiChunk_disassembleInstruction(DaiChunk* chunk, int offset) {
             return property_instruction1("OP_DEFINE_CLASS_FIELD", chunk, offset);
         case DaiOpDefineClassMethod:
             return property_instruction("OP_DEFINE_CLASS_METHOD", chunk, offset);
-        case DaiOpGetProperty: return property_instruction("OP_GET_PROPERTY", chunk, offset);
-        case DaiOpSetProperty: return property_instruction("OP_SET_PROPERTY", chunk, offset);
+        case DaiOpGetProperty:
+            return cached_property_instruction("OP_GET_PROPERTY", chunk, offset);
+        case DaiOpSetProperty:
+            return cached_property_instruction("OP_SET_PROPERTY", chunk, offset);
         case DaiOpGetSelfProperty:
-            return property_instruction("OP_GET_SELF_PROPERTY", chunk, offset);
+            return cached_property_instruction("OP_GET_SELF_PROPERTY", chunk, offset);
         case DaiOpSetSelfProperty:
-            return property_instruction("OP_SET_SELF_PROPERTY", chunk, offset);
+            return cached_property_instruction("OP_SET_SELF_PROPERTY", chunk, offset);
         case DaiOpGetSuperProperty:
             return property_instruction("OP_GET_SUPER_PROPERTY", chunk, offset);
         case DaiOpInherit: return simple_instruction("OP_INHERIT", offset);
-        case DaiOpCallMethod: return call_method_instruction("OP_CALL_METHOD", chunk, offset);
+        case DaiOpCallMethod:
+            return cached_call_method_instruction("OP_CALL_METHOD", chunk, offset);
         case DaiOpCallSelfMethod:
-            return call_method_instruction("OP_CALL_SELF_METHOD", chunk, offset);
+            return cached_call_method_instruction("OP_CALL_SELF_METHOD", chunk, offset);
         case DaiOpCallSuperMethod:
             return call_method_instruction("OP_CALL_SUPER_METHOD", chunk, offset);
 
+        case DaiOpAddLocalLocal:
+            return local_local_instruction("OP_ADD_LOCAL_LOCAL", chunk, offset);
+        case DaiOpAddLocalConstant:
+            return local_constant_instruction("OP_ADD_LOCAL_CONSTANT", chunk, offset);
+        case DaiOpSubLocalConstant:
+            return local_constant_instruction("OP_SUB_LOCAL_CONSTANT", chunk, offset);
+        case DaiOpGreaterThanJumpIfFalse:
+            return compare_jump_instruction("OP_GREATER_THAN_JUMP_IF_FALSE", chunk, offset);
+        case DaiOpAddInt: return simple_instruction("OP_ADD_INT", offset);
+        case DaiOpAddFloat: return simple_instruction("OP_ADD_FLOAT", offset);
+        case DaiOpSubInt: return simple_instruction("OP_SUB_INT", offset);
+        case DaiOpSubFloat: return simple_instruction("OP_SUB_FLOAT", offset);
+        case DaiOpMulInt: return simple_instruction("OP_MUL_INT", offset);
+        case DaiOpMulFloat: return simple_instruction("OP_MUL_FLOAT", offset);
+        case DaiOpGreaterThanInt: return simple_instruction("OP_GREATER_THAN_INT", offset);
+        case DaiOpGreaterThanFloat: return simple_instruction("OP_GREATER_THAN_FLOAT", offset);
+        case DaiOpEqualInt: return simple_instruction("OP_EQUAL_INT", offset);
+        case DaiOpEqualFloat: return simple_instruction("OP_EQUAL_FLOAT", offset);
         case DaiOpEnd: return simple_instruction("OP_END", offset);
     }
     return offset + 1;
@@ -0,0 +1,1182 @@
+#include "dai_jit.h"
+
+#ifdef DAI_JIT
+
+#    include <stdint.h>
+#    include <string.h>
+#    include <sys/mman.h>
+
+#    include "dai_chunk.h"
+#    include "dai_memory.h"
+#    include "dai_value.h"
+
+// 机器码直接读写 DaiValue ，依赖它的结构体布局
+#    define VALUE_SIZE ((int32_t)sizeof(DaiValue))
+#    define TYPE_OFFSET ((int32_t)offsetof(DaiValue, type))
+#    define PAYLOAD_OFFSET ((int32_t)offsetof(DaiValue, as))
+// 栈顶往下第 n 个值相对栈顶指针的偏移量，和解释器的 PEEK(n) 对应
+#    define PEEK_OFFSET(n) (-((n) + 1) * VALUE_SIZE)
+
+_Static_assert(sizeof(DaiValue) == 16, "jit requires 16-byte DaiValue");
+
+// #region x86-64 汇编器
+
+typedef enum {
+    RAX = 0,
+    RCX,
+    RDX,
+    RBX,
+    RSP,
+    RBP,
+    RSI,
+    RDI,
+    R8,
+    R9,
+    R10,
+    R11,
+    R12,
+    R13,
+    R14,
+    R15,
+} DaiJitReg;
+
+// 机器码执行期间常驻在被调用者保存寄存器里的状态，调用 C 函数不需要保存
+#    define REG_VM RBX
+#    define REG_FRAME R12
+#    define REG_TOP R13   // 栈顶，对应解释器的局部变量 stack_top
+#    define REG_SLOTS R14
+#    define REG_GLOBALS R15
+
+#    define XMM0 0
+#    define XMM1 1
+
+// 条件码
+typedef enum {
+    CC_B  = 0x2,
+    CC_AE = 0x3,
+    CC_E  = 0x4,
+    CC_NE = 0x5,
+    CC_BE = 0x6,
+    CC_A  = 0x7,
+    CC_L  = 0xC,
+    CC_GE = 0xD,
+    CC_LE = 0xE,
+    CC_G  = 0xF,
+} DaiJitCond;
+// 无条件跳转
+#    define CC_ALWAYS (-1)
+
+// 操作码，大于 0xFF 的是 0x0F 开头的两字节操作码
+#    define OP_ADD 0x03         // add r64, r/m64
+#    define OP_ADD_STORE 0x01   // add r/m64, r64
+#    define OP_OR 0x0B
+#    define OP_AND 0x23
+#    define OP_SUB 0x2B
+#    define OP_SUB_STORE 0x29
+#    define OP_XOR 0x33
+#    define OP_XOR_STORE 0x31
+#    define OP_CMP 0x3B
+#    define OP_IMUL 0x0FAF
+#    define OP_TEST 0x85
+#    define OP_TEST8 0x84
+#    define OP_MOV_LOAD 0x8B
+#    define OP_MOV_STORE 0x89
+#    define OP_MOV_IMM32 0xC7   // /0
+#    define OP_LEA 0x8D
+#    define OP_GROUP1_BYTE 0x80   // /7 cmp r/m8, imm8
+#    define OP_GROUP1_IMM32 0x81   // /0 add /5 sub ， imm32
+#    define OP_GROUP1_IMM8 0x83    // /0 add /5 sub /7 cmp ， imm8
+#    define OP_GROUP3 0xF7         // /2 not /3 neg /7 idiv
+#    define OP_SHIFT_CL 0xD3       // /4 shl /7 sar
+#    define OP_GROUP5 0xFF         // /2 call /4 jmp
+#    define OP_MOVUPS_LOAD 0x0F10
+#    define OP_MOVUPS_STORE 0x0F11
+// 下面这些需要 0xF2 （标量双精度）或者 0x66 前缀
+#    define OP_MOVSD_LOAD 0x0F10
+#    define OP_MOVSD_STORE 0x0F11
+#    define OP_ADDSD 0x0F58
+#    define OP_MULSD 0x0F59
+#    define OP_SUBSD 0x0F5C
+#    define OP_DIVSD 0x0F5E
+#    define OP_UCOMISD 0x0F2E
+#    define OP_XORPD 0x0F57
+#    define PREFIX_F2 0xF2
+#    define PREFIX_66 0x66
+
+// 待回填的跳转
+typedef struct {
+    int position;   // rel32 在机器码中的位置
+    int target;     // 目标字节码偏移量
+} DaiJitFixup;
+
+typedef struct {
+    int count;
+    int capacity;
+    DaiJitFixup* fixups;
+} DaiJitFixupArray;
+
+static void
+DaiJitFixupArray_init(DaiJitFixupArray* array) {
+    array->count    = 0;
+    array->capacity = 0;
+    array->fixups   = NULL;
+}
+
+static void
+DaiJitFixupArray_write(DaiJitFixupArray* array, int position, int target) {
+    if (array->capacity < array->count + 1) {
+        int old_capacity = array->capacity;
+        array->capacity  = GROW_CAPACITY(old_capacity);
+        array->fixups =
+            GROW_ARRAY(DaiJitFixup, array->fixups, old_capacity, array->capacity);
+    }
+    array->fixups[array->count++] = (DaiJitFixup){position, target};
+}
+
+static void
+DaiJitFixupArray_reset(DaiJitFixupArray* array) {
+    FREE_ARRAY(DaiJitFixup, array->fixups, array->capacity);
+    DaiJitFixupArray_init(array);
+}
+
+typedef struct {
+    DaiChunk* chunk;
+    int count;
+    int capacity;
+    uint8_t* code;
+    int* labels;              // 字节码偏移量 -> 机器码偏移量，-1 表示不是指令的开头
+    int* stubs;               // 字节码偏移量 -> 退出桩的机器码偏移量，-1 表示还没有生成
+    DaiJitFixupArray jumps;   // 跳到其他指令
+    DaiJitFixupArray bails;   // 跳到退出桩，回到解释器从目标指令开始执行
+    int exit;                 // 出口的机器码偏移量
+} DaiJitCompiler;
+
+struct DaiJitCode {
+    uint8_t* code;      // mmap 分配的可执行内存，开头是入口
+    size_t size;
+    int32_t* entries;   // 字节码偏移量 -> 机器码偏移量，-1 表示不能从这里进入
+    int entry_count;
+};
+
+// 机器码的入口，从 target 开始执行，返回 NULL 表示回到解释器从 frame->ip 接着执行
+typedef DaiObjError* (*DaiJitEntry)(DaiVM* vm, CallFrame* frame, const uint8_t* target);
+
+static void
+emit_byte(DaiJitCompiler* c, uint8_t byte) {
+    if (c->capacity < c->count + 1) {
+        int old_capacity = c->capacity;
+        c->capacity      = GROW_CAPACITY(old_capacity);
+        c->code          = GROW_ARRAY(uint8_t, c->code, old_capacity, c->capacity);
+    }
+    c->code[c->count++] = byte;
+}
+
+static void
+emit_u32(DaiJitCompiler* c, uint32_t n) {
+    for (int i = 0; i < 4; i++) {
+        emit_byte(c, (n >> (i * 8)) & 0xFF);
+    }
+}
+
+static void
+emit_u64(DaiJitCompiler* c, uint64_t n) {
+    for (int i = 0; i < 8; i++) {
+        emit_byte(c, (n >> (i * 8)) & 0xFF);
+    }
+}
+
+static void
+patch_u32(DaiJitCompiler* c, int position, uint32_t n) {
+    for (int i = 0; i < 4; i++) {
+        c->code[position + i] = (n >> (i * 8)) & 0xFF;
+    }
+}
+
+// 前缀 + REX + 操作码
+// reg 对应 ModRM.reg （寄存器或者操作码扩展），rm 对应 ModRM.rm （寄存器或者内存操作数的基址）
+static void
+emit_opcode(DaiJitCompiler* c, uint8_t prefix, bool w, uint16_t opcode, int reg, int rm) {
+    if (prefix != 0) {
+        emit_byte(c, prefix);
+    }
+    uint8_t rex = 0x40 | (w ? 0x08 : 0) | ((reg & 8) ? 0x04 : 0) | ((rm & 8) ? 0x01 : 0);
+    if (rex != 0x40) {
+        emit_byte(c, rex);
+    }
+    if (opcode > 0xFF) {
+        emit_byte(c, opcode >> 8);
+    }
+    emit_byte(c, opcode & 0xFF);
+}
+
+// op reg, [base + disp]
+static void
+emit_mem(DaiJitCompiler* c, uint8_t prefix, bool w, uint16_t opcode, int reg, int base,
+         int32_t disp) {
+    emit_opcode(c, prefix, w, opcode, reg, base);
+    bool disp8 = disp >= INT8_MIN && disp <= INT8_MAX;
+    emit_byte(c, (disp8 ? 0x40 : 0x80) | ((reg & 7) << 3) | (base & 7));
+    if ((base & 7) == RSP) {
+        // rsp 和 r12 做基址时需要 SIB 字节
+        emit_byte(c, 0x24);
+    }
+    if (disp8) {
+        emit_byte(c, (uint8_t)disp);
+    } else {
+        emit_u32(c, (uint32_t)disp);
+    }
+}
+
+// op reg, rm （两个都是寄存器）
+static void
+emit_reg(DaiJitCompiler* c, uint8_t prefix, bool w, uint16_t opcode, int reg, int rm) {
+    emit_opcode(c, prefix, w, opcode, reg, rm);
+    emit_byte(c, 0xC0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+static void
+emit_mov_load(DaiJitCompiler* c, int dst, int base, int32_t disp) {
+    emit_mem(c, 0, true, OP_MOV_LOAD, dst, base, disp);
+}
+
+static void
+emit_mov_store(DaiJitCompiler* c, int base, int32_t disp, int src) {
+    emit_mem(c, 0, true, OP_MOV_STORE, src, base, disp);
+}
+
+static void
+emit_mov_reg(DaiJitCompiler* c, int dst, int src) {
+    emit_reg(c, 0, true, OP_MOV_STORE, src, dst);
+}
+
+static void
+emit_mov_imm64(DaiJitCompiler* c, int dst, uint64_t n) {
+    emit_opcode(c, 0, true, 0xB8 + (dst & 7), 0, dst);
+    emit_u64(c, n);
+}
+
+static void
+emit_lea(DaiJitCompiler* c, int dst, int base, int32_t disp) {
+    emit_mem(c, 0, true, OP_LEA, dst, base, disp);
+}
+
+// reg += n ，ext 为 0 时是 add ，为 5 时是 sub
+static void
+emit_add_imm(DaiJitCompiler* c, int reg, int32_t n) {
+    int ext = 0;
+    if (n < 0) {
+        ext = 5;
+        n   = -n;
+    }
+    if (n <= INT8_MAX) {
+        emit_reg(c, 0, true, OP_GROUP1_IMM8, ext, reg);
+        emit_byte(c, (uint8_t)n);
+    } else {
+        emit_reg(c, 0, true, OP_GROUP1_IMM32, ext, reg);
+        emit_u32(c, (uint32_t)n);
+    }
+}
+
+// 调用 C 函数，返回值在 rax
+static void
+emit_call(DaiJitCompiler* c, const void* function) {
+    emit_mov_imm64(c, RAX, (uint64_t)(uintptr_t)function);
+    emit_reg(c, 0, false, OP_GROUP5, 2, RAX);
+}
+
+// setcc al; movzx eax, al
+static void
+emit_setcc(DaiJitCompiler* c, DaiJitCond cc) {
+    emit_byte(c, 0x0F);
+    emit_byte(c, 0x90 | cc);
+    emit_byte(c, 0xC0);
+    emit_byte(c, 0x0F);
+    emit_byte(c, 0xB6);
+    emit_byte(c, 0xC0);
+}
+
+// 条件跳转（ cc 为 CC_ALWAYS 时是无条件跳转），返回 rel32 的位置，之后用 patch_jump 回填
+static int
+emit_jump(DaiJitCompiler* c, int cc) {
+    if (cc == CC_ALWAYS) {
+        emit_byte(c, 0xE9);
+    } else {
+        emit_byte(c, 0x0F);
+        emit_byte(c, 0x80 | cc);
+    }
+    int position = c->count;
+    emit_u32(c, 0);
+    return position;
+}
+
+// 把跳转的目标设置为 target （机器码偏移量）
+static void
+patch_jump_to(DaiJitCompiler* c, int position, int target) {
+    patch_u32(c, position, (uint32_t)(target - (position + 4)));
+}
+
+// 把跳转的目标设置为当前位置
+static void
+patch_jump(DaiJitCompiler* c, int position) {
+    patch_jump_to(c, position, c->count);
+}
+
+// #endregion
+
+// #region 机器码调用的运行时函数，参数都通过指针传递，方便机器码直接传栈上的地址
+
+static bool
+DaiJit_truthy(const DaiValue* value) {
+    return dai_value_is_truthy(*value);
+}
+
+static int
+DaiJit_equal(const DaiValue* a, const DaiValue* b) {
+    return dai_value_equal(*a, *b);
+}
+
+static bool
+DaiJit_getField(DaiPropertyCache* cache, const DaiValue* receiver, DaiObjString* name,
+                DaiValue* value) {
+    return DaiVM_getInstanceField(cache, *receiver, name, value);
+}
+
+static bool
+DaiJit_setField(DaiPropertyCache* cache, const DaiValue* receiver, DaiObjString* name,
+                const DaiValue* value, DaiVM* vm) {
+    return DaiVM_setInstanceField(vm, cache, *receiver, name, *value);
+}
+
+// 数组下标的快速路径，下标越界等出错的情况交给解释器处理
+static DaiValue*
+DaiJit_arrayElement(DaiValue receiver, DaiValue index) {
+    if (!IS_ARRAY(receiver) || !IS_INTEGER(index)) {
+        return NULL;
+    }
+    const DaiObjArray* array = AS_ARRAY(receiver);
+    int64_t n                = AS_INTEGER(index);
+    if (n < 0) {
+        n += array->length;
+    }
+    if (n < 0 || n >= array->length) {
+        return NULL;
+    }
+    return &array->elements[n];
+}
+
+// 从栈顶排列为 index, object (object[index])
+static bool
+DaiJit_subscriptGet(DaiValue* stack_top) {
+    DaiValue* element = DaiJit_arrayElement(stack_top[-2], stack_top[-1]);
+    if (element == NULL) {
+        return false;
+    }
+    stack_top[-2] = *element;
+    return true;
+}
+
+// 从栈顶排列为 index, object, value (object[index] = value)
+static bool
+DaiJit_subscriptSet(DaiValue* stack_top, DaiVM* vm) {
+    DaiValue* element = DaiJit_arrayElement(stack_top[-2], stack_top[-1]);
+    if (element == NULL) {
+        return false;
+    }
+    *element           = stack_top[-3];
+    DaiObjArray* array = AS_ARRAY(stack_top[-2]);
+    DaiObjArray_write_barrier(vm, array, (int)(element - array->elements), stack_top[-3]);
+    return true;
+}
+
+// 返回 false 表示迭代结束
+static bool
+DaiJit_iterNext(DaiVM* vm, DaiValue* slots, uint8_t flags) {
+    return DaiVM_iterNext(vm, slots, flags);
+}
+
+// #endregion
+
+// #region 指令模板
+
+static void
+DaiJitCompiler_compileInstruction(DaiJitCompiler* c, int offset);
+
+// 跳到字节码 target 对应的机器码
+static void
+DaiJitCompiler_jump(DaiJitCompiler* c, int cc, int target) {
+    DaiJitFixupArray_write(&c->jumps, emit_jump(c, cc), target);
+}
+
+// 回到解释器，从字节码 offset 开始执行
+static void
+DaiJitCompiler_bail(DaiJitCompiler* c, int cc, int offset) {
+    DaiJitFixupArray_write(&c->bails, emit_jump(c, cc), offset);
+}
+
+// 调用可能分配内存（触发 GC ）或者重入虚拟机的函数前，把栈顶和 ip 写回，对应解释器的 SAVE_STATE
+static void
+DaiJitCompiler_saveState(DaiJitCompiler* c, int next_offset) {
+    emit_mov_store(c, REG_VM, offsetof(DaiVM, stack_top), REG_TOP);
+    emit_mov_imm64(c, RAX, (uint64_t)(uintptr_t)(c->chunk->code + next_offset));
+    emit_mov_store(c, REG_FRAME, offsetof(CallFrame, ip), RAX);
+}
+
+// 比较 [base + disp] 处的值的类型
+static void
+DaiJitCompiler_cmpType(DaiJitCompiler* c, int base, int32_t disp, DaiValueType type) {
+    emit_mem(c, 0, false, OP_GROUP1_IMM8, 7, base, disp + TYPE_OFFSET);
+    emit_byte(c, (uint8_t)type);
+}
+
+// [base + disp] 处的值不是 type 类型时回到解释器，从字节码 offset 开始执行
+static void
+DaiJitCompiler_guardType(DaiJitCompiler* c, int base, int32_t disp, DaiValueType type,
+                         int offset) {
+    DaiJitCompiler_cmpType(c, base, disp, type);
+    DaiJitCompiler_bail(c, CC_NE, offset);
+}
+
+// 把 [base + disp] 处的值压栈
+static void
+DaiJitCompiler_push(DaiJitCompiler* c, int base, int32_t disp) {
+    emit_mem(c, 0, false, OP_MOVUPS_LOAD, XMM0, base, disp);
+    emit_mem(c, 0, false, OP_MOVUPS_STORE, XMM0, REG_TOP, 0);
+    emit_add_imm(c, REG_TOP, VALUE_SIZE);
+}
+
+// 出栈并保存到 [base + disp]
+static void
+DaiJitCompiler_pop(DaiJitCompiler* c, int base, int32_t disp) {
+    emit_add_imm(c, REG_TOP, -VALUE_SIZE);
+    emit_mem(c, 0, false, OP_MOVUPS_LOAD, XMM0, REG_TOP, 0);
+    emit_mem(c, 0, false, OP_MOVUPS_STORE, XMM0, base, disp);
+}
+
+// 压入类型为 type ，值为 n 的值
+static void
+DaiJitCompiler_pushImmediate(DaiJitCompiler* c, DaiValueType type, int32_t n) {
+    emit_mem(c, 0, false, OP_MOV_IMM32, 0, REG_TOP, TYPE_OFFSET);
+    emit_u32(c, type);
+    emit_mem(c, 0, true, OP_MOV_IMM32, 0, REG_TOP, PAYLOAD_OFFSET);
+    emit_u32(c, (uint32_t)n);
+    emit_add_imm(c, REG_TOP, VALUE_SIZE);
+}
+
+// 把 reg 作为整数保存到 [base + disp]
+static void
+DaiJitCompiler_storeInt(DaiJitCompiler* c, int base, int32_t disp, int reg) {
+    emit_mov_store(c, base, disp + PAYLOAD_OFFSET, reg);
+    emit_mem(c, 0, false, OP_MOV_IMM32, 0, base, disp + TYPE_OFFSET);
+    emit_u32(c, DaiValueType_int);
+}
+
+// 把 eax （ 0 或者 1 ）作为布尔值保存到栈顶往下第 n 个值
+static void
+DaiJitCompiler_storeBool(DaiJitCompiler* c, int n) {
+    emit_mov_store(c, REG_TOP, PEEK_OFFSET(n) + PAYLOAD_OFFSET, RAX);
+    emit_mem(c, 0, false, OP_MOV_IMM32, 0, REG_TOP, PEEK_OFFSET(n) + TYPE_OFFSET);
+    emit_u32(c, DaiValueType_bool);
+}
+
+// 整数和整数、浮点数和浮点数的加减乘，其他情况交给解释器
+static void
+DaiJitCompiler_arithmetic(DaiJitCompiler* c, int offset, uint16_t int_op, uint16_t float_op) {
+    DaiJitCompiler_cmpType(c, REG_TOP, PEEK_OFFSET(1), DaiValueType_int);
+    int not_int = emit_jump(c, CC_NE);
+    DaiJitCompiler_guardType(c, REG_TOP, PEEK_OFFSET(0), DaiValueType_int, offset);
+    emit_mov_load(c, RAX, REG_TOP, PEEK_OFFSET(1) + PAYLOAD_OFFSET);
+    emit_mem(c, 0, true, int_op, RAX, REG_TOP, PEEK_OFFSET(0) + PAYLOAD_OFFSET);
+    emit_mov_store(c, REG_TOP, PEEK_OFFSET(1) + PAYLOAD_OFFSET, RAX);
+    emit_add_imm(c, REG_TOP, -VALUE_SIZE);
+    int done = emit_jump(c, CC_ALWAYS);
+
+    patch_jump(c, not_int);
+    DaiJitCompiler_guardType(c, REG_TOP, PEEK_OFFSET(1), DaiValueType_float, offset);
+    DaiJitCompiler_guardType(c, REG_TOP, PEEK_OFFSET(0), DaiValueType_float, offset);
+    emit_mem(c, PREFIX_F2, false, OP_MOVSD_LOAD, XMM0, REG_TOP, PEEK_OFFSET(1) + PAYLOAD_OFFSET);
+    emit_mem(c, PREFIX_F2, false, float_op, XMM0, REG_TOP, PEEK_OFFSET(0) + PAYLOAD_OFFSET);
+    emit_mem(c, PREFIX_F2, false, OP_MOVSD_STORE, XMM0, REG_TOP, PEEK_OFFSET(1) + PAYLOAD_OFFSET);
+    emit_add_imm(c, REG_TOP, -VALUE_SIZE);
+    patch_jump(c, done);
+}
+
+// 整数除法和取模，除数为 0 （报错）和 -1 （ INT64_MIN / -1 会溢出）时交给解释器
+// 除法还支持浮点数和浮点数
+static void
+DaiJitCompiler_divide(DaiJitCompiler* c, int offset, bool modulo) {
+    DaiJitCompiler_cmpType(c, REG_TOP, PEEK_OFFSET(1), DaiValueType_int);
+    int not_int = emit_jump(c, CC_NE);
+    DaiJitCompiler_guardType(c, REG_TOP, PEEK_OFFSET(0), DaiValueType_int, offset);
+    emit_mov_load(c, RCX, REG_TOP, PEEK_OFFSET(0) + PAYLOAD_OFFSET);
+    emit_reg(c, 0, true, OP_TEST, RCX, RCX);
+    DaiJitCompiler_bail(c, CC_E, offset);
+    emit_reg(c, 0, true, OP_GROUP1_IMM8, 7, RCX);   // cmp rcx, -1
+    emit_byte(c, 0xFF);
+    DaiJitCompiler_bail(c, CC_E, offset);
+    emit_mov_load(c, RAX, REG_TOP, PEEK_OFFSET(1) + PAYLOAD_OFFSET);
+    emit_byte(c, 0x48);   // cqo
+    emit_byte(c, 0x99);
+    emit_reg(c, 0, true, OP_GROUP3, 7, RCX);   // idiv rcx
+    emit_mov_store(c, REG_TOP, PEEK_OFFSET(1) + PAYLOAD_OFFSET, modulo ? RDX : RAX);
+    emit_add_imm(c, REG_TOP, -VALUE_SIZE);
+    int done = emit_jump(c, CC_ALWAYS);
+
+    patch_jump(c, not_int);
+    if (modulo) {
+        DaiJitCompiler_bail(c, CC_ALWAYS, offset);
+    } else {
+        DaiJitCompiler_guardType(c, REG_TOP, PEEK_OFFSET(1), DaiValueType_float, offset);
+        DaiJitCompiler_guardType(c, REG_TOP, PEEK_OFFSET(0), DaiValueType_float, offset);
+        emit_mem(
+            c, PREFIX_F2, false, OP_MOVSD_LOAD, XMM1, REG_TOP, PEEK_OFFSET(0) + PAYLOAD_OFFSET);
+        emit_reg(c, PREFIX_66, false, OP_XORPD, XMM0, XMM0);
+        emit_reg(c, PREFIX_66, false, OP_UCOMISD, XMM1, XMM0);
+        // 除数为 0 （或者 NaN ）
+        DaiJitCompiler_bail(c, CC_E, offset);
+        emit_mem(
+            c, PREFIX_F2, false, OP_MOVSD_LOAD, XMM0, REG_TOP, PEEK_OFFSET(1) + PAYLOAD_OFFSET);
+        emit_reg(c, PREFIX_F2, false, OP_DIVSD, XMM0, XMM1);
+        emit_mem(
+            c, PREFIX_F2, false, OP_MOVSD_STORE, XMM0, REG_TOP, PEEK_OFFSET(1) + PAYLOAD_OFFSET);
+        emit_add_imm(c, REG_TOP, -VALUE_SIZE);
+    }
+    patch_jump(c, done);
+}
+
+// 整数的位运算
+static void
+DaiJitCompiler_binary(DaiJitCompiler* c, int offset, DaiBinaryOpType op_type) {
+    DaiJitCompiler_guardType(c, REG_TOP, PEEK_OFFSET(1), DaiValueType_int, offset);
+    DaiJitCompiler_guardType(c, REG_TOP, PEEK_OFFSET(0), DaiValueType_int, offset);
+    emit_mov_load(c, RAX, REG_TOP, PEEK_OFFSET(1) + PAYLOAD_OFFSET);
+    switch (op_type) {
+        case BinaryOpLeftShift:
+        case BinaryOpRightShift: {
+            emit_mov_load(c, RCX, REG_TOP, PEEK_OFFSET(0) + PAYLOAD_OFFSET);
+            emit_reg(c, 0, true, OP_SHIFT_CL, op_type == BinaryOpLeftShift ? 4 : 7, RAX);
+            break;
+        }
+        case BinaryOpBitwiseAnd: {
+            emit_mem(c, 0, true, OP_AND, RAX, REG_TOP, PEEK_OFFSET(0) + PAYLOAD_OFFSET);
+            break;
+        }
+        case BinaryOpBitwiseXor: {
+            emit_mem(c, 0, true, OP_XOR, RAX, REG_TOP, PEEK_OFFSET(0) + PAYLOAD_OFFSET);
+            break;
+        }
+        case BinaryOpBitwiseOr: {
+            emit_mem(c, 0, true, OP_OR, RAX, REG_TOP, PEEK_OFFSET(0) + PAYLOAD_OFFSET);
+            break;
+        }
+        default: {
+            DaiJitCompiler_bail(c, CC_ALWAYS, offset);
+            return;
+        }
+    }
+    emit_mov_store(c, REG_TOP, PEEK_OFFSET(1) + PAYLOAD_OFFSET, RAX);
+    emit_add_imm(c, REG_TOP, -VALUE_SIZE);
+}
+
+// 整数和整数、浮点数和浮点数的大小比较，其他情况（比如字符串）交给解释器
+static void
+DaiJitCompiler_compare(DaiJitCompiler* c, int offset, DaiJitCond int_cc, DaiJitCond float_cc) {
+    DaiJitCompiler_cmpType(c, REG_TOP, PEEK_OFFSET(1), DaiValueType_int);
+    int not_int = emit_jump(c, CC_NE);
+    DaiJitCompiler_guardType(c, REG_TOP, PEEK_OFFSET(0), DaiValueType_int, offset);
+    emit_mov_load(c, RAX, REG_TOP, PEEK_OFFSET(1) + PAYLOAD_OFFSET);
+    emit_mem(c, 0, true, OP_CMP, RAX, REG_TOP, PEEK_OFFSET(0) + PAYLOAD_OFFSET);
+    emit_setcc(c, int_cc);
+    int store = emit_jump(c, CC_ALWAYS);
+
+    patch_jump(c, not_int);
+    DaiJitCompiler_guardType(c, REG_TOP, PEEK_OFFSET(1), DaiValueType_float, offset);
+    DaiJitCompiler_guardType(c, REG_TOP, PEEK_OFFSET(0), DaiValueType_float, offset);
+    emit_mem(c, PREFIX_F2, false, OP_MOVSD_LOAD, XMM0, REG_TOP, PEEK_OFFSET(1) + PAYLOAD_OFFSET);
+    emit_mem(c, PREFIX_66, false, OP_UCOMISD, XMM0, REG_TOP, PEEK_OFFSET(0) + PAYLOAD_OFFSET);
+    emit_setcc(c, float_cc);
+
+    patch_jump(c, store);
+    DaiJitCompiler_storeBool(c, 1);
+    emit_add_imm(c, REG_TOP, -VALUE_SIZE);
+}
+
+// 相等比较，整数和整数直接比较，其他类型调用 dai_value_equal
+static void
+DaiJitCompiler_equal(DaiJitCompiler* c, int offset, bool not_equal) {
+    DaiJitCompiler_cmpType(c, REG_TOP, PEEK_OFFSET(1), DaiValueType_int);
+    int slow1 = emit_jump(c, CC_NE);
+    DaiJitCompiler_cmpType(c, REG_TOP, PEEK_OFFSET(0), DaiValueType_int);
+    int slow2 = emit_jump(c, CC_NE);
+    emit_mov_load(c, RAX, REG_TOP, PEEK_OFFSET(1) + PAYLOAD_OFFSET);
+    emit_mem(c, 0, true, OP_CMP, RAX, REG_TOP, PEEK_OFFSET(0) + PAYLOAD_OFFSET);
+    emit_setcc(c, not_equal ? CC_NE : CC_E);
+    int store = emit_jump(c, CC_ALWAYS);
+
+    patch_jump(c, slow1);
+    patch_jump(c, slow2);
+    emit_lea(c, RDI, REG_TOP, PEEK_OFFSET(1));
+    emit_lea(c, RSI, REG_TOP, PEEK_OFFSET(0));
+    emit_call(c, DaiJit_equal);
+    // 返回 -1 表示比较的递归太深，交给解释器报错
+    emit_reg(c, 0, false, OP_GROUP1_IMM8, 7, RAX);
+    emit_byte(c, 0xFF);
+    DaiJitCompiler_bail(c, CC_E, offset);
+    emit_reg(c, 0, false, OP_TEST, RAX, RAX);
+    emit_setcc(c, not_equal ? CC_E : CC_NE);
+
+    patch_jump(c, store);
+    DaiJitCompiler_storeBool(c, 1);
+    emit_add_imm(c, REG_TOP, -VALUE_SIZE);
+}
+
+// 根据栈顶往下第 n 个值的真假跳转到字节码 target
+// jump_if_true 为 true 时值为真跳转，否则值为假跳转
+static void
+DaiJitCompiler_branch(DaiJitCompiler* c, int n, bool jump_if_true, int target) {
+    DaiJitCompiler_cmpType(c, REG_TOP, PEEK_OFFSET(n), DaiValueType_bool);
+    int slow = emit_jump(c, CC_NE);
+    emit_mem(c, 0, false, OP_GROUP1_BYTE, 7, REG_TOP, PEEK_OFFSET(n) + PAYLOAD_OFFSET);
+    emit_byte(c, 0);
+    DaiJitCompiler_jump(c, jump_if_true ? CC_NE : CC_E, target);
+    int done = emit_jump(c, CC_ALWAYS);
+
+    patch_jump(c, slow);
+    emit_lea(c, RDI, REG_TOP, PEEK_OFFSET(n));
+    emit_call(c, DaiJit_truthy);
+    emit_reg(c, 0, false, OP_TEST8, RAX, RAX);
+    DaiJitCompiler_jump(c, jump_if_true ? CC_NE : CC_E, target);
+    patch_jump(c, done);
+}
+
+// for-in range(...) 的迭代，计数器相关的局部变量都是 DaiOpRangeInit 检查过的整数
+static void
+DaiJitCompiler_rangeNext(DaiJitCompiler* c, int offset) {
+    int32_t slot    = c->chunk->code[offset + 1] * VALUE_SIZE;
+    uint8_t flags   = c->chunk->code[offset + 2];
+    int target      = offset + 5 + DaiChunk_readu16(c->chunk, offset + 3);
+    int32_t counter = slot + DAI_RANGE_COUNTER * VALUE_SIZE;
+    int32_t end     = slot + DAI_RANGE_END * VALUE_SIZE + PAYLOAD_OFFSET;
+    int32_t index   = slot + DAI_RANGE_INDEX * VALUE_SIZE;
+    emit_mov_load(c, RAX, REG_SLOTS, counter + PAYLOAD_OFFSET);
+    emit_mov_load(c, RCX, REG_SLOTS, slot + DAI_RANGE_STEP * VALUE_SIZE + PAYLOAD_OFFSET);
+    emit_reg(c, 0, true, OP_TEST, RCX, RCX);
+    int negative = emit_jump(c, CC_L);
+    emit_mem(c, 0, true, OP_CMP, RAX, REG_SLOTS, end);
+    DaiJitCompiler_jump(c, CC_GE, target);
+    int next = emit_jump(c, CC_ALWAYS);
+    patch_jump(c, negative);
+    emit_mem(c, 0, true, OP_CMP, RAX, REG_SLOTS, end);
+    DaiJitCompiler_jump(c, CC_LE, target);
+
+    patch_jump(c, next);
+    DaiJitCompiler_storeInt(c, REG_SLOTS, slot + DAI_RANGE_E * VALUE_SIZE, RAX);
+    if (!(flags & DAI_ITER_SKIP_INDEX)) {
+        emit_mov_load(c, RDX, REG_SLOTS, index + PAYLOAD_OFFSET);
+        DaiJitCompiler_storeInt(c, REG_SLOTS, slot + DAI_RANGE_I * VALUE_SIZE, RDX);
+        emit_mem(c, 0, true, OP_GROUP1_IMM8, 0, REG_SLOTS, index + PAYLOAD_OFFSET);   // add [index], 1
+        emit_byte(c, 1);
+    }
+    emit_reg(c, 0, true, OP_ADD_STORE, RCX, RAX);   // add rax, rcx
+    emit_mov_store(c, REG_SLOTS, counter + PAYLOAD_OFFSET, RAX);
+}
+
+// 融合了 GetLocal a; GetLocal b; Add 的超级指令
+static void
+DaiJitCompiler_addLocalLocal(DaiJitCompiler* c, int offset) {
+    int32_t a = c->chunk->code[offset + 1] * VALUE_SIZE;
+    int32_t b = c->chunk->code[offset + 3] * VALUE_SIZE;
+    DaiJitCompiler_cmpType(c, REG_SLOTS, a, DaiValueType_int);
+    int slow1 = emit_jump(c, CC_NE);
+    DaiJitCompiler_cmpType(c, REG_SLOTS, b, DaiValueType_int);
+    int slow2 = emit_jump(c, CC_NE);
+    emit_mov_load(c, RAX, REG_SLOTS, a + PAYLOAD_OFFSET);
+    emit_mem(c, 0, true, OP_ADD, RAX, REG_SLOTS, b + PAYLOAD_OFFSET);
+    DaiJitCompiler_storeInt(c, REG_TOP, 0, RAX);
+    emit_add_imm(c, REG_TOP, VALUE_SIZE);
+    int done = emit_jump(c, CC_ALWAYS);
+
+    // 慢路径：超级指令后面保留着原指令，逐条执行
+    patch_jump(c, slow1);
+    patch_jump(c, slow2);
+    DaiJitCompiler_push(c, REG_SLOTS, a);
+    DaiJitCompiler_compileInstruction(c, offset + 2);
+    DaiJitCompiler_compileInstruction(c, offset + 4);
+    patch_jump(c, done);
+}
+
+// 融合了 GetLocal a; Constant k; Add/Sub 的超级指令
+static void
+DaiJitCompiler_arithmeticLocalConstant(DaiJitCompiler* c, int offset, uint16_t int_op) {
+    int32_t a  = c->chunk->code[offset + 1] * VALUE_SIZE;
+    DaiValue k = c->chunk->constants.values[DaiChunk_readu16(c->chunk, offset + 3)];
+    int done   = -1;
+    if (IS_INTEGER(k)) {
+        DaiJitCompiler_cmpType(c, REG_SLOTS, a, DaiValueType_int);
+        int slow = emit_jump(c, CC_NE);
+        emit_mov_load(c, RAX, REG_SLOTS, a + PAYLOAD_OFFSET);
+        emit_mov_imm64(c, RCX, (uint64_t)AS_INTEGER(k));
+        emit_reg(c, 0, true, int_op, RCX, RAX);
+        DaiJitCompiler_storeInt(c, REG_TOP, 0, RAX);
+        emit_add_imm(c, REG_TOP, VALUE_SIZE);
+        done = emit_jump(c, CC_ALWAYS);
+        patch_jump(c, slow);
+    }
+    DaiJitCompiler_push(c, REG_SLOTS, a);
+    DaiJitCompiler_compileInstruction(c, offset + 2);
+    DaiJitCompiler_compileInstruction(c, offset + 5);
+    if (done >= 0) {
+        patch_jump(c, done);
+    }
+}
+
+// 融合了 GreaterThan; JumpIfFalse offset 的超级指令
+static void
+DaiJitCompiler_greaterThanJumpIfFalse(DaiJitCompiler* c, int offset) {
+    int target = offset + 4 + DaiChunk_readu16(c->chunk, offset + 2);
+    DaiJitCompiler_cmpType(c, REG_TOP, PEEK_OFFSET(1), DaiValueType_int);
+    int not_int = emit_jump(c, CC_NE);
+    DaiJitCompiler_guardType(c, REG_TOP, PEEK_OFFSET(0), DaiValueType_int, offset);
+    emit_add_imm(c, REG_TOP, -2 * VALUE_SIZE);
+    emit_mov_load(c, RAX, REG_TOP, PAYLOAD_OFFSET);
+    emit_mem(c, 0, true, OP_CMP, RAX, REG_TOP, VALUE_SIZE + PAYLOAD_OFFSET);
+    DaiJitCompiler_jump(c, CC_LE, target);
+    int done = emit_jump(c, CC_ALWAYS);
+
+    patch_jump(c, not_int);
+    DaiJitCompiler_guardType(c, REG_TOP, PEEK_OFFSET(1), DaiValueType_float, offset);
+    DaiJitCompiler_guardType(c, REG_TOP, PEEK_OFFSET(0), DaiValueType_float, offset);
+    emit_add_imm(c, REG_TOP, -2 * VALUE_SIZE);
+    emit_mem(c, PREFIX_F2, false, OP_MOVSD_LOAD, XMM0, REG_TOP, PAYLOAD_OFFSET);
+    emit_mem(c, PREFIX_66, false, OP_UCOMISD, XMM0, REG_TOP, VALUE_SIZE + PAYLOAD_OFFSET);
+    // 不大于（包括 NaN ）时跳转
+    DaiJitCompiler_jump(c, CC_BE, target);
+    patch_jump(c, done);
+}
+
+static void
+DaiJitCompiler_compileInstruction(DaiJitCompiler* c, int offset) {
+    DaiChunk* chunk = c->chunk;
+    uint8_t* ip     = chunk->code + offset;
+    switch (*ip) {
+        case DaiOpConstant: {
+            const DaiValue* constant = &chunk->constants.values[DaiChunk_readu16(chunk, offset + 1)];
+            emit_mov_imm64(c, RAX, (uint64_t)(uintptr_t)constant);
+            DaiJitCompiler_push(c, RAX, 0);
+            break;
+        }
+        case DaiOpAdd:
+        case DaiOpAddInt:
+        case DaiOpAddFloat: {
+            DaiJitCompiler_arithmetic(c, offset, OP_ADD, OP_ADDSD);
+            break;
+        }
+        case DaiOpSub:
+        case DaiOpSubInt:
+        case DaiOpSubFloat: {
+            DaiJitCompiler_arithmetic(c, offset, OP_SUB, OP_SUBSD);
+            break;
+        }
+        case DaiOpMul:
+        case DaiOpMulInt:
+        case DaiOpMulFloat: {
+            DaiJitCompiler_arithmetic(c, offset, OP_IMUL, OP_MULSD);
+            break;
+        }
+        case DaiOpDiv: {
+            DaiJitCompiler_divide(c, offset, false);
+            break;
+        }
+        case DaiOpMod: {
+            DaiJitCompiler_divide(c, offset, true);
+            break;
+        }
+        case DaiOpBinary: {
+            DaiJitCompiler_binary(c, offset, ip[1]);
+            break;
+        }
+        case DaiOpSubscript: {
+            emit_mov_reg(c, RDI, REG_TOP);
+            emit_call(c, DaiJit_subscriptGet);
+            emit_reg(c, 0, false, OP_TEST8, RAX, RAX);
+            DaiJitCompiler_bail(c, CC_E, offset);
+            emit_add_imm(c, REG_TOP, -VALUE_SIZE);
+            break;
+        }
+        case DaiOpSubscriptSet: {
+            emit_mov_reg(c, RDI, REG_TOP);
+            emit_mov_reg(c, RSI, REG_VM);
+            emit_call(c, DaiJit_subscriptSet);
+            emit_reg(c, 0, false, OP_TEST8, RAX, RAX);
+            DaiJitCompiler_bail(c, CC_E, offset);
+            emit_add_imm(c, REG_TOP, -3 * VALUE_SIZE);
+            break;
+        }
+        case DaiOpTrue: {
+            DaiJitCompiler_pushImmediate(c, DaiValueType_bool, 1);
+            break;
+        }
+        case DaiOpFalse: {
+            DaiJitCompiler_pushImmediate(c, DaiValueType_bool, 0);
+            break;
+        }
+        case DaiOpNil: {
+            DaiJitCompiler_pushImmediate(c, DaiValueType_nil, 0);
+            break;
+        }
+        case DaiOpUndefined: {
+            DaiJitCompiler_pushImmediate(c, DaiValueType_undefined, 0);
+            break;
+        }
+        case DaiOpEqual:
+        case DaiOpEqualInt:
+        case DaiOpEqualFloat: {
+            DaiJitCompiler_equal(c, offset, false);
+            break;
+        }
+        case DaiOpNotEqual: {
+            DaiJitCompiler_equal(c, offset, true);
+            break;
+        }
+        case DaiOpGreaterThan:
+        case DaiOpGreaterThanInt:
+        case DaiOpGreaterThanFloat: {
+            DaiJitCompiler_compare(c, offset, CC_G, CC_A);
+            break;
+        }
+        case DaiOpGreaterEqualThan: {
+            DaiJitCompiler_compare(c, offset, CC_GE, CC_AE);
+            break;
+        }
+        case DaiOpNot:
+        case DaiOpBang: {
+            emit_lea(c, RDI, REG_TOP, PEEK_OFFSET(0));
+            emit_call(c, DaiJit_truthy);
+            emit_byte(c, 0x34);   // xor al, 1
+            emit_byte(c, 0x01);
+            emit_byte(c, 0x0F);   // movzx eax, al
+            emit_byte(c, 0xB6);
+            emit_byte(c, 0xC0);
+            DaiJitCompiler_storeBool(c, 0);
+            break;
+        }
+        case DaiOpAndJump: {
+            DaiJitCompiler_branch(c, 0, false, offset + 3 + DaiChunk_readu16(chunk, offset + 1));
+            break;
+        }
+        case DaiOpOrJump: {
+            DaiJitCompiler_branch(c, 0, true, offset + 3 + DaiChunk_readu16(chunk, offset + 1));
+            break;
+        }
+        case DaiOpMinus: {
+            DaiJitCompiler_cmpType(c, REG_TOP, PEEK_OFFSET(0), DaiValueType_int);
+            int not_int = emit_jump(c, CC_NE);
+            emit_mem(c, 0, true, OP_GROUP3, 3, REG_TOP, PEEK_OFFSET(0) + PAYLOAD_OFFSET);
+            int done = emit_jump(c, CC_ALWAYS);
+            patch_jump(c, not_int);
+            DaiJitCompiler_guardType(c, REG_TOP, PEEK_OFFSET(0), DaiValueType_float, offset);
+            // 翻转符号位
+            emit_mov_imm64(c, RAX, UINT64_C(1) << 63);
+            emit_mem(c, 0, true, OP_XOR_STORE, RAX, REG_TOP, PEEK_OFFSET(0) + PAYLOAD_OFFSET);
+            patch_jump(c, done);
+            break;
+        }
+        case DaiOpBitwiseNot: {
+            DaiJitCompiler_guardType(c, REG_TOP, PEEK_OFFSET(0), DaiValueType_int, offset);
+            emit_mem(c, 0, true, OP_GROUP3, 2, REG_TOP, PEEK_OFFSET(0) + PAYLOAD_OFFSET);
+            break;
+        }
+        case DaiOpJumpIfFalse: {
+            emit_add_imm(c, REG_TOP, -VALUE_SIZE);
+            DaiJitCompiler_branch(c, -1, false, offset + 3 + DaiChunk_readu16(chunk, offset + 1));
+            break;
+        }
+        case DaiOpJump: {
+            DaiJitCompiler_jump(c, CC_ALWAYS, offset + 3 + DaiChunk_readu16(chunk, offset + 1));
+            break;
+        }
+        case DaiOpJumpBack: {
+            DaiJitCompiler_jump(c, CC_ALWAYS, offset + 3 - DaiChunk_readu16(chunk, offset + 1));
+            break;
+        }
+        case DaiOpIterNext: {
+            int32_t slot = ip[1] * VALUE_SIZE;
+            int target   = offset + 5 + DaiChunk_readu16(chunk, offset + 3);
+            DaiJitCompiler_saveState(c, offset + 5);
+            emit_mov_reg(c, RDI, REG_VM);
+            emit_lea(c, RSI, REG_SLOTS, slot);
+            emit_mov_imm64(c, RDX, ip[2]);
+            emit_call(c, DaiJit_iterNext);
+            emit_reg(c, 0, false, OP_TEST8, RAX, RAX);
+            DaiJitCompiler_jump(c, CC_E, target);
+            break;
+        }
+        case DaiOpRangeNext: {
+            DaiJitCompiler_rangeNext(c, offset);
+            break;
+        }
+        case DaiOpPop: {
+            emit_add_imm(c, REG_TOP, -VALUE_SIZE);
+            break;
+        }
+        case DaiOpPopN: {
+            emit_add_imm(c, REG_TOP, -ip[1] * VALUE_SIZE);
+            break;
+        }
+        case DaiOpSetGlobal:
+        case DaiOpDefineGlobal: {
+            DaiJitCompiler_pop(c, REG_GLOBALS, DaiChunk_readu16(chunk, offset + 1) * VALUE_SIZE);
+            break;
+        }
+        case DaiOpGetGlobal: {
+            DaiJitCompiler_push(c, REG_GLOBALS, DaiChunk_readu16(chunk, offset + 1) * VALUE_SIZE);
+            break;
+        }
+        case DaiOpSetLocal: {
+            DaiJitCompiler_pop(c, REG_SLOTS, ip[1] * VALUE_SIZE);
+            break;
+        }
+        case DaiOpGetLocal: {
+            DaiJitCompiler_push(c, REG_SLOTS, ip[1] * VALUE_SIZE);
+            break;
+        }
+        case DaiOpGetBuiltin: {
+            DaiJitCompiler_push(
+                c, REG_VM, offsetof(DaiVM, builtin_objects) + ip[1] * VALUE_SIZE);
+            break;
+        }
+        case DaiOpGetFree: {
+            emit_mov_load(c, RAX, REG_FRAME, offsetof(CallFrame, closure));
+            emit_mov_load(c, RAX, RAX, offsetof(DaiObjClosure, frees));
+            DaiJitCompiler_push(c, RAX, ip[1] * VALUE_SIZE);
+            break;
+        }
+        case DaiOpGetProperty:
+        case DaiOpGetSelfProperty:
+        case DaiOpSetProperty:
+        case DaiOpSetSelfProperty: {
+            DaiObjString* name =
+                AS_STRING(chunk->constants.values[DaiChunk_readu16(chunk, offset + 1)]);
+            DaiPropertyCache* cache =
+                &chunk->property_caches[DaiChunk_readu16(chunk, offset + 3)];
+            emit_mov_imm64(c, RDI, (uint64_t)(uintptr_t)cache);
+            emit_mov_imm64(c, RDX, (uint64_t)(uintptr_t)name);
+            switch (*ip) {
+                case DaiOpGetProperty: {
+                    emit_lea(c, RSI, REG_TOP, PEEK_OFFSET(0));
+                    emit_lea(c, RCX, REG_TOP, PEEK_OFFSET(0));
+                    emit_call(c, DaiJit_getField);
+                    break;
+                }
+                case DaiOpGetSelfProperty: {
+                    emit_mov_reg(c, RSI, REG_SLOTS);
+                    emit_mov_reg(c, RCX, REG_TOP);
+                    emit_call(c, DaiJit_getField);
+                    break;
+                }
+                case DaiOpSetProperty: {
+                    emit_lea(c, RSI, REG_TOP, PEEK_OFFSET(0));
+                    emit_lea(c, RCX, REG_TOP, PEEK_OFFSET(1));
+                    emit_mov_reg(c, R8, REG_VM);
+                    emit_call(c, DaiJit_setField);
+                    break;
+                }
+                default: {
+                    emit_mov_reg(c, RSI, REG_SLOTS);
+                    emit_lea(c, RCX, REG_TOP, PEEK_OFFSET(0));
+                    emit_mov_reg(c, R8, REG_VM);
+                    emit_call(c, DaiJit_setField);
+                    break;
+                }
+            }
+            // 没有命中实例属性，交给解释器的通用路径
+            emit_reg(c, 0, false, OP_TEST8, RAX, RAX);
+            DaiJitCompiler_bail(c, CC_E, offset);
+            switch (*ip) {
+                case DaiOpGetSelfProperty: emit_add_imm(c, REG_TOP, VALUE_SIZE); break;
+                case DaiOpSetProperty: emit_add_imm(c, REG_TOP, -2 * VALUE_SIZE); break;
+                case DaiOpSetSelfProperty: emit_add_imm(c, REG_TOP, -VALUE_SIZE); break;
+                default: break;
+            }
+            break;
+        }
+        case DaiOpAddLocalLocal: {
+            DaiJitCompiler_addLocalLocal(c, offset);
+            break;
+        }
+        case DaiOpAddLocalConstant: {
+            DaiJitCompiler_arithmeticLocalConstant(c, offset, OP_ADD_STORE);
+            break;
+        }
+        case DaiOpSubLocalConstant: {
+            DaiJitCompiler_arithmeticLocalConstant(c, offset, OP_SUB_STORE);
+            break;
+        }
+        case DaiOpGreaterThanJumpIfFalse: {
+            DaiJitCompiler_greaterThanJumpIfFalse(c, offset);
+            break;
+        }
+        default: {
+            // 调用、返回、创建对象等指令交给解释器
+            DaiJitCompiler_bail(c, CC_ALWAYS, offset);
+            break;
+        }
+    }
+}
+
+// #endregion
+
+bool
+DaiJit_compile(DaiChunk* chunk) {
+    DaiJitCompiler compiler;
+    DaiJitCompiler* c = &compiler;
+    c->chunk          = chunk;
+    c->count          = 0;
+    c->capacity       = 0;
+    c->code           = NULL;
+    c->labels         = ALLOCATE(int, chunk->count);
+    c->stubs          = ALLOCATE(int, chunk->count);
+    for (int i = 0; i < chunk->count; i++) {
+        c->labels[i] = -1;
+        c->stubs[i]  = -1;
+    }
+    DaiJitFixupArray_init(&c->jumps);
+    DaiJitFixupArray_init(&c->bails);
+
+    // 入口：DaiJitEntry(vm, frame, target)
+    // 保存被调用者保存寄存器，加载常驻状态，然后跳到 target
+    emit_byte(c, 0x55);   // push rbp
+    emit_mov_reg(c, RBP, RSP);
+    emit_byte(c, 0x53);   // push rbx
+    for (int reg = R12; reg <= R15; reg++) {
+        emit_byte(c, 0x41);   // push r12 ~ r15
+        emit_byte(c, 0x50 + (reg & 7));
+    }
+    emit_add_imm(c, RSP, -8);   // 调用 C 函数时栈需要 16 字节对齐
+    emit_mov_reg(c, REG_VM, RDI);
+    emit_mov_reg(c, REG_FRAME, RSI);
+    emit_mov_load(c, REG_TOP, REG_VM, offsetof(DaiVM, stack_top));
+    emit_mov_load(c, REG_SLOTS, REG_FRAME, offsetof(CallFrame, slots));
+    emit_mov_load(c, REG_GLOBALS, REG_FRAME, offsetof(CallFrame, globals));
+    emit_reg(c, 0, false, OP_GROUP5, 4, RDX);   // jmp rdx
+
+    // 出口：写回栈顶，恢复寄存器，返回 rax
+    c->exit = c->count;
+    emit_mov_store(c, REG_VM, offsetof(DaiVM, stack_top), REG_TOP);
+    emit_add_imm(c, RSP, 8);
+    for (int reg = R15; reg >= R12; reg--) {
+        emit_byte(c, 0x41);   // pop r15 ~ r12
+        emit_byte(c, 0x58 + (reg & 7));
+    }
+    emit_byte(c, 0x5B);   // pop rbx
+    emit_byte(c, 0x5D);   // pop rbp
+    emit_byte(c, 0xC3);   // ret
+
+    for (int offset = 0; offset < chunk->count;) {
+        c->labels[offset] = c->count;
+        DaiJitCompiler_compileInstruction(c, offset);
+        offset += dai_opcode_lookup(chunk->code[offset])->operand_bytes + 1;
+    }
+    // 函数最后总是 return ，不会执行到这里
+    emit_byte(c, 0x0F);   // ud2
+    emit_byte(c, 0x0B);
+
+    // 跳转目标不是指令的开头时（不应该发生），回到解释器执行
+    for (int i = 0; i < c->jumps.count; i++) {
+        DaiJitFixup fixup = c->jumps.fixups[i];
+        if (c->labels[fixup.target] >= 0) {
+            patch_jump_to(c, fixup.position, c->labels[fixup.target]);
+        } else {
+            DaiJitFixupArray_write(&c->bails, fixup.position, fixup.target);
+        }
+    }
+    // 退出桩：把 frame->ip 设置为要回到的指令，返回 NULL
+    for (int i = 0; i < c->bails.count; i++) {
+        DaiJitFixup fixup = c->bails.fixups[i];
+        if (c->stubs[fixup.target] < 0) {
+            c->stubs[fixup.target] = c->count;
+            emit_mov_imm64(c, RAX, (uint64_t)(uintptr_t)(chunk->code + fixup.target));
+            emit_mov_store(c, REG_FRAME, offsetof(CallFrame, ip), RAX);
+            emit_reg(c, 0, false, OP_XOR_STORE, RAX, RAX);
+            patch_jump_to(c, emit_jump(c, CC_ALWAYS), c->exit);
+        }
+        patch_jump_to(c, fixup.position, c->stubs[fixup.target]);
+    }
+
+    bool ok = false;
+    // 拷贝到可执行内存
+    void* memory =
+        mmap(NULL, c->count, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory != MAP_FAILED) {
+        memcpy(memory, c->code, c->count);
+        if (mprotect(memory, c->count, PROT_READ | PROT_EXEC) == 0) {
+            DaiJitCode* code  = ALLOCATE(DaiJitCode, 1);
+            code->code        = memory;
+            code->size        = c->count;
+            code->entry_count = chunk->count;
+            code->entries     = ALLOCATE(int32_t, chunk->count);
+            for (int i = 0; i < chunk->count; i++) {
+                code->entries[i] = c->labels[i];
+            }
+            chunk->jit_code = code;
+            ok              = true;
+        } else {
+            munmap(memory, c->count);
+        }
+    }
+
+    FREE_ARRAY(uint8_t, c->code, c->capacity);
+    FREE_ARRAY(int, c->labels, chunk->count);
+    FREE_ARRAY(int, c->stubs, chunk->count);
+    DaiJitFixupArray_reset(&c->jumps);
+    DaiJitFixupArray_reset(&c->bails);
+    return ok;
+}
+
+void
+DaiJit_free(DaiChunk* chunk) {
+    DaiJitCode* code = chunk->jit_code;
+    if (code == NULL) {
+        return;
+    }
+    munmap(code->code, code->size);
+    FREE_ARRAY(int32_t, code->entries, code->entry_count);
+    FREE(DaiJitCode, code);
+    chunk->jit_code = NULL;
+}
+
+DaiObjError*
+DaiJit_enter(DaiVM* vm, CallFrame* frame) {
+    DaiChunk* chunk = frame->chunk;
+    if (chunk->jit_code == NULL) {
+        if (chunk->jit_counter < 0 || ++chunk->jit_counter < vm->jit_threshold) {
+            return NULL;
+        }
+        if (!DaiJit_compile(chunk)) {
+            chunk->jit_counter = -1;
+            return NULL;
+        }
+    }
+    const DaiJitCode* code = chunk->jit_code;
+    int32_t entry          = code->entries[frame->ip - chunk->code];
+    if (entry < 0) {
+        return NULL;
+    }
+    return ((DaiJitEntry)code->code)(vm, frame, code->code + entry);
+}
+
+#else
+
+bool
+DaiJit_compile(__attribute__((unused)) DaiChunk* chunk) {
+    return false;
+}
+
+void
+DaiJit_free(__attribute__((unused)) DaiChunk* chunk) {}
+
+DaiObjError*
+DaiJit_enter(__attribute__((unused)) DaiVM* vm, __attribute__((unused)) CallFrame* frame) {
+    return NULL;
+}
+
+#endif
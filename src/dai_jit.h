@@ -0,0 +1,30 @@
+/*
+基线 JIT ：把包含热循环的字节码块（函数或者模块）逐条翻译成 x86-64 机器码（模板 JIT ）
+
+机器码和解释器共用同一个 CallFrame 和虚拟机栈，所以可以在任意一条指令的边界上互相切换：
+解释器在循环回跳时调用 DaiJit_enter ，从循环开头（frame->ip）开始执行机器码；
+机器码遇到不支持的指令（调用、返回、分配对象等）或者快速路径的类型检查失败时，
+把 frame->ip 写回成这条指令的位置后返回，由解释器接着执行
+*/
+#ifndef CBDAI_DAI_JIT_H
+#define CBDAI_DAI_JIT_H
+
+#include "dai_chunk.h"
+#include "dai_common.h"
+#include "dai_vm.h"
+
+// 字节码块的循环回跳次数超过这个值时编译成机器码
+#define DAI_JIT_THRESHOLD 1000
+
+// 把字节码块编译成机器码，成功后保存在 chunk->jit_code
+bool
+DaiJit_compile(DaiChunk* chunk);
+// 释放字节码块的机器码
+void
+DaiJit_free(DaiChunk* chunk);
+// 累计当前帧字节码块的热度，已经编译（或者刚好达到阈值编译成功）时从 frame->ip 开始执行机器码，
+// 返回时 frame->ip 和 vm->stack_top 已经更新，出错时返回错误对象
+DaiObjError*
+DaiJit_enter(DaiVM* vm, CallFrame* frame);
+
+#endif /* CBDAI_DAI_JIT_H */
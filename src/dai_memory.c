@@ -2,15 +2,22 @@
 内存操作封装，用于编译和运行时
 */
 
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "dai_chunk.h"
 #include "dai_common.h"
 #include "dai_memory.h"
 #include "dai_object.h"
 #include "dai_objects/dai_object_base.h"
+#include "dai_pool.h"
+#include "dai_threadpool.h"
+#include "dai_utils.h"
 #include "dai_value.h"
 
 #ifdef DEBUG_LOG_GC
@@ -18,23 +25,107 @@
 #    include <stdio.h>
 #endif
 
-#define GC_HEAP_GROW_FACTOR 2
+// 并行回收时每个线程的状态
+struct _DaiGCWorker {
+    // 私有的灰色栈，只有自己访问
+    int count;
+    int capacity;
+    DaiObj** stack;
+    // 分享出来的灰色对象，其他线程从这里窃取，用 lock 保护
+    pthread_mutex_t lock;
+    int sharedCount;
+    int sharedCapacity;
+    DaiObj** shared;
+    // 清除时释放的字节数，结束之后一起从 vm->bytesAllocated 中减去
+    size_t freedBytes;
+    // 释放时会调用外部代码的对象，交给当前线程释放
+    int deferredCount;
+    int deferredCapacity;
+    DaiObj** deferred;
+    // 标记时遇到的小切片字符串，标记结束之后合并到 vm->gcSlices
+    int sliceCount;
+    int sliceCapacity;
+    DaiObj** slices;
+};
 
-void*
-vm_reallocate(DaiVM* vm, void* pointer, size_t old_size, size_t new_size) {
-#ifdef DEBUG_LOG_GC
-    size_t allocated = vm->bytesAllocated;
-#endif
+// 当前线程正在参与并行回收时不为 NULL
+static _Thread_local DaiGCWorker* gc_worker = NULL;
+
+// 完整回收之后下一次回收的阈值，有堆上限时不超过上限，让普通的回收先于紧急回收发生
+static size_t
+nextThreshold(const DaiVM* vm) {
+    size_t next = (size_t)((double)vm->bytesAllocated * vm->gcGrowFactor);
+    if (vm->gcHeapLimit != 0 && next > vm->gcHeapLimit) {
+        next = vm->gcHeapLimit;
+    }
+    return next;
+}
+
+// 堆超过上限时先进行一次紧急的完整回收，仍然超过就标记内存不足，由虚拟机在安全点返回错误。
+// 这次分配还是会继续进行，所以上限是软性的，超出的量最多是安全点之间分配的内存
+static void
+checkHeapLimit(DaiVM* vm) {
+    if (vm->gcOutOfMemory || vm->state != VMState_running) {
+        return;
+    }
+    if (dai_gc_emergency_collect(vm)) {
+        vm->gcOutOfMemory = true;
+    }
+}
+
+// 记录虚拟机管理的内存变化，内存增加时按阈值触发 GC
+static void
+vm_account(DaiVM* vm, size_t old_size, size_t new_size) {
+    if (new_size < old_size && gc_worker != NULL) {
+        // 并行清除时多个线程同时释放内存，先各自记下来
+        gc_worker->freedBytes += old_size - new_size;
+        return;
+    }
     vm->bytesAllocated += new_size - old_size;
     if (new_size > old_size) {
+        vm->youngBytes += new_size - old_size;
+        if (DAI_UNLIKELY(vm->gcHeapLimit != 0 && vm->bytesAllocated > vm->gcHeapLimit)) {
+            checkHeapLimit(vm);
+        }
+        if (vm->gcDisabled) {
+            return;
+        }
         // 频繁地运行 GC ，方便找到内存管理 bug
+        // 先进行新生代回收，漏掉的写屏障会让还在使用的新生代对象被回收
 #ifdef DEBUG_STRESS_GC
-        collectGarbage(vm);
-#endif
-        if (vm->bytesAllocated > vm->nextGC) {
+        collectYoungGarbage(vm);
+        if (vm->gcIncremental) {
+            incrementalGCStep(vm);
+        } else {
             collectGarbage(vm);
         }
+#endif
+        if (vm->gcPhase != DaiGCPhase_idle) {
+            vm->gcStepBytes += new_size - old_size;
+            if (vm->gcStepBytes > vm->gcStepSize) {
+                incrementalGCStep(vm);
+            }
+        }
+        // 新生代满了先回收新生代，晋升之后老年代超过阈值再进行完整回收
+        if (vm->gcPhase != DaiGCPhase_mark && vm->youngBytes > vm->gcNurserySize) {
+            collectYoungGarbage(vm);
+            if (vm->gcPhase == DaiGCPhase_idle && vm->bytesAllocated > vm->nextGC) {
+                if (vm->gcIncremental) {
+                    incrementalGCStep(vm);
+                } else {
+                    collectGarbage(vm);
+                }
+            }
+        }
     }
+}
+
+void*
+vm_reallocate(DaiVM* vm, void* pointer, size_t old_size, size_t new_size) {
+#ifdef DEBUG_LOG_GC
+    size_t allocated = vm->bytesAllocated;
+#endif
+    vm_account(vm, old_size, new_size);
     void* newpointer = reallocate(pointer, old_size, new_size);
 #ifdef DEBUG_LOG_GC
     dai_loggc("reallocate %p->%p %zu->%zu\n", pointer, newpointer, old_size, new_size);
@@ -48,6 +139,52 @@ vm_reallocate(DaiVM* vm, void* pointer, size_t old_size, size_t new_size) {
     return newpointer;
 }
 
+void
+vm_account_nogc(DaiVM* vm, size_t old_size, size_t new_size) {
+    if (new_size < old_size && gc_worker != NULL) {
+        gc_worker->freedBytes += old_size - new_size;
+    } else {
+        vm->bytesAllocated += new_size - old_size;
+        if (new_size > old_size) {
+            vm->youngBytes += new_size - old_size;
+            if (vm->gcHeapLimit != 0 && vm->bytesAllocated > vm->gcHeapLimit) {
+                vm->gcOutOfMemory = true;
+            }
+        }
+    }
+}
+
+void*
+vm_reallocate_nogc(DaiVM* vm, void* pointer, size_t old_size, size_t new_size) {
+    vm_account_nogc(vm, old_size, new_size);
+    return reallocate(pointer, old_size, new_size);
+}
+
+void*
+vm_allocate_object(DaiVM* vm, size_t size) {
+    // 先记账（可能触发 GC ）再分配，回收释放的位置可以马上重新使用
+    vm_account(vm, 0, size);
+    return DaiPool_alloc(&vm->objectPool, size);
+}
+
+void
+vm_free_object_memory(DaiVM* vm, void* pointer, size_t size) {
+#ifdef DEBUG_LOG_GC
+    if (vm->bytesAllocated < size) {
+        dai_loggc("free object: %zu < %zu\n", vm->bytesAllocated, size);
+        fflush(stdout);
+        fflush(stderr);
+        abort();
+    }
+#endif
+    if (gc_worker != NULL) {
+        gc_worker->freedBytes += size;
+    } else {
+        vm->bytesAllocated -= size;
+    }
+    DaiPool_free(&vm->objectPool, pointer, size);
+}
+
 void*
 reallocate(void* pointer, size_t old_size, size_t new_size) {
     if (new_size == 0) {
@@ -78,19 +215,19 @@ vm_free_object(DaiVM* vm, DaiObj* object) {
         }
         case DaiObjType_cFunction: {
             free(((DaiObjCFunction*)object)->name);
-            VM_FREE(vm, DaiObjCFunction, object);
+            VM_FREE_OBJ(vm, DaiObjCFunction, object);
             break;
         }
         case DaiObjType_rangeIterator: {
-            VM_FREE(vm, DaiObjRangeIterator, object);
+            VM_FREE_OBJ(vm, DaiObjRangeIterator, object);
             break;
         }
         case DaiObjType_mapIterator: {
-            VM_FREE(vm, DaiObjMapIterator, object);
+            VM_FREE_OBJ(vm, DaiObjMapIterator, object);
             break;
         }
         case DaiObjType_arrayIterator: {
-            VM_FREE(vm, DaiObjArrayIterator, object);
+            VM_FREE_OBJ(vm, DaiObjArrayIterator, object);
             break;
         }
         case DaiObjType_map: {
@@ -99,17 +236,17 @@ vm_free_object(DaiVM* vm, DaiObj* object) {
             break;
         }
         case DaiObjType_error: {
-            VM_FREE(vm, DaiObjError, object);
+            VM_FREE_OBJ(vm, DaiObjError, object);
             break;
         }
         case DaiObjType_array: {
             DaiObjArray* array = (DaiObjArray*)object;
-            FREE_ARRAY(DaiValue, array->elements, array->capacity);
-            VM_FREE(vm, DaiObjArray, object);
+            VM_FREE_ARRAY(vm, DaiValue, array->elements, array->capacity);
+            VM_FREE_OBJ(vm, DaiObjArray, object);
             break;
         }
         case DaiObjType_boundMethod: {
-            VM_FREE(vm, DaiObjBoundMethod, object);
+            VM_FREE_OBJ(vm, DaiObjBoundMethod, object);
             break;
         }
         case DaiObjType_instance: {
@@ -126,7 +263,7 @@ vm_free_object(DaiVM* vm, DaiObj* object) {
             if (closure->frees != NULL) {
                 VM_FREE_ARRAY(vm, DaiValue, closure->frees, closure->free_count);
             }
-            VM_FREE(vm, DaiObjClosure, object);
+            VM_FREE_OBJ(vm, DaiObjClosure, object);
             break;
         }
         case DaiObjType_function: {
@@ -135,13 +272,17 @@ vm_free_object(DaiVM* vm, DaiObj* object) {
             if (function->defaults != NULL) {
                 VM_FREE_ARRAY(vm, DaiValue, function->defaults, function->default_count);
             }
-            VM_FREE(vm, DaiObjFunction, object);
+            VM_FREE_OBJ(vm, DaiObjFunction, object);
             break;
         }
         case DaiObjType_string: {
             DaiObjString* string = (DaiObjString*)object;
-            VM_FREE_ARRAY(vm, char, string->chars, string->length + 1);
-            VM_FREE(vm, DaiObjString, object);
+            DaiObjString_freeIndex(vm, string);
+            // 没有拼接过的绳索字符串没有字符数组，切片字符串的字符数组属于 parent
+            if (string->chars != NULL && string->parent == NULL) {
+                VM_FREE_ARRAY(vm, char, string->chars, string->length + 1);
+            }
+            VM_FREE_OBJ(vm, DaiObjString, object);
             break;
         }
         case DaiObjType_builtinFn: {
@@ -156,6 +297,12 @@ vm_free_object(DaiVM* vm, DaiObj* object) {
             DaiObjTuple_Free(vm, (DaiObjTuple*)object);
             break;
         }
+        case DaiObjType_boxedInt: {
+#ifdef DAI_NAN_BOXING
+            VM_FREE_OBJ(vm, DaiObjBoxedInt, object);
+#endif
+            break;
+        }
         case DaiObjType_count: {
             unreachable();
             break;
@@ -163,40 +310,109 @@ vm_free_object(DaiVM* vm, DaiObj* object) {
     }
 }
 
+static void
+free_pool_object(void* pointer, void* ctx) {
+    vm_free_object((DaiVM*)ctx, (DaiObj*)pointer);
+}
+
 void
 dai_free_objects(DaiVM* vm) {
-    DaiObj* obj = vm->objects;
-    while (obj != NULL) {
-        DaiObj* next = obj->next;
-        vm_free_object(vm, obj);
-        obj = next;
-    }
+    // 清空标记之后清除一遍，释放池里的所有对象
+    DaiPool_clearMarks(&vm->objectPool);
+    DaiPool_beginSweep(&vm->objectPool);
+    DaiPool_sweepStep(&vm->objectPool, SIZE_MAX, free_pool_object, vm);
+    free(vm->youngObjects);
+    vm->youngObjects  = NULL;
+    vm->youngCount    = 0;
+    vm->youngCapacity = 0;
     free(vm->grayStack);
     vm->grayStack = NULL;
+    free(vm->rememberedSet);
+    vm->rememberedSet = NULL;
+    free(vm->gcSlices);
+    vm->gcSlices     = NULL;
+    vm->gcSliceCount = 0;
+    free(vm->gcCompactSlices);
+    vm->gcCompactSlices = NULL;
+    vm->gcCompactCount  = 0;
+    DaiPool_reset(&vm->objectPool);
+    dai_gc_set_threads(vm, 1);
 }
 
 // #region 垃圾回收
 
 // https://readonly.link/books/https://raw.githubusercontent.com/GuoYaxiang/craftinginterpreters_zh/main/book.json/-/26.%E5%9E%83%E5%9C%BE%E5%9B%9E%E6%94%B6.md
+//
+// 对象都分配在内存池 vm->objectPool 中，标记位放在页的侧边位图里（见 dai_pool.h ），
+// 对象头里没有标记位和对象链表。清除时按页遍历位图，释放已分配但没有标记的对象。
+//
+// 分代回收：
+// 新分配的对象记录在新生代数组 youngObjects 中，在一次回收中存活下来的对象就晋升到了老年代。
+// 老年代对象在两次回收之间一直保持标记，所以新生代回收从根出发标记时会跳过老年代对象，
+// 只需要遍历和清除新生代数组。
+// 老年代对象引用的新生代对象通过写屏障记录（见 dai_gc_write_barrier ），
+// 新生代回收时把记忆集里的老年代对象也当作根。
+// 完整回收先清空所有的标记位，再按普通的标记-清除算法回收整个内存池。
+//
+// 增量回收（三色标记）：
+// 开启增量回收后，完整回收拆成很多小步，每分配 vm->gcStepSize 字节执行一步
+// （见 incrementalGCStep ）。
+// 开始时先做一次新生代回收，再清空标记位并标记根。
+// 标记阶段每一步从灰色栈中取出最多 vm->gcStepSize 个单位的工作，
+// 一个单位是遍历一个对象或者一个引用，大数组分多步遍历；写屏障保证黑色对象不会引用白色对象。
+// 这个阶段新分配的对象直接属于老年代，没有标记（白色），不进行新生代回收。
+// 栈和模块的全局变量不经过写屏障，灰色栈清空之后重新标记它们，没有新的灰色对象时标记完成。
+// 清除阶段每一步最多检查 vm->gcStepSize 个对象，等待清除的页不会分配新对象，
+// 所以这个阶段可以正常进行新生代回收。
+//
+// 并行回收：
+// 设置了多个回收线程时（见 DaiVM_setGCThreads ），完整回收的标记和清除由多个线程一起完成。
+// 当前线程先标记根，然后把灰色对象分给所有线程。每个线程有私有的灰色栈和一个分享栈，
+// 私有栈里的对象多了并且分享栈是空的时候，把一半放进分享栈；私有栈空了先拿回自己分享的，
+// 再从其他线程的分享栈窃取一半。标记位用原子操作设置，保证每个对象只被一个线程遍历。
+// 清除时先在当前线程清理字符串表，再把等待清除的页分成小段，线程轮流领取一段清除。
+// 释放时会调用外部代码的对象（ struct ）留给当前线程释放，大对象也在当前线程清除。
+// 新生代回收和增量回收的每一步都很小，总是只使用当前线程。
+//
+// 对象不会移动：字节码、JIT 生成的机器码和 C 代码里到处都直接持有对象指针，
+// 而且对象的默认哈希值就是它的地址
+
+static void
+pushGray(DaiVM* vm, DaiObj* object) {
+    if (vm->grayCapacity < vm->grayCount + 1) {
+        vm->grayCapacity = GROW_CAPACITY(vm->grayCapacity);
+        vm->grayStack    = (DaiObj**)realloc(vm->grayStack, sizeof(DaiObj*) * vm->grayCapacity);
+        assert(vm->grayStack != NULL);
+    }
+    vm->grayStack[vm->grayCount] = object;
+    vm->grayCount++;
+}
+
+static void
+workerPush(DaiGCWorker* worker, DaiObj* object);
+static void
+objectStackPush(DaiObj*** stack, int* count, int* capacity, DaiObj* object);
+
 void
 markObject(DaiVM* vm, DaiObj* object) {
     if (object == NULL) {
         return;
     }
-    if (object->is_marked) {
+    if (gc_worker != NULL) {
+        // 并行标记，多个线程可能同时标记同一个对象，只有设置成功的线程遍历它
+        if (dai_gc_try_mark(object)) {
+            workerPush(gc_worker, object);
+        }
+        return;
+    }
+    if (dai_gc_is_marked(object)) {
         return;
     }
 #ifdef DEBUG_LOG_GC
     dai_loggc("%p mark %s\n", (void*)object, dai_object_ts(OBJ_VAL(object)));
 #endif
-    object->is_marked = true;
-    if (vm->grayCapacity < vm->grayCount + 1) {
-        vm->grayCapacity = GROW_CAPACITY(vm->grayCapacity);
-        vm->grayStack    = (DaiObj**)realloc(vm->grayStack, sizeof(DaiObj*) * vm->grayCapacity);
-        assert(vm->grayStack != NULL);
-    }
-    vm->grayStack[vm->grayCount] = object;
-    vm->grayCount++;
+    dai_gc_set_marked(object);
+    pushGray(vm, object);
 }
 
 void
@@ -204,56 +420,137 @@ markValue(DaiVM* vm, DaiValue value) {
     if (IS_OBJ(value)) {
         markObject(vm, AS_OBJ(value));
     }
+#ifdef DAI_NAN_BOXING
+    else if (IS_BOXED_INTEGER(value)) {
+        markObject(vm, AS_OBJ(value));
+    }
+#endif
 }
 
-static void
+static size_t
 markArray(DaiVM* vm, DaiValueArray* array) {
     for (int i = 0; i < array->count; i++) {
         markValue(vm, array->values[i]);
     }
+    return array->count;
 }
 
-static void
+static size_t
 markTable(DaiVM* vm, DaiTable* table) {
     for (int i = 0; i < table->capacity; i++) {
         Entry* entry = &table->entries[i];
         markObject(vm, (DaiObj*)entry->key);
         markValue(vm, entry->value);
     }
+    return table->capacity;
+}
+
+// #region 切片字符串
+
+// 切片比 parent 小很多时先不标记 parent ，记下来等标记结束之后再处理
+static void
+markSlice(DaiVM* vm, DaiObjString* slice) {
+    DaiObjString* parent = slice->parent;
+    if ((size_t)slice->length * DAI_STRING_SLICE_COMPACT_RATIO >= (size_t)parent->length) {
+        markObject(vm, (DaiObj*)parent);
+        return;
+    }
+    if (gc_worker != NULL) {
+        objectStackPush(
+            &gc_worker->slices, &gc_worker->sliceCount, &gc_worker->sliceCapacity, (DaiObj*)slice);
+    } else {
+        objectStackPush(&vm->gcSlices, &vm->gcSliceCount, &vm->gcSliceCapacity, (DaiObj*)slice);
+    }
+}
+
+// 标记结束、清除之前调用。
+// parent 没有被其他对象标记，说明只有小切片引用它，这些切片等到安全点再复制自己的内容。
+// 这一次回收先保留 parent ，安全点之前 C 代码可能还拿着指向它的字符数组的指针
+static void
+markSliceParents(DaiVM* vm) {
+    for (int i = 0; i < vm->gcThreadCount && vm->gcWorkers != NULL; i++) {
+        DaiGCWorker* worker = &vm->gcWorkers[i];
+        for (int j = 0; j < worker->sliceCount; j++) {
+            objectStackPush(
+                &vm->gcSlices, &vm->gcSliceCount, &vm->gcSliceCapacity, worker->slices[j]);
+        }
+        worker->sliceCount = 0;
+    }
+    int start = vm->gcCompactCount;
+    for (int i = 0; i < vm->gcSliceCount; i++) {
+        DaiObjString* slice = (DaiObjString*)vm->gcSlices[i];
+        // parent 为 NULL 说明已经在安全点复制过了
+        if (slice->parent != NULL && !dai_gc_is_marked((DaiObj*)slice->parent)) {
+            objectStackPush(&vm->gcCompactSlices,
+                            &vm->gcCompactCount,
+                            &vm->gcCompactCapacity,
+                            (DaiObj*)slice);
+        }
+    }
+    vm->gcSliceCount = 0;
+    // 同一个 parent 的切片都要复制，全部检查完之后再标记 parent 。
+    // parent 不引用其他对象，不需要放进灰色栈
+    for (int i = start; i < vm->gcCompactCount; i++) {
+        dai_gc_set_marked((DaiObj*)((DaiObjString*)vm->gcCompactSlices[i])->parent);
+    }
 }
 
-// 标记 object 引用的其他对象
+// 等待复制的切片和它们的 parent 在复制之前都要保持存活
 static void
+markCompactSlices(DaiVM* vm) {
+    for (int i = 0; i < vm->gcCompactCount; i++) {
+        DaiObjString* slice = (DaiObjString*)vm->gcCompactSlices[i];
+        markObject(vm, (DaiObj*)slice->parent);
+        markObject(vm, (DaiObj*)slice);
+    }
+}
+
+void
+dai_gc_compact_slices(DaiVM* vm) {
+    for (int i = 0; i < vm->gcCompactCount; i++) {
+        DaiObjString* slice = (DaiObjString*)vm->gcCompactSlices[i];
+        if (slice->parent != NULL) {
+            DaiObjString_unslice(vm, slice);
+        }
+    }
+    vm->gcCompactCount = 0;
+}
+
+// #endregion
+
+// 标记 object 引用的其他对象，返回工作量（遍历的引用数量加一）
+static size_t
 blackenObject(DaiVM* vm, DaiObj* object) {
 #ifdef DEBUG_LOG_GC
     dai_loggc("%p blacken %s\n", (void*)object, dai_object_ts(OBJ_VAL(object)));
 #endif
+    size_t work = 1;
     switch (object->type) {
         case DaiObjType_struct: {
             DaiObjStruct* obj = (DaiObjStruct*)object;
             for (size_t i = 0; i < obj->ref_count; i++) {
                 markValue(vm, obj->refs[i]);
             }
+            work += obj->ref_count;
             break;
         }
         case DaiObjType_tuple: {
             DaiObjTuple* tuple = (DaiObjTuple*)object;
-            markArray(vm, &tuple->values);
+            work += markArray(vm, &tuple->values);
             break;
         }
         case DaiObjType_module: {
             DaiObjModule* module = (DaiObjModule*)object;
             markObject(vm, (DaiObj*)module->name);
             markObject(vm, (DaiObj*)module->filename);
-            markArray(vm, &module->chunk.constants);
+            work += markArray(vm, &module->chunk.constants);
             DaiObjString* key;
             DaiValue value;
             size_t i = 0;
             while (DaiObjModule_iter(module, &i, &key, &value)) {
                 markObject(vm, (DaiObj*)key);
-                if (IS_OBJ(value)) {
-                    markObject(vm, AS_OBJ(value));
-                }
+                markValue(vm, value);
+                work++;
             }
             break;
         }
@@ -272,22 +569,18 @@ blackenObject(DaiVM* vm, DaiObj* object) {
             DaiValue key, value;
             size_t i = 0;
             while (DaiObjMap_iter(map, &i, &key, &value)) {
-                if (IS_OBJ(key)) {
-                    markObject(vm, AS_OBJ(key));
-                }
-                if (IS_OBJ(value)) {
-                    markObject(vm, AS_OBJ(value));
-                }
+                markValue(vm, key);
+                markValue(vm, value);
+                work++;
             }
             break;
         }
         case DaiObjType_array: {
             const DaiObjArray* array = (DaiObjArray*)object;
             for (int i = 0; i < array->length; i++) {
-                if (IS_OBJ(array->elements[i])) {
-                    markObject(vm, AS_OBJ(array->elements[i]));
-                }
+                markValue(vm, array->elements[i]);
             }
+            work += array->length;
             break;
         }
         case DaiObjType_boundMethod: {
@@ -302,6 +595,7 @@ blackenObject(DaiVM* vm, DaiObj* object) {
             for (int i = 0; i < instance->field_count; i++) {
                 markValue(vm, instance->fields[i]);
             }
+            work += instance->field_count;
             break;
         }
         case DaiObjType_class: {
@@ -314,6 +608,7 @@ blackenObject(DaiVM* vm, DaiObj* object) {
                     DaiFieldDesc* prop = res;
                     markObject(vm, (DaiObj*)prop->name);
                     markValue(vm, prop->value);
+                    work++;
                 }
             }
             {
@@ -323,10 +618,11 @@ blackenObject(DaiVM* vm, DaiObj* object) {
                     DaiFieldDesc* prop = res;
                     markObject(vm, (DaiObj*)prop->name);
                     markValue(vm, prop->value);
+                    work++;
                 }
             }
-            markTable(vm, &klass->class_methods);
-            markTable(vm, &klass->methods);
+            work += markTable(vm, &klass->class_methods);
+            work += markTable(vm, &klass->methods);
             markObject(vm, (DaiObj*)klass->define_field_names);
 
             markObject(vm, (DaiObj*)klass->parent);
@@ -338,26 +634,42 @@ blackenObject(DaiVM* vm, DaiObj* object) {
             for (int i = 0; i < closure->free_count; ++i) {
                 markValue(vm, closure->frees[i]);
             }
+            work += closure->free_count;
             break;
         }
         case DaiObjType_function: {
             DaiObjFunction* function = (DaiObjFunction*)object;
             markObject(vm, (DaiObj*)function->name);
-            markArray(vm, &(function->chunk.constants));
+            work += markArray(vm, &(function->chunk.constants));
             for (int i = 0; i < function->default_count; i++) {
                 markValue(vm, function->defaults[i]);
             }
+            work += function->default_count;
+            break;
+        }
+        case DaiObjType_string: {
+            // 绳索字符串引用拼接的两个字符串，切片字符串引用 parent
+            DaiObjString* string = (DaiObjString*)object;
+            if (string->chars == NULL) {
+                markObject(vm, (DaiObj*)string->left);
+                markObject(vm, (DaiObj*)string->right);
+                work += 2;
+            } else if (string->parent != NULL) {
+                markSlice(vm, string);
+                work++;
+            }
             break;
         }
         case DaiObjType_cFunction:
         case DaiObjType_rangeIterator:
         case DaiObjType_error:
         case DaiObjType_builtinFn:
-        case DaiObjType_string:
+        case DaiObjType_boxedInt:
         case DaiObjType_count: {
             break;
         }
     }
+    return work;
 }
 
 static void
@@ -383,6 +695,86 @@ markRoots(DaiVM* vm) {
     }
     // 标记模块表
     markObject(vm, (DaiObj*)vm->modules);
+    markCompactSlices(vm);
+}
+
+static void
+rememberObject(DaiVM* vm, DaiObj* object) {
+    object->is_remembered = true;
+    if (object->type == DaiObjType_array) {
+        // 不知道写入了哪些元素，遍历整个数组
+        DaiObjArray* array = (DaiObjArray*)object;
+        array->dirty_start = 0;
+        array->dirty_end   = INT_MAX;
+    }
+    if (vm->rememberedCapacity < vm->rememberedCount + 1) {
+        vm->rememberedCapacity = GROW_CAPACITY(vm->rememberedCapacity);
+        vm->rememberedSet =
+            (DaiObj**)realloc(vm->rememberedSet, sizeof(DaiObj*) * vm->rememberedCapacity);
+        assert(vm->rememberedSet != NULL);
+    }
+    vm->rememberedSet[vm->rememberedCount] = object;
+    vm->rememberedCount++;
+}
+
+void
+dai_gc_write_barrier_slow(DaiVM* vm, DaiObj* owner, DaiObj* object) {
+    if (vm->gcPhase == DaiGCPhase_mark) {
+        // 增量标记阶段，已经标记的对象引用了未标记的对象，把它标成灰色
+        markObject(vm, object);
+    } else {
+        rememberObject(vm, owner);
+    }
+}
+
+void
+dai_gc_write_barrier_all_slow(DaiVM* vm, DaiObj* owner) {
+    if (vm->gcPhase == DaiGCPhase_mark) {
+        // 增量标记阶段，已经标记的对象重新放回灰色栈，之后再遍历一次
+        pushGray(vm, owner);
+    } else {
+        rememberObject(vm, owner);
+    }
+}
+
+static void
+clearRememberedSet(DaiVM* vm) {
+    for (int i = 0; i < vm->rememberedCount; i++) {
+        vm->rememberedSet[i]->is_remembered = false;
+    }
+    vm->rememberedCount = 0;
+}
+
+// 解释器和 JIT 生成的机器码直接写模块的全局变量，不经过写屏障，需要遍历所有的模块
+static size_t
+markModules(DaiVM* vm) {
+    size_t work = 0;
+    DaiValue key, value;
+    size_t i = 0;
+    while (DaiObjMap_iter(vm->modules, &i, &key, &value)) {
+        work += blackenObject(vm, AS_OBJ(value));
+    }
+    return work;
+}
+
+// 新生代回收时标记记忆集中的老年代对象引用的对象
+static void
+markRememberedSet(DaiVM* vm) {
+    for (int i = 0; i < vm->rememberedCount; i++) {
+        DaiObj* object = vm->rememberedSet[i];
+        if (object->type == DaiObjType_array) {
+            // 数组只遍历写屏障记录的范围，追加元素的大数组不用每次都完整遍历
+            DaiObjArray* array = (DaiObjArray*)object;
+            int end = array->dirty_end < array->length ? array->dirty_end : array->length;
+            for (int j = array->dirty_start; j < end; j++) {
+                markValue(vm, array->elements[j]);
+            }
+        } else {
+            blackenObject(vm, object);
+        }
+    }
+    clearRememberedSet(vm);
+    markModules(vm);
 }
 
 static void
@@ -394,28 +786,485 @@ traceReferences(DaiVM* vm) {
     }
 }
 
+void
+dai_gc_push_young(DaiVM* vm, DaiObj* object) {
+    if (vm->youngCapacity < vm->youngCount + 1) {
+        vm->youngCapacity = GROW_CAPACITY(vm->youngCapacity);
+        vm->youngObjects =
+            (DaiObj**)realloc(vm->youngObjects, sizeof(DaiObj*) * vm->youngCapacity);
+        assert(vm->youngObjects != NULL);
+    }
+    vm->youngObjects[vm->youngCount] = object;
+    vm->youngCount++;
+}
+
+// 清除新生代中没有被标记的对象，存活的对象保持标记，晋升到老年代
+static void
+sweepYoung(DaiVM* vm) {
+    for (int i = 0; i < vm->youngCount; i++) {
+        DaiObj* object = vm->youngObjects[i];
+        if (!dai_gc_is_marked(object)) {
+            vm_free_object(vm, object);
+        }
+    }
+    vm->youngCount = 0;
+    vm->youngBytes = 0;
+}
+
+// 清除内存池时释放没有标记的对象，字符串表不再一次性清理，清除字符串时顺便从表里删除
+static void
+sweepObject(void* pointer, void* ctx) {
+    DaiVM* vm      = ctx;
+    DaiObj* object = pointer;
+    if (object->type == DaiObjType_string && DaiObjString_isInterned((DaiObjString*)object)) {
+        DaiTable_delete(&vm->strings, (DaiObjString*)object);
+    }
+    vm_free_object(vm, object);
+}
+
+// #region 统计
+
+// 记录一次停顿，start 是停顿开始的时间
+static void
+recordPause(DaiVM* vm, uint64_t start) {
+    uint64_t ns       = dai_monotonic_ns() - start;
+    DaiGCStats* stats = &vm->gcStats;
+    stats->pauses++;
+    stats->pauseTotalNs += ns;
+    if (ns > stats->pauseMaxNs) {
+        stats->pauseMaxNs = ns;
+    }
+    uint64_t us = ns / 1000;
+    int bucket  = us == 0 ? 0 : 64 - __builtin_clzll(us);
+    if (bucket >= DAI_GC_PAUSE_BUCKETS) {
+        bucket = DAI_GC_PAUSE_BUCKETS - 1;
+    }
+    stats->pauseHistogram[bucket]++;
+}
+
+// 记录完成的一次回收释放的字节数
+static void
+recordFreed(DaiVM* vm, size_t freed) {
+    vm->gcStats.bytesFreed += freed;
+    vm->gcStats.lastBytesFreed = freed;
+}
+
+typedef struct {
+    DaiPool* pool;
+    DaiHeapTypeStats* stats;
+} HeapStatsContext;
+
+static void
+countHeapObject(void* pointer, void* ctx) {
+    HeapStatsContext* context = ctx;
+    DaiObj* object            = pointer;
+    size_t size;
+    if (object->space == DaiObjSpace_large) {
+        size = DaiPool_largeOf(object)->size;
+    } else {
+        size = context->pool->classes[DaiPool_pageOf(object)->class_index].slot_size;
+    }
+    context->stats[object->type].count++;
+    context->stats[object->type].bytes += size;
+}
+
+void
+dai_gc_heap_stats(DaiVM* vm, DaiHeapTypeStats stats[DaiObjType_count]) {
+    for (int i = 0; i < DaiObjType_count; i++) {
+        stats[i].count = 0;
+        stats[i].bytes = 0;
+    }
+    HeapStatsContext context = {.pool = &vm->objectPool, .stats = stats};
+    DaiPool_iter(&vm->objectPool, countHeapObject, &context);
+}
+
+// #endregion
+
 static void
-sweep(DaiVM* vm) {
-    DaiObj* previous = NULL;
-    DaiObj* object   = vm->objects;
-    while (object != NULL) {
-        if (object->is_marked) {
-            object->is_marked = false;
-            previous          = object;
-            object            = object->next;
+youngCollection(DaiVM* vm) {
+#ifdef DEBUG_LOG_GC
+    dai_loggc("-- young gc begin\n");
+#endif
+    size_t before = vm->bytesAllocated;
+    markRoots(vm);
+    markRememberedSet(vm);
+    traceReferences(vm);
+    markSliceParents(vm);
+    tableRemoveWhite(&vm->strings);
+    sweepYoung(vm);
+    vm->gcStats.youngCollections++;
+    recordFreed(vm, before - vm->bytesAllocated);
+
+#ifdef DEBUG_LOG_GC
+    dai_loggc("-- young gc end\n");
+    dai_loggc("   collected %zu bytes (from %zu to %zu) next at %zu\n",
+              before - vm->bytesAllocated,
+              before,
+              vm->bytesAllocated,
+              vm->nextGC);
+#endif
+}
+
+void
+collectYoungGarbage(DaiVM* vm) {
+    // 增量标记阶段没有新生代
+    if (vm->state != VMState_running || vm->gcPhase == DaiGCPhase_mark) {
+        return;
+    }
+    uint64_t start = dai_monotonic_ns();
+    youngCollection(vm);
+    recordPause(vm, start);
+}
+
+// #region 增量回收
+
+static void
+startIncrementalGC(DaiVM* vm) {
+#ifdef DEBUG_LOG_GC
+    dai_loggc("-- incremental gc begin\n");
+#endif
+    // 先清空新生代，标记阶段新分配的对象都放进老年代
+    youngCollection(vm);
+    clearRememberedSet(vm);
+    vm->gcCycleFreed = 0;
+    DaiPool_clearMarks(&vm->objectPool);
+    vm->gcPhase = DaiGCPhase_mark;
+    markRoots(vm);
+}
+
+// 大数组分多步遍历，从后往前遍历，删除元素时还没遍历的元素不会移动到已经遍历过的位置。
+// 其他改变元素位置的操作（ reverse 和 sort ）都经过写屏障
+static size_t
+scanArrayStep(DaiVM* vm, size_t quantum) {
+    DaiObjArray* array = vm->gcScanArray;
+    if (vm->gcScanIndex > array->length) {
+        vm->gcScanIndex = array->length;
+    }
+    size_t work = 0;
+    while (vm->gcScanIndex > 0 && work < quantum) {
+        vm->gcScanIndex--;
+        markValue(vm, array->elements[vm->gcScanIndex]);
+        work++;
+    }
+    if (vm->gcScanIndex == 0) {
+        vm->gcScanArray = NULL;
+    }
+    return work;
+}
+
+static void
+markStep(DaiVM* vm, size_t quantum) {
+    size_t work = 0;
+    while (work < quantum) {
+        if (vm->gcScanArray != NULL) {
+            work += scanArrayStep(vm, quantum - work);
+            continue;
+        }
+        if (vm->grayCount == 0) {
+            // 栈和模块的全局变量不经过写屏障，重新标记一遍，没有新的灰色对象时标记完成
+            markRoots(vm);
+            work += markModules(vm);
+            if (vm->grayCount == 0) {
+                markSliceParents(vm);
+                vm->gcPhase    = DaiGCPhase_sweep;
+                vm->youngBytes = 0;
+                DaiPool_beginSweep(&vm->objectPool);
+#ifdef DEBUG_LOG_GC
+                dai_loggc("-- incremental gc mark end\n");
+#endif
+                return;
+            }
+        }
+        vm->grayCount--;
+        DaiObj* object = vm->grayStack[vm->grayCount];
+        if (object->type == DaiObjType_array && (size_t)((DaiObjArray*)object)->length > quantum) {
+            vm->gcScanArray = (DaiObjArray*)object;
+            vm->gcScanIndex = vm->gcScanArray->length;
+            work++;
         } else {
-            DaiObj* unreached = object;
-            object            = object->next;
-            if (previous != NULL) {
-                previous->next = object;
-            } else {
-                vm->objects = object;
+            work += blackenObject(vm, object);
+        }
+    }
+}
+
+static void
+sweepStep(DaiVM* vm, size_t quantum) {
+    size_t before = vm->bytesAllocated;
+    bool finished = DaiPool_sweepStep(&vm->objectPool, quantum, sweepObject, vm);
+    vm->gcCycleFreed += before - vm->bytesAllocated;
+    if (finished) {
+        vm->gcStats.fullCollections++;
+        recordFreed(vm, vm->gcCycleFreed);
+        vm->gcPhase = DaiGCPhase_idle;
+        vm->nextGC  = nextThreshold(vm);
+#ifdef DEBUG_LOG_GC
+        dai_loggc("-- incremental gc end, next at %zu\n", vm->nextGC);
+#endif
+    }
+}
+
+// 把进行中的增量回收一次性做完
+static void
+finishIncrementalGC(DaiVM* vm) {
+    if (vm->gcPhase == DaiGCPhase_mark) {
+        markStep(vm, SIZE_MAX);
+    }
+    if (vm->gcPhase == DaiGCPhase_sweep) {
+        sweepStep(vm, SIZE_MAX);
+    }
+}
+
+void
+incrementalGCStep(DaiVM* vm) {
+    if (vm->state != VMState_running) {
+        return;
+    }
+    uint64_t start  = dai_monotonic_ns();
+    vm->gcStepBytes = 0;
+    switch (vm->gcPhase) {
+        case DaiGCPhase_idle: startIncrementalGC(vm); break;
+        case DaiGCPhase_mark: markStep(vm, vm->gcStepSize); break;
+        case DaiGCPhase_sweep: sweepStep(vm, vm->gcStepSize); break;
+    }
+    vm->gcStats.incrementalSteps++;
+    recordPause(vm, start);
+}
+
+// #endregion
+
+// #region 并行回收
+
+// 私有栈里的对象超过这个数量时才分享
+#define GC_SHARE_THRESHOLD 64
+// 清除时每次领取的页数
+#define GC_SWEEP_CHUNK 8
+
+static void
+objectStackPush(DaiObj*** stack, int* count, int* capacity, DaiObj* object) {
+    if (*capacity < *count + 1) {
+        *capacity = GROW_CAPACITY(*capacity);
+        *stack    = (DaiObj**)realloc(*stack, sizeof(DaiObj*) * *capacity);
+        assert(*stack != NULL);
+    }
+    (*stack)[*count] = object;
+    (*count)++;
+}
+
+// 把私有栈顶部的一半放进分享栈
+static void
+shareWork(DaiGCWorker* worker) {
+    pthread_mutex_lock(&worker->lock);
+    int half = worker->count / 2;
+    if (worker->sharedCapacity < worker->sharedCount + half) {
+        worker->sharedCapacity = worker->sharedCount + half;
+        worker->shared =
+            (DaiObj**)realloc(worker->shared, sizeof(DaiObj*) * worker->sharedCapacity);
+        assert(worker->shared != NULL);
+    }
+    worker->count -= half;
+    memcpy(worker->shared + worker->sharedCount, worker->stack + worker->count, sizeof(DaiObj*) * half);
+    __atomic_store_n(&worker->sharedCount, worker->sharedCount + half, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&worker->lock);
+}
+
+static void
+workerPush(DaiGCWorker* worker, DaiObj* object) {
+    objectStackPush(&worker->stack, &worker->count, &worker->capacity, object);
+    if (worker->count > GC_SHARE_THRESHOLD &&
+        __atomic_load_n(&worker->sharedCount, __ATOMIC_RELAXED) == 0) {
+        shareWork(worker);
+    }
+}
+
+// 从 victim 的分享栈中拿走一半（自己的全部拿走）放进 thief 的私有栈，拿到了返回 true
+static bool
+takeWork(DaiGCWorker* thief, DaiGCWorker* victim) {
+    if (__atomic_load_n(&victim->sharedCount, __ATOMIC_RELAXED) == 0) {
+        return false;
+    }
+    pthread_mutex_lock(&victim->lock);
+    int take = victim == thief ? victim->sharedCount : (victim->sharedCount + 1) / 2;
+    for (int i = 0; i < take; i++) {
+        objectStackPush(&thief->stack,
+                        &thief->count,
+                        &thief->capacity,
+                        victim->shared[victim->sharedCount - take + i]);
+    }
+    __atomic_store_n(&victim->sharedCount, victim->sharedCount - take, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&victim->lock);
+    return take > 0;
+}
+
+static bool
+findWork(DaiVM* vm, int index) {
+    DaiGCWorker* self = &vm->gcWorkers[index];
+    if (takeWork(self, self)) {
+        return true;
+    }
+    for (int i = 1; i < vm->gcThreadCount; i++) {
+        if (takeWork(self, &vm->gcWorkers[(index + i) % vm->gcThreadCount])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool
+hasSharedWork(DaiVM* vm) {
+    for (int i = 0; i < vm->gcThreadCount; i++) {
+        if (__atomic_load_n(&vm->gcWorkers[i].sharedCount, __ATOMIC_RELAXED) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+typedef struct {
+    DaiVM* vm;
+    int idle;   // 没有工作的线程数量，等于线程数时标记完成
+} ParallelMarkTask;
+
+// 空闲的线程只有在私有栈和分享栈都空了之后才会计入 idle ，而分享栈只有它自己会放入，
+// 所以所有线程都空闲时不会再有新的灰色对象
+static void
+parallelMarkWorker(void* ctx, int index) {
+    ParallelMarkTask* task = ctx;
+    DaiVM* vm              = task->vm;
+    DaiGCWorker* self      = &vm->gcWorkers[index];
+    gc_worker              = self;
+    while (true) {
+        while (self->count > 0) {
+            self->count--;
+            blackenObject(vm, self->stack[self->count]);
+        }
+        if (findWork(vm, index)) {
+            continue;
+        }
+        __atomic_add_fetch(&task->idle, 1, __ATOMIC_SEQ_CST);
+        bool done = false;
+        while (true) {
+            if (__atomic_load_n(&task->idle, __ATOMIC_SEQ_CST) == vm->gcThreadCount) {
+                done = true;
+                break;
             }
-            vm_free_object(vm, unreached);
+            if (hasSharedWork(vm)) {
+                __atomic_sub_fetch(&task->idle, 1, __ATOMIC_SEQ_CST);
+                break;
+            }
+            sched_yield();
+        }
+        if (done) {
+            break;
         }
     }
+    gc_worker = NULL;
+}
+
+// 标记根之后调用，把灰色栈里的对象分给所有线程，并行标记到结束
+static void
+parallelTraceReferences(DaiVM* vm) {
+    for (int i = 0; i < vm->grayCount; i++) {
+        DaiGCWorker* worker = &vm->gcWorkers[i % vm->gcThreadCount];
+        objectStackPush(&worker->stack, &worker->count, &worker->capacity, vm->grayStack[i]);
+    }
+    vm->grayCount          = 0;
+    ParallelMarkTask task = {.vm = vm, .idle = 0};
+    DaiThreadPool_run(vm->gcThreadPool, parallelMarkWorker, &task);
+}
+
+typedef struct {
+    DaiVM* vm;
+    DaiPoolPage** pages;
+    size_t count;
+    size_t next;   // 下一个要领取的页
+} ParallelSweepTask;
+
+static void
+parallelSweepObject(void* pointer, void* ctx) {
+    DaiGCWorker* worker = gc_worker;
+    DaiObj* object      = pointer;
+    if (object->type == DaiObjType_struct) {
+        objectStackPush(
+            &worker->deferred, &worker->deferredCount, &worker->deferredCapacity, object);
+        return;
+    }
+    vm_free_object((DaiVM*)ctx, object);
+}
+
+static void
+parallelSweepWorker(void* ctx, int index) {
+    ParallelSweepTask* task = ctx;
+    gc_worker               = &task->vm->gcWorkers[index];
+    while (true) {
+        size_t start = __atomic_fetch_add(&task->next, GC_SWEEP_CHUNK, __ATOMIC_RELAXED);
+        if (start >= task->count) {
+            break;
+        }
+        size_t end = start + GC_SWEEP_CHUNK < task->count ? start + GC_SWEEP_CHUNK : task->count;
+        for (size_t i = start; i < end; i++) {
+            DaiPool_sweepPage(task->pages[i], parallelSweepObject, task->vm);
+        }
+    }
+    gc_worker = NULL;
+}
+
+static void
+parallelSweep(DaiVM* vm) {
+    // 先清理字符串表，线程释放字符串时就不用修改它
+    tableRemoveWhite(&vm->strings);
+    DaiPool_beginSweep(&vm->objectPool);
+    ParallelSweepTask task = {.vm = vm, .next = 0};
+    task.pages             = DaiPool_takeUnswept(&vm->objectPool, &task.count);
+    DaiThreadPool_run(vm->gcThreadPool, parallelSweepWorker, &task);
+    for (int i = 0; i < vm->gcThreadCount; i++) {
+        DaiGCWorker* worker = &vm->gcWorkers[i];
+        vm->bytesAllocated -= worker->freedBytes;
+        worker->freedBytes = 0;
+        for (int j = 0; j < worker->deferredCount; j++) {
+            vm_free_object(vm, worker->deferred[j]);
+        }
+        worker->deferredCount = 0;
+    }
+    DaiPool_placePages(&vm->objectPool, task.pages, task.count);
+    // 剩下的大对象
+    DaiPool_sweepStep(&vm->objectPool, SIZE_MAX, sweepObject, vm);
 }
 
+void
+dai_gc_set_threads(DaiVM* vm, int thread_count) {
+    if (vm->gcThreadPool != NULL) {
+        DaiThreadPool_free(vm->gcThreadPool);
+        vm->gcThreadPool = NULL;
+    }
+    if (vm->gcWorkers != NULL) {
+        for (int i = 0; i < vm->gcThreadCount; i++) {
+            DaiGCWorker* worker = &vm->gcWorkers[i];
+            pthread_mutex_destroy(&worker->lock);
+            free(worker->stack);
+            free(worker->shared);
+            free(worker->deferred);
+            free(worker->slices);
+        }
+        free(vm->gcWorkers);
+        vm->gcWorkers = NULL;
+    }
+    vm->gcThreadCount = thread_count;
+    if (thread_count <= 1) {
+        return;
+    }
+    vm->gcWorkers = calloc(thread_count, sizeof(DaiGCWorker));
+    if (vm->gcWorkers == NULL) {
+        dai_error("dai_gc_set_threads: Out of memory\n");
+        abort();
+    }
+    for (int i = 0; i < thread_count; i++) {
+        pthread_mutex_init(&vm->gcWorkers[i].lock, NULL);
+    }
+    vm->gcThreadPool = DaiThreadPool_New(thread_count);
+}
+
+// #endregion
+
 void
 collectGarbage(DaiVM* vm) {
     // 只在运行时回收，
@@ -423,16 +1272,32 @@ collectGarbage(DaiVM* vm) {
     if (vm->state != VMState_running) {
         return;
     }
+    uint64_t start = dai_monotonic_ns();
+    finishIncrementalGC(vm);
 #ifdef DEBUG_LOG_GC
     dai_loggc("-- gc begin\n");
-    size_t before = vm->bytesAllocated;
 #endif
+    size_t before = vm->bytesAllocated;
+    // 回收之后所有对象都在老年代，不再需要记忆集
+    clearRememberedSet(vm);
+    DaiPool_clearMarks(&vm->objectPool);
     markRoots(vm);
-    traceReferences(vm);
-    // 清除字符串表中对回收对象的引用
-    tableRemoveWhite(&vm->strings);
-    sweep(vm);
-    vm->nextGC = vm->bytesAllocated * GC_HEAP_GROW_FACTOR;
+    // 新生代对象也在内存池里，一起清除
+    if (vm->gcThreadCount > 1) {
+        parallelTraceReferences(vm);
+        markSliceParents(vm);
+        parallelSweep(vm);
+    } else {
+        traceReferences(vm);
+        markSliceParents(vm);
+        DaiPool_beginSweep(&vm->objectPool);
+        DaiPool_sweepStep(&vm->objectPool, SIZE_MAX, sweepObject, vm);
+    }
+    vm->youngCount = 0;
+    vm->youngBytes = 0;
+    vm->nextGC = nextThreshold(vm);
+    vm->gcStats.fullCollections++;
+    recordFreed(vm, before - vm->bytesAllocated);
 
 #ifdef DEBUG_LOG_GC
     dai_loggc("-- gc end\n");
@@ -442,13 +1307,22 @@ collectGarbage(DaiVM* vm) {
               vm->bytesAllocated,
               vm->nextGC);
 #endif
+    recordPause(vm, start);
+}
+
+bool
+dai_gc_emergency_collect(DaiVM* vm) {
+    collectGarbage(vm);
+    return vm->gcHeapLimit != 0 && vm->bytesAllocated > vm->gcHeapLimit;
 }
 
 #ifdef DAI_TEST
 void
 test_mark(DaiVM* vm) {
+    DaiPool_clearMarks(&vm->objectPool);
     markRoots(vm);
     traceReferences(vm);
+    markSliceParents(vm);
 }
 #endif
 // #endregion
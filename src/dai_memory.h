@@ -23,6 +23,30 @@
 void*
 vm_reallocate(DaiVM* vm, void* pointer, size_t old_size, size_t new_size);
 
+// 和 vm_reallocate 一样记账，但是不会触发 GC ，
+// 用于调用方不能保证相关对象都被引用着的地方（比如数组元素，数组可能刚创建还不在栈上）。
+// 超过堆上限时只做标记，等到安全点再进行紧急回收
+#define VM_GROW_ARRAY_NOGC(vm, type, pointer, oldCount, newCount) \
+    (type*)vm_reallocate_nogc(vm, pointer, sizeof(type) * (oldCount), sizeof(type) * (newCount))
+
+void*
+vm_reallocate_nogc(DaiVM* vm, void* pointer, size_t old_size, size_t new_size);
+// 只记账不分配，用于不是通过 vm_reallocate 分配的内存（比如 DaiStringBuffer 的缓冲区）
+void
+vm_account_nogc(DaiVM* vm, size_t old_size, size_t new_size);
+
+// #endregion
+
+// #region 对象内存
+// 对象从虚拟机的内存池 vm->objectPool 中分配，和 vm_reallocate 一样记账，分配时可能触发 GC
+#define VM_FREE_OBJ(vm, type, pointer) vm_free_object_memory(vm, pointer, sizeof(type))
+#define VM_FREE_OBJ1(vm, size, pointer) vm_free_object_memory(vm, pointer, size)
+
+void*
+vm_allocate_object(DaiVM* vm, size_t size);
+void
+vm_free_object_memory(DaiVM* vm, void* pointer, size_t size);
+
 // #endregion
 
 // #region reallocate
@@ -47,12 +71,55 @@ reallocate(void* pointer, size_t oldSize, size_t newSize);
 
 // #endregion
 
+// 第一次完整回收的默认阈值
+#define DAI_GC_INITIAL_THRESHOLD (1024 * 1024)
+// 默认的堆增长系数，完整回收之后下一次回收的阈值是存活字节数乘以这个值
+#define DAI_GC_GROW_FACTOR 2.0
+// 新生代的默认大小
+#define DAI_GC_NURSERY_SIZE (4 * 1024 * 1024)
+// 增量回收每一步的默认工作量
+#define DAI_GC_STEP_SIZE (32 * 1024)
+// 开启增量回收时新生代的大小，新生代回收的停顿时间和新生代大小成正比
+#define DAI_GC_INCREMENTAL_NURSERY_SIZE (512 * 1024)
+
+void
+dai_gc_push_young(DaiVM* vm, DaiObj* object);
+
+// 新分配的对象一般放进新生代，
+// 增量标记阶段不进行新生代回收，新对象直接属于老年代（未标记，白色）
+static inline void
+dai_gc_link_object(DaiVM* vm, DaiObj* object) {
+    if (vm->gcPhase != DaiGCPhase_mark) {
+        dai_gc_push_young(vm, object);
+    }
+}
+
 void
 markObject(DaiVM* vm, DaiObj* object);
 void
 markValue(DaiVM* vm, DaiValue value);
+// 完整回收
 void
 collectGarbage(DaiVM* vm);
+// 新生代回收
+void
+collectYoungGarbage(DaiVM* vm);
+// 执行一步增量回收，没有进行中的增量回收时开始新的一轮
+void
+incrementalGCStep(DaiVM* vm);
+// 在安全点调用，复制回收时找到的小切片字符串的内容，之后它们的 parent 可以被回收
+void
+dai_gc_compact_slices(DaiVM* vm);
+
+// 按类型统计内存池中的对象
+void
+dai_gc_heap_stats(DaiVM* vm, DaiHeapTypeStats stats[DaiObjType_count]);
+// 堆超过上限时的紧急回收，进行一次完整回收，返回回收之后是否仍然超过上限
+bool
+dai_gc_emergency_collect(DaiVM* vm);
+// 设置完整回收使用的线程数，会停止原来的线程
+void
+dai_gc_set_threads(DaiVM* vm, int thread_count);
 
 void
 dai_free_objects(DaiVM* vm);
@@ -30,6 +30,33 @@ dai_object_ts(DaiValue value) {
         case DaiObjType_module: return "module";
         case DaiObjType_tuple: return "tuple";
         case DaiObjType_struct: return "struct";
+        case DaiObjType_boxedInt: return "int";
+        case DaiObjType_count: unreachable();
+    }
+    return "unknown";
+}
+
+const char*
+dai_object_type_name(DaiObjType type) {
+    switch (type) {
+        case DaiObjType_function: return "function";
+        case DaiObjType_closure: return "closure";
+        case DaiObjType_string: return "string";
+        case DaiObjType_builtinFn: return "builtin_function";
+        case DaiObjType_class: return "class";
+        case DaiObjType_instance: return "instance";
+        case DaiObjType_boundMethod: return "bound_method";
+        case DaiObjType_array: return "array";
+        case DaiObjType_arrayIterator: return "array_iterator";
+        case DaiObjType_map: return "map";
+        case DaiObjType_mapIterator: return "map_iterator";
+        case DaiObjType_rangeIterator: return "range_iterator";
+        case DaiObjType_error: return "error";
+        case DaiObjType_cFunction: return "c_function";
+        case DaiObjType_module: return "module";
+        case DaiObjType_tuple: return "tuple";
+        case DaiObjType_struct: return "struct";
+        case DaiObjType_boxedInt: return "boxed_int";
         case DaiObjType_count: unreachable();
     }
     return "unknown";
@@ -18,4 +18,7 @@
 
 const char*
 dai_object_ts(DaiValue value);
+// 对象类型的名字，每种类型都不一样（ dai_object_ts 对函数和闭包返回一样的名字）
+const char*
+dai_object_type_name(DaiObjType type);
 #endif /* CBDAI_DAI_OBJECT_H */
@@ -8,23 +8,25 @@
 
 // #region 数组 DaiObjArray
 static void
-DaiObjArray_shrink(DaiObjArray* array) {
+DaiObjArray_shrink(DaiVM* vm, DaiObjArray* array) {
     if (array->length > (array->capacity >> 2)) {
         return;
     }
     int old_capacity = array->capacity;
     array->capacity  = array->capacity >> 1;
-    array->elements  = GROW_ARRAY(DaiValue, array->elements, old_capacity, array->capacity);
+    array->elements =
+        VM_GROW_ARRAY_NOGC(vm, DaiValue, array->elements, old_capacity, array->capacity);
 }
 
 static void
-DaiObjArray_grow(DaiObjArray* array, int want) {
+DaiObjArray_grow(DaiVM* vm, DaiObjArray* array, int want) {
     int old_capacity = array->capacity;
     array->capacity  = GROW_CAPACITY(array->capacity);
     if (want > array->capacity) {
         array->capacity = want;
     }
-    array->elements = GROW_ARRAY(DaiValue, array->elements, old_capacity, array->capacity);
+    array->elements =
+        VM_GROW_ARRAY_NOGC(vm, DaiValue, array->elements, old_capacity, array->capacity);
 }
 
 static DaiObjArray*
@@ -32,7 +34,7 @@ DaiObjArray_pcopy(DaiVM* vm, DaiObjArray* array) {
     DaiObjArray* copy = DaiObjArray_New(vm, NULL, 0);
     copy->length      = array->length;
     copy->capacity    = array->capacity;
-    copy->elements    = GROW_ARRAY(DaiValue, NULL, 0, copy->capacity);
+    copy->elements    = VM_GROW_ARRAY_NOGC(vm, DaiValue, NULL, 0, copy->capacity);
     for (int i = 0; i < array->length; i++) {
         copy->elements[i] = array->elements[i];
     }
@@ -48,6 +50,14 @@ DaiObjArray_preverse(DaiObjArray* array) {
     }
 }
 
+// 删除元素后 index 之后的元素向前移动一位，记忆集中的数组需要把遍历范围扩大到 index
+static void
+DaiObjArray_shift_barrier(DaiObjArray* array, int index) {
+    if (array->obj.is_remembered && index < array->dirty_start) {
+        array->dirty_start = index;
+    }
+}
+
 static DaiValue
 DaiObjArray_length(__attribute__((unused)) DaiVM* vm, DaiValue receiver, int argc, DaiValue* argv) {
     if (argc != 0) {
@@ -82,7 +92,7 @@ DaiObjArray_pop(__attribute__((unused)) DaiVM* vm, DaiValue receiver, int argc,
     }
     DaiValue value = array->elements[array->length - 1];
     array->length--;
-    DaiObjArray_shrink(array);
+    DaiObjArray_shrink(vm, array);
     return value;
 }
 
@@ -145,8 +155,9 @@ DaiObjArray_remove(__attribute__((unused)) DaiVM* vm, DaiValue receiver, int arg
             for (int j = i; j < array->length - 1; j++) {
                 array->elements[j] = array->elements[j + 1];
             }
+            DaiObjArray_shift_barrier(array, i);
             array->length--;
-            DaiObjArray_shrink(array);
+            DaiObjArray_shrink(vm, array);
             return receiver;
         }
     }
@@ -179,8 +190,9 @@ DaiObjArray_removeIndex(__attribute__((unused)) DaiVM* vm, DaiValue receiver, in
     for (int i = index; i < array->length - 1; i++) {
         array->elements[i] = array->elements[i + 1];
     }
+    DaiObjArray_shift_barrier(array, index);
     array->length--;
-    DaiObjArray_shrink(array);
+    DaiObjArray_shrink(vm, array);
     return NIL_VAL;
 }
 
@@ -199,12 +211,13 @@ DaiObjArray_extend(__attribute__((unused)) DaiVM* vm, DaiValue receiver, int arg
     DaiObjArray* other = AS_ARRAY(argv[0]);
     int want           = array->length + other->length;
     if (want > array->capacity) {
-        DaiObjArray_grow(array, want);
+        DaiObjArray_grow(vm, array, want);
     }
     for (int i = 0; i < other->length; i++) {
         array->elements[array->length + i] = other->elements[i];
     }
     array->length += other->length;
+    dai_gc_write_barrier_all(vm, (DaiObj*)array);
     return receiver;
 }
 
@@ -254,6 +267,8 @@ DaiObjArray_reverse(__attribute__((unused)) DaiVM* vm, DaiValue receiver, int ar
     }
     DaiObjArray* array = AS_ARRAY(receiver);
     DaiObjArray_preverse(array);
+    // 元素的位置都变了
+    dai_gc_write_barrier_all(vm, (DaiObj*)array);
     return receiver;
 }
 
@@ -281,11 +296,14 @@ DaiObjArray_sort(__attribute__((unused)) DaiVM* vm, DaiValue receiver, int argc,
             }
             if (AS_INTEGER(ret) > 0) {
                 array->elements[j + 1] = array->elements[j];   // 数据移动
+                // 比较函数可能触发增量回收，每次移动都要经过写屏障
+                DaiObjArray_write_barrier(vm, array, j + 1, array->elements[j + 1]);
             } else {
                 break;
             }
         }
         array->elements[j + 1] = val;
+        DaiObjArray_write_barrier(vm, array, j + 1, val);
     }
     return receiver;
 }
@@ -522,8 +540,8 @@ DaiObjArray_subscript_set(__attribute__((unused)) DaiVM* vm, DaiValue receiver,
         DaiObjError* err = DaiObjError_Newf(vm, "array index must be integer");
         return OBJ_VAL(err);
     }
-    const DaiObjArray* array = AS_ARRAY(receiver);
-    int64_t n                = AS_INTEGER(index);
+    DaiObjArray* array = AS_ARRAY(receiver);
+    int64_t n          = AS_INTEGER(index);
     if (n < 0) {
         n += array->length;
     }
@@ -532,6 +550,7 @@ DaiObjArray_subscript_set(__attribute__((unused)) DaiVM* vm, DaiValue receiver,
         return OBJ_VAL(err);
     }
     array->elements[n] = value;
+    DaiObjArray_write_barrier(vm, array, n, value);
     return receiver;
 }
 
@@ -582,8 +601,10 @@ DaiObjArray_New2(DaiVM* vm, const DaiValue* elements, const int length, const in
     array->capacity      = capacity;
     array->length        = length;
     array->elements      = NULL;
+    array->dirty_start   = 0;
+    array->dirty_end     = 0;
     if (capacity > 0) {
-        array->elements = GROW_ARRAY(DaiValue, NULL, 0, capacity);
+        array->elements = VM_GROW_ARRAY_NOGC(vm, DaiValue, NULL, 0, capacity);
     }
     if (elements != NULL) {
         memcpy(array->elements, elements, length * sizeof(DaiValue));
@@ -601,10 +622,11 @@ DaiObjArray*
 DaiObjArray_append1(DaiVM* vm, DaiObjArray* array, int n, DaiValue* values) {
     int want = array->length + n;
     if (want > array->capacity) {
-        DaiObjArray_grow(array, want);
+        DaiObjArray_grow(vm, array, want);
     }
     for (int i = 0; i < n; i++) {
         array->elements[array->length + i] = values[i];
+        DaiObjArray_write_barrier(vm, array, array->length + i, values[i]);
     }
     array->length += n;
     return array;
@@ -616,11 +638,12 @@ DaiObjArray_append2(DaiVM* vm, DaiObjArray* array, int n, ...) {
     va_start(args, n);
     int want = array->length + n;
     if (want > array->capacity) {
-        DaiObjArray_grow(array, want);
+        DaiObjArray_grow(vm, array, want);
     }
     for (int i = 0; i < n; i++) {
         DaiValue value                     = va_arg(args, DaiValue);
         array->elements[array->length + i] = value;
+        DaiObjArray_write_barrier(vm, array, array->length + i, value);
     }
     array->length += n;
     va_end(args);
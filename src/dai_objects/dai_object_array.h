@@ -9,7 +9,29 @@ typedef struct {
     int capacity;
     int length;
     DaiValue* elements;
+    // 数组在记忆集中时，新生代回收只遍历 [dirty_start, dirty_end) 范围内的元素
+    int dirty_start;
+    int dirty_end;
 } DaiObjArray;
+
+// 写入 array->elements[index] 之后调用，除了写屏障之外还记录新生代回收需要遍历的范围
+static inline void
+DaiObjArray_write_barrier(DaiVM* vm, DaiObjArray* array, int index, DaiValue value) {
+    if (array->obj.is_remembered) {
+        if (index < array->dirty_start) {
+            array->dirty_start = index;
+        }
+        if (index >= array->dirty_end) {
+            array->dirty_end = index + 1;
+        }
+        return;
+    }
+    dai_gc_write_barrier(vm, (DaiObj*)array, value);
+    if (array->obj.is_remembered) {
+        array->dirty_start = index;
+        array->dirty_end   = index + 1;
+    }
+}
 DaiObjArray*
 DaiObjArray_New(DaiVM* vm, const DaiValue* elements, const int length);
 DaiObjArray*
@@ -4,6 +4,7 @@
 #include <string.h>
 
 #include "dai_memory.h"
+#include "dai_pool.h"
 #include "dai_vm.h"
 #include "dai_windows.h"   // IWYU pragma: keep
 
@@ -28,12 +29,13 @@ dai_default_hash(DaiValue value) {
 
 DaiObj*
 allocate_object(DaiVM* vm, size_t size, DaiObjType type) {
-    DaiObj* object    = (DaiObj*)vm_reallocate(vm, NULL, 0, size);
-    object->type      = type;
-    object->is_marked = false;
-    object->next      = vm->objects;
-    object->operation = NULL;
-    vm->objects       = object;
+    DaiObj* object        = (DaiObj*)vm_allocate_object(vm, size);
+    object->type          = type;
+    object->space         = size > DAI_POOL_MAX_SIZE ? DaiObjSpace_large : DaiObjSpace_page;
+    object->is_remembered = false;
+    object->flags         = 0;
+    object->operation     = NULL;
+    dai_gc_link_object(vm, object);
 #ifdef DEBUG_LOG_GC
     dai_loggc("%p allocate %zu for %d\n", (void*)object, size, type);
 
@@ -41,3 +43,61 @@ allocate_object(DaiVM* vm, size_t size, DaiObjType type) {
 
     return object;
 }
+
+#ifdef DAI_NAN_BOXING
+// #region 装箱整数
+
+static _Thread_local DaiVM* boxing_vm = NULL;
+
+DaiVM*
+dai_set_boxing_vm(DaiVM* vm) {
+    DaiVM* previous = boxing_vm;
+    boxing_vm       = vm;
+    return previous;
+}
+
+void
+dai_clear_boxing_vm(DaiVM* vm) {
+    if (boxing_vm == vm) {
+        boxing_vm = NULL;
+    }
+}
+
+DaiValue
+dai_box_integer(int64_t value) {
+    return dai_box_integer_vm(boxing_vm, value);
+}
+
+DaiValue
+dai_box_integer_vm(DaiVM* vm, int64_t value) {
+    // 这里不能触发 GC ：INTEGER_VAL 的调用方不会事先保护其他临时对象。
+    // 只记账，等下一次正常分配时再按阈值回收
+    DaiObjBoxedInt* box;
+    if (vm != NULL) {
+        box            = DaiPool_alloc(&vm->objectPool, sizeof(DaiObjBoxedInt));
+        box->obj.space = DaiObjSpace_page;
+    } else {
+        box            = reallocate(NULL, 0, sizeof(DaiObjBoxedInt));
+        box->obj.space = DaiObjSpace_static;
+    }
+    box->obj.type          = DaiObjType_boxedInt;
+    box->obj.is_remembered = false;
+    box->obj.flags         = 0;
+    box->obj.operation     = NULL;
+    box->value             = value;
+    if (vm != NULL) {
+        vm->bytesAllocated += sizeof(DaiObjBoxedInt);
+        vm->youngBytes += sizeof(DaiObjBoxedInt);
+        dai_gc_link_object(vm, (DaiObj*)box);
+    }
+    // 没有虚拟机时（比如单独使用 DaiTable 的测试）装箱的整数不会被回收
+    return DAI_TAG_BOXED_INT | (uint64_t)(uintptr_t)box;
+}
+
+int64_t
+dai_unbox_integer(DaiValue value) {
+    return AS_BOXED_INTEGER(value)->value;
+}
+
+// #endregion
+#endif
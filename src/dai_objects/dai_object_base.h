@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "dai_pool.h"
 #include "dai_value.h"
 
 #define BUILTIN_GLOBALS_COUNT 2
@@ -88,7 +89,6 @@ dai_default_hash(DaiValue value);
 #define AS_BUILTINFN(value) ((DaiObjBuiltinFunction*)AS_OBJ(value))
 #define AS_CLASS(value) ((DaiObjClass*)AS_OBJ(value))
 #define AS_STRING(value) ((DaiObjString*)AS_OBJ(value))
-#define AS_CSTRING(value) (((DaiObjString*)AS_OBJ(value))->chars)
 #define AS_ARRAY(value) ((DaiObjArray*)AS_OBJ(value))
 #define AS_ARRAY_ITERATOR(value) ((DaiObjArrayIterator*)AS_OBJ(value))
 #define AS_MAP(value) ((DaiObjMap*)AS_OBJ(value))
@@ -121,17 +121,26 @@ typedef enum {
     DaiObjType_cFunction,   // c api registered function
     DaiObjType_module,
     DaiObjType_tuple,
-    DaiObjType_struct,   // c struct
+    DaiObjType_struct,      // c struct
+    DaiObjType_boxedInt,   // NaN-boxing 下超出小整数范围的整数，不会作为对象暴露给用户
 
     DaiObjType_count,
 } DaiObjType;
 
 typedef void (*CFunction)(void* dai);
 
+// 对象所在的内存区域，决定标记位放在哪里
+typedef enum {
+    DaiObjSpace_static,   // 静态分配的对象（比如内置函数），不参与回收
+    DaiObjSpace_page,     // 内存池页中的小对象，标记位在页的位图里
+    DaiObjSpace_large,    // 大对象，标记位在对象前面的头里
+} DaiObjSpace;
+
 struct DaiObj {
     DaiObjType type;
-    bool is_marked;        // 是否被标记（标记-清除垃圾回收算法）
-    struct DaiObj* next;   // 对象链表，会串起所有分配的对象
+    uint8_t space;        // DaiObjSpace
+    bool is_remembered;   // 是否在记忆集中（分代垃圾回收）
+    uint8_t flags;        // 各类型自己使用的标志位
     struct DaiObjOperation* operation;
 };
 
@@ -147,4 +156,111 @@ DaiObj*
 allocate_object(DaiVM* vm, size_t size, DaiObjType type);
 // #endregion
 
+// #region 标记位
+
+// 静态对象当作一直被标记（属于老年代）
+static inline bool
+dai_gc_is_marked(const DaiObj* object) {
+    switch (object->space) {
+        case DaiObjSpace_page: return DaiPool_isMarked(object);
+        case DaiObjSpace_large: return DaiPool_largeOf(object)->marked;
+        default: return true;
+    }
+}
+
+static inline void
+dai_gc_set_marked(DaiObj* object) {
+    switch (object->space) {
+        case DaiObjSpace_page: DaiPool_setMarked(object); break;
+        case DaiObjSpace_large: DaiPool_largeOf(object)->marked = true; break;
+        default: break;
+    }
+}
+
+// 并行标记时使用，原子地设置标记位，只有一个线程会得到 true ，由它负责遍历这个对象
+static inline bool
+dai_gc_try_mark(DaiObj* object) {
+    switch (object->space) {
+        case DaiObjSpace_page: return DaiPool_tryMark(object);
+        case DaiObjSpace_large:
+            return !__atomic_exchange_n(&DaiPool_largeOf(object)->marked, true, __ATOMIC_RELAXED);
+        default: return false;
+    }
+}
+
+// #endregion
+
+// #region 写屏障
+// 新分配的对象在新生代，存活过一次回收后晋升到老年代，新生代回收不会遍历老年代。
+// 把值写入一个已经创建好的对象时需要调用写屏障：
+// 老年代对象引用了新生代对象时，把老年代对象加入记忆集，新生代回收时从记忆集出发标记；
+// 增量标记阶段黑色对象引用了白色对象时，把白色对象标成灰色。
+// 这两种情况都是已标记的 owner 引用了未标记的 value
+
+void
+dai_gc_write_barrier_slow(DaiVM* vm, DaiObj* owner, DaiObj* object);
+void
+dai_gc_write_barrier_all_slow(DaiVM* vm, DaiObj* owner);
+
+// 返回 value 引用的对象，不是对象时返回 NULL
+static inline DaiObj*
+dai_gc_value_object(DaiValue value) {
+#ifdef DAI_NAN_BOXING
+    if (IS_BOXED_INTEGER(value)) {
+        return AS_OBJ(value);
+    }
+#endif
+    return IS_OBJ(value) ? AS_OBJ(value) : NULL;
+}
+
+// value 写入 owner 之后调用
+static inline void
+dai_gc_write_barrier(DaiVM* vm, DaiObj* owner, DaiValue value) {
+    if (!owner->is_remembered) {
+        DaiObj* object = dai_gc_value_object(value);
+        if (object != NULL && !dai_gc_is_marked(object) && dai_gc_is_marked(owner)) {
+            dai_gc_write_barrier_slow(vm, owner, object);
+        }
+    }
+}
+
+// 一次写入多个值时调用
+static inline void
+dai_gc_write_barrier_all(DaiVM* vm, DaiObj* owner) {
+    if (!owner->is_remembered && dai_gc_is_marked(owner)) {
+        dai_gc_write_barrier_all_slow(vm, owner);
+    }
+}
+
+// #endregion
+
+#ifdef DAI_NAN_BOXING
+// #region 装箱整数
+
+typedef struct {
+    DaiObj obj;
+    int64_t value;
+} DaiObjBoxedInt;
+
+#    define AS_BOXED_INTEGER(value) ((DaiObjBoxedInt*)AS_OBJ(value))
+
+// INTEGER_VAL 拿不到虚拟机，装箱整数由当前线程正在执行的虚拟机管理。
+// 虚拟机开始执行（加载模块、运行帧）时设置，返回之前的虚拟机，执行结束时再设置回去。
+// 嵌入 API 和内置函数拿得到虚拟机，使用 INTEGER_VAL_VM 指定虚拟机
+DaiVM*
+dai_set_boxing_vm(DaiVM* vm);
+// 虚拟机释放时调用，之后装箱的整数不再由它管理
+void
+dai_clear_boxing_vm(DaiVM* vm);
+
+// #endregion
+#else
+static inline DaiVM*
+dai_set_boxing_vm(__attribute__((unused)) DaiVM* vm) {
+    return NULL;
+}
+static inline void
+dai_clear_boxing_vm(__attribute__((unused)) DaiVM* vm) {}
+#endif
+
 #endif /* CBDAI_DAI_OBJECT_BASE_H */
@@ -32,7 +32,19 @@ DaiFieldDesc_compare(const void* a, const void* b, void* udata) {
 static uint64_t
 DaiFieldDesc_hash(const void* item, uint64_t seed0, uint64_t seed1) {
     const DaiFieldDesc* p = item;
-    return p->name->hash;
+    return DaiObjString_hash(p->name);
+}
+
+// 形状 id 从 1 开始分配， 0 留给内联缓存表示空
+static uint32_t next_shape = 1;
+
+static uint32_t
+DaiObjClass_new_shape(void) {
+    uint32_t shape = next_shape++;
+    if (next_shape == 0) {
+        next_shape = 1;
+    }
+    return shape;
 }
 
 static bool
@@ -53,7 +65,8 @@ DaiObjInstance_get_property(DaiVM* vm, DaiValue receiver, DaiObjString* name) {
     assert(IS_OBJ(receiver));
     DaiObjInstance* instance = AS_INSTANCE(receiver);
     DaiFieldDesc prop        = {.name = name};
-    const void* res          = hashmap_get_with_hash(instance->klass->fields, &prop, name->hash);
+    const void* res =
+        hashmap_get_with_hash(instance->klass->fields, &prop, DaiObjString_hash(name));
     if (res) {
         return instance->fields[((DaiFieldDesc*)res)->index];
     }
@@ -74,11 +87,13 @@ DaiObjInstance_set_property(DaiVM* vm, DaiValue receiver, DaiObjString* name, Da
     assert(IS_OBJ(receiver));
     DaiObjInstance* instance = AS_INSTANCE(receiver);
     DaiFieldDesc prop        = {.name = name};
-    const void* res          = hashmap_get_with_hash(instance->klass->fields, &prop, name->hash);
+    const void* res =
+        hashmap_get_with_hash(instance->klass->fields, &prop, DaiObjString_hash(name));
     if (res) {
         const DaiFieldDesc* propp = res;
         if (!(instance->initialized && propp->is_const)) {
             instance->fields[propp->index] = value;
+            dai_gc_write_barrier(vm, (DaiObj*)instance, value);
         } else {
             // 不能修改常量属性
             DaiObjError* err = DaiObjError_Newf(vm,
@@ -111,7 +126,7 @@ DaiObjClass_get_property(DaiVM* vm, DaiValue receiver, DaiObjString* name) {
     assert(IS_OBJ(receiver));
     DaiObjClass* klass = AS_CLASS(receiver);
     DaiFieldDesc prop  = {.name = name};
-    const void* res    = hashmap_get_with_hash(klass->class_fields, &prop, name->hash);
+    const void* res    = hashmap_get_with_hash(klass->class_fields, &prop, DaiObjString_hash(name));
     if (res) {
         return ((DaiFieldDesc*)res)->value;
     }
@@ -131,7 +146,7 @@ DaiObjClass_set_property(DaiVM* vm, DaiValue receiver, DaiObjString* name, DaiVa
     assert(IS_OBJ(receiver));
     DaiObjClass* klass = AS_CLASS(receiver);
     DaiFieldDesc prop  = {.name = name};
-    const void* res    = hashmap_get_with_hash(klass->class_fields, &prop, name->hash);
+    const void* res    = hashmap_get_with_hash(klass->class_fields, &prop, DaiObjString_hash(name));
     if (res) {
         const DaiFieldDesc* propp = res;
         if (!(propp->is_const)) {
@@ -140,8 +155,9 @@ DaiObjClass_set_property(DaiVM* vm, DaiValue receiver, DaiObjString* name, DaiVa
                 .value    = value,
                 .is_const = propp->is_const,
             };
-            res = hashmap_set_with_hash(klass->class_fields, &nprop, name->hash);
+            res = hashmap_set_with_hash(klass->class_fields, &nprop, DaiObjString_hash(name));
             assert(res != NULL);
+            dai_gc_write_barrier(vm, (DaiObj*)klass, value);
         } else {
             // 不能修改常量属性
             DaiObjError* err = DaiObjError_Newf(vm,
@@ -202,9 +218,10 @@ DaiObjClass_builtin_init(DaiVM* vm, DaiValue receiver, int argc, DaiValue* argv)
     for (int i = 0; i < argc; i++) {
         DaiObjString* field_name = AS_STRING(DaiObjTuple_get(klass->define_field_names, i));
         const void* res          = hashmap_get_with_hash(
-            klass->fields, &(DaiFieldDesc){.name = field_name}, field_name->hash);
+            klass->fields, &(DaiFieldDesc){.name = field_name}, DaiObjString_hash(field_name));
         assert(res != NULL);
         instance->fields[((DaiFieldDesc*)res)->index] = argv[i];
+        dai_gc_write_barrier(vm, (DaiObj*)instance, argv[i]);
     }
     return receiver;
 }
@@ -243,21 +260,23 @@ DaiObjClass_New(DaiVM* vm, DaiObjString* name) {
         abort();
     }
     klass->parent             = NULL;
+    klass->shape              = DaiObjClass_new_shape();
     klass->init_fn            = UNDEFINED_VAL;
     klass->define_field_names = define_field_names;
 
     // 定义内置类属性
-    DaiObjClass_define_class_field(klass, STRING_NAME("__name__"), OBJ_VAL(klass->name), true);
     DaiObjClass_define_class_field(
-        klass, STRING_NAME("__fields__"), OBJ_VAL(klass->define_field_names), true);
+        vm, klass, STRING_NAME("__name__"), OBJ_VAL(klass->name), true);
+    DaiObjClass_define_class_field(
+        vm, klass, STRING_NAME("__fields__"), OBJ_VAL(klass->define_field_names), true);
 #ifdef _WIN32
     DaiTable_set(&klass->methods, name, OBJ_VAL(&builtin_init));
     klass->init_fn = OBJ_VAL(&builtin_init);
 #else
-    DaiObjClass_define_method(klass, STRING_NAME("__init__"), OBJ_VAL(&builtin_init));
+    DaiObjClass_define_method(vm, klass, STRING_NAME("__init__"), OBJ_VAL(&builtin_init));
 #endif
     // 定义内置实例属性
-    DaiObjClass_define_field(klass, STRING_NAME("__class__"), OBJ_VAL(klass), true);
+    DaiObjClass_define_field(vm, klass, STRING_NAME("__class__"), OBJ_VAL(klass), true);
 
     DaiVM_resetGCRef(vm);
     return klass;
@@ -269,7 +288,7 @@ DaiObjClass_Free(DaiVM* vm, DaiObjClass* klass) {
     hashmap_free(klass->fields);
     DaiTable_reset(&klass->class_methods);
     DaiTable_reset(&klass->methods);
-    VM_FREE(vm, DaiObjClass, klass);
+    VM_FREE_OBJ(vm, DaiObjClass, klass);
 }
 
 DaiValue
@@ -300,7 +319,7 @@ DaiObjClass_new_instance_within_vm(DaiObjClass* klass, DaiVM* vm, int argc, DaiV
     for (int i = argc; i < define_field_count; i++) {
         DaiObjString* field_name = AS_STRING(DaiObjTuple_get(klass->define_field_names, i));
         const void* res          = hashmap_get_with_hash(
-            klass->fields, &(DaiFieldDesc){.name = field_name}, field_name->hash);
+            klass->fields, &(DaiFieldDesc){.name = field_name}, DaiObjString_hash(field_name));
         assert(res != NULL);
         if (IS_UNDEFINED(instance->fields[((DaiFieldDesc*)res)->index])) {
             DaiObjError* err = DaiObjError_Newf(vm,
@@ -314,44 +333,56 @@ DaiObjClass_new_instance_within_vm(DaiObjClass* klass, DaiVM* vm, int argc, DaiV
     return OBJ_VAL(instance);
 }
 
+// 设置方法的 super class
+static void
+DaiObjClass_set_superclass(DaiVM* vm, DaiObjClass* klass, DaiValue method) {
+    DaiObjFunction* function = NULL;
+    if (IS_CLOSURE(method)) {
+        function = AS_CLOSURE(method)->function;
+    } else if (IS_FUNCTION(method)) {
+        function = AS_FUNCTION(method);
+    } else {
+        return;
+    }
+    function->superclass = klass->parent;
+    if (klass->parent != NULL) {
+        dai_gc_write_barrier(vm, (DaiObj*)function, OBJ_VAL(klass->parent));
+    }
+}
+
 void
-DaiObjClass_define_class_field(DaiObjClass* klass, DaiObjString* name, DaiValue value,
+DaiObjClass_define_class_field(DaiVM* vm, DaiObjClass* klass, DaiObjString* name, DaiValue value,
                                bool is_const) {
-    const void* res =
-        hashmap_get_with_hash(klass->class_fields, &(DaiFieldDesc){.name = name}, name->hash);
+    const void* res = hashmap_get_with_hash(
+        klass->class_fields, &(DaiFieldDesc){.name = name}, DaiObjString_hash(name));
     if (res == NULL) {
         DaiFieldDesc property = {
             .name     = name,
             .is_const = is_const,
             .value    = value,
         };
-        res = hashmap_set_with_hash(klass->class_fields, &property, name->hash);
+        res = hashmap_set_with_hash(klass->class_fields, &property, DaiObjString_hash(name));
         if (res == NULL && hashmap_oom(klass->class_fields)) {
             dai_error("DaiObjClass_define_class_field: Out of memory\n");
             abort();
         }
+        dai_gc_write_barrier_all(vm, (DaiObj*)klass);
     }
 }
 
 void
-DaiObjClass_define_class_method(DaiObjClass* klass, DaiObjString* name, DaiValue value) {
-    // 设置方法的 super class
-    {
-        if (IS_CLOSURE(value)) {
-            DaiObjFunction* function = AS_CLOSURE(value)->function;
-            function->superclass     = klass->parent;
-        } else if (IS_FUNCTION(value)) {
-            DaiObjFunction* function = AS_FUNCTION(value);
-            function->superclass     = klass->parent;
-        }
-    }
+DaiObjClass_define_class_method(DaiVM* vm, DaiObjClass* klass, DaiObjString* name,
+                                DaiValue value) {
+    DaiObjClass_set_superclass(vm, klass, value);
     DaiTable_set(&klass->class_methods, name, value);
+    dai_gc_write_barrier_all(vm, (DaiObj*)klass);
 }
 
 int
-DaiObjClass_define_field(DaiObjClass* klass, DaiObjString* name, DaiValue value, bool is_const) {
-    const void* res =
-        hashmap_get_with_hash(klass->fields, &(DaiFieldDesc){.name = name}, name->hash);
+DaiObjClass_define_field(DaiVM* vm, DaiObjClass* klass, DaiObjString* name, DaiValue value,
+                         bool is_const) {
+    const void* res = hashmap_get_with_hash(
+        klass->fields, &(DaiFieldDesc){.name = name}, DaiObjString_hash(name));
     DaiFieldDesc property = {
         .name     = name,
         .is_const = is_const,
@@ -361,54 +392,60 @@ DaiObjClass_define_field(DaiObjClass* klass, DaiObjString* name, DaiValue value,
     if (res == NULL) {
         if (!is_builtin_property(name->chars)) {
             DaiObjTuple_append(klass->define_field_names, OBJ_VAL(name));
+            dai_gc_write_barrier(vm, (DaiObj*)klass->define_field_names, OBJ_VAL(name));
         }
     } else {
         property.index = ((DaiFieldDesc*)res)->index;
     }
 
-    res = hashmap_set_with_hash(klass->fields, &property, name->hash);
+    res = hashmap_set_with_hash(klass->fields, &property, DaiObjString_hash(name));
     if (res == NULL && hashmap_oom(klass->fields)) {
         dai_error("DaiObjClass_define_field: Out of memory\n");
         abort();
     }
+    dai_gc_write_barrier_all(vm, (DaiObj*)klass);
+    // 属性布局变了，之前缓存的索引都不能再用
+    klass->shape = DaiObjClass_new_shape();
     return property.index;
 }
 
+const DaiFieldDesc*
+DaiObjClass_get_field(DaiObjClass* klass, DaiObjString* name) {
+    return hashmap_get_with_hash(
+        klass->fields, &(DaiFieldDesc){.name = name}, DaiObjString_hash(name));
+}
+
 void
-DaiObjClass_define_method(DaiObjClass* klass, DaiObjString* name, DaiValue value) {
-    // 设置方法的 super class
-    {
-        if (IS_CLOSURE(value)) {
-            DaiObjFunction* function = AS_CLOSURE(value)->function;
-            function->superclass     = klass->parent;
-        } else if (IS_FUNCTION(value)) {
-            DaiObjFunction* function = AS_FUNCTION(value);
-            function->superclass     = klass->parent;
-        }
-    }
+DaiObjClass_define_method(DaiVM* vm, DaiObjClass* klass, DaiObjString* name, DaiValue value) {
+    DaiObjClass_set_superclass(vm, klass, value);
     DaiTable_set(&klass->methods, name, value);
+    dai_gc_write_barrier_all(vm, (DaiObj*)klass);
     if (strcmp(name->chars, "__init__") == 0) {
         klass->init_fn = value;
     }
+    klass->shape = DaiObjClass_new_shape();
 }
 
 void
-DaiObjClass_inherit(DaiObjClass* klass, DaiObjClass* parent) {
+DaiObjClass_inherit(DaiVM* vm, DaiObjClass* klass, DaiObjClass* parent) {
     klass->parent  = parent;
     klass->init_fn = parent->init_fn;
+    klass->shape   = DaiObjClass_new_shape();
+    dai_gc_write_barrier_all(vm, (DaiObj*)klass);
     // 复制实例属性
     {
         void* item;
         size_t i = 0;
         while (hashmap_iter(parent->fields, &i, &item)) {
             DaiFieldDesc* prop = item;
-            DaiObjClass_define_field(klass, prop->name, prop->value, prop->is_const);
+            DaiObjClass_define_field(vm, klass, prop->name, prop->value, prop->is_const);
         }
         int count = DaiObjTuple_length(parent->define_field_names);
         for (int j = 0; j < count; j++) {
             DaiObjTuple_set(
                 klass->define_field_names, j, DaiObjTuple_get(parent->define_field_names, j));
         }
+        dai_gc_write_barrier_all(vm, (DaiObj*)klass->define_field_names);
     }
     // 复制类属性
     {
@@ -416,7 +453,7 @@ DaiObjClass_inherit(DaiObjClass* klass, DaiObjClass* parent) {
         size_t i = 0;
         while (hashmap_iter(parent->class_fields, &i, &item)) {
             DaiFieldDesc* prop = item;
-            DaiObjClass_define_class_field(klass, prop->name, prop->value, prop->is_const);
+            DaiObjClass_define_class_field(vm, klass, prop->name, prop->value, prop->is_const);
         }
     }
 }
@@ -484,7 +521,7 @@ void
 DaiObjInstance_Free(DaiVM* vm, DaiObjInstance* instance) {
     free(instance->fields);
     instance->fields = NULL;
-    VM_FREE(vm, DaiObjInstance, instance);
+    VM_FREE_OBJ(vm, DaiObjInstance, instance);
 }
 
 DaiObjInstance*
@@ -506,7 +543,8 @@ DaiObjInstance_Copy(DaiVM* vm, DaiObjInstance* instance) {
 void
 DaiObjInstance_set(DaiObjInstance* instance, DaiObjString* name, DaiValue value) {
     DaiFieldDesc prop = {.name = name};
-    const void* res   = hashmap_get_with_hash(instance->klass->fields, &prop, name->hash);
+    const void* res =
+        hashmap_get_with_hash(instance->klass->fields, &prop, DaiObjString_hash(name));
     if (res) {
         const DaiFieldDesc* propp      = res;
         instance->fields[propp->index] = value;
@@ -32,6 +32,11 @@ typedef struct _DaiObjClass {
     struct hashmap* fields;         // 实例属性，存储名字 => DaiFieldDesc
     DaiObjTuple* define_field_names;   // 按定义顺序存储实例属性名（内置类属性 __fields__ 的值）
     DaiObjClass* parent;
+    // 形状 id ，定义实例属性、实例方法或者继承时都会换一个新的 id ，
+    // 属性和方法的内联缓存按它来匹配。
+    // 不直接缓存类指针，避免类被回收后地址被新的类复用导致缓存误命中
+    // 方法只在类定义时添加，子类继承时父类已经定义完成，所以不需要通知子类
+    uint32_t shape;
     // 下面是一些特殊的实例方法
     DaiValue init_fn;   // __init__ 方法
 } DaiObjClass;
@@ -42,16 +47,21 @@ DaiObjClass_Free(DaiVM* vm, DaiObjClass* klass);
 DaiValue
 DaiObjClass_new_instance_within_vm(DaiObjClass* klass, DaiVM* vm, int argc, DaiValue* argv);
 void
-DaiObjClass_define_class_field(DaiObjClass* klass, DaiObjString* name, DaiValue value,
+DaiObjClass_define_class_field(DaiVM* vm, DaiObjClass* klass, DaiObjString* name, DaiValue value,
                                bool is_const);
 void
-DaiObjClass_define_class_method(DaiObjClass* klass, DaiObjString* name, DaiValue value);
+DaiObjClass_define_class_method(DaiVM* vm, DaiObjClass* klass, DaiObjString* name,
+                                DaiValue value);
 int
-DaiObjClass_define_field(DaiObjClass* klass, DaiObjString* name, DaiValue value, bool is_const);
+DaiObjClass_define_field(DaiVM* vm, DaiObjClass* klass, DaiObjString* name, DaiValue value,
+                         bool is_const);
 void
-DaiObjClass_define_method(DaiObjClass* klass, DaiObjString* name, DaiValue value);
+DaiObjClass_define_method(DaiVM* vm, DaiObjClass* klass, DaiObjString* name, DaiValue value);
 void
-DaiObjClass_inherit(DaiObjClass* klass, DaiObjClass* parent);
+DaiObjClass_inherit(DaiVM* vm, DaiObjClass* klass, DaiObjClass* parent);
+// 查找实例属性，不存在返回 NULL
+const DaiFieldDesc*
+DaiObjClass_get_field(DaiObjClass* klass, DaiObjString* name);
 
 
 typedef struct {
@@ -209,6 +209,8 @@ DaiObjMap_subscript_set(DaiVM* vm, DaiValue receiver, DaiValue index, DaiValue v
         DaiObjError* err = DaiObjError_Newf(vm, "Out of memory");
         return OBJ_VAL(err);
     }
+    dai_gc_write_barrier(vm, (DaiObj*)map, index);
+    dai_gc_write_barrier(vm, (DaiObj*)map, value);
     return NIL_VAL;
 }
 
@@ -290,8 +292,11 @@ int
 DaiObjMapEntry_compare(const void* a, const void* b, void* udata) {
     const DaiObjMapEntry* entry_a = (const DaiObjMapEntry*)a;
     const DaiObjMapEntry* entry_b = (const DaiObjMapEntry*)b;
-    // 因为容器不能作为键，所以 dai_value_equal 不会返回错误
-    return !dai_value_equal(entry_a->key, entry_b->key);
+    // 浮点数键精确比较（ NaN 等于 NaN ），和按位模式计算的哈希值保持一致。
+    // dai_value_equal 带误差比较，两个足够接近的键哈希值不同，会时而相等时而不等。
+    // 因为容器不能作为键，所以不会超过递归深度
+    int limit = 256;
+    return dai_value_key_equal(entry_a->key, entry_b->key, &limit) != 1;
 }
 
 uint64_t
@@ -335,7 +340,7 @@ DaiObjMap_New(DaiVM* vm, const DaiValue* values, int length, DaiObjMap** map_ret
 void
 DaiObjMap_Free(DaiVM* vm, DaiObjMap* map) {
     hashmap_free(map->map);
-    VM_FREE(vm, DaiObjMap, map);
+    VM_FREE_OBJ(vm, DaiObjMap, map);
 }
 
 bool
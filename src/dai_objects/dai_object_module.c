@@ -28,7 +28,7 @@ DaiPropertyOffset_compare(const void* a, const void* b, void* udata) {
 static uint64_t
 DaiPropertyOffset_hash(const void* item, uint64_t seed0, uint64_t seed1) {
     const DaiPropertyOffset* offset = item;
-    return offset->property->hash;
+    return DaiObjString_hash(offset->property);
 }
 
 // #endregion
@@ -143,6 +143,8 @@ DaiObjModule_NewWithGlobals(DaiVM* vm, const char* name, const char* filename, D
     DaiValue key, value;
     while (DaiObjMap_iter(globals, &i, &key, &value)) {
         assert(IS_STRING(key));
+        // 全局变量名按 '\0' 结尾的字符串比较
+        DaiObjString_cstring(vm, AS_STRING(key));
         DaiObjModule_add_global1(module, AS_STRING(key), value);
     }
     return module;
@@ -154,7 +156,7 @@ DaiObjModule_Free(DaiVM* vm, DaiObjModule* module) {
     DaiChunk_reset(&module->chunk);
     hashmap_free(module->global_map);
     free(module->globals);
-    VM_FREE(vm, DaiObjModule, module);
+    VM_FREE_OBJ(vm, DaiObjModule, module);
 }
 
 void
@@ -239,6 +241,7 @@ DaiObjModule_set_global(DaiObjModule* module, const char* name, DaiValue value)
         return false;
     }
     module->globals[offset->offset] = value;
+    dai_gc_write_barrier(module->vm, (DaiObj*)module, value);
     return true;
 }
 
@@ -265,6 +268,7 @@ DaiObjModule_add_global(DaiObjModule* module, const char* name, DaiValue value)
         abort();
     }
     module->globals[count] = value;
+    dai_gc_write_barrier_all(module->vm, (DaiObj*)module);
     return true;
 }
 
@@ -290,6 +294,7 @@ DaiObjModule_add_global1(DaiObjModule* module, DaiObjString* name, DaiValue valu
         abort();
     }
     module->globals[count] = value;
+    dai_gc_write_barrier_all(module->vm, (DaiObj*)module);
     return true;
 }
 
@@ -316,6 +321,7 @@ DaiObjModule_copyto(DaiObjModule* module, DaiObjMap* globals) {
         DaiValue value           = module->globals[offset.offset];
         DaiObjMap_cset(globals, OBJ_VAL(key), value);
     }
+    dai_gc_write_barrier_all(module->vm, (DaiObj*)globals);
 }
 
 void
@@ -2,15 +2,14 @@
 
 
 static DaiValue
-DaiObjRangeIterator_iter_next(__attribute__((unused)) DaiVM* vm, DaiValue receiver, DaiValue* index,
-                              DaiValue* element) {
+DaiObjRangeIterator_iter_next(DaiVM* vm, DaiValue receiver, DaiValue* index, DaiValue* element) {
     DaiObjRangeIterator* iterator = AS_RANGE_ITERATOR(receiver);
     if ((iterator->step >= 0 && iterator->curr >= iterator->end) ||
         (iterator->step < 0 && iterator->curr <= iterator->end)) {
         return UNDEFINED_VAL;
         }
-    *index   = INTEGER_VAL(iterator->index);
-    *element = INTEGER_VAL(iterator->curr);
+    *index   = INTEGER_VAL_VM(vm, iterator->index);
+    *element = INTEGER_VAL_VM(vm, iterator->curr);
     iterator->curr += iterator->step;
     iterator->index++;
     return NIL_VAL;
@@ -4,13 +4,16 @@
 #include <limits.h>
 #include <stdio.h>
 #include <string.h>
-
-#include "utf8.h"
+#ifdef __SSE2__
+#    include <emmintrin.h>
+#endif
 
 #include "dai_memory.h"
 #include "dai_objects/dai_object_array.h"
 #include "dai_objects/dai_object_error.h"
+#include "dai_strsearch.h"
 #include "dai_stringbuffer.h"
+#include "dai_utils.h"
 #include "dai_value.h"
 #include "dai_vm.h"
 
@@ -51,6 +54,122 @@ utf8offset(const char* str, int n) {
     return (char*)str;
 }
 
+// 统计前 length 个字节中的后续字节（ 0b10xxxxxx ）数量，同时检查是否只有 ASCII 字符
+static int
+utf8_count_continuation(const char* chars, int length, bool* ascii) {
+    const uint8_t* s = (const uint8_t*)chars;
+    int continuation = 0;
+    int high         = 0;
+    int i            = 0;
+#ifdef __SSE2__
+    // 0x80 - 0xBF 作为有符号数是 -128 - -65 ，比 -64 (0xC0) 小的就是后续字节
+    const __m128i threshold = _mm_set1_epi8(-64);
+    for (; i + 16 <= length; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+        continuation += __builtin_popcount(_mm_movemask_epi8(_mm_cmplt_epi8(v, threshold)));
+        high |= _mm_movemask_epi8(v);
+    }
+#endif
+    for (; i < length; i++) {
+        continuation += (s[i] & 0xC0) == 0x80;
+        high |= s[i] & 0x80;
+    }
+    *ascii = high == 0;
+    return continuation;
+}
+
+// 统计字符数（不是 0b10xxxxxx 的字节数），同时检查是否只有 ASCII 字符
+void
+DaiObjString_scan(DaiObjString* string) {
+    bool ascii;
+    int continuation    = utf8_count_continuation(string->chars, string->length, &ascii);
+    string->utf8_length = string->length - continuation;
+    if (ascii) {
+        string->obj.flags |= DAI_STRING_ASCII;
+    }
+}
+
+// 短字符串直接从头查找，不创建索引
+#define DAI_STRING_INDEX_MIN_LENGTH 256
+
+static int
+DaiObjString_indexCount(const DaiObjString* string) {
+    return string->utf8_length / DAI_STRING_INDEX_STRIDE + 1;
+}
+
+static void
+DaiObjString_buildIndex(DaiVM* vm, DaiObjString* string) {
+    int count        = DaiObjString_indexCount(string);
+    int* index       = VM_GROW_ARRAY_NOGC(vm, int, NULL, 0, count);
+    const char* s    = string->chars;
+    for (int k = 0; k < count; k++) {
+        index[k] = (int)(s - string->chars);
+        if (k + 1 < count) {
+            s = utf8offset(s, DAI_STRING_INDEX_STRIDE);
+        }
+    }
+    string->utf8_index = index;
+}
+
+// 返回第 n 个字符的指针，n 不能越界（可以等于字符数，返回字符串末尾）
+static char*
+DaiObjString_charAt(DaiVM* vm, DaiObjString* string, int n) {
+    DaiObjString_utf8Length(string);
+    if (DaiObjString_isAscii(string)) {
+        return string->chars + n;
+    }
+    if (string->length < DAI_STRING_INDEX_MIN_LENGTH) {
+        return utf8offset(string->chars, n);
+    }
+    if (string->utf8_index == NULL) {
+        DaiObjString_buildIndex(vm, string);
+    }
+    const char* s = string->chars + string->utf8_index[n / DAI_STRING_INDEX_STRIDE];
+    return utf8offset(s, n % DAI_STRING_INDEX_STRIDE);
+}
+
+void
+DaiObjString_freeIndex(DaiVM* vm, DaiObjString* string) {
+    if (string->utf8_index != NULL) {
+        VM_FREE_ARRAY(vm, int, string->utf8_index, DaiObjString_indexCount(string));
+        string->utf8_index = NULL;
+    }
+}
+
+// 把字符串的内容复制到 dst（不写结尾的 '\0'），不修改字符串。
+// 从后往前填充，右边的子字符串先出栈，循环里 s = s + x 产生的左深绳索只需要很小的栈
+static void
+DaiObjString_copyChars(const DaiObjString* string, char* dst) {
+    const DaiObjString* small[32];
+    const DaiObjString** stack = small;
+    int capacity               = 32;
+    int count                  = 0;
+    int pos                    = string->length;
+    stack[count++]             = string;
+    while (count > 0) {
+        const DaiObjString* s = stack[--count];
+        if (s->chars != NULL) {
+            pos -= s->length;
+            memcpy(dst + pos, s->chars, s->length);
+            continue;
+        }
+        if (count + 2 > capacity) {
+            const DaiObjString** bigger = ALLOCATE(const DaiObjString*, capacity * 2);
+            memcpy(bigger, stack, sizeof(const DaiObjString*) * count);
+            if (stack != small) {
+                FREE_ARRAY(const DaiObjString*, stack, capacity);
+            }
+            stack = bigger;
+            capacity *= 2;
+        }
+        stack[count++] = s->left;
+        stack[count++] = s->right;
+    }
+    if (stack != small) {
+        FREE_ARRAY(const DaiObjString*, stack, capacity);
+    }
+}
+
 static DaiValue
 DaiObjString_length(__attribute__((unused)) DaiVM* vm, DaiValue receiver, int argc,
                     DaiValue* argv) {
@@ -58,39 +177,51 @@ DaiObjString_length(__attribute__((unused)) DaiVM* vm, DaiValue receiver, int ar
         DaiObjError* err = DaiObjError_Newf(vm, "length() expected no arguments, but got %d", argc);
         return OBJ_VAL(err);
     }
-    return INTEGER_VAL(AS_STRING(receiver)->utf8_length);
+    return INTEGER_VAL(DaiObjString_utf8Length(DaiObjString_flatten(vm, AS_STRING(receiver))));
 }
 
-static DaiValue
-DaiObjString_format(__attribute__((unused)) DaiVM* vm, DaiValue receiver, int argc,
-                    DaiValue* argv) {
-    DaiStringBuffer* sb  = DaiStringBuffer_New();
-    DaiObjString* string = AS_STRING(receiver);
-    const char* format   = string->chars;
-    int i                = 0;
-    int j                = 0;
-    while (format[i] != '\0') {
-        if (format[i] == '{' && format[i + 1] == '}') {
-            if (j >= argc) {
-                DaiStringBuffer_free(sb);
-                DaiObjError* err = DaiObjError_Newf(vm, "format() not enough arguments");
-                return OBJ_VAL(err);
-            }
-            DaiValue value = argv[j];
-            char* s        = dai_value_string(value);
+DaiObjError*
+DaiObjString_formatTo(DaiVM* vm, DaiStringBuffer* sb, DaiObjString* format, int argc,
+                      DaiValue* argv, const char* name) {
+    const char* p   = DaiObjString_flatten(vm, format)->chars;
+    const char* end = p + format->length;
+    int j           = 0;
+    while (p < end) {
+        // 占位符之间的内容整段写入
+        const char* q = dai_memmem(p, end - p, "{}", 2);
+        if (q == NULL) {
+            DaiStringBuffer_writen(sb, p, end - p);
+            break;
+        }
+        DaiStringBuffer_writen(sb, p, q - p);
+        if (j >= argc) {
+            return DaiObjError_Newf(vm, "%s() not enough arguments", name);
+        }
+        DaiValue value = argv[j];
+        if (IS_STRING(value)) {
+            DaiObjString* s = DaiObjString_flatten(vm, AS_STRING(value));
+            DaiStringBuffer_writen(sb, s->chars, s->length);
+        } else {
+            char* s = dai_value_string(value);
             DaiStringBuffer_write(sb, s);
             free(s);
-            i += 2;
-            j++;
-        } else {
-            int step = utf8_one_char_length(format + i);
-            DaiStringBuffer_writen(sb, format + i, step);
-            i += step;
         }
+        p = q + 2;
+        j++;
     }
     if (j != argc) {
+        return DaiObjError_Newf(vm, "%s() too many arguments", name);
+    }
+    return NULL;
+}
+
+static DaiValue
+DaiObjString_format(__attribute__((unused)) DaiVM* vm, DaiValue receiver, int argc,
+                    DaiValue* argv) {
+    DaiStringBuffer* sb = DaiStringBuffer_New();
+    DaiObjError* err    = DaiObjString_formatTo(vm, sb, AS_STRING(receiver), argc, argv, "format");
+    if (err != NULL) {
         DaiStringBuffer_free(sb);
-        DaiObjError* err = DaiObjError_Newf(vm, "format() too many arguments");
         return OBJ_VAL(err);
     }
     size_t length = 0;
@@ -114,26 +245,27 @@ DaiObjString_sub(__attribute__((unused)) DaiVM* vm, DaiValue receiver, int argc,
             DaiObjError_Newf(vm, "sub() expected int arguments, but got %s", dai_value_ts(argv[1]));
         return OBJ_VAL(err);
     }
-    DaiObjString* string = AS_STRING(receiver);
+    DaiObjString* string = DaiObjString_flatten(vm, AS_STRING(receiver));
+    int utf8_length      = DaiObjString_utf8Length(string);
     int start            = AS_INTEGER(argv[0]);
-    int end              = argc == 1 ? string->utf8_length : AS_INTEGER(argv[1]);
+    int end              = argc == 1 ? utf8_length : AS_INTEGER(argv[1]);
     if (start < 0) {
-        start += string->utf8_length;
+        start += utf8_length;
         if (start < 0) {
             start = 0;
         }
     }
     if (end < 0) {
-        end += string->utf8_length;
-    } else if (end > string->utf8_length) {
-        end = string->utf8_length;
+        end += utf8_length;
+    } else if (end > utf8_length) {
+        end = utf8_length;
     }
     if (start >= end) {
         return OBJ_VAL(dai_copy_string(vm, "", 0));
     }
-    char* s = utf8offset(string->chars, start);
-    char* e = utf8offset(s, end - start);
-    return OBJ_VAL(dai_copy_string(vm, s, e - s));
+    char* s = DaiObjString_charAt(vm, string, start);
+    char* e = DaiObjString_charAt(vm, string, end);
+    return OBJ_VAL(dai_slice_string(vm, string, s, e - s));
 }
 
 static DaiValue
@@ -147,31 +279,41 @@ DaiObjString_find(__attribute__((unused)) DaiVM* vm, DaiValue receiver, int argc
             vm, "find() expected string arguments, but got %s", dai_value_ts(argv[0]));
         return OBJ_VAL(err);
     }
-    DaiObjString* string = AS_STRING(receiver);
-    DaiObjString* sub    = AS_STRING(argv[0]);
+    DaiObjString* string = DaiObjString_flatten(vm, AS_STRING(receiver));
+    DaiObjString* sub    = DaiObjString_flatten(vm, AS_STRING(argv[0]));
     if (string->length < sub->length) {
         return INTEGER_VAL(-1);
     }
-    char* s = strstr(string->chars, sub->chars);
+    const char* s = dai_memmem(string->chars, string->length, sub->chars, sub->length);
     if (s == NULL) {
         return INTEGER_VAL(-1);
     }
-    return INTEGER_VAL(utf8nlen(string->chars, s - string->chars));
+    // 字节偏移转换成字符偏移
+    int offset = s - string->chars;
+    DaiObjString_utf8Length(string);
+    if (DaiObjString_isAscii(string)) {
+        return INTEGER_VAL(offset);
+    }
+    bool ascii;
+    return INTEGER_VAL(offset - utf8_count_continuation(string->chars, offset, &ascii));
 }
 
 static char*
-DaiObjString_replacen(DaiObjString* s, DaiObjString* old, DaiObjString* new, int max_replacements) {
+DaiObjString_replacen(DaiObjString* s, DaiObjString* old, DaiObjString* new, int max_replacements,
+                      size_t* length) {
     DaiStringBuffer* sb = DaiStringBuffer_New();
     const char* p       = s->chars;
     const char* end     = s->chars + s->length;
     int old_len         = old->length;
     int new_len         = new->length;
+    // 结果一般和原来的字符串差不多长，先分配好，避免多次扩容
+    DaiStringBuffer_grow(sb, s->length + 1);
     while (p < end) {
         if (max_replacements == 0) {
             DaiStringBuffer_writen(sb, p, end - p);
             break;
         }
-        const char* q = strstr(p, old->chars);
+        const char* q = dai_memmem(p, end - p, old->chars, old_len);
         if (q == NULL) {
             DaiStringBuffer_writen(sb, p, end - p);
             break;
@@ -181,9 +323,7 @@ DaiObjString_replacen(DaiObjString* s, DaiObjString* old, DaiObjString* new, int
         p = q + old_len;
         max_replacements--;
     }
-    size_t length = 0;
-    char* res     = DaiStringBuffer_getAndFree(sb, &length);
-    return res;
+    return DaiStringBuffer_getAndFree(sb, length);
 }
 
 static DaiValue
@@ -209,16 +349,17 @@ DaiObjString_replace(__attribute__((unused)) DaiVM* vm, DaiValue receiver, int a
             vm, "replace() expected int arguments, but got %s", dai_value_ts(argv[2]));
         return OBJ_VAL(err);
     }
-    DaiObjString* string = AS_STRING(receiver);
-    DaiObjString* old    = AS_STRING(argv[0]);
+    DaiObjString* string = DaiObjString_flatten(vm, AS_STRING(receiver));
+    DaiObjString* old    = DaiObjString_flatten(vm, AS_STRING(argv[0]));
     if (old->length == 0) {
         DaiObjError* err = DaiObjError_Newf(vm, "replace() empty old string");
         return OBJ_VAL(err);
     }
-    DaiObjString* new = AS_STRING(argv[1]);
+    DaiObjString* new = DaiObjString_flatten(vm, AS_STRING(argv[1]));
     int count         = argc == 3 ? AS_INTEGER(argv[2]) : INT_MAX;
-    char* res         = DaiObjString_replacen(string, old, new, count);
-    return OBJ_VAL(dai_take_string(vm, res, strlen(res)));
+    size_t length     = 0;
+    char* res         = DaiObjString_replacen(string, old, new, count, &length);
+    return OBJ_VAL(dai_take_string(vm, res, length));
 }
 
 static DaiValue
@@ -230,16 +371,18 @@ DaiObjString_splitn(DaiVM* vm, DaiObjString* s, DaiObjString* sep, int max_split
     int sep_len     = sep->length;
     while (p < end) {
         if (max_splits <= 0) {
-            DaiObjArray_append1(vm, array, 1, &OBJ_VAL(dai_copy_string(vm, p, end - p)));
+            DaiValue last = OBJ_VAL(dai_slice_string(vm, s, p, end - p));
+            DaiObjArray_append1(vm, array, 1, &last);
             break;
         }
-        const char* q = strstr(p, sep->chars);
+        const char* q = dai_memmem(p, end - p, sep->chars, sep_len);
         if (q == NULL) {
-            DaiObjArray_append1(vm, array, 1, &OBJ_VAL(dai_copy_string(vm, p, end - p)));
+            DaiValue last = OBJ_VAL(dai_slice_string(vm, s, p, end - p));
+            DaiObjArray_append1(vm, array, 1, &last);
             break;
         }
-        DaiObjString* sub = dai_copy_string(vm, p, q - p);
-        DaiObjArray_append1(vm, array, 1, &OBJ_VAL(sub));
+        DaiValue sub = OBJ_VAL(dai_slice_string(vm, s, p, q - p));
+        DaiObjArray_append1(vm, array, 1, &sub);
         p = q + sep_len;
         max_splits--;
     }
@@ -262,8 +405,8 @@ DaiObjString_split_whitespace(DaiVM* vm, DaiObjString* s) {
             q++;
         }
         if (p < q) {
-            DaiObjString* sub = dai_copy_string(vm, p, q - p);
-            DaiObjArray_append1(vm, array, 1, &OBJ_VAL(sub));
+            DaiValue sub = OBJ_VAL(dai_slice_string(vm, s, p, q - p));
+            DaiObjArray_append1(vm, array, 1, &sub);
         }
         p = q;
     }
@@ -274,7 +417,7 @@ DaiObjString_split_whitespace(DaiVM* vm, DaiObjString* s) {
 static DaiValue
 DaiObjString_split(__attribute__((unused)) DaiVM* vm, DaiValue receiver, int argc, DaiValue* argv) {
     if (argc == 0) {
-        return DaiObjString_split_whitespace(vm, AS_STRING(receiver));
+        return DaiObjString_split_whitespace(vm, DaiObjString_flatten(vm, AS_STRING(receiver)));
     }
     if ((argc != 1) && (argc != 2)) {
         DaiObjError* err = DaiObjError_Newf(vm, "split() expected 0-2 arguments, but got %d", argc);
@@ -290,8 +433,8 @@ DaiObjString_split(__attribute__((unused)) DaiVM* vm, DaiValue receiver, int arg
             vm, "split() expected int arguments, but got %s", dai_value_ts(argv[1]));
         return OBJ_VAL(err);
     }
-    DaiObjString* string = AS_STRING(receiver);
-    DaiObjString* sep    = AS_STRING(argv[0]);
+    DaiObjString* string = DaiObjString_flatten(vm, AS_STRING(receiver));
+    DaiObjString* sep    = DaiObjString_flatten(vm, AS_STRING(argv[0]));
     if (sep->length == 0) {
         DaiObjError* err = DaiObjError_Newf(vm, "split() empty separator");
         return OBJ_VAL(err);
@@ -312,7 +455,7 @@ DaiObjString_join(__attribute__((unused)) DaiVM* vm, DaiValue receiver, int argc
             vm, "join() expected array arguments, but got %s", dai_value_ts(argv[0]));
         return OBJ_VAL(err);
     }
-    DaiObjString* sep  = AS_STRING(receiver);
+    DaiObjString* sep  = DaiObjString_flatten(vm, AS_STRING(receiver));
     DaiObjArray* array = AS_ARRAY(argv[0]);
     if (array->length == 0) {
         return OBJ_VAL(dai_copy_string(vm, "", 0));
@@ -328,9 +471,10 @@ DaiObjString_join(__attribute__((unused)) DaiVM* vm, DaiValue receiver, int argc
                                  i);
             return OBJ_VAL(err);
         }
-        DaiStringBuffer_write(sb, AS_STRING(array->elements[i])->chars);
+        DaiObjString* element = DaiObjString_flatten(vm, AS_STRING(array->elements[i]));
+        DaiStringBuffer_writen(sb, element->chars, element->length);
         if (i != array->length - 1) {
-            DaiStringBuffer_write(sb, sep->chars);
+            DaiStringBuffer_writen(sb, sep->chars, sep->length);
         }
     }
     size_t length = 0;
@@ -349,9 +493,9 @@ DaiObjString_has(__attribute__((unused)) DaiVM* vm, DaiValue receiver, int argc,
             vm, "has() expected string arguments, but got %s", dai_value_ts(argv[0]));
         return OBJ_VAL(err);
     }
-    DaiObjString* string = AS_STRING(receiver);
-    DaiObjString* sub    = AS_STRING(argv[0]);
-    char* s              = strstr(string->chars, sub->chars);
+    DaiObjString* string = DaiObjString_flatten(vm, AS_STRING(receiver));
+    DaiObjString* sub    = DaiObjString_flatten(vm, AS_STRING(argv[0]));
+    const char* s = dai_memmem(string->chars, string->length, sub->chars, sub->length);
     return BOOL_VAL(s != NULL);
 }
 
@@ -361,7 +505,7 @@ DaiObjString_strip(__attribute__((unused)) DaiVM* vm, DaiValue receiver, int arg
         DaiObjError* err = DaiObjError_Newf(vm, "strip() expected no arguments, but got %d", argc);
         return OBJ_VAL(err);
     }
-    DaiObjString* string = AS_STRING(receiver);
+    DaiObjString* string = DaiObjString_flatten(vm, AS_STRING(receiver));
     const char* p        = string->chars;
     const char* end      = string->chars + string->length;
     while (p < end && isspace(*p)) {
@@ -373,7 +517,7 @@ DaiObjString_strip(__attribute__((unused)) DaiVM* vm, DaiValue receiver, int arg
     if (p == string->chars && end == string->chars + string->length) {
         return receiver;
     }
-    return OBJ_VAL(dai_copy_string(vm, p, end - p));
+    return OBJ_VAL(dai_slice_string(vm, string, p, end - p));
 }
 
 static DaiValue
@@ -389,9 +533,10 @@ DaiObjString_startswith(__attribute__((unused)) DaiVM* vm, DaiValue receiver, in
             vm, "startswith() expected string arguments, but got %s", dai_value_ts(argv[0]));
         return OBJ_VAL(err);
     }
-    DaiObjString* string = AS_STRING(receiver);
-    DaiObjString* sub    = AS_STRING(argv[0]);
-    return BOOL_VAL(strncmp(string->chars, sub->chars, sub->length) == 0);
+    DaiObjString* string = DaiObjString_flatten(vm, AS_STRING(receiver));
+    DaiObjString* sub    = DaiObjString_flatten(vm, AS_STRING(argv[0]));
+    return BOOL_VAL(string->length >= sub->length &&
+                    memcmp(string->chars, sub->chars, sub->length) == 0);
 }
 
 static DaiValue
@@ -407,10 +552,11 @@ DaiObjString_endswith(__attribute__((unused)) DaiVM* vm, DaiValue receiver, int
             vm, "endswith() expected string arguments, but got %s", dai_value_ts(argv[0]));
         return OBJ_VAL(err);
     }
-    DaiObjString* string = AS_STRING(receiver);
-    DaiObjString* sub    = AS_STRING(argv[0]);
+    DaiObjString* string = DaiObjString_flatten(vm, AS_STRING(receiver));
+    DaiObjString* sub    = DaiObjString_flatten(vm, AS_STRING(argv[0]));
     return BOOL_VAL(
-        strncmp(string->chars + string->length - sub->length, sub->chars, sub->length) == 0);
+        string->length >= sub->length &&
+        memcmp(string->chars + string->length - sub->length, sub->chars, sub->length) == 0);
 }
 
 enum DaiObjStringFunctionNo {
@@ -538,7 +684,15 @@ DaiObjString_get_property(DaiVM* vm, DaiValue receiver, DaiObjString* name) {
 
 static char*
 DaiObjString_String(DaiValue value, __attribute__((unused)) DaiPtrArray* visited) {
-    return strdup(AS_STRING(value)->chars);
+    DaiObjString* string = AS_STRING(value);
+    if (string->chars != NULL) {
+        return strndup(string->chars, string->length);
+    }
+    // 没有虚拟机不能记账，复制一份内容，不拼接绳索字符串
+    char* s = malloc(string->length + 1);
+    DaiObjString_copyChars(string, s);
+    s[string->length] = '\0';
+    return s;
 }
 
 static DaiValue
@@ -547,16 +701,17 @@ DaiObjString_subscript_get(DaiVM* vm, DaiValue receiver, DaiValue index) {
         DaiObjError* err = DaiObjError_Newf(vm, "index must be integer");
         return OBJ_VAL(err);
     }
-    DaiObjString* string = AS_STRING(receiver);
+    DaiObjString* string = DaiObjString_flatten(vm, AS_STRING(receiver));
+    int utf8_length      = DaiObjString_utf8Length(string);
     int i                = AS_INTEGER(index);
     if (i < 0) {
-        i += string->utf8_length;
+        i += utf8_length;
     }
-    if (i < 0 || i >= string->utf8_length) {
+    if (i < 0 || i >= utf8_length) {
         DaiObjError* err = DaiObjError_Newf(vm, "index out of range");
         return OBJ_VAL(err);
     }
-    char* s = utf8offset(string->chars, i);
+    char* s = DaiObjString_charAt(vm, string, i);
     return OBJ_VAL(dai_copy_string(vm, s, utf8_one_char_length(s)));
 }
 
@@ -571,13 +726,41 @@ static int
 DaiObjString_equal(DaiValue a, DaiValue b, __attribute__((unused)) int* limit) {
     DaiObjString* sa = AS_STRING(a);
     DaiObjString* sb = AS_STRING(b);
-    return (sa == sb) ||
-           (sa->length == sb->length && strncmp(sa->chars, sb->chars, sa->length) == 0);
+    if (sa == sb) {
+        return true;
+    }
+    if (sa->length != sb->length) {
+        return false;
+    }
+    // 两边都已经算过哈希值的话先比较哈希值，不为了比较去计算哈希值
+    if (sa->hash != 0 && sb->hash != 0 && sa->hash != sb->hash) {
+        return false;
+    }
+    if (sa->chars != NULL && sb->chars != NULL) {
+        return memcmp(sa->chars, sb->chars, sa->length) == 0;
+    }
+    // 复制绳索字符串的内容比较
+    char* ca = sa->chars != NULL ? sa->chars : malloc(sa->length);
+    char* cb = sb->chars != NULL ? sb->chars : malloc(sb->length);
+    if (sa->chars == NULL) {
+        DaiObjString_copyChars(sa, ca);
+    }
+    if (sb->chars == NULL) {
+        DaiObjString_copyChars(sb, cb);
+    }
+    int ret = memcmp(ca, cb, sa->length) == 0;
+    if (sa->chars == NULL) {
+        free(ca);
+    }
+    if (sb->chars == NULL) {
+        free(cb);
+    }
+    return ret;
 }
 
 static uint64_t
-DaiObjString_hash(DaiValue value) {
-    return AS_STRING(value)->hash;
+DaiObjString_hashValue(DaiValue value) {
+    return DaiObjString_hash(AS_STRING(value));
 }
 
 static struct DaiObjOperation string_operation = {
@@ -587,7 +770,7 @@ static struct DaiObjOperation string_operation = {
     .subscript_set_func = DaiObjString_subscript_set,
     .string_func        = DaiObjString_String,
     .equal_func         = DaiObjString_equal,
-    .hash_func          = DaiObjString_hash,
+    .hash_func          = DaiObjString_hashValue,
     .iter_init_func     = NULL,
     .iter_next_func     = NULL,
     .get_method_func    = DaiObjString_get_property,
@@ -595,69 +778,166 @@ static struct DaiObjOperation string_operation = {
 
 
 static DaiObjString*
-allocate_string(DaiVM* vm, char* chars, int length, uint32_t hash) {
+allocate_string(DaiVM* vm, char* chars, int length, uint64_t hash) {
     DaiObjString* string  = ALLOCATE_OBJ(vm, DaiObjString, DaiObjType_string);
     string->length        = length;
-    string->utf8_length   = utf8len(chars);
+    string->utf8_length   = -1;
     string->chars         = chars;
     string->hash          = hash;
+    string->utf8_index    = NULL;
+    string->left          = NULL;
+    string->right         = NULL;
     string->obj.operation = &string_operation;
+    return string;
+}
+
+// 只有标识符、常量和显式驻留的字符串放进字符串表，
+// 运行时产生的字符串（拼接、切分等）不放进去，字符串表不会随着存活的字符串一起增长
+static DaiObjString*
+intern_string(DaiVM* vm, DaiObjString* string) {
     DaiTable_set(&vm->strings, string, NIL_VAL);
+    string->obj.flags |= DAI_STRING_INTERNED;
     return string;
 }
-static uint32_t
+
+// 0 用来表示还没有计算哈希值，哈希值恰好是 0 的换成 1
+static uint64_t
 hash_string(const char* key, int length) {
-    uint32_t hash = 2166136261u;
-    for (int i = 0; i < length; i++) {
-        hash ^= (uint8_t)key[i];
-        hash *= 16777619;
+    uint64_t hash = dai_hash_bytes(key, length);
+    return hash == 0 ? 1 : hash;
+}
+
+uint64_t
+DaiObjString_computeHash(DaiObjString* string) {
+    if (string->chars != NULL) {
+        string->hash = hash_string(string->chars, string->length);
+    } else {
+        // 绳索字符串复制出内容计算，不展开，展开需要分配 GC 内存
+        char* chars = malloc(string->length);
+        DaiObjString_copyChars(string, chars);
+        string->hash = hash_string(chars, string->length);
+        free(chars);
+    }
+    return string->hash;
+}
+
+// 增量回收时字符串表里可能还有没被清除的未标记字符串，找到之后重新标记，避免它被清除。
+// 字符串不引用其他对象，不需要放进灰色栈
+static DaiObjString*
+find_interned_string(DaiVM* vm, const char* chars, int length, uint64_t hash) {
+    DaiObjString* interned = DaiTable_findString(&vm->strings, chars, length, hash);
+    if (interned != NULL && vm->gcPhase != DaiGCPhase_idle) {
+        dai_gc_set_marked(&interned->obj);
     }
-    return hash;
+    return interned;
 }
 
 DaiObjString*
 dai_find_string_intern(DaiVM* vm, const char* chars, int length) {
-    uint32_t hash = hash_string(chars, length);
-    return DaiTable_findString(&vm->strings, chars, length, hash);
+    uint64_t hash = hash_string(chars, length);
+    return find_interned_string(vm, chars, length, hash);
 }
 
 DaiObjString*
 dai_take_string_intern(DaiVM* vm, char* chars, int length) {
-    uint32_t hash          = hash_string(chars, length);
-    DaiObjString* interned = DaiTable_findString(&vm->strings, chars, length, hash);
+    uint64_t hash          = hash_string(chars, length);
+    DaiObjString* interned = find_interned_string(vm, chars, length, hash);
     if (interned != NULL) {
         FREE_ARRAY(char, chars, length + 1);
         return interned;
     }
 
-    return allocate_string(vm, chars, length, hash);
+    return intern_string(vm, allocate_string(vm, chars, length, hash));
 }
 DaiObjString*
 dai_copy_string_intern(DaiVM* vm, const char* chars, int length) {
-    uint32_t hash          = hash_string(chars, length);
-    DaiObjString* interned = DaiTable_findString(&vm->strings, chars, length, hash);
+    uint64_t hash          = hash_string(chars, length);
+    DaiObjString* interned = find_interned_string(vm, chars, length, hash);
     if (interned != NULL) return interned;
 
     char* heap_chars = VM_ALLOCATE(vm, char, length + 1);
     memcpy(heap_chars, chars, length);
     heap_chars[length] = '\0';
-    return allocate_string(vm, heap_chars, length, hash);
+    return intern_string(vm, allocate_string(vm, heap_chars, length, hash));
+}
+
+DaiObjString*
+dai_intern_string(DaiVM* vm, DaiObjString* string) {
+    if (DaiObjString_isInterned(string)) {
+        return string;
+    }
+    DaiObjString_cstring(vm, string);
+    DaiObjString* interned =
+        find_interned_string(vm, string->chars, string->length, DaiObjString_hash(string));
+    if (interned != NULL) {
+        return interned;
+    }
+    return intern_string(vm, string);
 }
 
+// 运行时产生的字符串大多不会被哈希，哈希值等到第一次使用时再计算
 DaiObjString*
 dai_take_string(DaiVM* vm, char* chars, int length) {
-    uint32_t hash = hash_string(chars, length);
-    return allocate_string(vm, chars, length, hash);
+    return allocate_string(vm, chars, length, 0);
 }
 
 DaiObjString*
 dai_copy_string(DaiVM* vm, const char* chars, int length) {
-    uint32_t hash    = hash_string(chars, length);
     char* heap_chars = VM_ALLOCATE(vm, char, length + 1);
     memcpy(heap_chars, chars, length);
     heap_chars[length] = '\0';
-    return allocate_string(vm, heap_chars, length, hash);
+    return allocate_string(vm, heap_chars, length, 0);
+}
+
+// #region 绳索字符串
+DaiObjString*
+DaiObjString_concat(DaiVM* vm, DaiObjString* a, DaiObjString* b) {
+    DaiObjString* string = allocate_string(vm, NULL, a->length + b->length, 0);
+    string->left         = a;
+    string->right        = b;
+    return string;
+}
+
+void
+DaiObjString_flattenRope(DaiVM* vm, DaiObjString* string) {
+    // 不触发 GC ，调用方可能还拿着没有放到栈上的字符串指针
+    char* chars = VM_GROW_ARRAY_NOGC(vm, char, NULL, 0, string->length + 1);
+    DaiObjString_copyChars(string, chars);
+    chars[string->length] = '\0';
+    string->chars         = chars;
+    // 子字符串不再需要了，没有其他引用的话会被回收
+    string->left  = NULL;
+    string->right = NULL;
+}
+// #endregion
+
+// #region 切片字符串
+DaiObjString*
+dai_slice_string(DaiVM* vm, DaiObjString* string, const char* chars, int length) {
+    if (chars == string->chars && length == string->length) {
+        return string;
+    }
+    if (length < DAI_STRING_SLICE_MIN_LENGTH) {
+        return dai_copy_string(vm, chars, length);
+    }
+    // 切片的切片直接引用最初的字符串
+    DaiObjString* parent = string->parent != NULL ? string->parent : string;
+    // 分配时可能触发 GC ，string 在调用方的栈上，parent 通过 string 保持存活
+    DaiObjString* slice = allocate_string(vm, (char*)chars, length, 0);
+    slice->parent       = parent;
+    return slice;
+}
+
+void
+DaiObjString_unslice(DaiVM* vm, DaiObjString* string) {
+    // 不触发 GC ，调用方可能还拿着没有放到栈上的字符串指针
+    char* chars = VM_GROW_ARRAY_NOGC(vm, char, NULL, 0, string->length + 1);
+    memcpy(chars, string->chars, string->length);
+    chars[string->length] = '\0';
+    string->chars         = chars;
+    string->parent        = NULL;
 }
+// #endregion
 
 // Function to compare two DaiObjString objects
 int
@@ -667,5 +947,5 @@ DaiObjString_cmp(DaiObjString* a, DaiObjString* b) {
     if (a->length > b->length) return 1;
 
     // If lengths are equal, compare the strings lexicographically
-    return strcmp(a->chars, b->chars);
+    return memcmp(a->chars, b->chars, a->length);
 }
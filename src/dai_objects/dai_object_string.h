@@ -2,25 +2,149 @@
 #define CBDAI_DAI_OBJECT_STRING_H
 
 #include "dai_objects/dai_object_base.h"
+#include "dai_objects/dai_object_error.h"
+#include "dai_stringbuffer.h"
+
+// 非 ASCII 字符串的字符偏移索引每隔这么多个字符记录一次字节偏移
+#define DAI_STRING_INDEX_STRIDE 32
+// 拼接结果不短于这么多字节时创建绳索字符串，不复制两边的内容
+#define DAI_STRING_ROPE_MIN_LENGTH 64
+// 切分结果不短于这么多字节时创建切片字符串，不复制内容
+#define DAI_STRING_SLICE_MIN_LENGTH 16
+// 切片不到引用的字符串长度的 1/4 ，并且引用的字符串只被切片引用时，回收时复制切片的内容，
+// 不再让小切片占着大字符串
+#define DAI_STRING_SLICE_COMPACT_RATIO 4
+
+// obj.flags 中的标志位
+#define DAI_STRING_INTERNED 0x01   // 在字符串表 vm->strings 中
+#define DAI_STRING_ASCII 0x02      // 只包含 ASCII 字符，和字符数一起计算
 
 struct DaiObjString {
     DaiObj obj;
-    int length;   // bytes length
-    int utf8_length;
+    int length;        // bytes length
+    int utf8_length;   // 字符数，小于 0 表示还没有计算，使用 DaiObjString_utf8Length 获取
     char* chars;
-    uint32_t hash;
+    // 64 位哈希值，为 0 表示还没有计算，第一次使用时计算（ DaiObjString_hash ）。
+    // 拼接、切分等产生的临时字符串大多不会被哈希
+    uint64_t hash;
+    // 字符偏移索引，第 k 项是第 k * DAI_STRING_INDEX_STRIDE 个字符的字节偏移，
+    // 只有较长的非 ASCII 字符串在按位置访问时才创建
+    int* utf8_index;
+    union {
+        // 绳索字符串（延迟拼接）的 chars 为 NULL ，内容是 left 和 right 拼起来，
+        // 第一次读取内容时用 DaiObjString_flatten 拼成连续的字符数组，然后清空 left 和 right 。
+        // length 在创建时就计算好了，hash 和其他字符串一样在第一次用到时
+        // 由 DaiObjString_hash / DaiObjString_computeHash 计算
+        struct {
+            DaiObjString* left;
+            DaiObjString* right;
+        };
+        // 切片字符串的 chars 指向 parent 的字符数组中间，没有自己的字符数组，
+        // 也不以 '\0' 结尾，需要以 '\0' 结尾的字符串时使用 DaiObjString_cstring 。
+        // parent 是普通的字符串，不是绳索字符串，也不是切片字符串
+        DaiObjString* parent;
+    };
 };
 
+// 延迟拼接两个字符串，a 和 b 的长度之和应不小于 DAI_STRING_ROPE_MIN_LENGTH
+DaiObjString*
+DaiObjString_concat(DaiVM* vm, DaiObjString* a, DaiObjString* b);
+
+void
+DaiObjString_flattenRope(DaiVM* vm, DaiObjString* string);
+
+// 确保字符串的内容是连续的字符数组，返回字符串本身
+static inline DaiObjString*
+DaiObjString_flatten(DaiVM* vm, DaiObjString* string) {
+    if (string->chars == NULL) {
+        DaiObjString_flattenRope(vm, string);
+    }
+    return string;
+}
+
+static inline bool
+DaiObjString_isInterned(const DaiObjString* string) {
+    return string->obj.flags & DAI_STRING_INTERNED;
+}
+
+static inline bool
+DaiObjString_isAscii(const DaiObjString* string) {
+    return string->obj.flags & DAI_STRING_ASCII;
+}
+
+uint64_t
+DaiObjString_computeHash(DaiObjString* string);
+
+// 返回字符串的哈希值，没有计算过的话计算之后缓存下来。
+// 字符串表、 DaiTable 、字典和类的字段表都使用这个哈希值
+static inline uint64_t
+DaiObjString_hash(DaiObjString* string) {
+    if (string->hash == 0) {
+        return DaiObjString_computeHash(string);
+    }
+    return string->hash;
+}
+
+static inline bool
+DaiObjString_isSlice(const DaiObjString* string) {
+    return string->chars != NULL && string->parent != NULL;
+}
+
+// 创建 string 中 [chars, chars + length) 这一段的字符串，较长的不复制内容，引用 string 的字符数组。
+// string 不能是绳索字符串
+DaiObjString*
+dai_slice_string(DaiVM* vm, DaiObjString* string, const char* chars, int length);
+
+// 把切片字符串的内容复制到自己的字符数组，不再引用 parent ，不触发 GC
+void
+DaiObjString_unslice(DaiVM* vm, DaiObjString* string);
+
+// 返回以 '\0' 结尾的字符数组，绳索字符串先拼接，切片字符串先复制一份自己的内容
+static inline const char*
+DaiObjString_cstring(DaiVM* vm, DaiObjString* string) {
+    DaiObjString_flatten(vm, string);
+    if (string->parent != NULL) {
+        DaiObjString_unslice(vm, string);
+    }
+    return string->chars;
+}
+
+// 扫描字符串，计算字符数和是否只包含 ASCII 字符，字符串不能是绳索字符串
+void
+DaiObjString_scan(DaiObjString* string);
+
+// 释放字符偏移索引
+void
+DaiObjString_freeIndex(DaiVM* vm, DaiObjString* string);
+
+static inline int
+DaiObjString_utf8Length(DaiObjString* string) {
+    if (string->utf8_length < 0) {
+        DaiObjString_scan(string);
+    }
+    return string->utf8_length;
+}
+
 DaiObjString*
 dai_find_string_intern(DaiVM* vm, const char* chars, int length);
 DaiObjString*
 dai_take_string_intern(DaiVM* vm, char* chars, int length);
 DaiObjString*
 dai_copy_string_intern(DaiVM* vm, const char* chars, int length);
+// 返回内容相同的驻留字符串，没有的话把 string 本身放进字符串表
+DaiObjString*
+dai_intern_string(DaiVM* vm, DaiObjString* string);
+// 不驻留，内容相同的字符串可能是不同的对象，比较时要比较内容
 DaiObjString*
 dai_take_string(DaiVM* vm, char* chars, int length);
 DaiObjString*
 dai_copy_string(DaiVM* vm, const char* chars, int length);
+// 把 format 中的 {} 依次替换成参数的字符串形式，写入到 sb ，
+// 参数数量不对时返回错误，name 是错误信息中的函数名
+DaiObjError*
+DaiObjString_formatTo(DaiVM* vm, DaiStringBuffer* sb, DaiObjString* format, int argc,
+                      DaiValue* argv, const char* name);
+// 两个字符串都不能是绳索字符串
 int
 DaiObjString_cmp(DaiObjString* s1, DaiObjString* s2);
 
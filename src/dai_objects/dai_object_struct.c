@@ -35,13 +35,14 @@ DaiObjStruct_Free(DaiVM* vm, DaiObjStruct* obj) {
     if (obj->free != NULL) {
         obj->free(vm, obj);
     }
-    VM_FREE1(vm, obj->size, obj);
+    VM_FREE_OBJ1(vm, obj->size, obj);
 }
 
 void
 DaiObjStruct_add_ref(DaiVM* vm, DaiObjStruct* obj, DaiValue value) {
     assert(obj->ref_count < sizeof(obj->refs) / sizeof(obj->refs[0]));
     obj->refs[obj->ref_count++] = value;
+    dai_gc_write_barrier(vm, (DaiObj*)obj, value);
 }
 
 // #region SimpleObjectStruct
@@ -8,6 +8,7 @@
 #include "dai_objects/dai_object_array.h"
 #include "dai_objects/dai_object_error.h"
 #include "dai_stringbuffer.h"
+#include "dai_utils.h"
 
 static DaiValue
 DaiObjTuple_subscript_get(__attribute__((unused)) DaiVM* vm, DaiValue receiver, DaiValue index) {
@@ -48,14 +49,57 @@ DaiObjTuple_String(DaiValue value, __attribute__((unused)) DaiPtrArray* visited)
     return DaiStringBuffer_getAndFree(sb, NULL);
 }
 
+// 元组按元素比较，元素个数相同并且每个元素都相等的元组相等。
+// 元素按哈希表键的规则比较，浮点数精确比较，和 DaiObjTuple_hash 保持一致
+static int
+DaiObjTuple_equal(DaiValue a, DaiValue b, int* limit) {
+    const DaiObjTuple* ta = AS_TUPLE(a);
+    const DaiObjTuple* tb = AS_TUPLE(b);
+    if (ta == tb) {
+        return 1;
+    }
+    if (ta->values.count != tb->values.count) {
+        return 0;
+    }
+    if (ta->hash != 0 && tb->hash != 0 && ta->hash != tb->hash) {
+        return 0;
+    }
+    for (int i = 0; i < ta->values.count; i++) {
+        int ret = dai_value_key_equal(ta->values.values[i], tb->values.values[i], limit);
+        if (ret != 1) {
+            return ret;
+        }
+    }
+    return 1;
+}
+
+// 组合元素的哈希值，结果缓存在元组里。
+// 不可哈希的元素（数组、字典等）当作 0 ，相等的元组哈希值仍然相同
+static uint64_t
+DaiObjTuple_hash(DaiValue value) {
+    DaiObjTuple* tuple = AS_TUPLE(value);
+    if (tuple->hash != 0) {
+        return tuple->hash;
+    }
+    uint64_t hash = (uint64_t)tuple->values.count;
+    for (int i = 0; i < tuple->values.count; i++) {
+        DaiValue element = tuple->values.values[i];
+        uint64_t h       = dai_value_is_hashable(element) ? dai_value_hash_unseeded(element) : 0;
+        // 乘以奇数常数再打散，元素的顺序会影响结果， (1, 2) 和 (2, 1) 不同
+        hash = dai_hash_mix(hash * 0x9e3779b97f4a7c15ULL + h, 0);
+    }
+    tuple->hash = hash == 0 ? 1 : hash;
+    return tuple->hash;
+}
+
 static struct DaiObjOperation tuple_operation = {
     .get_property_func  = NULL,
     .set_property_func  = NULL,
     .subscript_get_func = DaiObjTuple_subscript_get,
     .subscript_set_func = NULL,
     .string_func        = DaiObjTuple_String,
-    .equal_func         = dai_default_equal,
-    .hash_func          = dai_default_hash,
+    .equal_func         = DaiObjTuple_equal,
+    .hash_func          = DaiObjTuple_hash,
     .iter_init_func     = NULL,
     .iter_next_func     = NULL,
     .get_method_func    = NULL,
@@ -66,17 +110,19 @@ DaiObjTuple_New(DaiVM* vm) {
     DaiObjTuple* tuple   = ALLOCATE_OBJ(vm, DaiObjTuple, DaiObjType_tuple);
     tuple->obj.operation = &tuple_operation;
     DaiValueArray_init(&tuple->values);
+    tuple->hash = 0;
     return tuple;
 }
 
 void
 DaiObjTuple_Free(DaiVM* vm, DaiObjTuple* tuple) {
     DaiValueArray_reset(&tuple->values);
-    VM_FREE(vm, DaiObjTuple, tuple);
+    VM_FREE_OBJ(vm, DaiObjTuple, tuple);
 }
 void
 DaiObjTuple_append(DaiObjTuple* tuple, DaiValue value) {
     DaiValueArray_write(&tuple->values, value);
+    tuple->hash = 0;
 }
 
 int
@@ -94,5 +140,6 @@ void
 DaiObjTuple_set(DaiObjTuple* tuple, int index, DaiValue value) {
     assert(index >= 0 && index < tuple->values.count);
     tuple->values.values[index] = value;
+    tuple->hash                 = 0;
 }
 // #endregion
@@ -6,6 +6,8 @@
 typedef struct {
     DaiObj obj;
     DaiValueArray values;
+    // 按元素计算的哈希值，为 0 表示还没有计算，元素改变时清零
+    uint64_t hash;
 } DaiObjTuple;
 DaiObjTuple*
 DaiObjTuple_New(DaiVM* vm);
@@ -0,0 +1,528 @@
+/*
+虚拟机对象的内存池
+
+小对象按 DAI_POOL_GRANULE 向上取整分成若干个大小级别，每个级别从自己的页里分配。
+页按 DAI_POOL_PAGE_SIZE 对齐，页头放在页的开始，用对象地址就能找到页头。
+新页从前往后顺序分配（ bump ），释放的位置放进页内的空闲链表，下次优先使用。
+每个级别的页分成还有空位的和已经满了的两条链表，页里的对象都释放之后把整页还给系统。
+
+页头里有两个侧边位图：分配位图记录哪些位置上有对象，标记位图给垃圾回收使用。
+清除时一页一页地遍历“已分配但没有标记”的位，不需要对象链表。
+大对象单独用 malloc 分配，前面加一个 DaiPoolLarge 头，标记位放在头里。
+*/
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#    include <malloc.h>
+#endif
+
+#include "dai_pool.h"
+
+#if defined(__SANITIZE_ADDRESS__)
+#    define DAI_POOL_ASAN
+#elif defined(__has_feature)
+#    if __has_feature(address_sanitizer)
+#        define DAI_POOL_ASAN
+#    endif
+#endif
+
+// 开启 ASan 时把空闲的位置标记为不可访问，这样内存池不会掩盖释放后使用的 bug
+#ifdef DAI_POOL_ASAN
+#    include <sanitizer/asan_interface.h>
+#    define POOL_POISON(pointer, size) ASAN_POISON_MEMORY_REGION(pointer, size)
+#    define POOL_UNPOISON(pointer, size) ASAN_UNPOISON_MEMORY_REGION(pointer, size)
+#else
+#    define POOL_POISON(pointer, size) ((void)(pointer), (void)(size))
+#    define POOL_UNPOISON(pointer, size) ((void)(pointer), (void)(size))
+#endif
+
+#define PAGE_HEADER_SIZE                                                                  \
+    ((sizeof(DaiPoolPage) + DAI_POOL_GRANULE - 1) / DAI_POOL_GRANULE * DAI_POOL_GRANULE)
+
+// 大对象的头不能破坏对象的对齐
+_Static_assert(sizeof(DaiPoolLarge) % DAI_POOL_GRANULE == 0, "DaiPoolLarge must keep alignment");
+
+static inline size_t
+class_index_of(size_t size) {
+    return (size - 1) / DAI_POOL_GRANULE;
+}
+
+static inline void*
+page_slot(DaiPoolPage* page, size_t bit_index) {
+    return (char*)page + bit_index * DAI_POOL_GRANULE;
+}
+
+// #region 链表操作
+
+static void
+page_list_push(DaiPoolPage** head, DaiPoolPage* page, DaiPoolState state) {
+    page->prev  = NULL;
+    page->next  = *head;
+    page->state = state;
+    if (*head != NULL) {
+        (*head)->prev = page;
+    }
+    *head = page;
+}
+
+static void
+page_list_remove(DaiPoolPage** head, DaiPoolPage* page) {
+    if (page->prev != NULL) {
+        page->prev->next = page->next;
+    } else {
+        *head = page->next;
+    }
+    if (page->next != NULL) {
+        page->next->prev = page->prev;
+    }
+    page->prev  = NULL;
+    page->next  = NULL;
+    page->state = DaiPoolState_detached;
+}
+
+// 把 list 整个接到 *head 前面，并修改状态
+static void
+page_list_splice(DaiPoolPage** head, DaiPoolPage* list, DaiPoolState state) {
+    if (list == NULL) {
+        return;
+    }
+    DaiPoolPage* last = list;
+    while (true) {
+        last->state = state;
+        if (last->next == NULL) {
+            break;
+        }
+        last = last->next;
+    }
+    last->next = *head;
+    if (*head != NULL) {
+        (*head)->prev = last;
+    }
+    *head = list;
+}
+
+static void
+large_list_push(DaiPoolLarge** head, DaiPoolLarge* large, DaiPoolState state) {
+    large->prev  = NULL;
+    large->next  = *head;
+    large->state = state;
+    if (*head != NULL) {
+        (*head)->prev = large;
+    }
+    *head = large;
+}
+
+static void
+large_list_remove(DaiPoolLarge** head, DaiPoolLarge* large) {
+    if (large->prev != NULL) {
+        large->prev->next = large->next;
+    } else {
+        *head = large->next;
+    }
+    if (large->next != NULL) {
+        large->next->prev = large->prev;
+    }
+    large->prev  = NULL;
+    large->next  = NULL;
+    large->state = DaiPoolState_detached;
+}
+
+// #endregion
+
+// #region 页的申请和释放
+
+static void*
+page_alloc(void) {
+#ifdef _WIN32
+    void* memory = _aligned_malloc(DAI_POOL_PAGE_SIZE, DAI_POOL_PAGE_SIZE);
+#else
+    void* memory = aligned_alloc(DAI_POOL_PAGE_SIZE, DAI_POOL_PAGE_SIZE);
+#endif
+    if (memory == NULL) {
+        abort();
+    }
+    return memory;
+}
+
+static void
+page_release(DaiPool* pool, DaiPoolPage* page) {
+    POOL_UNPOISON(page, DAI_POOL_PAGE_SIZE);
+#ifdef _WIN32
+    _aligned_free(page);
+#else
+    free(page);
+#endif
+    pool->page_count--;
+}
+
+// 把页恢复成刚申请时的状态
+static void
+page_clear(DaiPool* pool, DaiPoolPage* page) {
+    size_t slot_size  = pool->classes[page->class_index].slot_size;
+    size_t slot_count = (DAI_POOL_PAGE_SIZE - PAGE_HEADER_SIZE) / slot_size;
+    page->free_list   = NULL;
+    page->bump        = (char*)page + PAGE_HEADER_SIZE;
+    page->end         = page->bump + slot_count * slot_size;
+    page->used        = 0;
+    memset(page->alloc_bits, 0, sizeof(page->alloc_bits));
+    memset(page->mark_bits, 0, sizeof(page->mark_bits));
+    POOL_POISON(page->bump, page->end - page->bump);
+}
+
+static DaiPoolPage*
+page_new(DaiPool* pool, size_t class_index) {
+    DaiPoolPage* page = page_alloc();
+    page->prev        = NULL;
+    page->next        = NULL;
+    page->class_index = class_index;
+    page->state       = DaiPoolState_detached;
+    page_clear(pool, page);
+    pool->page_count++;
+    return page;
+}
+
+// 页不在任何链表中时，按使用情况放回对应的链表
+static void
+page_place(DaiPool* pool, DaiPoolPage* page) {
+    DaiPoolClass* cls = &pool->classes[page->class_index];
+    if (page->used == 0) {
+        // 页空了，留一个备用，其他的还给系统
+        if (cls->empty == NULL) {
+            page_clear(pool, page);
+            cls->empty = page;
+        } else {
+            page_release(pool, page);
+        }
+    } else if (page->free_list == NULL && page->bump == page->end) {
+        page_list_push(&cls->full, page, DaiPoolState_full);
+    } else {
+        page_list_push(&cls->partial, page, DaiPoolState_partial);
+    }
+}
+
+// #endregion
+
+void
+DaiPool_init(DaiPool* pool) {
+    for (size_t i = 0; i < DAI_POOL_CLASS_COUNT; i++) {
+        pool->classes[i].slot_size = (i + 1) * DAI_POOL_GRANULE;
+        pool->classes[i].partial   = NULL;
+        pool->classes[i].full      = NULL;
+        pool->classes[i].unswept   = NULL;
+        pool->classes[i].empty     = NULL;
+    }
+    pool->large         = NULL;
+    pool->large_unswept = NULL;
+    pool->page_count    = 0;
+    pool->sweep_class   = 0;
+}
+
+static void
+release_page_list(DaiPool* pool, DaiPoolPage* page) {
+    while (page != NULL) {
+        DaiPoolPage* next = page->next;
+        page_release(pool, page);
+        page = next;
+    }
+}
+
+static void
+release_large_list(DaiPoolLarge* large) {
+    while (large != NULL) {
+        DaiPoolLarge* next = large->next;
+        free(large);
+        large = next;
+    }
+}
+
+void
+DaiPool_reset(DaiPool* pool) {
+    for (size_t i = 0; i < DAI_POOL_CLASS_COUNT; i++) {
+        DaiPoolClass* cls = &pool->classes[i];
+        release_page_list(pool, cls->partial);
+        release_page_list(pool, cls->full);
+        release_page_list(pool, cls->unswept);
+        release_page_list(pool, cls->empty);
+        cls->partial = NULL;
+        cls->full    = NULL;
+        cls->unswept = NULL;
+        cls->empty   = NULL;
+    }
+    release_large_list(pool->large);
+    release_large_list(pool->large_unswept);
+    pool->large         = NULL;
+    pool->large_unswept = NULL;
+    pool->sweep_class   = 0;
+    assert(pool->page_count == 0);
+}
+
+void*
+DaiPool_alloc(DaiPool* pool, size_t size) {
+    assert(size > 0);
+    if (size > DAI_POOL_MAX_SIZE) {
+        DaiPoolLarge* large = malloc(sizeof(DaiPoolLarge) + size);
+        if (large == NULL) {
+            abort();
+        }
+        large->size   = size;
+        large->marked = false;
+        large_list_push(&pool->large, large, DaiPoolState_full);
+        return large + 1;
+    }
+    size_t index      = class_index_of(size);
+    DaiPoolClass* cls = &pool->classes[index];
+    DaiPoolPage* page = cls->partial;
+    if (page == NULL) {
+        if (cls->empty != NULL) {
+            page       = cls->empty;
+            cls->empty = NULL;
+        } else {
+            page = page_new(pool, index);
+        }
+        page_list_push(&cls->partial, page, DaiPoolState_partial);
+    }
+
+    void* slot;
+    if (page->free_list != NULL) {
+        slot = page->free_list;
+        POOL_UNPOISON(slot, cls->slot_size);
+        page->free_list = *(void**)slot;
+    } else {
+        slot = page->bump;
+        POOL_UNPOISON(slot, cls->slot_size);
+        page->bump += cls->slot_size;
+    }
+    page->used++;
+    size_t bit = DaiPool_bitIndex(slot);
+    page->alloc_bits[bit / 64] |= (uint64_t)1 << (bit % 64);
+    if (page->free_list == NULL && page->bump == page->end) {
+        page_list_remove(&cls->partial, page);
+        page_list_push(&cls->full, page, DaiPoolState_full);
+    }
+    return slot;
+}
+
+void
+DaiPool_free(DaiPool* pool, void* pointer, size_t size) {
+    if (pointer == NULL) {
+        return;
+    }
+    if (size > DAI_POOL_MAX_SIZE) {
+        DaiPoolLarge* large = DaiPool_largeOf(pointer);
+        assert(large->size == size);
+        if (large->state == DaiPoolState_full) {
+            large_list_remove(&pool->large, large);
+        } else if (large->state == DaiPoolState_unswept) {
+            large_list_remove(&pool->large_unswept, large);
+        }
+        free(large);
+        return;
+    }
+    DaiPoolPage* page = DaiPool_pageOf(pointer);
+    DaiPoolClass* cls = &pool->classes[page->class_index];
+    assert(page->class_index == class_index_of(size));
+    size_t bit    = DaiPool_bitIndex(pointer);
+    uint64_t mask = ~((uint64_t)1 << (bit % 64));
+    page->alloc_bits[bit / 64] &= mask;
+    page->mark_bits[bit / 64] &= mask;
+    *(void**)pointer = page->free_list;
+    page->free_list  = pointer;
+    POOL_POISON(pointer, cls->slot_size);
+    page->used--;
+
+    switch ((DaiPoolState)page->state) {
+        case DaiPoolState_partial: {
+            if (page->used == 0) {
+                page_list_remove(&cls->partial, page);
+                page_place(pool, page);
+            }
+            break;
+        }
+        case DaiPoolState_full: {
+            page_list_remove(&cls->full, page);
+            page_place(pool, page);
+            break;
+        }
+        case DaiPoolState_unswept:
+        case DaiPoolState_detached: {
+            // 清除完这一页之后再决定放到哪里
+            break;
+        }
+    }
+}
+
+// #region 标记和清除
+
+static void
+clear_page_marks(DaiPoolPage* page) {
+    for (; page != NULL; page = page->next) {
+        memset(page->mark_bits, 0, sizeof(page->mark_bits));
+    }
+}
+
+static void
+clear_large_marks(DaiPoolLarge* large) {
+    for (; large != NULL; large = large->next) {
+        large->marked = false;
+    }
+}
+
+void
+DaiPool_clearMarks(DaiPool* pool) {
+    for (size_t i = 0; i < DAI_POOL_CLASS_COUNT; i++) {
+        DaiPoolClass* cls = &pool->classes[i];
+        clear_page_marks(cls->partial);
+        clear_page_marks(cls->full);
+        clear_page_marks(cls->unswept);
+    }
+    clear_large_marks(pool->large);
+    clear_large_marks(pool->large_unswept);
+}
+
+void
+DaiPool_beginSweep(DaiPool* pool) {
+    for (size_t i = 0; i < DAI_POOL_CLASS_COUNT; i++) {
+        DaiPoolClass* cls = &pool->classes[i];
+        page_list_splice(&cls->unswept, cls->partial, DaiPoolState_unswept);
+        page_list_splice(&cls->unswept, cls->full, DaiPoolState_unswept);
+        cls->partial = NULL;
+        cls->full    = NULL;
+    }
+    while (pool->large != NULL) {
+        DaiPoolLarge* large = pool->large;
+        large_list_remove(&pool->large, large);
+        large_list_push(&pool->large_unswept, large, DaiPoolState_unswept);
+    }
+    pool->sweep_class = 0;
+}
+
+// 释放一页中已分配但没有标记的对象，返回处理的对象数量
+static size_t
+sweep_page_objects(DaiPoolPage* page, DaiPoolVisitor free_object, void* ctx) {
+    size_t work = 1;
+    for (size_t i = 0; i < DAI_POOL_BITMAP_WORDS; i++) {
+        uint64_t dead = page->alloc_bits[i] & ~page->mark_bits[i];
+        work += __builtin_popcountll(page->alloc_bits[i]);
+        while (dead != 0) {
+            size_t bit = i * 64 + __builtin_ctzll(dead);
+            dead &= dead - 1;
+            free_object(page_slot(page, bit), ctx);
+        }
+    }
+    return work;
+}
+
+static size_t
+sweep_page(DaiPool* pool, DaiPoolPage* page, DaiPoolVisitor free_object, void* ctx) {
+    page_list_remove(&pool->classes[page->class_index].unswept, page);
+    size_t work = sweep_page_objects(page, free_object, ctx);
+    page_place(pool, page);
+    return work;
+}
+
+bool
+DaiPool_sweepStep(DaiPool* pool, size_t quantum, DaiPoolVisitor free_object, void* ctx) {
+    size_t work = 0;
+    while (work < quantum) {
+        if (pool->sweep_class < DAI_POOL_CLASS_COUNT) {
+            DaiPoolPage* page = pool->classes[pool->sweep_class].unswept;
+            if (page == NULL) {
+                pool->sweep_class++;
+            } else {
+                work += sweep_page(pool, page, free_object, ctx);
+            }
+            continue;
+        }
+        DaiPoolLarge* large = pool->large_unswept;
+        if (large == NULL) {
+            return true;
+        }
+        large_list_remove(&pool->large_unswept, large);
+        if (large->marked) {
+            large_list_push(&pool->large, large, DaiPoolState_full);
+        } else {
+            free_object(large + 1, ctx);
+        }
+        work++;
+    }
+    return false;
+}
+
+DaiPoolPage**
+DaiPool_takeUnswept(DaiPool* pool, size_t* count) {
+    size_t n = 0;
+    for (size_t i = 0; i < DAI_POOL_CLASS_COUNT; i++) {
+        for (DaiPoolPage* page = pool->classes[i].unswept; page != NULL; page = page->next) {
+            n++;
+        }
+    }
+    *count = n;
+    if (n == 0) {
+        return NULL;
+    }
+    DaiPoolPage** pages = malloc(sizeof(DaiPoolPage*) * n);
+    if (pages == NULL) {
+        abort();
+    }
+    n = 0;
+    for (size_t i = 0; i < DAI_POOL_CLASS_COUNT; i++) {
+        DaiPoolClass* cls = &pool->classes[i];
+        while (cls->unswept != NULL) {
+            DaiPoolPage* page = cls->unswept;
+            page_list_remove(&cls->unswept, page);
+            pages[n++] = page;
+        }
+    }
+    return pages;
+}
+
+void
+DaiPool_sweepPage(DaiPoolPage* page, DaiPoolVisitor free_object, void* ctx) {
+    assert(page->state == DaiPoolState_detached);
+    sweep_page_objects(page, free_object, ctx);
+}
+
+void
+DaiPool_placePages(DaiPool* pool, DaiPoolPage** pages, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        page_place(pool, pages[i]);
+    }
+    free(pages);
+}
+
+static void
+iter_page_list(DaiPoolPage* page, DaiPoolVisitor visitor, void* ctx) {
+    for (; page != NULL; page = page->next) {
+        for (size_t i = 0; i < DAI_POOL_BITMAP_WORDS; i++) {
+            uint64_t bits = page->alloc_bits[i];
+            while (bits != 0) {
+                size_t bit = i * 64 + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                visitor(page_slot(page, bit), ctx);
+            }
+        }
+    }
+}
+
+static void
+iter_large_list(DaiPoolLarge* large, DaiPoolVisitor visitor, void* ctx) {
+    for (; large != NULL; large = large->next) {
+        visitor(large + 1, ctx);
+    }
+}
+
+void
+DaiPool_iter(DaiPool* pool, DaiPoolVisitor visitor, void* ctx) {
+    for (size_t i = 0; i < DAI_POOL_CLASS_COUNT; i++) {
+        DaiPoolClass* cls = &pool->classes[i];
+        iter_page_list(cls->partial, visitor, ctx);
+        iter_page_list(cls->full, visitor, ctx);
+        iter_page_list(cls->unswept, visitor, ctx);
+    }
+    iter_large_list(pool->large, visitor, ctx);
+    iter_large_list(pool->large_unswept, visitor, ctx);
+}
+
+// #endregion
@@ -0,0 +1,156 @@
+/*
+虚拟机对象的内存池，按大小分级（ size class ）分配
+*/
+#ifndef CBDAI_DAI_POOL_H
+#define CBDAI_DAI_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// 页大小，页按页大小对齐，从对象地址可以直接算出它所在的页
+#define DAI_POOL_PAGE_SIZE (64 * 1024)
+// 分级的粒度，也是对象的对齐大小
+#define DAI_POOL_GRANULE 16
+// 超过这个大小的对象不放进页里，直接用 malloc 分配（大对象）
+#define DAI_POOL_MAX_SIZE 256
+#define DAI_POOL_CLASS_COUNT (DAI_POOL_MAX_SIZE / DAI_POOL_GRANULE)
+// 页的位图每个 granule 对应一位，这里是位图的 64 位字的数量
+#define DAI_POOL_BITMAP_WORDS (DAI_POOL_PAGE_SIZE / DAI_POOL_GRANULE / 64)
+
+// 页和大对象所在的链表
+typedef enum {
+    DaiPoolState_partial,    // 还有空位的页
+    DaiPoolState_full,       // 已经满了的页，或者正在使用的大对象
+    DaiPoolState_unswept,    // 等待清除，不会从这里分配
+    DaiPoolState_detached,   // 不在任何链表中（正在清除）
+} DaiPoolState;
+
+typedef struct _DaiPoolPage DaiPoolPage;
+struct _DaiPoolPage {
+    DaiPoolPage* prev;
+    DaiPoolPage* next;
+    void* free_list;   // 释放过的位置，位置的开头存放下一个空闲位置
+    char* bump;        // 还没有用过的位置从这里开始
+    char* end;
+    uint32_t used;   // 正在使用的位置数量
+    uint16_t class_index;
+    uint8_t state;   // DaiPoolState
+    // 侧边位图，按 granule 编号，只有对象开始位置对应的位会被设置。
+    // 标记时不用写对象本身，清除时按字遍历位图，不用访问存活的对象
+    uint64_t alloc_bits[DAI_POOL_BITMAP_WORDS];
+    uint64_t mark_bits[DAI_POOL_BITMAP_WORDS];
+};
+
+// 大对象前面的头
+typedef struct _DaiPoolLarge {
+    struct _DaiPoolLarge* prev;
+    struct _DaiPoolLarge* next;
+    size_t size;
+    uint8_t state;   // DaiPoolState
+    bool marked;
+} DaiPoolLarge;
+
+// 一个大小级别，同一个页里的对象大小都一样
+typedef struct {
+    size_t slot_size;
+    DaiPoolPage* partial;   // 还有空位的页（双向链表）
+    DaiPoolPage* full;      // 已经满了的页（双向链表）
+    DaiPoolPage* unswept;   // 等待清除的页（双向链表）
+    DaiPoolPage* empty;     // 留一个空页，避免对象数量在边界附近时反复申请和释放页
+} DaiPoolClass;
+
+typedef struct {
+    DaiPoolClass classes[DAI_POOL_CLASS_COUNT];
+    DaiPoolLarge* large;           // 大对象（双向链表）
+    DaiPoolLarge* large_unswept;   // 等待清除的大对象（双向链表）
+    size_t page_count;             // 当前持有的页数
+    size_t sweep_class;            // 清除进行到了哪个大小级别
+} DaiPool;
+
+// 遍历和清除时对每个对象调用
+typedef void (*DaiPoolVisitor)(void* pointer, void* ctx);
+
+void
+DaiPool_init(DaiPool* pool);
+// 释放所有的页和大对象，池里的对象都不能再使用
+void
+DaiPool_reset(DaiPool* pool);
+// 分配 size 字节，内存没有初始化，标记位是清空的
+void*
+DaiPool_alloc(DaiPool* pool, size_t size);
+// 释放 pointer ， size 必须和分配时的一样。页空了之后会被释放
+void
+DaiPool_free(DaiPool* pool, void* pointer, size_t size);
+
+// #region 标记和清除
+
+static inline DaiPoolPage*
+DaiPool_pageOf(const void* pointer) {
+    return (DaiPoolPage*)((uintptr_t)pointer & ~(uintptr_t)(DAI_POOL_PAGE_SIZE - 1));
+}
+
+static inline size_t
+DaiPool_bitIndex(const void* pointer) {
+    return ((uintptr_t)pointer & (DAI_POOL_PAGE_SIZE - 1)) / DAI_POOL_GRANULE;
+}
+
+static inline DaiPoolLarge*
+DaiPool_largeOf(const void* pointer) {
+    return (DaiPoolLarge*)pointer - 1;
+}
+
+// 页里的对象是否被标记
+static inline bool
+DaiPool_isMarked(const void* pointer) {
+    size_t index = DaiPool_bitIndex(pointer);
+    return (DaiPool_pageOf(pointer)->mark_bits[index / 64] >> (index % 64)) & 1;
+}
+
+static inline void
+DaiPool_setMarked(const void* pointer) {
+    size_t index = DaiPool_bitIndex(pointer);
+    DaiPool_pageOf(pointer)->mark_bits[index / 64] |= (uint64_t)1 << (index % 64);
+}
+
+// 多个线程同时标记时使用，原子地设置标记位，原来没有标记时返回 true
+static inline bool
+DaiPool_tryMark(const void* pointer) {
+    size_t index  = DaiPool_bitIndex(pointer);
+    uint64_t mask = (uint64_t)1 << (index % 64);
+    uint64_t* word = &DaiPool_pageOf(pointer)->mark_bits[index / 64];
+    if (__atomic_load_n(word, __ATOMIC_RELAXED) & mask) {
+        return false;
+    }
+    return (__atomic_fetch_or(word, mask, __ATOMIC_RELAXED) & mask) == 0;
+}
+
+// 清空所有对象的标记位
+void
+DaiPool_clearMarks(DaiPool* pool);
+// 开始清除：现有的页和大对象都变成等待清除，之后分配的对象不会放进等待清除的页
+void
+DaiPool_beginSweep(DaiPool* pool);
+// 清除一步，最多处理 quantum 个对象（至少处理一页），没有标记的对象交给 free_object 释放，
+// free_object 要调用 DaiPool_free 。全部清除完成时返回 true
+bool
+DaiPool_sweepStep(DaiPool* pool, size_t quantum, DaiPoolVisitor free_object, void* ctx);
+
+// 并行清除：DaiPool_beginSweep 之后取出所有等待清除的页（不包括大对象），
+// 多个线程各自用 DaiPool_sweepPage 清除不同的页，最后用 DaiPool_placePages 放回池里。
+// 取出的页不在任何链表中，清除时 DaiPool_free 只修改这一页，不会修改池
+DaiPoolPage**
+DaiPool_takeUnswept(DaiPool* pool, size_t* count);
+// 清除取出的一页，没有标记的对象交给 free_object 释放
+void
+DaiPool_sweepPage(DaiPoolPage* page, DaiPoolVisitor free_object, void* ctx);
+// 把清除完的页放回对应的链表，并释放 pages 数组
+void
+DaiPool_placePages(DaiPool* pool, DaiPoolPage** pages, size_t count);
+// 对池里的每个对象调用 visitor
+void
+DaiPool_iter(DaiPool* pool, DaiPoolVisitor visitor, void* ctx);
+
+// #endregion
+
+#endif /* CBDAI_DAI_POOL_H */
@@ -125,13 +125,23 @@ DaiStringBuffer_length(DaiStringBuffer* sb) {
     return sb->length;
 }
 
+size_t
+DaiStringBuffer_capacity(DaiStringBuffer* sb) {
+    return sb->size;
+}
+
 // 返回分配的字符串，并释放 DaiStringBuffer
 char*
 DaiStringBuffer_getAndFree(DaiStringBuffer* sb, size_t* length) {
     if (length != NULL) {
         *length = sb->length;
     }
-    char* s  = sb->data;
+    char* s = sb->data;
+    // 没有写入过内容时也返回空字符串，字符数组为 NULL 的字符串是绳索字符串
+    if (s == NULL) {
+        s    = dai_malloc(1);
+        s[0] = '\0';
+    }
     sb->data = NULL;
     dai_free(sb);
     return s;
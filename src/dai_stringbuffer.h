@@ -19,6 +19,9 @@ DaiStringBuffer_free(DaiStringBuffer* sb);
 // 返回当前缓冲区的字符串长度。
 size_t
 DaiStringBuffer_length(DaiStringBuffer* sb);
+// 返回缓冲区分配的大小。
+size_t
+DaiStringBuffer_capacity(DaiStringBuffer* sb);
 // 返回分配的字符串，并释放 DaiStringBuffer
 char*
 DaiStringBuffer_getAndFree(DaiStringBuffer* sb, size_t* length);
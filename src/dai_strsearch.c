@@ -0,0 +1,106 @@
+/*
+子串查找
+*/
+#include "dai_strsearch.h"
+
+#include <stdint.h>
+#include <string.h>
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#elif defined(__SSE2__)
+#    include <emmintrin.h>
+#endif
+
+const char*
+dai_memmem_scalar(const char* haystack, size_t haystack_len, const char* needle,
+                  size_t needle_len) {
+    if (needle_len == 0) {
+        return haystack;
+    }
+    if (needle_len > haystack_len) {
+        return NULL;
+    }
+    const char* last = haystack + haystack_len - needle_len;
+    const char* p    = haystack;
+    // 先用 memchr 找第一个字节，再比较剩下的部分
+    while (p <= last) {
+        p = memchr(p, needle[0], last - p + 1);
+        if (p == NULL) {
+            return NULL;
+        }
+        if (memcmp(p + 1, needle + 1, needle_len - 1) == 0) {
+            return p;
+        }
+        p++;
+    }
+    return NULL;
+}
+
+#if defined(__AVX2__) || defined(__SSE2__)
+// 每次取两块：从 i 开始的一块和从 i + needle_len - 1 开始的一块，
+// 第一块等于 needle 首字节、第二块等于 needle 尾字节的位置才是候选位置，
+// 首尾都相同的候选位置再比较中间的部分。
+// 常见文本中首尾同时相同的位置很少，大部分块不需要逐字节比较
+#    if defined(__AVX2__)
+#        define BLOCK_SIZE 32
+typedef __m256i Block;
+#        define BLOCK_SET1(c) _mm256_set1_epi8(c)
+#        define BLOCK_LOAD(p) _mm256_loadu_si256((const __m256i*)(p))
+#        define BLOCK_MATCH(a, b, f, l) \
+            (uint32_t) _mm256_movemask_epi8(  \
+                _mm256_and_si256(_mm256_cmpeq_epi8(a, f), _mm256_cmpeq_epi8(b, l)))
+#    else
+#        define BLOCK_SIZE 16
+typedef __m128i Block;
+#        define BLOCK_SET1(c) _mm_set1_epi8(c)
+#        define BLOCK_LOAD(p) _mm_loadu_si128((const __m128i*)(p))
+#        define BLOCK_MATCH(a, b, f, l) \
+            (uint32_t) _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, f), _mm_cmpeq_epi8(b, l)))
+#    endif
+
+static const char*
+memmem_simd(const char* haystack, size_t haystack_len, const char* needle, size_t needle_len) {
+    const Block first = BLOCK_SET1(needle[0]);
+    const Block last  = BLOCK_SET1(needle[needle_len - 1]);
+    size_t i          = 0;
+    // 第二块的结尾不能超过 haystack 的结尾
+    for (; i + needle_len - 1 + BLOCK_SIZE <= haystack_len; i += BLOCK_SIZE) {
+        const Block block_first = BLOCK_LOAD(haystack + i);
+        const Block block_last  = BLOCK_LOAD(haystack + i + needle_len - 1);
+        uint32_t mask           = BLOCK_MATCH(block_first, block_last, first, last);
+        while (mask != 0) {
+            int bit       = __builtin_ctz(mask);
+            const char* p = haystack + i + bit;
+            // 首尾两个字节已经相同了，needle 一般很短，直接比较中间的字节
+            size_t k = 1;
+            while (k < needle_len - 1 && p[k] == needle[k]) {
+                k++;
+            }
+            if (k >= needle_len - 1) {
+                return p;
+            }
+            mask &= mask - 1;
+        }
+    }
+    // 剩下不够一块的部分
+    return dai_memmem_scalar(haystack + i, haystack_len - i, needle, needle_len);
+}
+#endif
+
+const char*
+dai_memmem(const char* haystack, size_t haystack_len, const char* needle, size_t needle_len) {
+    if (needle_len == 0) {
+        return haystack;
+    }
+    if (needle_len > haystack_len) {
+        return NULL;
+    }
+    if (needle_len == 1) {
+        return memchr(haystack, needle[0], haystack_len);
+    }
+#if defined(__AVX2__) || defined(__SSE2__)
+    return memmem_simd(haystack, haystack_len, needle, needle_len);
+#else
+    return dai_memmem_scalar(haystack, haystack_len, needle, needle_len);
+#endif
+}
@@ -0,0 +1,21 @@
+/*
+子串查找，字符串的 find 、 has 、 replace 、 split 和 format 都用这里的函数。
+不要求以 '\0' 结尾，切片字符串可以直接查找
+*/
+#ifndef CBDAI_DAI_STRSEARCH_H
+#define CBDAI_DAI_STRSEARCH_H
+
+#include <stddef.h>
+
+// 在 [haystack, haystack + haystack_len) 中查找 needle 第一次出现的位置，找不到返回 NULL 。
+// needle 为空时返回 haystack 。
+// 单个字节用 memchr ，较长的用 SIMD 同时比较首尾两个字节过滤候选位置（有 SSE2 / AVX2 时）
+const char*
+dai_memmem(const char* haystack, size_t haystack_len, const char* needle, size_t needle_len);
+
+// 逐个候选位置比较的版本，没有 SIMD 时使用，测试中用来对照结果和性能
+const char*
+dai_memmem_scalar(const char* haystack, size_t haystack_len, const char* needle,
+                  size_t needle_len);
+
+#endif /* CBDAI_DAI_STRSEARCH_H */
@@ -8,6 +8,7 @@
 
 #include "dai_memory.h"
 #include "dai_symboltable.h"
+#include "dai_utils.h"
 
 // #region SymbolMap 结构体及其方法
 #define TABLE_MAX_LOAD 0.75
@@ -45,20 +46,9 @@ SymbolMap_reset(SymbolMap* table) {
     SymbolMap_init(table);
 }
 
-static uint32_t
-hash_string(const char* key, int length) {
-    uint32_t hash = 2166136261u;
-    for (int i = 0; i < length; i++) {
-        hash ^= (uint8_t)key[i];
-        hash *= 16777619;
-    }
-    return hash;
-}
-
 static SymbolEntry*
 find_entry(SymbolEntry* entries, int capacity, const char* key, int length) {
-    uint32_t hash  = hash_string(key, length);
-    uint32_t index = hash % capacity;
+    uint32_t index = dai_hash_bytes(key, length) % capacity;
 
     for (;;) {
         SymbolEntry* entry = &entries[index];
@@ -22,7 +22,7 @@ DaiTable_reset(DaiTable* table) {
 // If you change it here, make sure to update that copy.
 static Entry*
 find_entry(Entry* entries, int capacity, DaiObjString* key) {
-    uint32_t index   = key->hash & (capacity - 1);
+    uint32_t index   = DaiObjString_hash(key) & (capacity - 1);
     Entry* tombstone = NULL;
 
     for (;;) {
@@ -148,7 +148,7 @@ DaiTable_copy(DaiTable* from, DaiTable* to) {
 }
 
 DaiObjString*
-DaiTable_findString(DaiTable* table, const char* chars, int length, uint32_t hash) {
+DaiTable_findString(DaiTable* table, const char* chars, int length, uint64_t hash) {
     if (table->count == 0) return NULL;
 
     uint32_t index = hash & (table->capacity - 1);
@@ -157,7 +157,7 @@ DaiTable_findString(DaiTable* table, const char* chars, int length, uint32_t has
         if (entry->key == NULL) {
             // Stop if we find an empty non-tombstone entry.
             if (IS_NIL(entry->value)) return NULL;
-        } else if (entry->key->length == length && entry->key->hash == hash &&
+        } else if (entry->key->length == length && DaiObjString_hash(entry->key) == hash &&
                    memcmp(entry->key->chars, chars, length) == 0) {
             // We found it.
             return entry->key;
@@ -171,7 +171,7 @@ void
 tableRemoveWhite(DaiTable* table) {
     for (int i = 0; i < table->capacity; ++i) {
         Entry* entry = &table->entries[i];
-        if (entry->key != NULL && !entry->key->obj.is_marked) {
+        if (entry->key != NULL && !dai_gc_is_marked(&entry->key->obj)) {
             DaiTable_delete(table, entry->key);
         }
     }
@@ -34,7 +34,8 @@ DaiTable_addAll(DaiTable* from, DaiTable* to);
 void
 DaiTable_copy(DaiTable* from, DaiTable* to);
 DaiObjString*
-DaiTable_findString(DaiTable* table, const char* chars, int length, uint32_t hash);
+DaiTable_findString(DaiTable* table, const char* chars, int length, uint64_t hash);
+// 删除没有被标记的字符串
 void
 tableRemoveWhite(DaiTable* table);
 #endif /* CBDAI_DAI_TABLE_H */
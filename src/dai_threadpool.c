@@ -0,0 +1,139 @@
+/*
+固定数量的工作线程
+
+线程在创建之后一直等待任务，每次 DaiThreadPool_run 增加一次任务编号（ generation ）并唤醒所有线程，
+调用线程自己也执行一份任务，然后等待其他线程都执行完。
+*/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "dai_threadpool.h"
+
+typedef struct {
+    DaiThreadPool* pool;
+    int index;
+} DaiThreadArg;
+
+struct _DaiThreadPool {
+    int thread_count;   // 包括调用线程
+    pthread_t* threads;
+    DaiThreadArg* args;
+
+    pthread_mutex_t lock;
+    pthread_cond_t start;   // 有新任务或者需要退出
+    pthread_cond_t done;    // 其他线程都执行完了
+
+    uint64_t generation;   // 任务编号
+    int pending;           // 还没有执行完的线程数量（不包括调用线程）
+    bool stopping;
+    DaiThreadPoolTask task;
+    void* ctx;
+};
+
+static void*
+worker_main(void* arg) {
+    DaiThreadPool* pool = ((DaiThreadArg*)arg)->pool;
+    int index           = ((DaiThreadArg*)arg)->index;
+    uint64_t seen       = 0;
+    pthread_mutex_lock(&pool->lock);
+    while (true) {
+        while (!pool->stopping && pool->generation == seen) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->stopping) {
+            break;
+        }
+        seen                   = pool->generation;
+        DaiThreadPoolTask task = pool->task;
+        void* ctx              = pool->ctx;
+        pthread_mutex_unlock(&pool->lock);
+
+        task(ctx, index);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->pending--;
+        if (pool->pending == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+DaiThreadPool*
+DaiThreadPool_New(int thread_count) {
+    DaiThreadPool* pool = malloc(sizeof(DaiThreadPool));
+    if (pool == NULL) {
+        perror("malloc error");
+        abort();
+    }
+    pool->thread_count = thread_count < 1 ? 1 : thread_count;
+    pool->threads      = malloc(sizeof(pthread_t) * pool->thread_count);
+    pool->args         = malloc(sizeof(DaiThreadArg) * pool->thread_count);
+    if (pool->threads == NULL || pool->args == NULL) {
+        perror("malloc error");
+        abort();
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->generation = 0;
+    pool->pending    = 0;
+    pool->stopping   = false;
+    pool->task       = NULL;
+    pool->ctx        = NULL;
+    for (int i = 1; i < pool->thread_count; i++) {
+        pool->args[i].pool  = pool;
+        pool->args[i].index = i;
+        if (pthread_create(&pool->threads[i], NULL, worker_main, &pool->args[i]) != 0) {
+            perror("pthread_create error");
+            abort();
+        }
+    }
+    return pool;
+}
+
+void
+DaiThreadPool_free(DaiThreadPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 1; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool->threads);
+    free(pool->args);
+    free(pool);
+}
+
+int
+DaiThreadPool_size(const DaiThreadPool* pool) {
+    return pool->thread_count;
+}
+
+void
+DaiThreadPool_run(DaiThreadPool* pool, DaiThreadPoolTask task, void* ctx) {
+    if (pool->thread_count > 1) {
+        pthread_mutex_lock(&pool->lock);
+        pool->task    = task;
+        pool->ctx     = ctx;
+        pool->pending = pool->thread_count - 1;
+        pool->generation++;
+        pthread_cond_broadcast(&pool->start);
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    task(ctx, 0);
+
+    if (pool->thread_count > 1) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->pending > 0) {
+            pthread_cond_wait(&pool->done, &pool->lock);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
@@ -0,0 +1,28 @@
+/*
+固定数量的工作线程，用于并行垃圾回收
+*/
+#ifndef CBDAI_DAI_THREADPOOL_H
+#define CBDAI_DAI_THREADPOOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// index 是线程编号，调用 DaiThreadPool_run 的线程编号为 0
+typedef void (*DaiThreadPoolTask)(void* ctx, int index);
+
+typedef struct _DaiThreadPool DaiThreadPool;
+
+// thread_count 包括调用 DaiThreadPool_run 的线程，会额外创建 thread_count - 1 个线程
+DaiThreadPool*
+DaiThreadPool_New(int thread_count);
+// 通知所有线程退出并等待它们结束
+void
+DaiThreadPool_free(DaiThreadPool* pool);
+int
+DaiThreadPool_size(const DaiThreadPool* pool);
+// 在所有线程（包括当前线程）上执行 task ，全部执行完之后返回
+void
+DaiThreadPool_run(DaiThreadPool* pool, DaiThreadPoolTask task, void* ctx);
+
+#endif /* CBDAI_DAI_THREADPOOL_H */
@@ -18,6 +18,7 @@
 #endif
 
 #include "dai_windows.h"   // IWYU pragma: keep
+#include "hashmap.h"
 
 void
 pin_time_record(TimeRecord* record) {
@@ -38,6 +39,20 @@ pin_time_record(TimeRecord* record) {
 #endif
 }
 
+uint64_t
+dai_monotonic_ns(void) {
+#ifdef _WIN32
+    LARGE_INTEGER counter, freq;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&freq);
+    return (uint64_t)((double)counter.QuadPart * 1e9 / freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
 #ifdef _WIN32
 static double
 filetime_to_seconds(const FILETIME* ft) {
@@ -157,6 +172,11 @@ dai_line_from_file(const char* filename, int lineno) {
     return line;
 }
 
+uint64_t
+dai_hash_bytes(const void* data, size_t len) {
+    return hashmap_xxhash3(data, len, 0, 0);
+}
+
 int
 dai_generate_seed(uint8_t seed[16]) {
 #ifdef _WIN32
@@ -28,6 +28,9 @@ typedef struct {
 
 void
 pin_time_record(TimeRecord* record);
+// 单调时钟，单位是纳秒，用来计算时间间隔
+uint64_t
+dai_monotonic_ns(void);
 void
 print_used_time(TimeRecord* start, TimeRecord* end);
 
@@ -48,6 +51,23 @@ dai_get_line(const char* s, int lineno);
 char*
 dai_line_from_file(const char* filename, int lineno);
 
+// 64 位字符串哈希（ XXH64 ），字符串表、 DaiTable 、字典和符号表共用
+uint64_t
+dai_hash_bytes(const void* data, size_t len);
+
+// 把 64 位整数打散（ MurmurHash3 的 fmix64 ），输入的每一位都会影响输出的每一位。
+// 整数、浮点数的位模式和指针这类低位规律很强的值作为哈希值之前需要先打散
+static inline uint64_t
+dai_hash_mix(uint64_t x, uint64_t seed) {
+    x ^= seed;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
 // 生成随机数种子，返回 0 表示成功，-1 表示失败
 int
 dai_generate_seed(uint8_t seed[16]);
@@ -9,13 +9,14 @@
 
 #include "dai_memory.h"
 #include "dai_object.h"
+#include "dai_utils.h"
 #include "dai_value.h"
 
 #include <math.h>
 
 const char*
 dai_value_ts(DaiValue value) {
-    switch (value.type) {
+    switch (DAI_VALUE_TYPE(value)) {
         case DaiValueType_undefined: return "undefined";
         case DaiValueType_nil: return "nil";
         case DaiValueType_int: return "int";
@@ -33,25 +34,19 @@ dai_print_value(DaiValue value) {
     free(s);
 }
 
-static bool
-float_equals(double a, double b) {
-    double epsilon = 1e-10;
-    return fabs(a - b) < epsilon;
-}
-
 int
 dai_value_equal_with_limit(DaiValue a, DaiValue b, int* limit) {
     if (*limit <= 0) {
         return -1;
     }
     (*limit)--;
-    if (a.type != b.type) {
+    if (DAI_VALUE_TYPE(a) != DAI_VALUE_TYPE(b)) {
         return 0;
     }
-    switch (a.type) {
+    switch (DAI_VALUE_TYPE(a)) {
         case DaiValueType_nil: return 1;
         case DaiValueType_int: return AS_INTEGER(a) == AS_INTEGER(b);
-        case DaiValueType_float: return float_equals(AS_FLOAT(a), AS_FLOAT(b));
+        case DaiValueType_float: return dai_float_equals(AS_FLOAT(a), AS_FLOAT(b));
         case DaiValueType_bool: return AS_BOOL(a) == AS_BOOL(b);
         case DaiValueType_obj: {
             EqualFn equal_func = AS_OBJ(a)->operation->equal_func;
@@ -69,7 +64,7 @@ dai_value_equal(DaiValue a, DaiValue b) {
 
 char*
 dai_value_string_with_visited(DaiValue value, DaiPtrArray* visited) {
-    switch (value.type) {
+    switch (DAI_VALUE_TYPE(value)) {
         case DaiValueType_nil: return strdup("nil");
         case DaiValueType_int: {
             char buf[64];
@@ -100,7 +95,7 @@ dai_value_string(DaiValue value) {
 
 bool
 dai_value_is_truthy(const DaiValue value) {
-    switch (value.type) {
+    switch (DAI_VALUE_TYPE(value)) {
         case DaiValueType_nil: return false;
         case DaiValueType_bool: return AS_BOOL(value);
         case DaiValueType_int: return AS_INTEGER(value) != 0;
@@ -108,22 +103,52 @@ dai_value_is_truthy(const DaiValue value) {
     }
 }
 
+// 浮点数按位模式哈希，0.0 和 -0.0 、所有的 NaN 分别看作同一个键
+static uint64_t
+dai_float_hash(double d) {
+    if (d == 0.0) {
+        return 0;
+    }
+    if (isnan(d)) {
+        return 0x7ff8000000000000ULL;
+    }
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    return bits;
+}
+
+int
+dai_value_key_equal(DaiValue a, DaiValue b, int* limit) {
+    if (IS_FLOAT(a) && IS_FLOAT(b)) {
+        double fa = AS_FLOAT(a);
+        double fb = AS_FLOAT(b);
+        return fa == fb || (isnan(fa) && isnan(fb));
+    }
+    return dai_value_equal_with_limit(a, b, limit);
+}
+
 uint64_t
-dai_value_hash(DaiValue value, __attribute__((unused)) uint64_t seed0,
-               __attribute__((unused)) uint64_t seed1) {
-    switch (value.type) {
+dai_value_hash_unseeded(DaiValue value) {
+    switch (DAI_VALUE_TYPE(value)) {
         case DaiValueType_nil: return 0;
         case DaiValueType_int: return (uint64_t)AS_INTEGER(value);
-        case DaiValueType_float: return (uint64_t)AS_FLOAT(value);
+        case DaiValueType_float: return dai_float_hash(AS_FLOAT(value));
         case DaiValueType_bool: return AS_BOOL(value) ? 1 : 0;
         case DaiValueType_obj: return AS_OBJ(value)->operation->hash_func(value);
         default: return 0;
     }
 }
 
+uint64_t
+dai_value_hash(DaiValue value, uint64_t seed0, uint64_t seed1) {
+    // 不同类型的值混合上不同的常数，避免 1 、 1.0 和 true 这类值的哈希值有规律地重叠
+    uint64_t type = (uint64_t)DAI_VALUE_TYPE(value) * 0x9e3779b97f4a7c15ULL;
+    return dai_hash_mix(dai_value_hash_unseeded(value) ^ type, seed0 ^ seed1);
+}
+
 bool
 dai_value_is_hashable(DaiValue value) {
-    switch (value.type) {
+    switch (DAI_VALUE_TYPE(value)) {
         case DaiValueType_nil:
         case DaiValueType_int:
         case DaiValueType_float:
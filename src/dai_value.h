@@ -4,9 +4,12 @@
 #ifndef CBDAI_DAI_VALUE_H
 #define CBDAI_DAI_VALUE_H
 
+#include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "dai_common.h"
+
 typedef struct {
     int capacity;
     int count;
@@ -33,6 +36,143 @@ typedef enum {
     DaiValueType_obj,
 } DaiValueType;
 
+#ifdef DAI_NAN_BOXING
+
+// NaN-boxing ：DaiValue 只占 8 字节
+// 浮点数按原样存储，其他类型都编码在 quiet NaN 的负载里（bit 48-49 是类型标签）
+//   浮点数：   不是下面几种形式的任意 64 位
+//   单例值：   QNAN | 00 | 0-3 （undefined nil false true）
+//   小整数：   QNAN | 01 | 48 位补码
+//   对象：     SIGN | QNAN | 00 | 48 位指针
+//   装箱整数： SIGN | QNAN | 01 | 48 位指针，超出 48 位的整数放在堆上（DaiObjBoxedInt）
+typedef uint64_t DaiValue;
+
+#    define DAI_QNAN ((uint64_t)0x7ffc000000000000)
+#    define DAI_SIGN_BIT ((uint64_t)0x8000000000000000)
+#    define DAI_TAG_BITS ((uint64_t)0x0003000000000000)
+#    define DAI_PAYLOAD_MASK ((uint64_t)0x0000ffffffffffff)
+
+#    define DAI_TAG_SINGLETON (DAI_QNAN)
+#    define DAI_TAG_INT (DAI_QNAN | ((uint64_t)1 << 48))
+#    define DAI_TAG_OBJ (DAI_SIGN_BIT | DAI_QNAN)
+#    define DAI_TAG_BOXED_INT (DAI_SIGN_BIT | DAI_QNAN | ((uint64_t)1 << 48))
+#    define DAI_TAG_MASK (DAI_SIGN_BIT | DAI_QNAN | DAI_TAG_BITS)
+
+#    define DAI_UNDEFINED_BITS (DAI_TAG_SINGLETON | 0)
+#    define DAI_NIL_BITS (DAI_TAG_SINGLETON | 1)
+#    define DAI_FALSE_BITS (DAI_TAG_SINGLETON | 2)
+#    define DAI_TRUE_BITS (DAI_TAG_SINGLETON | 3)
+// 运算产生的 NaN 统一换成这个值，避免和上面的编码冲突
+#    define DAI_CANONICAL_NAN_BITS ((uint64_t)0x7ff8000000000000)
+
+#    define DAI_SMALL_INT_MIN (-((int64_t)1 << 47))
+#    define DAI_SMALL_INT_MAX (((int64_t)1 << 47) - 1)
+
+typedef struct _DaiVM DaiVM;
+
+// 装箱和拆箱超出小整数范围的整数，定义在 dai_object_base.c 。
+// dai_box_integer 装箱到当前线程正在执行的虚拟机（见 dai_set_boxing_vm ），
+// dai_box_integer_vm 装箱到指定的虚拟机
+DaiValue
+dai_box_integer(int64_t value);
+DaiValue
+dai_box_integer_vm(DaiVM* vm, int64_t value);
+int64_t
+dai_unbox_integer(DaiValue value);
+
+static inline DaiValue
+dai_integer_val(int64_t value) {
+    if (DAI_LIKELY(value >= DAI_SMALL_INT_MIN && value <= DAI_SMALL_INT_MAX)) {
+        return DAI_TAG_INT | ((uint64_t)value & DAI_PAYLOAD_MASK);
+    }
+    return dai_box_integer(value);
+}
+
+static inline DaiValue
+dai_integer_val_vm(DaiVM* vm, int64_t value) {
+    if (DAI_LIKELY(value >= DAI_SMALL_INT_MIN && value <= DAI_SMALL_INT_MAX)) {
+        return DAI_TAG_INT | ((uint64_t)value & DAI_PAYLOAD_MASK);
+    }
+    return dai_box_integer_vm(vm, value);
+}
+
+static inline int64_t
+dai_value_as_integer(DaiValue value) {
+    if (DAI_LIKELY(!(value & DAI_SIGN_BIT))) {
+        // 符号扩展 48 位补码
+        return ((int64_t)(value << 16)) >> 16;
+    }
+    return dai_unbox_integer(value);
+}
+
+static inline DaiValue
+dai_float_val(double num) {
+    union {
+        double num;
+        uint64_t bits;
+    } u;
+    u.num = num;
+    if (DAI_UNLIKELY(num != num)) {
+        return DAI_CANONICAL_NAN_BITS;
+    }
+    return u.bits;
+}
+
+static inline double
+dai_value_as_float(DaiValue value) {
+    union {
+        uint64_t bits;
+        double num;
+    } u;
+    u.bits = value;
+    return u.num;
+}
+
+#    define IS_UNDEFINED(value) ((value) == DAI_UNDEFINED_BITS)
+#    define IS_BOOL(value) (((value) | 1) == DAI_TRUE_BITS)
+#    define IS_NIL(value) ((value) == DAI_NIL_BITS)
+// 小整数和装箱整数只差一个符号位
+#    define IS_INTEGER(value) (((value) & (DAI_QNAN | DAI_TAG_BITS)) == DAI_TAG_INT)
+#    define IS_FLOAT(value) (((value) & DAI_QNAN) != DAI_QNAN)
+#    define IS_OBJ(value) (((value) & DAI_TAG_MASK) == DAI_TAG_OBJ)
+#    define IS_BOXED_INTEGER(value) (((value) & DAI_TAG_MASK) == DAI_TAG_BOXED_INT)
+
+#    define AS_BOOL(value) ((value) == DAI_TRUE_BITS)
+#    define AS_INTEGER(value) dai_value_as_integer(value)
+#    define AS_FLOAT(value) dai_value_as_float(value)
+#    define AS_OBJ(value) ((DaiObj*)(uintptr_t)((value) & DAI_PAYLOAD_MASK))
+
+#    define UNDEFINED_VAL ((DaiValue)DAI_UNDEFINED_BITS)
+#    define BOOL_VAL(value) ((value) ? (DaiValue)DAI_TRUE_BITS : (DaiValue)DAI_FALSE_BITS)
+#    define NIL_VAL ((DaiValue)DAI_NIL_BITS)
+#    define INTEGER_VAL(value) dai_integer_val(value)
+// 拿得到虚拟机的地方（内置函数、嵌入 API ）用这个，装箱的整数一定归 vm 管理
+#    define INTEGER_VAL_VM(vm, value) dai_integer_val_vm(vm, value)
+#    define FLOAT_VAL(value) dai_float_val(value)
+#    define OBJ_VAL(object) ((DaiValue)(DAI_TAG_OBJ | (uint64_t)(uintptr_t)(object)))
+
+static inline DaiValueType
+dai_value_type(DaiValue value) {
+    if (IS_FLOAT(value)) {
+        return DaiValueType_float;
+    }
+    if (IS_INTEGER(value)) {
+        return DaiValueType_int;
+    }
+    if (IS_OBJ(value)) {
+        return DaiValueType_obj;
+    }
+    switch (value) {
+        case DAI_NIL_BITS: return DaiValueType_nil;
+        case DAI_FALSE_BITS:
+        case DAI_TRUE_BITS: return DaiValueType_bool;
+        default: return DaiValueType_undefined;
+    }
+}
+#    define DAI_VALUE_TYPE(value) dai_value_type(value)
+
+#else
+
 typedef struct {
     DaiValueType type;
     union {
@@ -43,30 +183,36 @@ typedef struct {
     } as;
 } DaiValue;
 
-// 返回类型的字符串表示
-const char*
-dai_value_ts(DaiValue value);
+#    define IS_UNDEFINED(value) ((value).type == DaiValueType_undefined)
+#    define IS_BOOL(value) ((value).type == DaiValueType_bool)
+#    define IS_NIL(value) ((value).type == DaiValueType_nil)
+#    define IS_INTEGER(value) ((value).type == DaiValueType_int)
+#    define IS_FLOAT(value) ((value).type == DaiValueType_float)
+#    define IS_OBJ(value) ((value).type == DaiValueType_obj)
 
-#define IS_UNDEFINED(value) ((value).type == DaiValueType_undefined)
-#define IS_BOOL(value) ((value).type == DaiValueType_bool)
-#define IS_NIL(value) ((value).type == DaiValueType_nil)
-#define IS_INTEGER(value) ((value).type == DaiValueType_int)
-#define IS_FLOAT(value) ((value).type == DaiValueType_float)
-#define IS_OBJ(value) ((value).type == DaiValueType_obj)
-#define IS_NUMBER(value) (IS_INTEGER(value) || IS_FLOAT(value))   // 数字类型
+#    define AS_BOOL(value) ((value).as.boolean)
+#    define AS_INTEGER(value) ((value).as.intval)
+#    define AS_FLOAT(value) ((value).as.floatval)
+#    define AS_OBJ(value) ((value).as.obj)
+
+#    define UNDEFINED_VAL ((DaiValue){DaiValueType_undefined, {.intval = 0}})
+#    define BOOL_VAL(value) ((DaiValue){DaiValueType_bool, {.boolean = value}})
+#    define NIL_VAL ((DaiValue){DaiValueType_nil, {.intval = 0}})
+#    define INTEGER_VAL(value) ((DaiValue){DaiValueType_int, {.intval = value}})
+#    define INTEGER_VAL_VM(vm, value) ((void)(vm), INTEGER_VAL(value))
+#    define FLOAT_VAL(value) ((DaiValue){DaiValueType_float, {.floatval = value}})
+#    define OBJ_VAL(object) ((DaiValue){DaiValueType_obj, {.obj = (DaiObj*)object}})
 
-#define AS_BOOL(value) ((value).as.boolean)
-#define AS_INTEGER(value) ((value).as.intval)
-#define AS_FLOAT(value) ((value).as.floatval)
-#define AS_OBJ(value) ((value).as.obj)
+#    define DAI_VALUE_TYPE(value) ((value).type)
+
+#endif /* DAI_NAN_BOXING */
+
+#define IS_NUMBER(value) (IS_INTEGER(value) || IS_FLOAT(value))   // 数字类型
 #define AS_NUMBER(value) (IS_INTEGER(value) ? AS_INTEGER(value) : AS_FLOAT(value))   // 获取数字值
 
-#define UNDEFINED_VAL ((DaiValue){DaiValueType_undefined, {.intval = 0}})
-#define BOOL_VAL(value) ((DaiValue){DaiValueType_bool, {.boolean = value}})
-#define NIL_VAL ((DaiValue){DaiValueType_nil, {.intval = 0}})
-#define INTEGER_VAL(value) ((DaiValue){DaiValueType_int, {.intval = value}})
-#define FLOAT_VAL(value) ((DaiValue){DaiValueType_float, {.floatval = value}})
-#define OBJ_VAL(object) ((DaiValue){DaiValueType_obj, {.obj = (DaiObj*)object}})
+// 返回类型的字符串表示
+const char*
+dai_value_ts(DaiValue value);
 
 /**
  * @brief 打印值
@@ -76,6 +222,15 @@ dai_value_ts(DaiValue value);
 void
 dai_print_value(DaiValue value);
 
+/**
+ * @brief 比较两个浮点数是否相等（误差小于 1e-10 即认为相等）
+ */
+static inline bool
+dai_float_equals(double a, double b) {
+    double epsilon = 1e-10;
+    return fabs(a - b) < epsilon;
+}
+
 /**
  * @brief 比较两个值是否相等
  *
@@ -144,6 +299,29 @@ dai_value_is_truthy(const DaiValue value);
 uint64_t
 dai_value_hash(DaiValue value, uint64_t seed0, uint64_t seed1);
 
+/**
+ * @brief 作为哈希表的键比较两个值是否相等，和 dai_value_hash 保持一致：
+ * 浮点数精确比较（ 0.0 等于 -0.0 ， NaN 等于 NaN ），不使用 dai_value_equal 的误差比较
+ *
+ * @param a 值
+ * @param b 值
+ * @param limit 递归深度限制
+ *
+ * @return 1 相等，0 不相等，-1 超过递归深度
+ */
+int
+dai_value_key_equal(DaiValue a, DaiValue b, int* limit);
+
+/**
+ * @brief 返回值没有加种子、没有打散的哈希值，元组等组合类型用它组合元素的哈希值
+ *
+ * @param value 值
+ *
+ * @return uint64_t 哈希值
+ */
+uint64_t
+dai_value_hash_unseeded(DaiValue value);
+
 /**
  * @brief 返回值是否可哈希
  *
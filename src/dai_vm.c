@@ -11,6 +11,7 @@
 #include "dai_common.h"
 #include "dai_compile.h"
 #include "dai_error.h"
+#include "dai_jit.h"
 #include "dai_malloc.h"
 #include "dai_memory.h"
 #include "dai_object.h"
@@ -35,8 +36,13 @@ DaiVM_popN(DaiVM* vm, int n);
 static DaiObjError*
 DaiVM_callValue(DaiVM* vm, const DaiValue callee, const int argCount, const DaiValue receiver);
 
+#ifdef DAI_NAN_BOXING
+DaiValue dai_true  = DAI_TRUE_BITS;
+DaiValue dai_false = DAI_FALSE_BITS;
+#else
 DaiValue dai_true  = {.type = DaiValueType_bool, .as.boolean = true};
 DaiValue dai_false = {.type = DaiValueType_bool, .as.boolean = false};
+#endif
 
 void
 DaiVM_resetStack(DaiVM* vm) {
@@ -60,6 +66,8 @@ DaiVM_resetStack(DaiVM* vm) {
 
 void
 DaiVM_init(DaiVM* vm) {
+    // 初始化内置对象时产生的装箱整数归 vm 管理
+    DaiVM* previous_boxing_vm = dai_set_boxing_vm(vm);
     DaiVM_resetStack(vm);
     {
         // 初始化栈
@@ -67,15 +75,45 @@ DaiVM_init(DaiVM* vm) {
             vm->stack[i] = UNDEFINED_VAL;
         }
     }
-    vm->objects        = NULL;
+    DaiPool_init(&vm->objectPool);
+    vm->youngBytes     = 0;
+    vm->youngCount     = 0;
+    vm->youngCapacity  = 0;
+    vm->youngObjects   = NULL;
     vm->bytesAllocated = 0;
-    vm->nextGC         = 1024 * 1024;
+    vm->nextGC         = DAI_GC_INITIAL_THRESHOLD;
+    vm->gcGrowFactor   = DAI_GC_GROW_FACTOR;
+    vm->gcHeapLimit    = 0;
+    vm->gcOutOfMemory  = false;
+    vm->gcDisabled     = false;
     vm->gc_ref_count   = 0;
 
     vm->grayCount    = 0;
     vm->grayCapacity = 0;
     vm->grayStack    = NULL;
 
+    vm->rememberedCount    = 0;
+    vm->rememberedCapacity = 0;
+    vm->rememberedSet      = NULL;
+
+    vm->gcSliceCount      = 0;
+    vm->gcSliceCapacity   = 0;
+    vm->gcSlices          = NULL;
+    vm->gcCompactCount    = 0;
+    vm->gcCompactCapacity = 0;
+    vm->gcCompactSlices   = NULL;
+
+    vm->gcNurserySize = DAI_GC_NURSERY_SIZE;
+    vm->gcIncremental = false;
+    vm->gcStepSize    = DAI_GC_STEP_SIZE;
+    vm->gcStepBytes   = 0;
+    vm->gcPhase       = DaiGCPhase_idle;
+    vm->gcScanArray   = NULL;
+    vm->gcScanIndex   = 0;
+    vm->gcThreadCount = 1;
+    vm->gcThreadPool  = NULL;
+    vm->gcWorkers     = NULL;
+
     vm->state = VMState_pending;
     DaiTable_init(&vm->strings);
     vm->builtinSymbolTable = DaiSymbolTable_New();
@@ -105,7 +143,23 @@ DaiVM_init(DaiVM* vm) {
         }
     }
 
-    memset(vm->object_stats, 0, sizeof(vm->object_stats));
+    memset(&vm->gcStats, 0, sizeof(vm->gcStats));
+    vm->gcCycleFreed = 0;
+
+    vm->jit_enabled   = false;
+    vm->jit_threshold = DAI_JIT_THRESHOLD;
+    dai_set_boxing_vm(previous_boxing_vm);
+}
+
+bool
+DaiVM_enableJIT(DaiVM* vm) {
+#ifdef DAI_JIT
+    vm->jit_enabled = true;
+    return true;
+#else
+    vm->jit_enabled = false;
+    return false;
+#endif
 }
 
 void
@@ -114,6 +168,7 @@ DaiVM_reset(DaiVM* vm) {
     vm->builtinSymbolTable = NULL;
     DaiTable_reset(&vm->strings);
     dai_free_objects(vm);
+    dai_clear_boxing_vm(vm);
 }
 
 void
@@ -142,20 +197,24 @@ DaiVM_peek(const DaiVM* vm, int distance) {
     return vm->stack_top[-1 - distance];
 }
 
-static void
+// 拼接两个字符串，返回新字符串，调用方负责出栈入栈
+// 较长的结果是绳索字符串，不复制两边的内容，循环里 s = s + x 不会每次都复制整个 s
+static DaiObjString*
 concatenate_string(DaiVM* vm, DaiValue v1, DaiValue v2) {
     DaiObjString* a = (DaiObjString*)AS_OBJ(v1);
     DaiObjString* b = (DaiObjString*)AS_OBJ(v2);
 
-    int length  = a->length + b->length;
+    int length = a->length + b->length;
+    if (length >= DAI_STRING_ROPE_MIN_LENGTH) {
+        return DaiObjString_concat(vm, a, b);
+    }
+    // 绳索字符串都不短于 DAI_STRING_ROPE_MIN_LENGTH ，所以 a 和 b 的内容都是连续的
     char* chars = VM_ALLOCATE(vm, char, length + 1);
     memcpy(chars, a->chars, a->length);
     memcpy(chars + a->length, b->chars, b->length);
     chars[length] = '\0';
 
-    DaiObjString* result = dai_take_string(vm, chars, length);
-    DaiVM_popN(vm, 2);
-    DaiVM_push(vm, OBJ_VAL(result));
+    return dai_take_string(vm, chars, length);
 }
 
 static DaiObjError*
@@ -237,13 +296,25 @@ DaiVM_callValue(DaiVM* vm, const DaiValue callee, const int argCount, const DaiV
                     return AS_ERROR(result);
                 }
                 DaiVM_push(vm, result);
-                return NULL;
+                if (DAI_UNLIKELY(vm->gcCompactCount > 0)) {
+                    dai_gc_compact_slices(vm);
+                }
+                // 内置函数可能一次分配很多内存
+                return DaiVM_checkOutOfMemory(vm);
             }
             case DaiObjType_closure: {
                 DaiObjClosure* closure = (DaiObjClosure*)AS_OBJ(callee);
                 DaiObjError* err       = DaiVM_call(vm, closure->function, argCount);
-                vm->frames[vm->frame_count - 1].closure = closure;
-                return err;
+                if (err != NULL) {
+                    return err;
+                }
+                CallFrame* frame = CURRENT_FRAME;
+                frame->closure   = closure;
+                // 和函数一样，方法调用需要把 self 放到第一个槽位
+                if (!IS_UNDEFINED(receiver)) {
+                    frame->slots[0] = receiver;
+                }
+                return NULL;
             }
             case DaiObjType_cFunction: {
                 const BuiltinFn func  = AS_CFUNCTION(callee)->wrapper;
@@ -262,765 +333,1101 @@ DaiVM_callValue(DaiVM* vm, const DaiValue callee, const int argCount, const DaiV
 }
 
 static bool
-DaiVM_executeIntBinary(DaiVM* vm, const DaiBinaryOpType opType, const DaiValue a,
-                       const DaiValue b) {
+DaiVM_executeIntBinary(const DaiBinaryOpType opType, const DaiValue a, const DaiValue b,
+                       DaiValue* result) {
     switch (opType) {
         case BinaryOpLeftShift: {
-            DaiVM_push(vm, INTEGER_VAL(AS_INTEGER(a) << AS_INTEGER(b)));
+            *result = INTEGER_VAL(AS_INTEGER(a) << AS_INTEGER(b));
             return true;
         }
         case BinaryOpRightShift: {
-            DaiVM_push(vm, INTEGER_VAL(AS_INTEGER(a) >> AS_INTEGER(b)));
+            *result = INTEGER_VAL(AS_INTEGER(a) >> AS_INTEGER(b));
             return true;
         }
         case BinaryOpBitwiseAnd: {
-            DaiVM_push(vm, INTEGER_VAL(AS_INTEGER(a) & AS_INTEGER(b)));
+            *result = INTEGER_VAL(AS_INTEGER(a) & AS_INTEGER(b));
             return true;
         }
         case BinaryOpBitwiseOr: {
-            DaiVM_push(vm, INTEGER_VAL(AS_INTEGER(a) | AS_INTEGER(b)));
+            *result = INTEGER_VAL(AS_INTEGER(a) | AS_INTEGER(b));
             return true;
         }
         case BinaryOpBitwiseXor: {
-            DaiVM_push(vm, INTEGER_VAL(AS_INTEGER(a) ^ AS_INTEGER(b)));
+            *result = INTEGER_VAL(AS_INTEGER(a) ^ AS_INTEGER(b));
             return true;
         }
         default: return false;
     }
 }
 
+// 通过方法内联缓存查找实例方法，只有函数和闭包会进缓存
+static inline bool
+DaiVM_getCachedMethod(DaiMethodCache* cache, DaiValue receiver, DaiValue* method) {
+    if (!IS_INSTANCE(receiver)) {
+        return false;
+    }
+    return DaiMethodCache_lookup(cache, AS_INSTANCE(receiver)->klass->shape, method);
+}
+
+// 把通用路径查找到的方法放进内联缓存
+static inline void
+DaiVM_updateMethodCache(DaiMethodCache* cache, DaiValue receiver, DaiValue method) {
+    if (IS_INSTANCE(receiver) && (IS_FUNCTION(method) || IS_CLOSURE(method))) {
+        DaiMethodCache_update(cache, AS_INSTANCE(receiver)->klass->shape, method);
+    }
+}
+
+// 调用内联缓存命中的方法，跳过 DaiVM_callValue 的类型分派
+static inline DaiObjError*
+DaiVM_callCachedMethod(DaiVM* vm, DaiValue method, int argCount, DaiValue receiver) {
+    DaiObjClosure* closure   = NULL;
+    DaiObjFunction* function = NULL;
+    if (IS_CLOSURE(method)) {
+        closure  = AS_CLOSURE(method);
+        function = closure->function;
+    } else {
+        function = AS_FUNCTION(method);
+    }
+    DaiObjError* err = DaiVM_call(vm, function, argCount);
+    if (err != NULL) {
+        return err;
+    }
+    CallFrame* frame = CURRENT_FRAME;
+    frame->closure   = closure;
+    frame->slots[0]  = receiver;
+    return NULL;
+}
+
+#ifdef DEBUG_TRACE_EXECUTION
+// 打印当前栈和将要执行的指令
+static void
+DaiVM_traceExecution(DaiVM* vm, CallFrame* frame, const char** curr_funcname) {
+    DaiChunk* chunk = frame->chunk;
+    const char* funcname;
+    if (frame->function) {
+        funcname = DaiObjFunction_name(frame->function);
+    } else {
+        funcname = chunk->filename;
+    }
+    if (*curr_funcname != funcname) {
+        *curr_funcname = funcname;
+        dai_log("========== %s =========\n", *curr_funcname);
+    }
+    dai_log("          ");
+    for (DaiValue* slot = vm->stack; slot < vm->stack_top; slot++) {
+        if (slot != vm->stack && frame->slots == slot) {
+            dai_log("  ");
+        } else if (slot == frame->slots + frame->max_local_count) {
+            dai_log(" - ");
+        }
+        dai_log("[ \"");
+        dai_print_value(*slot);
+        dai_log("\" ]");
+    }
+    if (vm->stack_top == vm->stack) {
+        dai_log("<EMPTY>");
+    }
+    dai_log("\n");
+    DaiChunk_disassembleInstruction(chunk, (int)(frame->ip - chunk->code));
+}
+#endif
+
 // 运行当前帧，直至当前帧退出
 static DaiObjError*
-DaiVM_runCurrentFrame(DaiVM* vm) {
+DaiVM_runFrameLoop(DaiVM* vm) {
     int current_frame_index = vm->frame_count - 1;
     CallFrame* frame        = &vm->frames[vm->frame_count - 1];
     DaiChunk* chunk         = frame->chunk;
     DaiValue* globals       = frame->globals;
+    // ip 、栈顶和常量表放在局部变量里（编译器可以分配到寄存器），
+    // 只在调用、返回、可能触发 GC 或者出错的地方才同步回 frame 和 vm
+    uint8_t* ip         = frame->ip;
+    DaiValue* stack_top = vm->stack_top;
+    DaiValue* constants = chunk->constants.values;
 
-    // 数字运算
-#define ARITHMETIC_OPERATION(op)                                                         \
-    do {                                                                                 \
-        DaiValue b = DaiVM_pop(vm);                                                      \
-        DaiValue a = DaiVM_pop(vm);                                                      \
-        if (IS_INTEGER(a) && IS_INTEGER(b)) {                                            \
-            DaiVM_push(vm, INTEGER_VAL(AS_INTEGER(a) op AS_INTEGER(b)));                 \
-        } else if (IS_FLOAT(a) && IS_INTEGER(b)) {                                       \
-            DaiVM_push(vm, FLOAT_VAL(AS_FLOAT(a) op(double) AS_INTEGER(b)));             \
-        } else if (IS_INTEGER(a) && IS_FLOAT(b)) {                                       \
-            DaiVM_push(vm, FLOAT_VAL((double)AS_INTEGER(a) op AS_FLOAT(b)));             \
-        } else if (IS_FLOAT(a) && IS_FLOAT(b)) {                                         \
-            DaiVM_push(vm, FLOAT_VAL(AS_FLOAT(a) op AS_FLOAT(b)));                       \
-        } else {                                                                         \
-            return DaiObjError_Newf(vm,                                                  \
-                                    "unsupported operand type(s) for %s: '%s' and '%s'", \
-                                    #op,                                                 \
-                                    dai_value_ts(a),                                     \
-                                    dai_value_ts(b));                                    \
-        }                                                                                \
+    // 先取值，再自增
+#define READ_BYTE() (*ip++)
+#define READ_UINT16() (ip += 2, (uint16_t)((ip[-2] << 8) | ip[-1]))
+#define READ_CONSTANT() (constants[READ_UINT16()])
+
+#define PUSH(value) (*stack_top++ = (value))
+#define POP() (*--stack_top)
+#define POPN(n) (stack_top -= (n))
+#define PEEK(distance) (stack_top[-1 - (distance)])
+
+    // 把局部状态写回 frame 和 vm
+    // GC 只扫描 vm->stack 到 vm->stack_top 之间的值，回溯信息依赖 frame->ip ，
+    // 所以调用任何可能分配内存、重入虚拟机或者出错的函数前都要先写回
+#define SAVE_STATE()               \
+    do {                           \
+        frame->ip     = ip;        \
+        vm->stack_top = stack_top; \
+    } while (0)
+    // 切换帧之后重新加载局部状态
+#define LOAD_FRAME()                         \
+    do {                                     \
+        frame     = CURRENT_FRAME;           \
+        chunk     = frame->chunk;            \
+        globals   = frame->globals;          \
+        ip        = frame->ip;               \
+        constants = chunk->constants.values; \
+    } while (0)
+#define LOAD_STATE()               \
+    do {                           \
+        LOAD_FRAME();              \
+        stack_top = vm->stack_top; \
+    } while (0)
+#define RUNTIME_ERROR(...)                        \
+    do {                                          \
+        SAVE_STATE();                             \
+        return DaiObjError_Newf(vm, __VA_ARGS__); \
     } while (0)
 
-    // 先取值，再自增
-#define READ_BYTE() (*frame->ip++)
-#define READ_UINT16()                                        \
-    DaiChunk_readu16(chunk, (int)(frame->ip - chunk->code)); \
-    frame->ip += 2
+    // 通用指令根据操作数类型把自己改写成特化指令
+    // ip[-1] 不是通用指令时（比如从超级指令的慢路径进来）不改写
+#define QUICKEN(generic, specialized) \
+    do {                              \
+        if (ip[-1] == (generic)) {    \
+            ip[-1] = (specialized);   \
+        }                             \
+    } while (0)
+    // 特化指令的类型检查失败，改写回通用指令，随后的 DISPATCH() 会重新执行这条指令
+#define DEOPTIMIZE(generic) (*--ip = (generic))
+
+#ifdef DAI_JIT
+    // 循环回跳时尝试进入当前帧的机器码（字节码块足够热时先编译），
+    // 机器码执行到不支持的指令时把 frame->ip 指向它，回到解释器接着执行
+#    define JIT_ENTER()                                         \
+        do {                                                    \
+            if (DAI_UNLIKELY(vm->jit_enabled)) {                \
+                SAVE_STATE();                                   \
+                DaiObjError* jit_err = DaiJit_enter(vm, frame); \
+                if (jit_err != NULL) {                          \
+                    return jit_err;                             \
+                }                                               \
+                LOAD_STATE();                                   \
+            }                                                   \
+        } while (0)
+#else
+#    define JIT_ENTER() \
+        do {            \
+        } while (0)
+#endif
+
+    // 数字运算，整数和整数、浮点数和浮点数运算时会改写成对应的特化指令
+#define ARITHMETIC_OPERATION(op, generic, int_op, float_op)                    \
+    do {                                                                       \
+        DaiValue b = POP();                                                    \
+        DaiValue a = POP();                                                    \
+        if (IS_INTEGER(a) && IS_INTEGER(b)) {                                  \
+            QUICKEN(generic, int_op);                                          \
+            PUSH(INTEGER_VAL(AS_INTEGER(a) op AS_INTEGER(b)));                 \
+        } else if (IS_FLOAT(a) && IS_INTEGER(b)) {                             \
+            PUSH(FLOAT_VAL(AS_FLOAT(a) op(double) AS_INTEGER(b)));             \
+        } else if (IS_INTEGER(a) && IS_FLOAT(b)) {                             \
+            PUSH(FLOAT_VAL((double)AS_INTEGER(a) op AS_FLOAT(b)));             \
+        } else if (IS_FLOAT(a) && IS_FLOAT(b)) {                               \
+            QUICKEN(generic, float_op);                                        \
+            PUSH(FLOAT_VAL(AS_FLOAT(a) op AS_FLOAT(b)));                       \
+        } else {                                                               \
+            RUNTIME_ERROR("unsupported operand type(s) for %s: '%s' and '%s'", \
+                          #op,                                                 \
+                          dai_value_ts(a),                                     \
+                          dai_value_ts(b));                                    \
+        }                                                                      \
+    } while (0)
 
 #ifdef DEBUG_TRACE_EXECUTION
     const char* curr_funcname = NULL;
+#    define TRACE_EXECUTION()                                \
+        do {                                                 \
+            SAVE_STATE();                                    \
+            DaiVM_traceExecution(vm, frame, &curr_funcname); \
+        } while (0)
+#else
+#    define TRACE_EXECUTION() \
+        do {                  \
+        } while (0)
+#endif
+#ifdef DAI_COMPUTED_GOTO
+    // 每个字节码对应一个标签，执行完一条指令后直接跳到下一条指令的标签，
+    // 这样每条指令末尾都有自己的间接跳转，分支预测效果比 switch 共用一个跳转好
+#    if defined(__clang__)
+#        pragma clang diagnostic push
+#        pragma clang diagnostic ignored "-Winitializer-overrides"
+#    endif
+    static void* dispatch_table[UINT8_COUNT] = {
+        // 未知的字节码统一跳到 default 分支
+        [0 ... UINT8_MAX]             = &&TARGET_DaiOpUnknown,
+        [DaiOpConstant]               = &&TARGET_DaiOpConstant,
+        [DaiOpAdd]                    = &&TARGET_DaiOpAdd,
+        [DaiOpSub]                    = &&TARGET_DaiOpSub,
+        [DaiOpMul]                    = &&TARGET_DaiOpMul,
+        [DaiOpDiv]                    = &&TARGET_DaiOpDiv,
+        [DaiOpMod]                    = &&TARGET_DaiOpMod,
+        [DaiOpBinary]                 = &&TARGET_DaiOpBinary,
+        [DaiOpSubscript]              = &&TARGET_DaiOpSubscript,
+        [DaiOpSubscriptSet]           = &&TARGET_DaiOpSubscriptSet,
+        [DaiOpTrue]                   = &&TARGET_DaiOpTrue,
+        [DaiOpFalse]                  = &&TARGET_DaiOpFalse,
+        [DaiOpNil]                    = &&TARGET_DaiOpNil,
+        [DaiOpUndefined]              = &&TARGET_DaiOpUndefined,
+        [DaiOpArray]                  = &&TARGET_DaiOpArray,
+        [DaiOpMap]                    = &&TARGET_DaiOpMap,
+        [DaiOpEqual]                  = &&TARGET_DaiOpEqual,
+        [DaiOpNotEqual]               = &&TARGET_DaiOpNotEqual,
+        [DaiOpGreaterThan]            = &&TARGET_DaiOpGreaterThan,
+        [DaiOpGreaterEqualThan]       = &&TARGET_DaiOpGreaterEqualThan,
+        [DaiOpNot]                    = &&TARGET_DaiOpNot,
+        [DaiOpAndJump]                = &&TARGET_DaiOpAndJump,
+        [DaiOpOrJump]                 = &&TARGET_DaiOpOrJump,
+        [DaiOpMinus]                  = &&TARGET_DaiOpMinus,
+        [DaiOpBang]                   = &&TARGET_DaiOpBang,
+        [DaiOpBitwiseNot]             = &&TARGET_DaiOpBitwiseNot,
+        [DaiOpJumpIfFalse]            = &&TARGET_DaiOpJumpIfFalse,
+        [DaiOpJump]                   = &&TARGET_DaiOpJump,
+        [DaiOpJumpBack]               = &&TARGET_DaiOpJumpBack,
+        [DaiOpIterInit]               = &&TARGET_DaiOpIterInit,
+        [DaiOpIterNext]               = &&TARGET_DaiOpIterNext,
+        [DaiOpRangeInit]              = &&TARGET_DaiOpRangeInit,
+        [DaiOpRangeNext]              = &&TARGET_DaiOpRangeNext,
+        [DaiOpPop]                    = &&TARGET_DaiOpPop,
+        [DaiOpPopN]                   = &&TARGET_DaiOpPopN,
+        [DaiOpSetGlobal]              = &&TARGET_DaiOpSetGlobal,
+        [DaiOpDefineGlobal]           = &&TARGET_DaiOpDefineGlobal,
+        [DaiOpGetGlobal]              = &&TARGET_DaiOpGetGlobal,
+        [DaiOpCall]                   = &&TARGET_DaiOpCall,
+        [DaiOpReturnValue]            = &&TARGET_DaiOpReturnValue,
+        [DaiOpReturn]                 = &&TARGET_DaiOpReturn,
+        [DaiOpGetLocal]               = &&TARGET_DaiOpGetLocal,
+        [DaiOpSetLocal]               = &&TARGET_DaiOpSetLocal,
+        [DaiOpGetBuiltin]             = &&TARGET_DaiOpGetBuiltin,
+        [DaiOpSetFunctionDefault]     = &&TARGET_DaiOpSetFunctionDefault,
+        [DaiOpClosure]                = &&TARGET_DaiOpClosure,
+        [DaiOpGetFree]                = &&TARGET_DaiOpGetFree,
+        [DaiOpClass]                  = &&TARGET_DaiOpClass,
+        [DaiOpDefineField]            = &&TARGET_DaiOpDefineField,
+        [DaiOpDefineMethod]           = &&TARGET_DaiOpDefineMethod,
+        [DaiOpDefineClassField]       = &&TARGET_DaiOpDefineClassField,
+        [DaiOpDefineClassMethod]      = &&TARGET_DaiOpDefineClassMethod,
+        [DaiOpGetProperty]            = &&TARGET_DaiOpGetProperty,
+        [DaiOpSetProperty]            = &&TARGET_DaiOpSetProperty,
+        [DaiOpGetSelfProperty]        = &&TARGET_DaiOpGetSelfProperty,
+        [DaiOpSetSelfProperty]        = &&TARGET_DaiOpSetSelfProperty,
+        [DaiOpGetSuperProperty]       = &&TARGET_DaiOpGetSuperProperty,
+        [DaiOpInherit]                = &&TARGET_DaiOpInherit,
+        [DaiOpCallMethod]             = &&TARGET_DaiOpCallMethod,
+        [DaiOpCallSelfMethod]         = &&TARGET_DaiOpCallSelfMethod,
+        [DaiOpCallSuperMethod]        = &&TARGET_DaiOpCallSuperMethod,
+        [DaiOpAddLocalLocal]          = &&TARGET_DaiOpAddLocalLocal,
+        [DaiOpAddLocalConstant]       = &&TARGET_DaiOpAddLocalConstant,
+        [DaiOpSubLocalConstant]       = &&TARGET_DaiOpSubLocalConstant,
+        [DaiOpGreaterThanJumpIfFalse] = &&TARGET_DaiOpGreaterThanJumpIfFalse,
+        [DaiOpAddInt]                 = &&TARGET_DaiOpAddInt,
+        [DaiOpAddFloat]               = &&TARGET_DaiOpAddFloat,
+        [DaiOpSubInt]                 = &&TARGET_DaiOpSubInt,
+        [DaiOpSubFloat]               = &&TARGET_DaiOpSubFloat,
+        [DaiOpMulInt]                 = &&TARGET_DaiOpMulInt,
+        [DaiOpMulFloat]               = &&TARGET_DaiOpMulFloat,
+        [DaiOpGreaterThanInt]         = &&TARGET_DaiOpGreaterThanInt,
+        [DaiOpGreaterThanFloat]       = &&TARGET_DaiOpGreaterThanFloat,
+        [DaiOpEqualInt]               = &&TARGET_DaiOpEqualInt,
+        [DaiOpEqualFloat]             = &&TARGET_DaiOpEqualFloat,
+        [DaiOpEnd]                    = &&TARGET_DaiOpEnd,
+    };
+#    if defined(__clang__)
+#        pragma clang diagnostic pop
+#    endif
+#    define CASE(op) \
+        case op:     \
+        TARGET_##op
+#    define DISPATCH()                \
+        do {                          \
+            TRACE_EXECUTION();        \
+            op = READ_BYTE();         \
+            goto *dispatch_table[op]; \
+        } while (0)
+#else
+#    define CASE(op) case op
+#    define DISPATCH() break
 #endif
+
     //        while (frame->ip < chunk->code + chunk->count) {
     while (true) {
-#ifdef DEBUG_TRACE_EXECUTION
-        const char* funcname;
-        if (frame->function) {
-            funcname = DaiObjFunction_name(frame->function);
-        } else {
-            funcname = chunk->filename;
-        }
-        if (curr_funcname != funcname) {
-            curr_funcname = funcname;
-            dai_log("========== %s =========\n", curr_funcname);
-        }
-        dai_log("          ");
-        for (DaiValue* slot = vm->stack; slot < vm->stack_top; slot++) {
-            if (slot != vm->stack && frame->slots == slot) {
-                dai_log("  ");
-            } else if (slot == frame->slots + frame->max_local_count) {
-                dai_log(" - ");
-            }
-            dai_log("[ \"");
-            dai_print_value(*slot);
-            dai_log("\" ]");
-        }
-        if (vm->stack_top == vm->stack) {
-            dai_log("<EMPTY>");
-        }
-        dai_log("\n");
-        DaiChunk_disassembleInstruction(chunk, (int)(frame->ip - chunk->code), 0);
-#endif
+        TRACE_EXECUTION();
         DaiOpCode op = READ_BYTE();
         switch (op) {
-            case DaiOpConstant: {
-                uint16_t constant_index = READ_UINT16();
-                DaiValue constant       = chunk->constants.values[constant_index];
-                DaiVM_push(vm, constant);
-                break;
-            }
-            case DaiOpAdd: {
-                DaiValue b = DaiVM_peek(vm, 0);
-                DaiValue a = DaiVM_peek(vm, 1);
+            CASE(DaiOpConstant): {
+                PUSH(READ_CONSTANT());
+                DISPATCH();
+            }
+            CASE(DaiOpAdd): {
+                DaiValue b = PEEK(0);
+                DaiValue a = PEEK(1);
                 if (IS_STRING(a) && IS_STRING(b)) {
-                    concatenate_string(vm, a, b);
-                    break;
+                    SAVE_STATE();
+                    DaiObjString* result = concatenate_string(vm, a, b);
+                    POPN(2);
+                    PUSH(OBJ_VAL(result));
+                    DISPATCH();
                 }
-                DaiVM_popN(vm, 2);
+                POPN(2);
                 if (IS_INTEGER(a) && IS_INTEGER(b)) {
-                    DaiVM_push(vm, INTEGER_VAL(AS_INTEGER(a) + AS_INTEGER(b)));
+                    QUICKEN(DaiOpAdd, DaiOpAddInt);
+                    PUSH(INTEGER_VAL(AS_INTEGER(a) + AS_INTEGER(b)));
                 } else if (IS_FLOAT(a) && IS_INTEGER(b)) {
-                    DaiVM_push(vm, FLOAT_VAL(AS_FLOAT(a) + (double)AS_INTEGER(b)));
+                    PUSH(FLOAT_VAL(AS_FLOAT(a) + (double)AS_INTEGER(b)));
                 } else if (IS_INTEGER(a) && IS_FLOAT(b)) {
-                    DaiVM_push(vm, FLOAT_VAL((double)AS_INTEGER(a) + AS_FLOAT(b)));
+                    PUSH(FLOAT_VAL((double)AS_INTEGER(a) + AS_FLOAT(b)));
                 } else if (IS_FLOAT(a) && IS_FLOAT(b)) {
-                    DaiVM_push(vm, FLOAT_VAL(AS_FLOAT(a) + AS_FLOAT(b)));
+                    QUICKEN(DaiOpAdd, DaiOpAddFloat);
+                    PUSH(FLOAT_VAL(AS_FLOAT(a) + AS_FLOAT(b)));
                 } else {
-                    return DaiObjError_Newf(vm,
-                                            "unsupported operand type(s) for %s: '%s' and '%s'",
-                                            "+",
-                                            dai_value_ts(a),
-                                            dai_value_ts(b));
+                    RUNTIME_ERROR("unsupported operand type(s) for %s: '%s' and '%s'",
+                                  "+",
+                                  dai_value_ts(a),
+                                  dai_value_ts(b));
                 }
-                break;
-            }
-            case DaiOpSub: {
-                ARITHMETIC_OPERATION(-);
-                break;
-            }
-            case DaiOpMul: {
-                ARITHMETIC_OPERATION(*);
-                break;
-            }
-            case DaiOpDiv: {
-                DaiValue b = DaiVM_pop(vm);
-                DaiValue a = DaiVM_pop(vm);
-                if (AS_INTEGER(b) == 0) {
-                    return DaiObjError_Newf(vm, "division by zero");
+                DISPATCH();
+            }
+            CASE(DaiOpSub): {
+                ARITHMETIC_OPERATION(-, DaiOpSub, DaiOpSubInt, DaiOpSubFloat);
+                DISPATCH();
+            }
+            CASE(DaiOpMul): {
+                ARITHMETIC_OPERATION(*, DaiOpMul, DaiOpMulInt, DaiOpMulFloat);
+                DISPATCH();
+            }
+            CASE(DaiOpDiv): {
+                DaiValue b = POP();
+                DaiValue a = POP();
+                if ((IS_INTEGER(b) && AS_INTEGER(b) == 0) ||
+                    (IS_FLOAT(b) && AS_FLOAT(b) == 0.0)) {
+                    RUNTIME_ERROR("division by zero");
                 }
                 if (IS_INTEGER(a) && IS_INTEGER(b)) {
-                    DaiVM_push(vm, INTEGER_VAL(AS_INTEGER(a) / AS_INTEGER(b)));
+                    PUSH(INTEGER_VAL(AS_INTEGER(a) / AS_INTEGER(b)));
                 } else if (IS_FLOAT(a) && IS_INTEGER(b)) {
-                    DaiVM_push(vm, FLOAT_VAL(AS_FLOAT(a) / (double)AS_INTEGER(b)));
+                    PUSH(FLOAT_VAL(AS_FLOAT(a) / (double)AS_INTEGER(b)));
                 } else if (IS_INTEGER(a) && IS_FLOAT(b)) {
-                    DaiVM_push(vm, FLOAT_VAL((double)AS_INTEGER(a) / AS_FLOAT(b)));
+                    PUSH(FLOAT_VAL((double)AS_INTEGER(a) / AS_FLOAT(b)));
                 } else if (IS_FLOAT(a) && IS_FLOAT(b)) {
-                    DaiVM_push(vm, FLOAT_VAL(AS_FLOAT(a) / AS_FLOAT(b)));
+                    PUSH(FLOAT_VAL(AS_FLOAT(a) / AS_FLOAT(b)));
                 } else {
-                    return DaiObjError_Newf(vm,
-                                            "unsupported operand type(s) for /: '%s' and '%s'",
-                                            dai_value_ts(a),
-                                            dai_value_ts(b));
+                    RUNTIME_ERROR("unsupported operand type(s) for /: '%s' and '%s'",
+                                  dai_value_ts(a),
+                                  dai_value_ts(b));
                 }
-                break;
+                DISPATCH();
             }
-            case DaiOpMod: {
-                DaiValue b = DaiVM_pop(vm);
-                DaiValue a = DaiVM_pop(vm);
-                if (AS_INTEGER(b) == 0) {
-                    return DaiObjError_Newf(vm, "modulo by zero");
+            CASE(DaiOpMod): {
+                DaiValue b = POP();
+                DaiValue a = POP();
+                if (IS_INTEGER(b) && AS_INTEGER(b) == 0) {
+                    RUNTIME_ERROR("modulo by zero");
                 }
                 if (IS_INTEGER(a) && IS_INTEGER(b)) {
-                    DaiVM_push(vm, INTEGER_VAL(AS_INTEGER(a) % AS_INTEGER(b)));
+                    PUSH(INTEGER_VAL(AS_INTEGER(a) % AS_INTEGER(b)));
                 } else {
-                    return DaiObjError_Newf(vm,
-                                            "unsupported operand type(s) for %%: '%s' and '%s'",
-                                            dai_value_ts(a),
-                                            dai_value_ts(b));
+                    RUNTIME_ERROR("unsupported operand type(s) for %%: '%s' and '%s'",
+                                  dai_value_ts(a),
+                                  dai_value_ts(b));
                 }
-                break;
+                DISPATCH();
             }
-            case DaiOpBinary: {
+            CASE(DaiOpBinary): {
                 DaiBinaryOpType opType = READ_BYTE();
-                DaiValue b             = DaiVM_pop(vm);
-                DaiValue a             = DaiVM_pop(vm);
+                DaiValue b             = POP();
+                DaiValue a             = POP();
                 if (IS_INTEGER(a) && IS_INTEGER(b)) {
-                    DaiVM_executeIntBinary(vm, opType, a, b);
-                    break;
+                    DaiValue res;
+                    if (DaiVM_executeIntBinary(opType, a, b, &res)) {
+                        PUSH(res);
+                    }
+                    DISPATCH();
                 } else {
-                    return DaiObjError_Newf(vm,
-                                            "unsupported operand type(s) for %s: '%s' and '%s'",
-                                            DaiBinaryOpTypeToString(opType),
-                                            dai_value_ts(a),
-                                            dai_value_ts(b));
+                    RUNTIME_ERROR("unsupported operand type(s) for %s: '%s' and '%s'",
+                                  DaiBinaryOpTypeToString(opType),
+                                  dai_value_ts(a),
+                                  dai_value_ts(b));
                 }
-                break;
+                DISPATCH();
             }
-            case DaiOpSubscript: {
+            CASE(DaiOpSubscript): {
                 // 从栈顶排列为 index, object (object[index])
-                DaiValue receiver   = DaiVM_peek(vm, 1);
+                DaiValue receiver   = PEEK(1);
                 SubscriptGetFn func = NULL;
                 if (IS_OBJ(receiver)) {
                     func = AS_OBJ(receiver)->operation->subscript_get_func;
                 }
                 if (func) {
-                    DaiValue result = func(vm, receiver, DaiVM_peek(vm, 0));
+                    SAVE_STATE();
+                    DaiValue result = func(vm, receiver, PEEK(0));
                     if (DAI_IS_ERROR(result)) {
                         return AS_ERROR(result);
                     }
-                    DaiVM_popN(vm, 2);   // 弹出 index, object
-                    DaiVM_push(vm, result);
+                    POPN(2);   // 弹出 index, object
+                    PUSH(result);
                 } else {
-                    return DaiObjError_Newf(
-                        vm, "'%s' object is not subscriptable", dai_value_ts(receiver));
+                    RUNTIME_ERROR("'%s' object is not subscriptable", dai_value_ts(receiver));
                 }
-                break;
+                DISPATCH();
             }
-            case DaiOpSubscriptSet: {
+            CASE(DaiOpSubscriptSet): {
                 // 从栈顶排列为 index, object, value (object[index] = value)
-                DaiValue receiver   = DaiVM_peek(vm, 1);
+                DaiValue receiver   = PEEK(1);
                 SubscriptSetFn func = NULL;
                 if (IS_OBJ(receiver)) {
                     func = AS_OBJ(receiver)->operation->subscript_set_func;
                 }
                 if (func) {
-                    DaiValue result = func(vm, receiver, DaiVM_peek(vm, 0), DaiVM_peek(vm, 2));
-                    DaiVM_popN(vm, 3);   // 弹出 index, object, value
+                    SAVE_STATE();
+                    DaiValue result = func(vm, receiver, PEEK(0), PEEK(2));
                     if (DAI_IS_ERROR(result)) {
                         return AS_ERROR(result);
                     }
+                    POPN(3);   // 弹出 index, object, value
                 } else {
-                    return DaiObjError_Newf(
-                        vm, "'%s' object is not subscriptable", dai_value_ts(receiver));
+                    RUNTIME_ERROR("'%s' object is not subscriptable", dai_value_ts(receiver));
                 }
-                break;
-            }
-            case DaiOpTrue: {
-                DaiVM_push(vm, dai_true);
-                break;
-            }
-            case DaiOpFalse: {
-                DaiVM_push(vm, dai_false);
-                break;
-            }
-            case DaiOpNil: {
-                DaiVM_push(vm, NIL_VAL);
-                break;
-            }
-            case DaiOpUndefined: {
-                DaiVM_push(vm, UNDEFINED_VAL);
-                break;
-            }
-            case DaiOpArray: {
-                uint16_t length    = READ_UINT16();
-                DaiObjArray* array = DaiObjArray_New(vm, vm->stack_top - length, length);
-                DaiVM_popN(vm, length);
-                DaiVM_push(vm, OBJ_VAL(array));
-                break;
-            }
-            case DaiOpMap: {
-                uint16_t length  = READ_UINT16();
+                DISPATCH();
+            }
+            CASE(DaiOpTrue): {
+                PUSH(dai_true);
+                DISPATCH();
+            }
+            CASE(DaiOpFalse): {
+                PUSH(dai_false);
+                DISPATCH();
+            }
+            CASE(DaiOpNil): {
+                PUSH(NIL_VAL);
+                DISPATCH();
+            }
+            CASE(DaiOpUndefined): {
+                PUSH(UNDEFINED_VAL);
+                DISPATCH();
+            }
+            CASE(DaiOpArray): {
+                uint16_t length = READ_UINT16();
+                SAVE_STATE();
+                DaiObjArray* array = DaiObjArray_New(vm, stack_top - length, length);
+                POPN(length);
+                PUSH(OBJ_VAL(array));
+                DISPATCH();
+            }
+            CASE(DaiOpMap): {
+                uint16_t length = READ_UINT16();
+                SAVE_STATE();
                 DaiObjMap* map   = NULL;
-                DaiObjError* err = DaiObjMap_New(vm, vm->stack_top - length * 2, length, &map);
+                DaiObjError* err = DaiObjMap_New(vm, stack_top - length * 2, length, &map);
                 if (err != NULL) {
                     return err;
                 }
-                DaiVM_popN(vm, length * 2);
-                DaiVM_push(vm, OBJ_VAL(map));
-                break;
+                POPN(length * 2);
+                PUSH(OBJ_VAL(map));
+                DISPATCH();
             }
 
-            case DaiOpEqual: {
-                DaiValue b = DaiVM_pop(vm);
-                DaiValue a = DaiVM_pop(vm);
-                int ret    = dai_value_equal(a, b);
+            CASE(DaiOpEqual): {
+                DaiValue b = POP();
+                DaiValue a = POP();
+                if (IS_INTEGER(a) && IS_INTEGER(b)) {
+                    QUICKEN(DaiOpEqual, DaiOpEqualInt);
+                } else if (IS_FLOAT(a) && IS_FLOAT(b)) {
+                    QUICKEN(DaiOpEqual, DaiOpEqualFloat);
+                }
+                int ret = dai_value_equal(a, b);
                 if (ret == -1) {
-                    return DaiObjError_Newf(vm, "maximum recursion depth exceeded in comparison");
+                    RUNTIME_ERROR("maximum recursion depth exceeded in comparison");
                 }
-                DaiValue res = BOOL_VAL(ret == 1);
-                DaiVM_push(vm, res);
-                break;
+                PUSH(BOOL_VAL(ret == 1));
+                DISPATCH();
             }
-            case DaiOpNotEqual: {
-                DaiValue b = DaiVM_pop(vm);
-                DaiValue a = DaiVM_pop(vm);
+            CASE(DaiOpNotEqual): {
+                DaiValue b = POP();
+                DaiValue a = POP();
                 int ret    = dai_value_equal(a, b);
                 if (ret == -1) {
-                    return DaiObjError_Newf(vm, "maximum recursion depth exceeded in comparison");
+                    RUNTIME_ERROR("maximum recursion depth exceeded in comparison");
+                }
+                PUSH(BOOL_VAL(ret == 0));
+                DISPATCH();
+            }
+            CASE(DaiOpGreaterThanJumpIfFalse): {
+                // GreaterThan; JumpIfFalse offset
+                DaiValue b = PEEK(0);
+                DaiValue a = PEEK(1);
+                if (IS_INTEGER(a) && IS_INTEGER(b)) {
+                    POPN(2);
+                    ip++;   // 跳过 JumpIfFalse
+                    uint16_t offset = READ_UINT16();
+                    if (!(AS_INTEGER(a) > AS_INTEGER(b))) {
+                        ip += offset;
+                    }
+                    DISPATCH();
+                }
+                if (IS_FLOAT(a) && IS_FLOAT(b)) {
+                    POPN(2);
+                    ip++;   // 跳过 JumpIfFalse
+                    uint16_t offset = READ_UINT16();
+                    if (!(AS_FLOAT(a) > AS_FLOAT(b))) {
+                        ip += offset;
+                    }
+                    DISPATCH();
                 }
-                DaiValue res = BOOL_VAL(ret == 0);
-                DaiVM_push(vm, res);
-                break;
+                // 其他类型按 GreaterThan 处理，接着会执行后面的 JumpIfFalse
+                // fallthrough
             }
-            case DaiOpGreaterThan: {
-                DaiValue b = DaiVM_pop(vm);
-                DaiValue a = DaiVM_pop(vm);
+            CASE(DaiOpGreaterThan): {
+                DaiValue b = POP();
+                DaiValue a = POP();
                 if (IS_INTEGER(a) && IS_INTEGER(b)) {
-                    DaiValue res = BOOL_VAL(AS_INTEGER(a) > AS_INTEGER(b));
-                    DaiVM_push(vm, res);
+                    QUICKEN(DaiOpGreaterThan, DaiOpGreaterThanInt);
+                    PUSH(BOOL_VAL(AS_INTEGER(a) > AS_INTEGER(b)));
                 } else if (IS_INTEGER(a) && IS_FLOAT(b)) {
-                    DaiValue res = BOOL_VAL(AS_INTEGER(a) > AS_FLOAT(b));
-                    DaiVM_push(vm, res);
+                    PUSH(BOOL_VAL(AS_INTEGER(a) > AS_FLOAT(b)));
                 } else if (IS_FLOAT(a) && IS_INTEGER(b)) {
-                    DaiValue res = BOOL_VAL(AS_FLOAT(a) > AS_INTEGER(b));
-                    DaiVM_push(vm, res);
+                    PUSH(BOOL_VAL(AS_FLOAT(a) > AS_INTEGER(b)));
                 } else if (IS_FLOAT(a) && IS_FLOAT(b)) {
-                    DaiValue res = BOOL_VAL(AS_FLOAT(a) > AS_FLOAT(b));
-                    DaiVM_push(vm, res);
+                    QUICKEN(DaiOpGreaterThan, DaiOpGreaterThanFloat);
+                    PUSH(BOOL_VAL(AS_FLOAT(a) > AS_FLOAT(b)));
                 } else if (IS_STRING(a) && IS_STRING(b)) {
-                    int ret      = DaiObjString_cmp(AS_STRING(a), AS_STRING(b));
-                    DaiValue res = BOOL_VAL(ret > 0);
-                    DaiVM_push(vm, res);
+                    int ret = DaiObjString_cmp(DaiObjString_flatten(vm, AS_STRING(a)),
+                                               DaiObjString_flatten(vm, AS_STRING(b)));
+                    PUSH(BOOL_VAL(ret > 0));
                 } else {
-                    return DaiObjError_Newf(vm,
-                                            "unsupported operand type(s) for >/<: '%s' and '%s'",
-                                            dai_value_ts(a),
-                                            dai_value_ts(b));
+                    RUNTIME_ERROR("unsupported operand type(s) for >/<: '%s' and '%s'",
+                                  dai_value_ts(a),
+                                  dai_value_ts(b));
                 }
-                break;
+                DISPATCH();
             }
-            case DaiOpGreaterEqualThan: {
-                DaiValue b = DaiVM_pop(vm);
-                DaiValue a = DaiVM_pop(vm);
+            CASE(DaiOpGreaterEqualThan): {
+                DaiValue b = POP();
+                DaiValue a = POP();
                 if (IS_INTEGER(a) && IS_INTEGER(b)) {
-                    DaiValue res = BOOL_VAL(AS_INTEGER(a) >= AS_INTEGER(b));
-                    DaiVM_push(vm, res);
+                    PUSH(BOOL_VAL(AS_INTEGER(a) >= AS_INTEGER(b)));
                 } else if (IS_INTEGER(a) && IS_FLOAT(b)) {
-                    DaiValue res = BOOL_VAL(AS_INTEGER(a) >= AS_FLOAT(b));
-                    DaiVM_push(vm, res);
+                    PUSH(BOOL_VAL(AS_INTEGER(a) >= AS_FLOAT(b)));
                 } else if (IS_FLOAT(a) && IS_INTEGER(b)) {
-                    DaiValue res = BOOL_VAL(AS_FLOAT(a) >= AS_INTEGER(b));
-                    DaiVM_push(vm, res);
+                    PUSH(BOOL_VAL(AS_FLOAT(a) >= AS_INTEGER(b)));
                 } else if (IS_FLOAT(a) && IS_FLOAT(b)) {
-                    DaiValue res = BOOL_VAL(AS_FLOAT(a) >= AS_FLOAT(b));
-                    DaiVM_push(vm, res);
+                    PUSH(BOOL_VAL(AS_FLOAT(a) >= AS_FLOAT(b)));
                 } else if (IS_STRING(a) && IS_STRING(b)) {
-                    int ret      = DaiObjString_cmp(AS_STRING(a), AS_STRING(b));
-                    DaiValue res = BOOL_VAL(ret >= 0);
-                    DaiVM_push(vm, res);
+                    int ret = DaiObjString_cmp(DaiObjString_flatten(vm, AS_STRING(a)),
+                                               DaiObjString_flatten(vm, AS_STRING(b)));
+                    PUSH(BOOL_VAL(ret >= 0));
                 } else {
-                    return DaiObjError_Newf(vm,
-                                            "unsupported operand type(s) for >=/<=: '%s' and '%s'",
-                                            dai_value_ts(a),
-                                            dai_value_ts(b));
+                    RUNTIME_ERROR("unsupported operand type(s) for >=/<=: '%s' and '%s'",
+                                  dai_value_ts(a),
+                                  dai_value_ts(b));
                 }
-                break;
+                DISPATCH();
             }
 
-            case DaiOpNot: {
-                DaiValue a   = DaiVM_pop(vm);
-                DaiValue res = BOOL_VAL(!dai_value_is_truthy(a));
-                DaiVM_push(vm, res);
-                break;
+            CASE(DaiOpNot): {
+                DaiValue a = POP();
+                PUSH(BOOL_VAL(!dai_value_is_truthy(a)));
+                DISPATCH();
             }
-            case DaiOpAndJump: {
+            CASE(DaiOpAndJump): {
                 int offset = READ_UINT16();
-                DaiValue a = DaiVM_peek(vm, 0);
-                if (!dai_value_is_truthy(a)) {
-                    frame->ip += offset;
+                if (!dai_value_is_truthy(PEEK(0))) {
+                    ip += offset;
                 }
-                break;
+                DISPATCH();
             }
-            case DaiOpOrJump: {
+            CASE(DaiOpOrJump): {
                 int offset = READ_UINT16();
-                DaiValue a = DaiVM_peek(vm, 0);
-                if (dai_value_is_truthy(a)) {
-                    frame->ip += offset;
+                if (dai_value_is_truthy(PEEK(0))) {
+                    ip += offset;
                 }
-                break;
+                DISPATCH();
             }
 
-            case DaiOpMinus: {
-                DaiValue a = DaiVM_pop(vm);
+            CASE(DaiOpMinus): {
+                DaiValue a = POP();
                 if (IS_INTEGER(a)) {
-                    DaiVM_push(vm, INTEGER_VAL(-AS_INTEGER(a)));
+                    PUSH(INTEGER_VAL(-AS_INTEGER(a)));
                 } else if (IS_FLOAT(a)) {
-                    DaiVM_push(vm, FLOAT_VAL(-AS_FLOAT(a)));
+                    PUSH(FLOAT_VAL(-AS_FLOAT(a)));
                 } else {
-                    return DaiObjError_Newf(
-                        vm, "unsupported operand type(s) for -: '%s'", dai_value_ts(a));
+                    RUNTIME_ERROR("unsupported operand type(s) for -: '%s'", dai_value_ts(a));
                 }
-                break;
+                DISPATCH();
             }
-            case DaiOpBang: {
-                DaiValue a   = DaiVM_pop(vm);
-                DaiValue res = BOOL_VAL(!dai_value_is_truthy(a));
-                DaiVM_push(vm, res);
-                break;
+            CASE(DaiOpBang): {
+                DaiValue a = POP();
+                PUSH(BOOL_VAL(!dai_value_is_truthy(a)));
+                DISPATCH();
             }
-            case DaiOpBitwiseNot: {
-                DaiValue a = DaiVM_pop(vm);
+            CASE(DaiOpBitwiseNot): {
+                DaiValue a = POP();
                 if (IS_INTEGER(a)) {
-                    DaiVM_push(vm, INTEGER_VAL(~AS_INTEGER(a)));
+                    PUSH(INTEGER_VAL(~AS_INTEGER(a)));
                 } else {
-                    return DaiObjError_Newf(
-                        vm, "unsupported operand type(s) for ~: '%s'", dai_value_ts(a));
+                    RUNTIME_ERROR("unsupported operand type(s) for ~: '%s'", dai_value_ts(a));
                 }
-                break;
+                DISPATCH();
             }
 
-            case DaiOpJumpIfFalse: {
+            CASE(DaiOpJumpIfFalse): {
                 uint16_t offset = READ_UINT16();
-                if (!dai_value_is_truthy(DaiVM_pop(vm))) {
-                    frame->ip += offset;
+                if (!dai_value_is_truthy(POP())) {
+                    ip += offset;
                 }
-                break;
+                DISPATCH();
             }
-            case DaiOpJump: {
+            CASE(DaiOpJump): {
                 uint16_t offset = READ_UINT16();
-                frame->ip += offset;
-                break;
+                ip += offset;
+                DISPATCH();
             }
-            case DaiOpJumpBack: {
+            CASE(DaiOpJumpBack): {
                 uint16_t offset = READ_UINT16();
-                frame->ip -= offset;
-                break;
+                ip -= offset;
+                // 循环回跳是安全点，复制等待复制的切片字符串，堆超过上限时在这里返回错误
+                if (DAI_UNLIKELY(vm->gcCompactCount > 0)) {
+                    dai_gc_compact_slices(vm);
+                }
+                if (DAI_UNLIKELY(vm->gcOutOfMemory)) {
+                    SAVE_STATE();
+                    DaiObjError* err = DaiVM_checkOutOfMemory(vm);
+                    if (err != NULL) {
+                        return err;
+                    }
+                }
+                JIT_ENTER();
+                DISPATCH();
             }
 
-            case DaiOpIterInit: {
+            CASE(DaiOpIterInit): {
                 uint8_t iterator_slot = READ_BYTE();
-                DaiValue val          = DaiVM_peek(vm, 0);   // 先不要 pop ，以免被 GC 回收
-                IterInitFn func       = NULL;
+                DaiValue val          = PEEK(0);   // 先不要 pop ，以免被 GC 回收
+                DaiValue* slots       = frame->slots + iterator_slot;
+                // 数组和字典直接遍历容器本身，不创建迭代器对象
+                if (IS_ARRAY(val) || IS_MAP(val)) {
+                    slots[DAI_ITER_ITERATOR] = val;
+                    slots[DAI_ITER_CURSOR]   = INTEGER_VAL(0);
+                    POPN(1);
+                    DISPATCH();
+                }
+                IterInitFn func = NULL;
                 if (IS_OBJ(val)) {
                     func = AS_OBJ(val)->operation->iter_init_func;
                 }
                 if (func) {
-                    DaiValue iterator           = func(vm, val);
-                    frame->slots[iterator_slot] = iterator;
-                    DaiVM_pop(vm);
+                    SAVE_STATE();
+                    DaiValue iterator        = func(vm, val);
+                    slots[DAI_ITER_ITERATOR] = iterator;
+                    POPN(1);
                 } else {
-                    return DaiObjError_Newf(vm, "'%s' object is not iterable", dai_value_ts(val));
+                    RUNTIME_ERROR("'%s' object is not iterable", dai_value_ts(val));
                 }
-                break;
+                DISPATCH();
             }
-            case DaiOpIterNext: {
+            CASE(DaiOpIterNext): {
                 uint8_t iterator_slot = READ_BYTE();
+                uint8_t flags         = READ_BYTE();
                 uint16_t end_offset   = READ_UINT16();
-                DaiValue iterator     = frame->slots[iterator_slot];
-                DaiValue i, e;
-                DaiValue next = AS_OBJ(iterator)->operation->iter_next_func(vm, iterator, &i, &e);
-                frame->slots[iterator_slot + 1] = i;
-                frame->slots[iterator_slot + 2] = e;
-                if (IS_UNDEFINED(next)) {
-                    frame->ip += end_offset;
+                SAVE_STATE();
+                if (!DaiVM_iterNext(vm, frame->slots + iterator_slot, flags)) {
+                    ip += end_offset;
+                }
+                DISPATCH();
+            }
+            CASE(DaiOpRangeInit): {
+                // 从栈顶排列为 step, end, start
+                uint8_t counter_slot = READ_BYTE();
+                for (int i = 0; i < 3; i++) {
+                    if (!IS_INTEGER(PEEK(i))) {
+                        RUNTIME_ERROR("range() expected int arguments, but got %s",
+                                      dai_value_ts(PEEK(i)));
+                    }
+                }
+                DaiValue* slots          = frame->slots + counter_slot;
+                slots[DAI_RANGE_STEP]    = POP();
+                slots[DAI_RANGE_END]     = POP();
+                slots[DAI_RANGE_COUNTER] = POP();
+                slots[DAI_RANGE_INDEX]   = INTEGER_VAL(0);
+                DISPATCH();
+            }
+            CASE(DaiOpRangeNext): {
+                uint8_t counter_slot = READ_BYTE();
+                uint8_t flags        = READ_BYTE();
+                uint16_t end_offset  = READ_UINT16();
+                DaiValue* slots      = frame->slots + counter_slot;
+                int64_t curr         = AS_INTEGER(slots[DAI_RANGE_COUNTER]);
+                int64_t end          = AS_INTEGER(slots[DAI_RANGE_END]);
+                int64_t step         = AS_INTEGER(slots[DAI_RANGE_STEP]);
+                if ((step >= 0 && curr >= end) || (step < 0 && curr <= end)) {
+                    ip += end_offset;
+                    DISPATCH();
+                }
+                if (!(flags & DAI_ITER_SKIP_INDEX)) {
+                    slots[DAI_RANGE_I]     = slots[DAI_RANGE_INDEX];
+                    slots[DAI_RANGE_INDEX] = INTEGER_VAL(AS_INTEGER(slots[DAI_RANGE_INDEX]) + 1);
                 }
-                break;
+                slots[DAI_RANGE_E]       = INTEGER_VAL(curr);
+                slots[DAI_RANGE_COUNTER] = INTEGER_VAL(curr + step);
+                DISPATCH();
             }
 
-            case DaiOpPop: {
+            CASE(DaiOpPop): {
 #ifdef DEBUG_TRACE_EXECUTION
                 dai_log("          pop [ ");
-                dai_print_value(DaiVM_peek(vm, 0));
+                dai_print_value(PEEK(0));
                 dai_log(" ]\n");
 #endif
-                DaiVM_pop(vm);
-                break;
+                POPN(1);
+                DISPATCH();
             }
-            case DaiOpPopN: {
+            CASE(DaiOpPopN): {
                 uint8_t n = READ_BYTE();
-                DaiVM_popN(vm, n);
-                break;
+                POPN(n);
+                DISPATCH();
             }
 
-            case DaiOpSetGlobal:
-            case DaiOpDefineGlobal: {
+            CASE(DaiOpSetGlobal):
+            CASE(DaiOpDefineGlobal): {
                 uint16_t globalIndex = READ_UINT16();
-                DaiValue val         = DaiVM_pop(vm);
-                globals[globalIndex] = val;
-                break;
+                globals[globalIndex] = POP();
+                DISPATCH();
             }
-            case DaiOpGetGlobal: {
+            CASE(DaiOpGetGlobal): {
                 uint16_t globalIndex = READ_UINT16();
-                DaiValue val         = globals[globalIndex];
-                DaiVM_push(vm, val);
-                break;
+                PUSH(globals[globalIndex]);
+                DISPATCH();
             }
 
-            case DaiOpCall: {
-                int argCount     = READ_BYTE();
-                DaiValue callee  = DaiVM_peek(vm, argCount);
+            CASE(DaiOpCall): {
+                int argCount    = READ_BYTE();
+                DaiValue callee = PEEK(argCount);
+                SAVE_STATE();
                 DaiObjError* err = DaiVM_callValue(vm, callee, argCount, UNDEFINED_VAL);
                 if (err != NULL) {
                     return err;
                 }
-                frame   = CURRENT_FRAME;
-                chunk   = frame->chunk;
-                globals = frame->globals;
-                break;
+                LOAD_STATE();
+                DISPATCH();
             }
-            case DaiOpReturnValue: {
-                DaiValue result = DaiVM_pop(vm);
+            CASE(DaiOpReturnValue): {
+                DaiValue result = POP();
                 vm->frame_count--;
-                vm->stack_top = frame->slots;
-                DaiVM_push(vm, result);
-                frame   = CURRENT_FRAME;
-                chunk   = frame->chunk;
-                globals = frame->globals;
+                stack_top = frame->slots;
+                PUSH(result);
                 if (vm->frame_count == current_frame_index) {
+                    vm->stack_top = stack_top;
                     return NULL;
                 }
-                break;
+                LOAD_FRAME();
+                DISPATCH();
             }
-            case DaiOpReturn: {
-                DaiValue result = NIL_VAL;
+            CASE(DaiOpReturn): {
                 vm->frame_count--;
-                vm->stack_top = frame->slots;
-                DaiVM_push(vm, result);
-                frame   = CURRENT_FRAME;
-                chunk   = frame->chunk;
-                globals = frame->globals;
+                stack_top = frame->slots;
+                PUSH(NIL_VAL);
                 if (vm->frame_count == current_frame_index) {
+                    vm->stack_top = stack_top;
                     return NULL;
                 }
-                break;
+                LOAD_FRAME();
+                DISPATCH();
             }
 
-            case DaiOpGetLocal: {
+            CASE(DaiOpGetLocal): {
                 uint8_t slot = READ_BYTE();
-                DaiVM_push(vm, frame->slots[slot]);
-                break;
+                PUSH(frame->slots[slot]);
+                DISPATCH();
             }
-            case DaiOpSetLocal: {
+            CASE(DaiOpSetLocal): {
                 // var 语句和赋值语句都会用到这个指令
                 uint8_t slot       = READ_BYTE();
-                frame->slots[slot] = DaiVM_pop(vm);
-                break;
+                frame->slots[slot] = POP();
+                DISPATCH();
             }
 
-            case DaiOpGetBuiltin: {
+            CASE(DaiOpGetBuiltin): {
                 uint8_t index = READ_BYTE();
-                DaiVM_push(vm, vm->builtin_objects[index]);
-                break;
+                PUSH(vm->builtin_objects[index]);
+                DISPATCH();
             }
 
-            case DaiOpSetFunctionDefault: {
+            CASE(DaiOpSetFunctionDefault): {
                 uint8_t default_count    = READ_BYTE();
-                DaiValue value           = DaiVM_peek(vm, default_count);
+                DaiValue value           = PEEK(default_count);
                 DaiObjFunction* function = NULL;
                 if (IS_CLOSURE(value)) {
                     function = AS_CLOSURE(value)->function;
                 } else {
                     function = AS_FUNCTION(value);
                 }
+                SAVE_STATE();
                 DaiValue* defaults = VM_ALLOCATE(vm, DaiValue, default_count);
-                memcpy(defaults, vm->stack_top - default_count, default_count * sizeof(DaiValue));
-                DaiVM_popN(vm, default_count);
+                memcpy(defaults, stack_top - default_count, default_count * sizeof(DaiValue));
+                POPN(default_count);
                 function->defaults      = defaults;
                 function->default_count = default_count;
-                break;
+                dai_gc_write_barrier_all(vm, (DaiObj*)function);
+                DISPATCH();
             }
 
-            case DaiOpClosure: {
-                uint16_t function_index = READ_UINT16();
-                uint8_t free_var_count  = READ_BYTE();
-                DaiValue constant       = chunk->constants.values[function_index];
-                DaiValue* frees         = NULL;
+            CASE(DaiOpClosure): {
+                DaiValue constant      = READ_CONSTANT();
+                uint8_t free_var_count = READ_BYTE();
+                DaiValue* frees        = NULL;
+                SAVE_STATE();
                 if (free_var_count > 0) {
                     frees = VM_ALLOCATE(vm, DaiValue, free_var_count);
                     for (int i = 0; i < free_var_count; i++) {
-                        frees[i] = DaiVM_peek(
-                            vm, free_var_count - i - 1);   // peek 里面 -1 ，所以这里要 -1
+                        frees[i] = PEEK(free_var_count - i - 1);   // peek 里面 -1 ，所以这里要 -1
                     }
                 }
                 DaiObjClosure* closure = DaiObjClosure_New(vm, AS_FUNCTION(constant));
                 closure->frees         = frees;
-                DaiVM_popN(vm, free_var_count);
-                DaiVM_push(vm, OBJ_VAL(closure));
-                break;
+                POPN(free_var_count);
+                PUSH(OBJ_VAL(closure));
+                DISPATCH();
             }
 
-            case DaiOpGetFree: {
+            CASE(DaiOpGetFree): {
                 uint8_t index = READ_BYTE();
-                DaiVM_push(vm, frame->closure->frees[index]);
-                break;
-            }
-
-            case DaiOpClass: {
-                uint16_t name_index = READ_UINT16();
-                DaiValue name       = chunk->constants.values[name_index];
-                DaiObjClass* cls    = DaiObjClass_New(vm, AS_STRING(name));
-                DaiVM_push(vm, OBJ_VAL(cls));
-                break;
-            }
-            case DaiOpDefineField: {
-                uint16_t name_index = READ_UINT16();
-                uint8_t is_const    = READ_BYTE();
-                DaiObjString* name  = AS_STRING(chunk->constants.values[name_index]);
-                DaiObjClass* klass  = AS_CLASS(DaiVM_peek(vm, 1));
-                DaiValue value      = DaiVM_pop(vm);
-                DaiObjClass_define_field(klass, name, value, is_const);
-                break;
-            }
-            case DaiOpDefineMethod: {
-                uint16_t name_index = READ_UINT16();
-                DaiObjString* name  = AS_STRING(chunk->constants.values[name_index]);
-                DaiObjClass* klass  = AS_CLASS(DaiVM_peek(vm, 1));
-                DaiValue value      = DaiVM_pop(vm);
-                DaiObjClass_define_method(klass, name, value);
-                break;
-            }
-            case DaiOpDefineClassField: {
-                uint16_t name_index = READ_UINT16();
-                uint8_t is_const    = READ_BYTE();
-                DaiObjString* name  = AS_STRING(chunk->constants.values[name_index]);
-                DaiObjClass* klass  = AS_CLASS(DaiVM_peek(vm, 1));
-                DaiValue value      = DaiVM_pop(vm);
-                DaiObjClass_define_class_field(klass, name, value, is_const);
-                break;
-            }
-            case DaiOpDefineClassMethod: {
-                uint16_t name_index = READ_UINT16();
-                DaiObjString* name  = AS_STRING(chunk->constants.values[name_index]);
-                DaiObjClass* klass  = AS_CLASS(DaiVM_peek(vm, 1));
-                DaiValue method     = DaiVM_pop(vm);
-                DaiObjClass_define_class_method(klass, name, method);
-                break;
-            }
-            case DaiOpGetProperty: {
-                uint16_t name_index = READ_UINT16();
-                DaiObjString* name  = AS_STRING(chunk->constants.values[name_index]);
-                DaiValue receiver   = DaiVM_pop(vm);
-                GetPropertyFn func  = NULL;
+                PUSH(frame->closure->frees[index]);
+                DISPATCH();
+            }
+
+            CASE(DaiOpClass): {
+                DaiValue name = READ_CONSTANT();
+                SAVE_STATE();
+                DaiObjClass* cls = DaiObjClass_New(vm, AS_STRING(name));
+                PUSH(OBJ_VAL(cls));
+                DISPATCH();
+            }
+            CASE(DaiOpDefineField): {
+                DaiObjString* name = AS_STRING(READ_CONSTANT());
+                uint8_t is_const   = READ_BYTE();
+                DaiObjClass* klass = AS_CLASS(PEEK(1));
+                DaiValue value     = PEEK(0);
+                SAVE_STATE();
+                DaiObjClass_define_field(vm, klass, name, value, is_const);
+                POPN(1);
+                DISPATCH();
+            }
+            CASE(DaiOpDefineMethod): {
+                DaiObjString* name = AS_STRING(READ_CONSTANT());
+                DaiObjClass* klass = AS_CLASS(PEEK(1));
+                DaiValue value     = PEEK(0);
+                SAVE_STATE();
+                DaiObjClass_define_method(vm, klass, name, value);
+                POPN(1);
+                DISPATCH();
+            }
+            CASE(DaiOpDefineClassField): {
+                DaiObjString* name = AS_STRING(READ_CONSTANT());
+                uint8_t is_const   = READ_BYTE();
+                DaiObjClass* klass = AS_CLASS(PEEK(1));
+                DaiValue value     = PEEK(0);
+                SAVE_STATE();
+                DaiObjClass_define_class_field(vm, klass, name, value, is_const);
+                POPN(1);
+                DISPATCH();
+            }
+            CASE(DaiOpDefineClassMethod): {
+                DaiObjString* name = AS_STRING(READ_CONSTANT());
+                DaiObjClass* klass = AS_CLASS(PEEK(1));
+                DaiValue method    = PEEK(0);
+                SAVE_STATE();
+                DaiObjClass_define_class_method(vm, klass, name, method);
+                POPN(1);
+                DISPATCH();
+            }
+            CASE(DaiOpGetProperty): {
+                DaiObjString* name      = AS_STRING(READ_CONSTANT());
+                DaiPropertyCache* cache = &chunk->property_caches[READ_UINT16()];
+                DaiValue receiver       = PEEK(0);
+                if (DaiVM_getInstanceField(cache, receiver, name, &PEEK(0))) {
+                    DISPATCH();
+                }
+                GetPropertyFn func = NULL;
                 if (IS_OBJ(receiver)) {
                     func = AS_OBJ(receiver)->operation->get_property_func;
                 }
                 if (func) {
+                    SAVE_STATE();
                     DaiValue res = func(vm, receiver, name);
                     if (DAI_IS_ERROR(res)) {
                         return AS_ERROR(res);
                     }
-                    DaiVM_push(vm, res);
+                    PEEK(0) = res;
                 } else {
-                    return DaiObjError_Newf(vm,
-                                            "'%s' object has not property '%s'",
-                                            dai_value_ts(receiver),
-                                            name->chars);
-                }
-                break;
-            }
-            case DaiOpSetProperty: {
-                uint16_t name_index = READ_UINT16();
-                DaiObjString* name  = AS_STRING(chunk->constants.values[name_index]);
-                DaiValue receiver   = DaiVM_pop(vm);
-                DaiValue value      = DaiVM_pop(vm);
-                SetPropertyFn func  = NULL;
+                    RUNTIME_ERROR("'%s' object has not property '%s'",
+                                  dai_value_ts(receiver),
+                                  name->chars);
+                }
+                DISPATCH();
+            }
+            CASE(DaiOpSetProperty): {
+                DaiObjString* name      = AS_STRING(READ_CONSTANT());
+                DaiPropertyCache* cache = &chunk->property_caches[READ_UINT16()];
+                DaiValue receiver       = PEEK(0);
+                DaiValue value          = PEEK(1);
+                if (DaiVM_setInstanceField(vm, cache, receiver, name, value)) {
+                    POPN(2);
+                    DISPATCH();
+                }
+                SetPropertyFn func = NULL;
                 if (IS_OBJ(receiver)) {
                     func = AS_OBJ(receiver)->operation->set_property_func;
                 }
                 if (func) {
+                    SAVE_STATE();
                     DaiValue res = func(vm, receiver, name, value);
                     if (DAI_IS_ERROR(res)) {
                         return AS_ERROR(res);
                     }
+                    POPN(2);
                 } else {
-                    return DaiObjError_Newf(vm,
-                                            "'%s' object can not set property '%s'",
-                                            dai_value_ts(receiver),
-                                            name->chars);
+                    RUNTIME_ERROR("'%s' object can not set property '%s'",
+                                  dai_value_ts(receiver),
+                                  name->chars);
                 }
-                break;
-            }
-            case DaiOpGetSelfProperty: {
-                uint16_t name_index = READ_UINT16();
-                DaiObjString* name  = AS_STRING(chunk->constants.values[name_index]);
-                DaiValue receiver   = frame->slots[0];
+                DISPATCH();
+            }
+            CASE(DaiOpGetSelfProperty): {
+                DaiObjString* name      = AS_STRING(READ_CONSTANT());
+                DaiPropertyCache* cache = &chunk->property_caches[READ_UINT16()];
+                DaiValue receiver       = frame->slots[0];
+                if (DaiVM_getInstanceField(cache, receiver, name, stack_top)) {
+                    stack_top++;
+                    DISPATCH();
+                }
+                SAVE_STATE();
                 DaiValue res = AS_OBJ(receiver)->operation->get_property_func(vm, receiver, name);
                 if (DAI_IS_ERROR(res)) {
                     return AS_ERROR(res);
                 }
-                DaiVM_push(vm, res);
-                break;
-            }
-            case DaiOpSetSelfProperty: {
-                uint16_t name_index = READ_UINT16();
-                DaiObjString* name  = AS_STRING(chunk->constants.values[name_index]);
-                DaiValue receiver   = frame->slots[0];
-                DaiValue res        = AS_OBJ(receiver)->operation->set_property_func(
-                    vm, receiver, name, DaiVM_pop(vm));
+                PUSH(res);
+                DISPATCH();
+            }
+            CASE(DaiOpSetSelfProperty): {
+                DaiObjString* name      = AS_STRING(READ_CONSTANT());
+                DaiPropertyCache* cache = &chunk->property_caches[READ_UINT16()];
+                DaiValue receiver       = frame->slots[0];
+                if (DaiVM_setInstanceField(vm, cache, receiver, name, PEEK(0))) {
+                    POPN(1);
+                    DISPATCH();
+                }
+                SAVE_STATE();
+                DaiValue res =
+                    AS_OBJ(receiver)->operation->set_property_func(vm, receiver, name, PEEK(0));
                 if (DAI_IS_ERROR(res)) {
                     return AS_ERROR(res);
                 }
-                break;
+                POPN(1);
+                DISPATCH();
             }
-            case DaiOpGetSuperProperty: {
+            CASE(DaiOpGetSuperProperty): {
                 if (frame->function->superclass == NULL) {
-                    return DaiObjError_Newf(vm, "no superclass found");
+                    RUNTIME_ERROR("no superclass found");
                 }
-                uint16_t name_index             = READ_UINT16();
-                DaiObjString* name              = AS_STRING(chunk->constants.values[name_index]);
+                DaiObjString* name = AS_STRING(READ_CONSTANT());
+                SAVE_STATE();
                 DaiObjBoundMethod* bound_method = DaiObjClass_get_super_method(
                     vm, frame->function->superclass, name, frame->slots[0]);
                 if (bound_method == NULL) {
-                    return DaiObjError_Newf(
-                        vm, "'super' object has not property '%s'", name->chars);
-                }
-                DaiVM_push(vm, OBJ_VAL(bound_method));
-                break;
-            }
-            case DaiOpInherit: {
-                DaiObjClass* parent = AS_CLASS(DaiVM_pop(vm));
-                DaiObjClass* child  = AS_CLASS(DaiVM_peek(vm, 0));
-                DaiObjClass_inherit(child, parent);
-                break;
-            }
-            case DaiOpCallMethod: {
-                uint16_t name_index = READ_UINT16();
-                DaiObjString* name  = AS_STRING(chunk->constants.values[name_index]);
-                int argCount        = READ_BYTE();
-                DaiValue receiver   = DaiVM_peek(vm, argCount);
-                GetMethodFn func    = NULL;
+                    RUNTIME_ERROR("'super' object has not property '%s'", name->chars);
+                }
+                PUSH(OBJ_VAL(bound_method));
+                DISPATCH();
+            }
+            CASE(DaiOpInherit): {
+                DaiObjClass* parent = AS_CLASS(PEEK(0));
+                DaiObjClass* child  = AS_CLASS(PEEK(1));
+                SAVE_STATE();
+                DaiObjClass_inherit(vm, child, parent);
+                POPN(1);
+                DISPATCH();
+            }
+            CASE(DaiOpCallMethod): {
+                DaiObjString* name    = AS_STRING(READ_CONSTANT());
+                int argCount          = READ_BYTE();
+                DaiMethodCache* cache = &chunk->method_caches[READ_UINT16()];
+                DaiValue receiver     = PEEK(argCount);
+                DaiValue method;
+                if (DaiVM_getCachedMethod(cache, receiver, &method)) {
+                    SAVE_STATE();
+                    DaiObjError* err = DaiVM_callCachedMethod(vm, method, argCount, receiver);
+                    if (err != NULL) {
+                        return err;
+                    }
+                    LOAD_STATE();
+                    DISPATCH();
+                }
+                GetMethodFn func = NULL;
                 if (IS_OBJ(receiver)) {
                     func = AS_OBJ(receiver)->operation->get_method_func;
                 }
                 if (func) {
+                    SAVE_STATE();
                     DaiValue res = func(vm, receiver, name);
                     if (DAI_IS_ERROR(res)) {
                         return AS_ERROR(res);
                     }
+                    DaiVM_updateMethodCache(cache, receiver, res);
                     DaiObjError* err = DaiVM_callValue(vm, res, argCount, receiver);
                     if (err != NULL) {
                         return err;
                     }
-                    frame   = CURRENT_FRAME;
-                    chunk   = frame->chunk;
-                    globals = frame->globals;
+                    LOAD_STATE();
                 } else {
-                    return DaiObjError_Newf(vm,
-                                            "'%s' object has not property '%s'",
-                                            dai_value_ts(receiver),
-                                            name->chars);
-                }
-                break;
-            }
-            case DaiOpCallSelfMethod: {
-                uint16_t name_index = READ_UINT16();
-                DaiObjString* name  = AS_STRING(chunk->constants.values[name_index]);
-                int argCount        = READ_BYTE();
-                DaiValue receiver   = frame->slots[0];
-                GetMethodFn func    = AS_OBJ(receiver)->operation->get_method_func;
+                    RUNTIME_ERROR("'%s' object has not property '%s'",
+                                  dai_value_ts(receiver),
+                                  name->chars);
+                }
+                DISPATCH();
+            }
+            CASE(DaiOpCallSelfMethod): {
+                DaiObjString* name    = AS_STRING(READ_CONSTANT());
+                int argCount          = READ_BYTE();
+                DaiMethodCache* cache = &chunk->method_caches[READ_UINT16()];
+                DaiValue receiver     = frame->slots[0];
+                DaiValue method;
+                if (DaiVM_getCachedMethod(cache, receiver, &method)) {
+                    SAVE_STATE();
+                    DaiObjError* err = DaiVM_callCachedMethod(vm, method, argCount, receiver);
+                    if (err != NULL) {
+                        return err;
+                    }
+                    LOAD_STATE();
+                    DISPATCH();
+                }
+                GetMethodFn func = AS_OBJ(receiver)->operation->get_method_func;
                 if (func) {
+                    SAVE_STATE();
                     DaiValue res = func(vm, receiver, name);
                     if (DAI_IS_ERROR(res)) {
                         return AS_ERROR(res);
                     }
+                    DaiVM_updateMethodCache(cache, receiver, res);
                     DaiObjError* err = DaiVM_callValue(vm, res, argCount, receiver);
                     if (err != NULL) {
                         return err;
                     }
-                    frame   = CURRENT_FRAME;
-                    chunk   = frame->chunk;
-                    globals = frame->globals;
+                    LOAD_STATE();
                 } else {
-                    return DaiObjError_Newf(vm,
-                                            "'%s' object has not property '%s'",
-                                            dai_value_ts(receiver),
-                                            name->chars);
-                }
-                break;
-            }
-            case DaiOpCallSuperMethod: {
-                uint16_t name_index = READ_UINT16();
-                DaiObjString* name  = AS_STRING(chunk->constants.values[name_index]);
-                int argCount        = READ_BYTE();
-                DaiValue receiver   = frame->slots[0];
+                    RUNTIME_ERROR("'%s' object has not property '%s'",
+                                  dai_value_ts(receiver),
+                                  name->chars);
+                }
+                DISPATCH();
+            }
+            CASE(DaiOpCallSuperMethod): {
+                DaiObjString* name = AS_STRING(READ_CONSTANT());
+                int argCount       = READ_BYTE();
+                DaiValue receiver  = frame->slots[0];
                 DaiValue method;
+                SAVE_STATE();
                 DaiObj_get_method(vm, frame->function->superclass, receiver, name, &method);
                 if (DAI_IS_ERROR(method)) {
                     return AS_ERROR(method);
@@ -1029,16 +1436,166 @@ DaiVM_runCurrentFrame(DaiVM* vm) {
                 if (err != NULL) {
                     return err;
                 }
-                frame   = CURRENT_FRAME;
-                chunk   = frame->chunk;
-                globals = frame->globals;
-                break;
+                LOAD_STATE();
+                DISPATCH();
+            }
+
+            CASE(DaiOpAddLocalLocal): {
+                // GetLocal a; GetLocal b; Add
+                DaiValue a = frame->slots[ip[0]];
+                DaiValue b = frame->slots[ip[2]];
+                if (IS_INTEGER(a) && IS_INTEGER(b)) {
+                    PUSH(INTEGER_VAL(AS_INTEGER(a) + AS_INTEGER(b)));
+                    ip += 4;
+                    DISPATCH();
+                }
+                // 慢路径：只执行 GetLocal a ，后面的 GetLocal b; Add 照常执行
+                PUSH(a);
+                ip++;
+                DISPATCH();
+            }
+            CASE(DaiOpAddLocalConstant): {
+                // GetLocal a; Constant k; Add
+                DaiValue a = frame->slots[ip[0]];
+                DaiValue b = constants[(ip[2] << 8) | ip[3]];
+                if (IS_INTEGER(a) && IS_INTEGER(b)) {
+                    PUSH(INTEGER_VAL(AS_INTEGER(a) + AS_INTEGER(b)));
+                    ip += 5;
+                    DISPATCH();
+                }
+                PUSH(a);
+                ip++;
+                DISPATCH();
+            }
+            CASE(DaiOpSubLocalConstant): {
+                // GetLocal a; Constant k; Sub
+                DaiValue a = frame->slots[ip[0]];
+                DaiValue b = constants[(ip[2] << 8) | ip[3]];
+                if (IS_INTEGER(a) && IS_INTEGER(b)) {
+                    PUSH(INTEGER_VAL(AS_INTEGER(a) - AS_INTEGER(b)));
+                    ip += 5;
+                    DISPATCH();
+                }
+                PUSH(a);
+                ip++;
+                DISPATCH();
             }
 
-            case DaiOpEnd: {
+            CASE(DaiOpAddInt): {
+                DaiValue b = PEEK(0);
+                DaiValue a = PEEK(1);
+                if (DAI_UNLIKELY(!(IS_INTEGER(a) && IS_INTEGER(b)))) {
+                    DEOPTIMIZE(DaiOpAdd);
+                    DISPATCH();
+                }
+                POPN(1);
+                PEEK(0) = INTEGER_VAL(AS_INTEGER(a) + AS_INTEGER(b));
+                DISPATCH();
+            }
+            CASE(DaiOpAddFloat): {
+                DaiValue b = PEEK(0);
+                DaiValue a = PEEK(1);
+                if (DAI_UNLIKELY(!(IS_FLOAT(a) && IS_FLOAT(b)))) {
+                    DEOPTIMIZE(DaiOpAdd);
+                    DISPATCH();
+                }
+                POPN(1);
+                PEEK(0) = FLOAT_VAL(AS_FLOAT(a) + AS_FLOAT(b));
+                DISPATCH();
+            }
+            CASE(DaiOpSubInt): {
+                DaiValue b = PEEK(0);
+                DaiValue a = PEEK(1);
+                if (DAI_UNLIKELY(!(IS_INTEGER(a) && IS_INTEGER(b)))) {
+                    DEOPTIMIZE(DaiOpSub);
+                    DISPATCH();
+                }
+                POPN(1);
+                PEEK(0) = INTEGER_VAL(AS_INTEGER(a) - AS_INTEGER(b));
+                DISPATCH();
+            }
+            CASE(DaiOpSubFloat): {
+                DaiValue b = PEEK(0);
+                DaiValue a = PEEK(1);
+                if (DAI_UNLIKELY(!(IS_FLOAT(a) && IS_FLOAT(b)))) {
+                    DEOPTIMIZE(DaiOpSub);
+                    DISPATCH();
+                }
+                POPN(1);
+                PEEK(0) = FLOAT_VAL(AS_FLOAT(a) - AS_FLOAT(b));
+                DISPATCH();
+            }
+            CASE(DaiOpMulInt): {
+                DaiValue b = PEEK(0);
+                DaiValue a = PEEK(1);
+                if (DAI_UNLIKELY(!(IS_INTEGER(a) && IS_INTEGER(b)))) {
+                    DEOPTIMIZE(DaiOpMul);
+                    DISPATCH();
+                }
+                POPN(1);
+                PEEK(0) = INTEGER_VAL(AS_INTEGER(a) * AS_INTEGER(b));
+                DISPATCH();
+            }
+            CASE(DaiOpMulFloat): {
+                DaiValue b = PEEK(0);
+                DaiValue a = PEEK(1);
+                if (DAI_UNLIKELY(!(IS_FLOAT(a) && IS_FLOAT(b)))) {
+                    DEOPTIMIZE(DaiOpMul);
+                    DISPATCH();
+                }
+                POPN(1);
+                PEEK(0) = FLOAT_VAL(AS_FLOAT(a) * AS_FLOAT(b));
+                DISPATCH();
+            }
+            CASE(DaiOpGreaterThanInt): {
+                DaiValue b = PEEK(0);
+                DaiValue a = PEEK(1);
+                if (DAI_UNLIKELY(!(IS_INTEGER(a) && IS_INTEGER(b)))) {
+                    DEOPTIMIZE(DaiOpGreaterThan);
+                    DISPATCH();
+                }
+                POPN(1);
+                PEEK(0) = BOOL_VAL(AS_INTEGER(a) > AS_INTEGER(b));
+                DISPATCH();
+            }
+            CASE(DaiOpGreaterThanFloat): {
+                DaiValue b = PEEK(0);
+                DaiValue a = PEEK(1);
+                if (DAI_UNLIKELY(!(IS_FLOAT(a) && IS_FLOAT(b)))) {
+                    DEOPTIMIZE(DaiOpGreaterThan);
+                    DISPATCH();
+                }
+                POPN(1);
+                PEEK(0) = BOOL_VAL(AS_FLOAT(a) > AS_FLOAT(b));
+                DISPATCH();
+            }
+            CASE(DaiOpEqualInt): {
+                DaiValue b = PEEK(0);
+                DaiValue a = PEEK(1);
+                if (DAI_UNLIKELY(!(IS_INTEGER(a) && IS_INTEGER(b)))) {
+                    DEOPTIMIZE(DaiOpEqual);
+                    DISPATCH();
+                }
+                POPN(1);
+                PEEK(0) = BOOL_VAL(AS_INTEGER(a) == AS_INTEGER(b));
+                DISPATCH();
+            }
+            CASE(DaiOpEqualFloat): {
+                DaiValue b = PEEK(0);
+                DaiValue a = PEEK(1);
+                if (DAI_UNLIKELY(!(IS_FLOAT(a) && IS_FLOAT(b)))) {
+                    DEOPTIMIZE(DaiOpEqual);
+                    DISPATCH();
+                }
+                POPN(1);
+                PEEK(0) = BOOL_VAL(dai_float_equals(AS_FLOAT(a), AS_FLOAT(b)));
+                DISPATCH();
+            }
+
+            CASE(DaiOpEnd): {
                 // 退出 module 调用帧
                 // 假装设置模块的返回值（方便测试）
-                DaiValue result = *(vm->stack_top);
+                DaiValue result = *stack_top;
                 vm->frame_count--;
                 vm->stack_top    = frame->slots;
                 *(vm->stack_top) = result;
@@ -1046,25 +1603,50 @@ DaiVM_runCurrentFrame(DaiVM* vm) {
             }
 
             default: {
-                return DaiObjError_Newf(vm,
-
-                                        "Unknown opcode: %s(%d)",
-                                        dai_opcode_name(op),
-                                        op);
+#ifdef DAI_COMPUTED_GOTO
+            TARGET_DaiOpUnknown:
+#endif
+                RUNTIME_ERROR("Unknown opcode: %s(%d)", dai_opcode_name(op), op);
             }
         }
     }
     return NULL;
 
+#undef DISPATCH
+#undef CASE
+#undef TRACE_EXECUTION
 #undef ARITHMETIC_OPERATION
+#undef JIT_ENTER
+#undef DEOPTIMIZE
+#undef QUICKEN
+#undef RUNTIME_ERROR
+#undef LOAD_STATE
+#undef LOAD_FRAME
+#undef SAVE_STATE
+#undef PEEK
+#undef POPN
+#undef POP
+#undef PUSH
+#undef READ_CONSTANT
 #undef READ_UINT16
 #undef READ_BYTE
 }
 
+// 执行期间 INTEGER_VAL 装箱的整数归 vm 管理，返回时恢复成之前的虚拟机。
+// 嵌入 API 可能在一个虚拟机的 C 函数里调用另一个虚拟机的函数
+static DaiObjError*
+DaiVM_runCurrentFrame(DaiVM* vm) {
+    DaiVM* previous_boxing_vm = dai_set_boxing_vm(vm);
+    DaiObjError* err          = DaiVM_runFrameLoop(vm);
+    dai_set_boxing_vm(previous_boxing_vm);
+    return err;
+}
+
 DaiObjError*
 DaiVM_runModule(DaiVM* vm, DaiObjModule* module) {
     vm->state = VMState_running;
     DaiObjMap_cset(vm->modules, OBJ_VAL(module->filename), OBJ_VAL(module));
+    dai_gc_write_barrier_all(vm, (DaiObj*)vm->modules);
     if (vm->frame_count == FRAMES_MAX) {
         return DaiObjError_Newf(vm, "maximum recursion depth exceeded");
     }
@@ -1092,6 +1674,9 @@ DaiVM_getModule(DaiVM* vm, const char* filename) {
 
 DaiObjError*
 DaiVM_loadModule(DaiVM* vm, const char* text, DaiObjModule* module) {
+    // 编译产生的常量和运行时的装箱整数归 vm 管理，返回时恢复，
+    // 不影响调用方（比如另一个虚拟机里的内置函数 import ）
+    DaiVM* previous_boxing_vm = dai_set_boxing_vm(vm);
     vm->state = VMState_pending;
     DaiAstProgram program;
     DaiAstProgram_init(&program);
@@ -1107,12 +1692,15 @@ DaiVM_loadModule(DaiVM* vm, const char* text, DaiObjModule* module) {
         goto DAI_LOAD_MODULE_ERROR;
     }
     DaiAstProgram_reset(&program);
-    return DaiVM_runModule(vm, module);
+    oerr = DaiVM_runModule(vm, module);
+    dai_set_boxing_vm(previous_boxing_vm);
+    return oerr;
 
 DAI_LOAD_MODULE_ERROR:
     oerr = DaiObjError_From(vm, err);
     DaiError_free(err);
     DaiAstProgram_reset(&program);
+    dai_set_boxing_vm(previous_boxing_vm);
     return oerr;
 }
 
@@ -1125,26 +1713,18 @@ DaiVM_runCall(DaiVM* vm, DaiValue callee, int argCount, ...) {
         DaiVM_push(vm, va_arg(args, DaiValue));
     }
     va_end(args);
-    DaiObjError* err = NULL;
-    err              = DaiVM_callValue(vm, callee, argCount, UNDEFINED_VAL);
-    if (err != NULL) {
-        return OBJ_VAL(err);
-    }
-    err = DaiVM_runCurrentFrame(vm);
-    if (err != NULL) {
-        return OBJ_VAL(err);
-    }
-    return DaiVM_pop(vm);
+    return DaiVM_runCall2(vm, callee, argCount);
 }
 
 DaiValue
 DaiVM_runCall2(DaiVM* vm, DaiValue callee, int argCount) {
-    DaiObjError* err = NULL;
-    err              = DaiVM_callValue(vm, callee, argCount, UNDEFINED_VAL);
-    if (err != NULL) {
-        return OBJ_VAL(err);
+    // callee 可能是内置函数或者方法，在 DaiVM_callValue 里就直接执行了
+    DaiVM* previous_boxing_vm = dai_set_boxing_vm(vm);
+    DaiObjError* err          = DaiVM_callValue(vm, callee, argCount, UNDEFINED_VAL);
+    if (err == NULL) {
+        err = DaiVM_runCurrentFrame(vm);
     }
-    err = DaiVM_runCurrentFrame(vm);
+    dai_set_boxing_vm(previous_boxing_vm);
     if (err != NULL) {
         return OBJ_VAL(err);
     }
@@ -1278,6 +1858,72 @@ DaiVM_resumeGC(DaiVM* vm) {
     vm->state = VMState_running;
 }
 
+void
+DaiVM_enableIncrementalGC(DaiVM* vm, size_t step_size) {
+    vm->gcIncremental = true;
+    vm->gcStepSize    = step_size == 0 ? DAI_GC_STEP_SIZE : step_size;
+    vm->gcNurserySize = DAI_GC_INCREMENTAL_NURSERY_SIZE;
+}
+
+void
+DaiVM_setGCThreads(DaiVM* vm, int thread_count) {
+    dai_gc_set_threads(vm, thread_count < 1 ? 1 : thread_count);
+}
+
+void
+DaiVM_setGCThreshold(DaiVM* vm, size_t threshold) {
+    vm->nextGC = threshold;
+}
+
+void
+DaiVM_setGCGrowFactor(DaiVM* vm, double factor) {
+    vm->gcGrowFactor = factor < 1.0 ? 1.0 : factor;
+}
+
+void
+DaiVM_setHeapLimit(DaiVM* vm, size_t limit) {
+    vm->gcHeapLimit = limit;
+}
+
+void
+DaiVM_disableGC(DaiVM* vm) {
+    vm->gcDisabled = true;
+}
+
+void
+DaiVM_enableGC(DaiVM* vm) {
+    vm->gcDisabled = false;
+}
+
+DaiObjError*
+DaiVM_checkOutOfMemory(DaiVM* vm) {
+    if (DAI_LIKELY(!vm->gcOutOfMemory)) {
+        return NULL;
+    }
+    // 标记可能来自不触发 GC 的记账（ vm_reallocate_nogc ），在安全点先回收一次
+    if (!dai_gc_emergency_collect(vm)) {
+        vm->gcOutOfMemory = false;
+        return NULL;
+    }
+    // 先创建错误再清除标记，创建错误时不会再次触发紧急回收
+    DaiObjError* err = DaiObjError_Newf(vm,
+                                        "out of memory: heap size %zu bytes exceeds the limit %zu bytes",
+                                        vm->bytesAllocated,
+                                        vm->gcHeapLimit);
+    vm->gcOutOfMemory = false;
+    return err;
+}
+
+const DaiGCStats*
+DaiVM_getGCStats(const DaiVM* vm) {
+    return &vm->gcStats;
+}
+
+void
+DaiVM_getHeapStats(DaiVM* vm, DaiHeapTypeStats stats[DaiObjType_count]) {
+    dai_gc_heap_stats(vm, stats);
+}
+
 void
 DaiVM_addGCRef(DaiVM* vm, DaiValue value) {
     assert(vm->gc_ref_count < DAI_GC_REF_MAX);
@@ -8,8 +8,10 @@
 #include "dai_chunk.h"
 #include "dai_object.h"
 #include "dai_objects/dai_object_base.h"
+#include "dai_pool.h"
 #include "dai_symboltable.h"
 #include "dai_table.h"
+#include "dai_threadpool.h"
 #include "dai_utils.h"
 #include "dai_value.h"
 
@@ -24,6 +26,39 @@ typedef enum {
     VMState_running,
 } VMState;
 
+// 增量回收的阶段
+typedef enum {
+    DaiGCPhase_idle,    // 没有进行中的增量回收
+    DaiGCPhase_mark,    // 增量标记，这个阶段不进行新生代回收
+    DaiGCPhase_sweep,   // 惰性清除老年代
+} DaiGCPhase;
+
+// 并行回收时每个线程的状态，定义在 dai_memory.c
+typedef struct _DaiGCWorker DaiGCWorker;
+
+// 停顿时间直方图的桶数，桶 0 记录不到 1 微秒的停顿，
+// 桶 i 记录 [2^(i-1), 2^i) 微秒的停顿，最后一个桶还包括更长的停顿
+#define DAI_GC_PAUSE_BUCKETS 24
+
+// GC 统计，一直开启，每次停顿只多读两次时钟
+typedef struct {
+    uint64_t fullCollections;    // 完成的完整回收次数（包括增量回收）
+    uint64_t youngCollections;   // 新生代回收次数
+    uint64_t incrementalSteps;   // 增量回收执行的步数
+    uint64_t pauses;             // 停顿次数，每次回收或者增量回收的每一步是一次停顿
+    uint64_t pauseTotalNs;
+    uint64_t pauseMaxNs;
+    uint64_t pauseHistogram[DAI_GC_PAUSE_BUCKETS];
+    uint64_t bytesFreed;       // 累计释放的字节数
+    uint64_t lastBytesFreed;   // 最近完成的一次回收（新生代或完整）释放的字节数
+} DaiGCStats;
+
+// 堆中某种类型的对象的数量和占用的字节数
+typedef struct {
+    size_t count;
+    size_t bytes;   // 对象本身在内存池中占用的字节数，不包括数组元素等单独分配的内存
+} DaiHeapTypeStats;
+
 typedef DaiValue (*VMCallback)(DaiVM* vm);
 
 typedef struct {
@@ -52,12 +87,51 @@ typedef struct _DaiVM {
     DaiTable strings;        // 字符串驻留
     size_t bytesAllocated;   // 虚拟机管理的内存字节数
     size_t nextGC;           // 下一次 GC 的阈值
-    DaiObj* objects;
+    double gcGrowFactor;     // 完整回收之后，下一次 GC 的阈值是存活字节数乘以这个值
+    size_t gcHeapLimit;      // 堆的上限，为 0 时不限制
+    bool gcOutOfMemory;      // 堆超过了上限，等待在安全点紧急回收或者返回内存不足错误
+    bool gcDisabled;         // 不自动回收（ gc.disable() ），显式回收和紧急回收不受影响
+    DaiPool objectPool;      // 对象的内存池，所有对象都在这里，标记位在池的位图里
+    size_t youngBytes;       // 上一次回收之后分配的字节数
+
+    // 新生代对象，上一次回收之后分配的对象
+    int youngCount;
+    int youngCapacity;
+    DaiObj** youngObjects;
 
     int grayCount;
     int grayCapacity;
     DaiObj** grayStack;
 
+    // 记忆集，引用了新生代对象的老年代对象
+    int rememberedCount;
+    int rememberedCapacity;
+    DaiObj** rememberedSet;
+
+    // 标记时遇到的小切片字符串，标记结束之后检查它们的 parent
+    int gcSliceCount;
+    int gcSliceCapacity;
+    DaiObj** gcSlices;
+    // 只有小切片引用 parent 的切片字符串，在安全点复制自己的内容（ dai_gc_compact_slices ）
+    int gcCompactCount;
+    int gcCompactCapacity;
+    DaiObj** gcCompactSlices;
+
+    size_t gcNurserySize;   // 新生代分配的字节数超过这个值时进行新生代回收
+
+    // 增量回收
+    bool gcIncremental;         // 是否开启增量回收
+    size_t gcStepSize;          // 每分配这么多字节执行一步，每一步最多处理这么多个单位的工作
+    size_t gcStepBytes;         // 上一步之后分配的字节数
+    DaiGCPhase gcPhase;         // 增量回收的阶段
+    DaiObjArray* gcScanArray;   // 正在分步遍历的大数组
+    int gcScanIndex;            // 大数组中下一个要遍历的位置（从后往前）
+
+    // 并行回收，完整回收时用多个线程标记和清除
+    int gcThreadCount;             // 使用的线程数（包括当前线程），为 1 时不创建线程
+    DaiThreadPool* gcThreadPool;   // gcThreadCount 大于 1 时才有
+    DaiGCWorker* gcWorkers;        // 每个线程一个
+
     // 内置符号表
     DaiSymbolTable* builtinSymbolTable;
 
@@ -78,7 +152,11 @@ typedef struct _DaiVM {
 
     uint8_t seed[16];   // 随机数种子
 
-    size_t object_stats[DaiObjType_count];
+    DaiGCStats gcStats;
+    size_t gcCycleFreed;   // 进行中的增量回收已经释放的字节数
+
+    bool jit_enabled;    // 是否开启 JIT
+    int jit_threshold;   // 字节码块的循环回跳次数超过这个值时编译成机器码
 } DaiVM;
 
 void
@@ -117,6 +195,40 @@ DaiVM_pauseGC(DaiVM* vm);
 // 恢复 GC
 void
 DaiVM_resumeGC(DaiVM* vm);
+// 开启增量回收，完整回收拆成很多小步和内存分配交替进行，同时缩小新生代，
+// step_size 是每一步的工作量，为 0 时使用默认值 DAI_GC_STEP_SIZE
+void
+DaiVM_enableIncrementalGC(DaiVM* vm, size_t step_size);
+// 完整回收时使用 thread_count 个线程（包括当前线程）并行标记和清除，
+// 为 1 时（默认）只使用当前线程，新生代回收和增量回收的每一步总是只使用当前线程
+void
+DaiVM_setGCThreads(DaiVM* vm, int thread_count);
+// 设置下一次完整回收的阈值，在运行之前调用就是第一次回收的阈值（默认 DAI_GC_INITIAL_THRESHOLD ）
+void
+DaiVM_setGCThreshold(DaiVM* vm, size_t threshold);
+// 设置堆增长系数（默认 DAI_GC_GROW_FACTOR ），小于 1 时按 1 处理
+void
+DaiVM_setGCGrowFactor(DaiVM* vm, double factor);
+// 设置堆的上限（字节），为 0 时不限制（默认）。
+// 分配内存使堆超过上限时先进行一次紧急的完整回收，仍然超过的话，
+// 虚拟机在下一个安全点（循环回跳、内置函数返回）返回内存不足的运行时错误
+void
+DaiVM_setHeapLimit(DaiVM* vm, size_t limit);
+// 暂停/恢复自动回收，不影响 collectGarbage 和堆上限触发的紧急回收
+void
+DaiVM_disableGC(DaiVM* vm);
+void
+DaiVM_enableGC(DaiVM* vm);
+// 安全点调用。堆超过了上限时进行紧急回收，回收之后仍然超过就返回内存不足的错误并清除标记，否则返回 NULL
+DaiObjError*
+DaiVM_checkOutOfMemory(DaiVM* vm);
+// GC 统计
+const DaiGCStats*
+DaiVM_getGCStats(const DaiVM* vm);
+// 按类型统计堆中的对象，需要遍历整个堆。
+// 统计的是还没有释放的对象，可能包括还没有回收的垃圾，刚完成完整回收时就是存活的对象
+void
+DaiVM_getHeapStats(DaiVM* vm, DaiHeapTypeStats stats[DaiObjType_count]);
 void
 DaiVM_addGCRef(DaiVM* vm, DaiValue value);
 void
@@ -127,6 +239,107 @@ void
 DaiVM_getSeed2(DaiVM* vm, uint64_t* seed0, uint64_t* seed1);
 size_t
 DaiVM_bytesAllocated(const DaiVM* vm);
+// 开启 JIT ，当前平台不支持 JIT 时返回 false
+bool
+DaiVM_enableJIT(DaiVM* vm);
+
+// #region for-in 循环，解释器和 JIT 生成的机器码共用
+
+// 取出 for-in 循环的下一个元素，放到 slots[DAI_ITER_I] 和 slots[DAI_ITER_E] ，迭代结束时返回 false
+// 数组和字典不创建迭代器对象， slots[DAI_ITER_ITERATOR] 是容器本身， slots[DAI_ITER_CURSOR] 是游标
+static inline bool
+DaiVM_iterNext(DaiVM* vm, DaiValue* slots, uint8_t flags) {
+    DaiValue iterator = slots[DAI_ITER_ITERATOR];
+    if (IS_ARRAY(iterator)) {
+        const DaiObjArray* array = AS_ARRAY(iterator);
+        int64_t cursor           = AS_INTEGER(slots[DAI_ITER_CURSOR]);
+        if (cursor >= array->length) {
+            return false;
+        }
+        if (!(flags & DAI_ITER_SKIP_INDEX)) {
+            slots[DAI_ITER_I] = INTEGER_VAL(cursor);
+        }
+        slots[DAI_ITER_E]      = array->elements[cursor];
+        slots[DAI_ITER_CURSOR] = INTEGER_VAL(cursor + 1);
+        return true;
+    }
+    if (IS_MAP(iterator)) {
+        size_t cursor = AS_INTEGER(slots[DAI_ITER_CURSOR]);
+        DaiValue key, value;
+        if (!DaiObjMap_iter(AS_MAP(iterator), &cursor, &key, &value)) {
+            return false;
+        }
+        if (!(flags & DAI_ITER_SKIP_INDEX)) {
+            slots[DAI_ITER_I] = key;
+        }
+        slots[DAI_ITER_E]      = value;
+        slots[DAI_ITER_CURSOR] = INTEGER_VAL((int64_t)cursor);
+        return true;
+    }
+    DaiValue i, e;
+    DaiValue next = AS_OBJ(iterator)->operation->iter_next_func(vm, iterator, &i, &e);
+    if (IS_UNDEFINED(next)) {
+        return false;
+    }
+    if (!(flags & DAI_ITER_SKIP_INDEX)) {
+        slots[DAI_ITER_I] = i;
+    }
+    slots[DAI_ITER_E] = e;
+    return true;
+}
+
+// #endregion
+
+// #region 属性内联缓存，解释器和 JIT 生成的机器码共用
+
+// 通过属性内联缓存读取实例属性
+// receiver 不是实例或者没有这个实例属性（比如是方法）时返回 false ，交给通用路径处理
+static inline bool
+DaiVM_getInstanceField(DaiPropertyCache* cache, DaiValue receiver, DaiObjString* name,
+                       DaiValue* value) {
+    if (!IS_INSTANCE(receiver)) {
+        return false;
+    }
+    DaiObjInstance* instance = AS_INSTANCE(receiver);
+    DaiObjClass* klass       = instance->klass;
+    int index                = DaiPropertyCache_lookup(cache, klass->shape);
+    if (DAI_UNLIKELY(index < 0)) {
+        const DaiFieldDesc* field = DaiObjClass_get_field(klass, name);
+        if (field == NULL) {
+            return false;
+        }
+        index = field->index;
+        DaiPropertyCache_update(cache, klass->shape, index);
+    }
+    *value = instance->fields[index];
+    return true;
+}
+
+// 通过属性内联缓存设置实例属性
+// 常量属性不进缓存，由通用路径检查能不能修改
+static inline bool
+DaiVM_setInstanceField(DaiVM* vm, DaiPropertyCache* cache, DaiValue receiver, DaiObjString* name,
+                       DaiValue value) {
+    if (!IS_INSTANCE(receiver)) {
+        return false;
+    }
+    DaiObjInstance* instance = AS_INSTANCE(receiver);
+    DaiObjClass* klass       = instance->klass;
+    int index                = DaiPropertyCache_lookup(cache, klass->shape);
+    if (DAI_UNLIKELY(index < 0)) {
+        const DaiFieldDesc* field = DaiObjClass_get_field(klass, name);
+        if (field == NULL || field->is_const) {
+            return false;
+        }
+        index = field->index;
+        DaiPropertyCache_update(cache, klass->shape, index);
+    }
+    instance->fields[index] = value;
+    dai_gc_write_barrier(vm, (DaiObj*)instance, value);
+    return true;
+}
+
+// #endregion
 
 // #region 用于测试的函数
 
@@ -8,6 +8,7 @@ extern MunitTest demo_tests[];
 extern MunitTest atstr_tests[];
 extern MunitTest tokenize_suite_tests[];
 extern MunitTest stringbuffer_tests[];
+extern MunitTest strsearch_tests[];
 extern MunitTest parse_tests[];
 extern MunitTest parseint_tests[];
 extern MunitTest ast_tests[];
@@ -16,6 +17,7 @@ extern MunitTest chunk_tests[];
 extern MunitTest compile_tests[];
 extern MunitTest vm_tests[];
 extern MunitTest table_tests[];
+extern MunitTest pool_tests[];
 extern MunitTest symboltable_tests[];
 extern MunitTest cbdai_tests[];
 
@@ -24,6 +26,7 @@ static MunitSuite sub_suites[] = {
     {"/atstr", atstr_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE},
     {"/tokenize", tokenize_suite_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE},
     {"/stringbuffer", stringbuffer_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE},
+    {"/strsearch", strsearch_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE},
     {"/parse", parse_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE},
     {"/parseint", parseint_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE},
     {"/ast", ast_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE},
@@ -32,6 +35,7 @@ static MunitSuite sub_suites[] = {
     {"/compile", compile_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE},
     {"/vm", vm_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE},
     {"/table", table_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE},
+    {"/pool", pool_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE},
     {"/symboltable", symboltable_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE},
     {"/cbdai", cbdai_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE},
     {NULL, NULL, NULL, 0, MUNIT_SUITE_OPTION_NONE},
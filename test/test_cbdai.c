@@ -54,6 +54,7 @@ test_dai_call(__attribute__((unused)) const MunitParameter params[],
     get_file_directory(resolved_path);
     strcat(resolved_path, "dai_call_example.dai");
     Dai* dai = dai_new();
+    dai_set_gc_threads(dai, 2);
     dai_load_file(dai, resolved_path);
     dai_func_t sum_int    = dai_get_function(dai, "sum_int");
     dai_func_t sum_float  = dai_get_function(dai, "sum_float");
@@ -130,9 +131,82 @@ test_dai_c_function(__attribute__((unused)) const MunitParameter params[],
     return MUNIT_OK;
 }
 
+static MunitResult
+test_dai_gc_stats(__attribute__((unused)) const MunitParameter params[],
+                  __attribute__((unused)) void* user_data) {
+    char resolved_path[PATH_MAX];
+    get_file_directory(resolved_path);
+    strcat(resolved_path, "dai_variable_example.dai");
+    Dai* dai = dai_new();
+    dai_set_gc_threshold(dai, 64 * 1024);
+    dai_set_gc_grow_factor(dai, 1.5);
+    dai_set_heap_limit(dai, 64 * 1024 * 1024);
+    dai_load_file(dai, resolved_path);
+    {
+        dai_gc_stats_t stats;
+        dai_get_gc_stats(dai, &stats);
+        munit_assert_uint64(stats.heap_bytes, >, 0);
+        uint64_t pauses = 0;
+        for (int i = 0; i < DAI_GC_PAUSE_HISTOGRAM_SIZE; i++) {
+            pauses += stats.pause_histogram[i];
+        }
+        munit_assert_uint64(pauses, ==, stats.pauses);
+    }
+    {
+        dai_gc_type_stats_t stats[32];
+        int n          = dai_get_gc_heap_stats(dai, stats, 32);
+        bool found_str = false;
+        for (int i = 0; i < n; i++) {
+            munit_assert_uint64(stats[i].count, >, 0);
+            munit_assert_uint64(stats[i].bytes, >, 0);
+            if (strcmp(stats[i].type, "string") == 0) {
+                found_str = true;
+            }
+        }
+        munit_assert_true(found_str);
+        munit_assert_int(dai_get_gc_heap_stats(dai, stats, 1), ==, 1);
+    }
+    dai_free(dai);
+    return MUNIT_OK;
+}
+
+// 两个虚拟机交替使用，装箱的大整数要归各自的虚拟机管理，释放一个不能影响另一个
+static MunitResult
+test_dai_two_vm(__attribute__((unused)) const MunitParameter params[],
+                __attribute__((unused)) void* user_data) {
+    char variable_path[PATH_MAX];
+    get_file_directory(variable_path);
+    strcat(variable_path, "dai_variable_example.dai");
+    char call_path[PATH_MAX];
+    get_file_directory(call_path);
+    strcat(call_path, "dai_call_example.dai");
+    const int64_t big = 1LL << 50;
+
+    Dai* a = dai_new();
+    dai_load_file(a, variable_path);
+    Dai* b = dai_new();
+    dai_load_file(b, call_path);
+    dai_set_int(a, "intv", big);
+    {
+        daicall_push_function(b, dai_get_function(b, "sum_int"));
+        daicall_pusharg_int(b, big);
+        daicall_pusharg_int(b, big);
+        daicall_execute(b);
+        munit_assert_int64(daicall_getrv_int(b), ==, big * 2);
+    }
+    dai_free(b);
+    munit_assert_int64(dai_get_int(a, "intv"), ==, big);
+    dai_set_int(a, "intv", -big);
+    munit_assert_int64(dai_get_int(a, "intv"), ==, -big);
+    dai_free(a);
+    return MUNIT_OK;
+}
+
 MunitTest cbdai_tests[] = {
     {(char*)"/test_dai_variable", test_dai_variable, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
     {(char*)"/test_dai_call", test_dai_call, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
     {(char*)"/test_dai_c_function", test_dai_c_function, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+    {(char*)"/test_dai_gc_stats", test_dai_gc_stats, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+    {(char*)"/test_dai_two_vm", test_dai_two_vm, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
     {NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
 };
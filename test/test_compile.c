@@ -1742,7 +1742,7 @@ test_var_statement(__attribute__((unused)) const MunitParameter params[],
             1,
             DaiOpSetLocal,
             2,
-            DaiOpGetLocal,
+            DaiOpAddLocalLocal,
             1,
             DaiOpGetLocal,
             2,
@@ -2204,6 +2204,8 @@ test_class(__attribute__((unused)) const MunitParameter params[],
             DaiOpGetSelfProperty,
             0,
             0,
+            0,
+            0,
             DaiOpPop,
             // class.classVar = 5;
             DaiOpConstant,
@@ -2212,6 +2214,8 @@ test_class(__attribute__((unused)) const MunitParameter params[],
             DaiOpSetSelfProperty,
             0,
             2,
+            0,
+            1,
             // super.func2;
             DaiOpGetSuperProperty,
             0,
@@ -2234,12 +2238,16 @@ test_class(__attribute__((unused)) const MunitParameter params[],
             DaiOpSetProperty,
             0,
             5,
+            0,
+            2,
             // c.s3;
             DaiOpGetLocal,
             1,
             DaiOpGetProperty,
             0,
             6,
+            0,
+            3,
             DaiOpPop,
             DaiOpReturn,
         };
@@ -2269,6 +2277,8 @@ test_class(__attribute__((unused)) const MunitParameter params[],
             DaiOpGetSelfProperty,
             0,
             0,
+            0,
+            0,
             DaiOpPop,
             // class.classVar = 5;
             DaiOpConstant,
@@ -2277,6 +2287,8 @@ test_class(__attribute__((unused)) const MunitParameter params[],
             DaiOpSetSelfProperty,
             0,
             2,
+            0,
+            1,
             // super.func2;
             DaiOpGetSuperProperty,
             0,
@@ -2299,12 +2311,16 @@ test_class(__attribute__((unused)) const MunitParameter params[],
             DaiOpSetProperty,
             0,
             5,
+            0,
+            2,
             // c.s3;
             DaiOpGetLocal,
             1,
             DaiOpGetProperty,
             0,
             6,
+            0,
+            3,
             DaiOpPop,
             DaiOpReturn,
         };
@@ -2746,6 +2762,11 @@ test_compile_error(__attribute__((unused)) const MunitParameter params[],
             "con a = 1; a = 2;",
             "CompileError: cannot assign to const variable 'a' in <test-file>:1:12",
         },
+        {
+            // for-in 循环中的 _ 只是占位，不能使用
+            "for (var _, e in [1]) { _; };",
+            "CompileError: undefined variable: '_' in <test-file>:1:25",
+        },
     };
     for (int i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
         DaiVM vm;
@@ -3332,7 +3353,7 @@ test_forin_statement(__attribute__((unused)) const MunitParameter params[],
     const DaiCompilerTestCase tests[] = {
         {
             "var a = [1, 2, 3]; for (var i, e in a) {};",
-            27 + 1,
+            28 + 1,
             {
                 DaiOpConstant,
                 0,
@@ -3358,10 +3379,11 @@ test_forin_statement(__attribute__((unused)) const MunitParameter params[],
                 DaiOpIterNext,
                 0,
                 0,
+                0,
                 3,
                 DaiOpJumpBack,
                 0,
-                7,
+                8,
                 DaiOpEnd,
 
             },
@@ -3373,7 +3395,7 @@ test_forin_statement(__attribute__((unused)) const MunitParameter params[],
         },
         {
             "var a = [1, 2, 3]; for (var i, e in a) { break; continue; };",
-            33 + 1,
+            34 + 1,
             {
                 DaiOpConstant,
                 0,
@@ -3399,6 +3421,7 @@ test_forin_statement(__attribute__((unused)) const MunitParameter params[],
                 DaiOpIterNext,
                 0,
                 0,
+                0,
                 9,
                 // break;
                 DaiOpJump,
@@ -3407,10 +3430,10 @@ test_forin_statement(__attribute__((unused)) const MunitParameter params[],
                 // continue
                 DaiOpJumpBack,
                 0,
-                10,
+                11,
                 DaiOpJumpBack,
                 0,
-                13,
+                14,
                 DaiOpEnd,
             },
             {
@@ -3421,7 +3444,7 @@ test_forin_statement(__attribute__((unused)) const MunitParameter params[],
         },
         {
             "var a = [1, 2, 3]; for (var e in a) { break; continue; };",
-            33 + 1,
+            34 + 1,
             {
                 DaiOpConstant,
                 0,
@@ -3446,6 +3469,7 @@ test_forin_statement(__attribute__((unused)) const MunitParameter params[],
                 0,
                 DaiOpIterNext,
                 0,
+                1,
                 0,
                 9,
                 // break;
@@ -3455,10 +3479,10 @@ test_forin_statement(__attribute__((unused)) const MunitParameter params[],
                 // continue
                 DaiOpJumpBack,
                 0,
-                10,
+                11,
                 DaiOpJumpBack,
                 0,
-                13,
+                14,
                 DaiOpEnd,
             },
             {
@@ -3468,11 +3492,189 @@ test_forin_statement(__attribute__((unused)) const MunitParameter params[],
             },
         },
 
+        {
+            "for (var i, e in range(3)) {};",
+            19 + 1,
+            {
+                // range 的参数补齐成 start, end, step
+                DaiOpConstant,
+                0,
+                0,
+                DaiOpConstant,
+                0,
+                1,
+                DaiOpConstant,
+                0,
+                2,
+                DaiOpRangeInit,
+                0,
+                DaiOpRangeNext,
+                0,
+                0,
+                0,
+                3,
+                DaiOpJumpBack,
+                0,
+                8,
+                DaiOpEnd,
+            },
+            {
+                INTEGER_VAL(0),
+                INTEGER_VAL(3),
+                INTEGER_VAL(1),
+            },
+        },
+        {
+            // range 被覆盖时按普通的函数调用处理
+            "{ var range = [1]; for (var e in range(3)) {}; };",
+            25 + 1,
+            {
+                DaiOpConstant,
+                0,
+                0,
+                DaiOpArray,
+                0,
+                1,
+                DaiOpSetLocal,
+                0,
+                DaiOpGetLocal,
+                0,
+                DaiOpConstant,
+                0,
+                1,
+                DaiOpCall,
+                1,
+                DaiOpIterInit,
+                1,
+                DaiOpIterNext,
+                1,
+                1,
+                0,
+                3,
+                DaiOpJumpBack,
+                0,
+                8,
+                DaiOpEnd,
+            },
+            {
+                INTEGER_VAL(1),
+                INTEGER_VAL(3),
+            },
+        },
     };
     run_compiler_tests(tests, sizeof(tests) / sizeof(tests[0]));
     return MUNIT_OK;
 }
 
+static MunitResult
+test_superinstructions(__attribute__((unused)) const MunitParameter params[],
+                       __attribute__((unused)) void* user_data) {
+    DaiVM vm;
+    DaiVM_init(&vm);
+    DaiObjModule* module  = create_test_module(&vm);
+    DaiObjFunction* func1 = DaiObjFunction_New(&vm, module, "<test1>", "<test>");
+    {
+        uint8_t expected_codes1[] = {
+            // if (a > b)
+            DaiOpGetLocal,
+            1,
+            DaiOpGetLocal,
+            2,
+            DaiOpGreaterThanJumpIfFalse,
+            DaiOpJumpIfFalse,
+            0,
+            7,
+            // return a - 1;
+            DaiOpSubLocalConstant,
+            1,
+            DaiOpConstant,
+            0,
+            0,
+            DaiOpSub,
+            DaiOpReturnValue,
+            // return (a and b) + b;
+            // and 的跳转目标在 GetLocal b; GetLocal b; Add 中间，不能融合
+            DaiOpGetLocal,
+            1,
+            DaiOpAndJump,
+            0,
+            2,
+            DaiOpGetLocal,
+            2,
+            DaiOpGetLocal,
+            2,
+            DaiOpAdd,
+            DaiOpReturnValue,
+            DaiOpReturn,
+        };
+        for (int i = 0; i < sizeof(expected_codes1) / sizeof(expected_codes1[0]); i++) {
+            DaiChunk_write(&func1->chunk, expected_codes1[i], 1);
+        }
+    }
+    DaiObjFunction* func2 = DaiObjFunction_New(&vm, module, "<test2>", "<test>");
+    {
+        uint8_t expected_codes1[] = {
+            DaiOpAddLocalLocal,
+            1,
+            DaiOpGetLocal,
+            2,
+            DaiOpAdd,
+            DaiOpSetLocal,
+            3,
+            DaiOpAddLocalConstant,
+            3,
+            DaiOpConstant,
+            0,
+            0,
+            DaiOpAdd,
+            DaiOpReturnValue,
+            DaiOpReturn,
+        };
+        for (int i = 0; i < sizeof(expected_codes1) / sizeof(expected_codes1[0]); i++) {
+            DaiChunk_write(&func2->chunk, expected_codes1[i], 1);
+        }
+    }
+    DaiCompilerTestCase tests[] = {
+        {
+            "var f = fn(a, b) { if (a > b) { return a - 1; }; return (a and b) + b; };",
+            6 + 1,
+            {
+                DaiOpConstant,
+                0,
+                0,
+                DaiOpDefineGlobal,
+                0,
+                0 + BUILTIN_GLOBALS_COUNT,
+                DaiOpEnd,
+            },
+            {
+                INTEGER_VAL(1),
+                OBJ_VAL(func1),
+            },
+        },
+        {
+            "var f = fn(a, b) { var c = a + b; return c + 1; };",
+            6 + 1,
+            {
+                DaiOpConstant,
+                0,
+                0,
+                DaiOpDefineGlobal,
+                0,
+                0 + BUILTIN_GLOBALS_COUNT,
+                DaiOpEnd,
+            },
+            {
+                INTEGER_VAL(1),
+                OBJ_VAL(func2),
+            },
+        },
+    };
+    run_compiler_tests(tests, sizeof(tests) / sizeof(tests[0]));
+    DaiVM_reset(&vm);
+    return MUNIT_OK;
+}
+
 MunitTest compile_tests[] = {
     {(char*)"/test_integer_arithmetic",
      test_integer_arithmetic,
@@ -3544,5 +3746,11 @@ MunitTest compile_tests[] = {
      NULL,
      MUNIT_TEST_OPTION_NONE,
      NULL},
+    {(char*)"/test_superinstructions",
+     test_superinstructions,
+     NULL,
+     NULL,
+     MUNIT_TEST_OPTION_NONE,
+     NULL},
     {NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
 };
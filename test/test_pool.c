@@ -0,0 +1,172 @@
+#include <string.h>
+
+#include "munit/munit.h"
+
+#include "dai_pool.h"
+
+static MunitResult
+test_alloc_free(__attribute__((unused)) const MunitParameter params[],
+                __attribute__((unused)) void* user_data) {
+    DaiPool pool;
+    DaiPool_init(&pool);
+    // 足够多的对象，每个大小级别都要用好几页
+    const int count = 20000;
+    void** pointers = malloc(sizeof(void*) * count);
+    for (int i = 0; i < count; i++) {
+        size_t size = i % (DAI_POOL_MAX_SIZE + 64) + 1;
+        pointers[i] = DaiPool_alloc(&pool, size);
+        munit_assert_size((uintptr_t)pointers[i] % DAI_POOL_GRANULE, ==, 0);
+        memset(pointers[i], i & 0xFF, size);
+    }
+    munit_assert_size(pool.page_count, >, DAI_POOL_CLASS_COUNT);
+    for (int i = 0; i < count; i++) {
+        size_t size = i % (DAI_POOL_MAX_SIZE + 64) + 1;
+        munit_assert_uint8(((uint8_t*)pointers[i])[size - 1], ==, i & 0xFF);
+    }
+    // 先释放一半，再重新分配，释放的位置会被重新使用
+    size_t pages = pool.page_count;
+    for (int i = 0; i < count; i += 2) {
+        DaiPool_free(&pool, pointers[i], i % (DAI_POOL_MAX_SIZE + 64) + 1);
+    }
+    for (int i = 0; i < count; i += 2) {
+        pointers[i] = DaiPool_alloc(&pool, i % (DAI_POOL_MAX_SIZE + 64) + 1);
+    }
+    munit_assert_size(pool.page_count, ==, pages);
+    // 全部释放之后每个级别最多留一个空页
+    for (int i = 0; i < count; i++) {
+        DaiPool_free(&pool, pointers[i], i % (DAI_POOL_MAX_SIZE + 64) + 1);
+    }
+    munit_assert_size(pool.page_count, <=, DAI_POOL_CLASS_COUNT);
+    DaiPool_reset(&pool);
+    munit_assert_size(pool.page_count, ==, 0);
+    free(pointers);
+    return MUNIT_OK;
+}
+
+static MunitResult
+test_reset(__attribute__((unused)) const MunitParameter params[],
+           __attribute__((unused)) void* user_data) {
+    DaiPool pool;
+    DaiPool_init(&pool);
+    // 不释放对象直接 reset ，满了的页也要被释放
+    for (int i = 0; i < 10000; i++) {
+        DaiPool_alloc(&pool, 48);
+    }
+    munit_assert_size(pool.page_count, >, 1);
+    DaiPool_reset(&pool);
+    munit_assert_size(pool.page_count, ==, 0);
+    // reset 之后还能继续使用
+    void* p = DaiPool_alloc(&pool, 48);
+    munit_assert_not_null(p);
+    DaiPool_free(&pool, p, 48);
+    DaiPool_reset(&pool);
+    return MUNIT_OK;
+}
+
+static void
+count_object(__attribute__((unused)) void* pointer, void* ctx) {
+    (*(size_t*)ctx)++;
+}
+
+static void
+free_object(void* pointer, void* ctx) {
+    DaiPool_free(ctx, pointer, *(size_t*)pointer);
+}
+
+static MunitResult
+test_sweep(__attribute__((unused)) const MunitParameter params[],
+           __attribute__((unused)) void* user_data) {
+    DaiPool pool;
+    DaiPool_init(&pool);
+    // 对象的开头保存自己的大小，释放时使用，包括大对象
+    const int count = 30000;
+    size_t marked   = 0;
+    for (int i = 0; i < count; i++) {
+        size_t size    = (i % 3 == 0) ? DAI_POOL_MAX_SIZE + 32 : (size_t)(i % 200 + 16);
+        size_t* object = DaiPool_alloc(&pool, size);
+        *object        = size;
+        if (i % 5 == 0) {
+            if (size > DAI_POOL_MAX_SIZE) {
+                DaiPool_largeOf(object)->marked = true;
+            } else {
+                DaiPool_setMarked(object);
+                munit_assert_true(DaiPool_isMarked(object));
+            }
+            marked++;
+        }
+    }
+    size_t total = 0;
+    DaiPool_iter(&pool, count_object, &total);
+    munit_assert_size(total, ==, count);
+
+    // 分多步清除，清除过程中分配的对象不会被清除
+    DaiPool_beginSweep(&pool);
+    size_t* fresh = DaiPool_alloc(&pool, 32);
+    *fresh        = 32;
+    while (!DaiPool_sweepStep(&pool, 100, free_object, &pool)) {
+    }
+    total = 0;
+    DaiPool_iter(&pool, count_object, &total);
+    munit_assert_size(total, ==, marked + 1);
+
+    // 清空标记之后全部清除
+    DaiPool_clearMarks(&pool);
+    DaiPool_beginSweep(&pool);
+    munit_assert_true(DaiPool_sweepStep(&pool, SIZE_MAX, free_object, &pool));
+    total = 0;
+    DaiPool_iter(&pool, count_object, &total);
+    munit_assert_size(total, ==, 0);
+    munit_assert_size(pool.page_count, <=, DAI_POOL_CLASS_COUNT);
+    DaiPool_reset(&pool);
+    return MUNIT_OK;
+}
+
+static MunitResult
+test_sweep_pages(__attribute__((unused)) const MunitParameter params[],
+                 __attribute__((unused)) void* user_data) {
+    DaiPool pool;
+    DaiPool_init(&pool);
+    const int count = 20000;
+    size_t marked   = 0;
+    for (int i = 0; i < count; i++) {
+        size_t size    = (size_t)(i % 100 + 16);
+        size_t* object = DaiPool_alloc(&pool, size);
+        *object        = size;
+        if (i % 3 == 0) {
+            DaiPool_setMarked(object);
+            marked++;
+        }
+    }
+    // 只有第一次设置成功
+    size_t* object = DaiPool_alloc(&pool, 16);
+    *object        = 16;
+    munit_assert_true(DaiPool_tryMark(object));
+    munit_assert_false(DaiPool_tryMark(object));
+    marked++;
+
+    // 取出所有页分别清除，清除过程中分配的对象放在新页里
+    DaiPool_beginSweep(&pool);
+    size_t page_count;
+    DaiPoolPage** pages = DaiPool_takeUnswept(&pool, &page_count);
+    munit_assert_size(page_count, ==, pool.page_count);
+    size_t* fresh = DaiPool_alloc(&pool, 32);
+    *fresh        = 32;
+    for (size_t i = page_count; i > 0; i--) {
+        DaiPool_sweepPage(pages[i - 1], free_object, &pool);
+    }
+    DaiPool_placePages(&pool, pages, page_count);
+    munit_assert_true(DaiPool_sweepStep(&pool, SIZE_MAX, free_object, &pool));
+    size_t total = 0;
+    DaiPool_iter(&pool, count_object, &total);
+    munit_assert_size(total, ==, marked + 1);
+    DaiPool_reset(&pool);
+    return MUNIT_OK;
+}
+
+MunitTest pool_tests[] = {
+    {(char*)"/test_alloc_free", test_alloc_free, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+    {(char*)"/test_reset", test_reset, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+    {(char*)"/test_sweep", test_sweep, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+    {(char*)"/test_sweep_pages", test_sweep_pages, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+    {NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+};
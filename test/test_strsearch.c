@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dai_strsearch.h"
+#include "dai_utils.h"
+#include "munit/munit.h"
+
+static MunitResult
+test_strsearch(__attribute__((unused)) const MunitParameter params[],
+               __attribute__((unused)) void* user_data) {
+    const char* s = "hello world, hello dai";
+    size_t n      = strlen(s);
+    munit_assert_ptr_equal(dai_memmem(s, n, "", 0), s);
+    munit_assert_ptr_equal(dai_memmem(s, n, "h", 1), s);
+    munit_assert_ptr_equal(dai_memmem(s, n, "d", 1), s + 10);
+    munit_assert_ptr_equal(dai_memmem(s, n, "hello", 5), s);
+    munit_assert_ptr_equal(dai_memmem(s, n, "hello dai", 9), s + 13);
+    munit_assert_ptr_equal(dai_memmem(s, n, "dai", 3), s + 19);
+    munit_assert_ptr_equal(dai_memmem(s, n, s, n), s);
+    munit_assert_null(dai_memmem(s, n, "hello daix", 10));
+    munit_assert_null(dai_memmem(s, n, "x", 1));
+    munit_assert_null(dai_memmem(s, 3, "hello", 5));
+    // 不读取长度之外的内容
+    munit_assert_null(dai_memmem(s, n - 1, "dai", 3));
+    munit_assert_null(dai_memmem("", 0, "a", 1));
+
+    // 随机内容和标量版本对照，字母表很小，首尾字节相同的候选位置很多
+    munit_rand_seed(12345);
+    char haystack[300];
+    char needle[40];
+    for (int round = 0; round < 2000; round++) {
+        size_t haystack_len = munit_rand_uint32() % (sizeof(haystack) + 1);
+        size_t needle_len   = munit_rand_uint32() % (sizeof(needle) + 1);
+        for (size_t i = 0; i < haystack_len; i++) {
+            haystack[i] = (char)('a' + munit_rand_uint32() % 3);
+        }
+        for (size_t i = 0; i < needle_len; i++) {
+            needle[i] = (char)('a' + munit_rand_uint32() % 3);
+        }
+        // 一半的情况把 needle 放进 haystack 里
+        if (needle_len <= haystack_len && round % 2 == 0) {
+            size_t pos = munit_rand_uint32() % (haystack_len - needle_len + 1);
+            memcpy(haystack + pos, needle, needle_len);
+        }
+        munit_assert_ptr_equal(dai_memmem(haystack, haystack_len, needle, needle_len),
+                               dai_memmem_scalar(haystack, haystack_len, needle, needle_len));
+    }
+    return MUNIT_OK;
+}
+
+typedef const char* (*MemmemFn)(const char*, size_t, const char*, size_t);
+
+// 统计 needle 出现的次数，返回耗时（纳秒）
+static uint64_t
+bench_memmem(MemmemFn fn, const char* haystack, size_t haystack_len, const char* needle,
+             size_t needle_len, int* count) {
+    uint64_t start = dai_monotonic_ns();
+    *count         = 0;
+    for (int round = 0; round < 20; round++) {
+        const char* p   = haystack;
+        const char* end = haystack + haystack_len;
+        while ((p = fn(p, end - p, needle, needle_len)) != NULL) {
+            (*count)++;
+            p += needle_len;
+        }
+    }
+    return dai_monotonic_ns() - start;
+}
+
+// 对照 SIMD 版本和标量版本的吞吐量，定义了 DAI_TEST_VERBOSE 时输出结果，不作为断言
+static MunitResult
+test_strsearch_benchmark(__attribute__((unused)) const MunitParameter params[],
+                         __attribute__((unused)) void* user_data) {
+    // 类似日志的文本
+    size_t haystack_len = 1 << 20;
+    char* haystack      = malloc(haystack_len);
+    const char* line    = "2024-01-01 12:00:00 INFO request handled in 12ms path=/api/v1/users\n";
+    size_t line_len     = strlen(line);
+    for (size_t i = 0; i < haystack_len; i++) {
+        haystack[i] = line[i % line_len];
+    }
+    const char* needles[] = {"\n", "ms", "path=", "handled in 13ms", "users/"};
+#ifdef DAI_TEST_VERBOSE
+    const char* names[] = {"'\\n'", "'ms'", "'path='", "'handled in 13ms'", "'users/'"};
+#endif
+    for (size_t i = 0; i < sizeof(needles) / sizeof(needles[0]); i++) {
+        size_t needle_len = strlen(needles[i]);
+        int count1, count2;
+        uint64_t scalar_ns =
+            bench_memmem(dai_memmem_scalar, haystack, haystack_len, needles[i], needle_len, &count1);
+        uint64_t simd_ns =
+            bench_memmem(dai_memmem, haystack, haystack_len, needles[i], needle_len, &count2);
+        munit_assert_int(count1, ==, count2);
+#ifdef DAI_TEST_VERBOSE
+        printf("memmem %-17s scalar %6.0f MB/s, dai_memmem %6.0f MB/s\n",
+               names[i],
+               20.0 * haystack_len * 1000 / (scalar_ns + 1),
+               20.0 * haystack_len * 1000 / (simd_ns + 1));
+#else
+        (void)scalar_ns;
+        (void)simd_ns;
+#endif
+    }
+    free(haystack);
+    return MUNIT_OK;
+}
+
+MunitTest strsearch_tests[] = {
+    {(char*)"/test_strsearch", test_strsearch, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+    {(char*)"/test_strsearch_benchmark",
+     test_strsearch_benchmark,
+     NULL,
+     NULL,
+     MUNIT_TEST_OPTION_NONE,
+     NULL},
+    {NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+};
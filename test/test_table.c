@@ -3,25 +3,16 @@
 #include "dai_malloc.h"
 #include "dai_object.h"
 #include "dai_table.h"
-
-static uint32_t
-hash_string(const char* key, int length) {
-    uint32_t hash = 2166136261u;
-    for (int i = 0; i < length; i++) {
-        hash ^= (uint8_t)key[i];
-        hash *= 16777619;
-    }
-    return hash;
-}
+#include "dai_utils.h"
 
 static DaiObjString*
 new_obj_string(char* s) {
     DaiObjString* obj = dai_malloc(sizeof(DaiObjString));
     obj->obj.type     = DaiObjType_string;
-    obj->obj.next     = NULL;
+    obj->obj.space    = DaiObjSpace_static;
     obj->length       = strlen(s);
     obj->chars        = strdup(s);
-    obj->hash         = hash_string(s, obj->length);
+    obj->hash         = dai_hash_bytes(s, obj->length);
     return obj;
 }
 
@@ -1,4 +1,6 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "munit/munit.h"
 
@@ -6,6 +8,18 @@
 #include "dai_object.h"
 #include "dai_value.h"
 
+// 测试里手动构造的字符串没有 operation ，不能调用 dai_value_string ，
+// 它们的 chars 都不为 NULL 。只有虚拟机创建的绳索字符串 chars 为 NULL ，
+// 这时才用 dai_value_string （绳索字符串有 operation ）
+static char*
+string_contents(DaiValue value) {
+    const DaiObjString* string = AS_STRING(value);
+    if (string->chars != NULL) {
+        return strndup(string->chars, string->length);
+    }
+    return dai_value_string(value);
+}
+
 void
 dai_assert_value_equal(DaiValue actual, DaiValue expected) {
     if (IS_OBJ(expected)) {
@@ -18,7 +32,12 @@ dai_assert_value_equal(DaiValue actual, DaiValue expected) {
                 fprintf(stderr, "expected a string, but got %s\n", dai_value_ts(actual));
                 munit_assert_true(IS_STRING(actual));
             }
-            munit_assert_string_equal(AS_CSTRING(actual), AS_CSTRING(expected));
+            // 绳索字符串和切片字符串的 chars 不能直接当作 C 字符串用
+            char* actual_s   = string_contents(actual);
+            char* expected_s = string_contents(expected);
+            munit_assert_string_equal(actual_s, expected_s);
+            free(actual_s);
+            free(expected_s);
         } else if (IS_FUNCTION(expected)) {
             if (!IS_FUNCTION(actual)) {
                 fprintf(stderr, "expected a function, but got %s\n", dai_value_ts(actual));
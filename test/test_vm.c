@@ -2,6 +2,7 @@
 #include <assert.h>
 #include <dirent.h>
 #include <limits.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
@@ -40,6 +41,44 @@ get_file_directory(char* path) {
     path[len] = '\0';
 }
 
+// 为 true 时测试用的虚拟机开启 JIT ，并且函数第一次执行就编译
+static bool test_with_jit = false;
+// 为 true 时测试用的虚拟机开启增量回收，并且使用很小的新生代和步长，让回收频繁发生
+static bool test_with_incremental_gc = false;
+// 为 true 时测试用的虚拟机使用多个线程进行完整回收，并且使用很小的新生代，让完整回收频繁发生
+static bool test_with_parallel_gc = false;
+
+static void
+test_vm_init(DaiVM* vm) {
+    DaiVM_init(vm);
+    if (test_with_jit && DaiVM_enableJIT(vm)) {
+        vm->jit_threshold = 0;
+    }
+    if (test_with_incremental_gc) {
+        DaiVM_enableIncrementalGC(vm, 256);
+        vm->gcNurserySize = 4096;
+        vm->nextGC        = 0;
+    }
+    if (test_with_parallel_gc) {
+        DaiVM_setGCThreads(vm, 4);
+        vm->gcNurserySize = 4096;
+        vm->nextGC        = 0;
+    }
+}
+
+#ifdef DAI_TEST
+static void
+assert_object_marked(void* pointer, __attribute__((unused)) void* ctx) {
+    DaiObj* obj = pointer;
+    if (!dai_gc_is_marked(obj)) {
+        printf("unmarked object ");
+        dai_print_value(OBJ_VAL(obj));
+        printf("\n");
+    }
+    munit_assert_true(dai_gc_is_marked(obj));
+}
+#endif
+
 static DaiObjError*
 interpret(DaiVM* vm, const char* input, const char* filename) {
     DaiAstProgram program;
@@ -103,7 +142,7 @@ run_vm_tests(const DaiVMTestCase* tests, const size_t count) {
         printf("input: %s\n", tests[i].input);
 #endif
         DaiVM vm;
-        DaiVM_init(&vm);
+        test_vm_init(&vm);
         if (DAI_IS_ERROR(tests[i].expected)) {
             DaiObjError* got_err = interpret(&vm, tests[i].input, "<test-file>");
             munit_assert_not_null(got_err);
@@ -132,16 +171,7 @@ run_vm_tests(const DaiVMTestCase* tests, const size_t count) {
 #ifdef DAI_TEST
             test_mark(&vm);
             // 检查所有的对象都被标记了
-            DaiObj* obj = vm.objects;
-            while (obj != NULL) {
-                if (!obj->is_marked) {
-                    printf("unmarked object ");
-                    dai_print_value(OBJ_VAL(obj));
-                    printf("\n");
-                }
-                munit_assert_true(obj->is_marked);
-                obj = obj->next;
-            }
+            DaiPool_iter(&vm.objectPool, assert_object_marked, NULL);
 #endif
         }
 
@@ -181,7 +211,7 @@ run_vm_test_file_with_number(const char* filename) {
     }
 
     DaiVM vm;
-    DaiVM_init(&vm);
+    test_vm_init(&vm);
     DaiObjError* err = interpret(&vm, input, filename);
     if (err) {
         DaiVM_printError(&vm, err);
@@ -208,16 +238,7 @@ run_vm_test_file_with_number(const char* filename) {
 #ifdef DAI_TEST
         test_mark(&vm);
         // 检查所有的对象都被标记了
-        DaiObj* obj = vm.objects;
-        while (obj != NULL) {
-            if (!obj->is_marked) {
-                printf("unmarked object ");
-                dai_print_value(OBJ_VAL(obj));
-                printf("\n");
-            }
-            munit_assert_true(obj->is_marked);
-            obj = obj->next;
-        }
+        DaiPool_iter(&vm.objectPool, assert_object_marked, NULL);
 #endif
     }
 
@@ -239,7 +260,7 @@ run_vm_test_file_expect_error(const char* filename, const char* expected) {
     munit_assert_not_null(input);
 
     DaiVM vm;
-    DaiVM_init(&vm);
+    test_vm_init(&vm);
     DaiObjError* got_err = interpret(&vm, input, "<test-file>");
     munit_assert_not_null(got_err);
     munit_assert_string_equal(got_err->message, expected);
@@ -253,16 +274,7 @@ run_vm_test_file_expect_error(const char* filename, const char* expected) {
 #ifdef DAI_TEST
         test_mark(&vm);
         // 检查所有的对象都被标记了
-        DaiObj* obj = vm.objects;
-        while (obj != NULL) {
-            if (!obj->is_marked) {
-                printf("unmarked object ");
-                dai_print_value(OBJ_VAL(obj));
-                printf("\n");
-            }
-            munit_assert_true(obj->is_marked);
-            obj = obj->next;
-        }
+        DaiPool_iter(&vm.objectPool, assert_object_marked, NULL);
 #endif
     }
 
@@ -558,7 +570,9 @@ static MunitResult
 test_string_operation(__attribute__((unused)) const MunitParameter params[],
                       __attribute__((unused)) void* user_data) {
     DaiVM vm;
-    DaiVM_init(&vm);
+    test_vm_init(&vm);
+    DaiObjArray* format_array = DaiObjArray_New(&vm, NULL, 0);
+    DaiObjArray_append2(&vm, format_array, 4, INTEGER_VAL(41), dai_true, dai_true, dai_true);
     DaiVMTestCase tests[] = {
         // #region compare
         {
@@ -730,13 +744,16 @@ test_string_operation(__attribute__((unused)) const MunitParameter params[],
             "\"{} is {} {} {}\".format('中文', 'good', [1], {1: 1});",
             OBJ_VAL(dai_copy_string_intern(&vm, "中文 is good [1] {1: 1, }", 27)),
         },
+        // 字典的遍历顺序取决于加了随机种子的哈希值，每次运行都可能不同
         {
-            "\"{} is {} {} {}\".format('中文', 'good', [1, 2], {1: 1, 2: 2});",
-            OBJ_VAL(dai_copy_string_intern(&vm, "中文 is good [1, 2] {1: 1, 2: 2, }", 36)),
+            "var s = \"{} is {} {} {}\".format('中文', 'good', [1, 2], {1: 1, 2: 2});"
+            "s == '中文 is good [1, 2] {1: 1, 2: 2, }' or s == '中文 is good [1, 2] {2: 2, 1: 1, }';",
+            dai_true,
         },
         {
-            "\"{} is {} {} {}\".format('中文', 'good', [1, 2, 3], {1: 1, 2: 2, 3: 3});",
-            OBJ_VAL(dai_copy_string_intern(&vm, "中文 is good [1, 2, 3] {1: 1, 2: 2, 3: 3, }", 45)),
+            "var s = \"{} is {} {} {}\".format('中文', 'good', [1, 2, 3], {1: 1, 2: 2, 3: 3});"
+            "[s.length(), s.has('1: 1, '), s.has('2: 2, '), s.has('3: 3, ')];",
+            OBJ_VAL(format_array),
         },
         // #endregion
 
@@ -990,6 +1007,19 @@ test_string_operation(__attribute__((unused)) const MunitParameter params[],
             "\"monkey中文end\".find(\"end\");",
             INTEGER_VAL(8),
         },
+        // 较长的字符串按块查找
+        {
+            "\"monkeymonkeymonkeymonkeymonkeymonkey中文end\".find(\"中文end\");",
+            INTEGER_VAL(36),
+        },
+        {
+            "\"中文monkeymonkeymonkeymonkeymonkeymonkey, banana\".find(\"y, b\");",
+            INTEGER_VAL(37),
+        },
+        {
+            "\"monkeymonkeymonkeymonkeymonkeymonkeymonkey\".find(\"keym0\");",
+            INTEGER_VAL(-1),
+        },
         // #endregion
 
         // #region replace method
@@ -1041,6 +1071,10 @@ test_string_operation(__attribute__((unused)) const MunitParameter params[],
             "\"monkeymonkey\".replace(\"monkey\", \"MONKEY\");",
             OBJ_VAL(dai_copy_string_intern(&vm, "MONKEYMONKEY", 12)),
         },
+        {
+            "\"monkeymonkeymonkeymonkeymonkeymonkey\".replace(\"eym\", \"-\");",
+            OBJ_VAL(dai_copy_string_intern(&vm, "monk-onk-onk-onk-onk-onkey", 26)),
+        },
         {
             "\"monkeymonkeymonkey\".replace(\"monkey\", \"MONKEY\");",
             OBJ_VAL(dai_copy_string_intern(&vm, "MONKEYMONKEYMONKEY", 18)),
@@ -1099,6 +1133,14 @@ test_string_operation(__attribute__((unused)) const MunitParameter params[],
             "\"monkey\".has(\"abc\");",
             dai_false,
         },
+        {
+            "\"monkeymonkeymonkeymonkeymonkeymonkeybanana\".has(\"keyb\");",
+            dai_true,
+        },
+        {
+            "\"monkeymonkeymonkeymonkeymonkeymonkeybanana\".has(\"keyba \");",
+            dai_false,
+        },
         // #endregion
 
         // #region strip method
@@ -1928,7 +1970,7 @@ static MunitResult
 test_error(__attribute__((unused)) const MunitParameter params[],
            __attribute__((unused)) void* user_data) {
     DaiVM vm;
-    DaiVM_init(&vm);
+    test_vm_init(&vm);
     const DaiVMTestCase tests[] = {
         // 数字运算
         {
@@ -2253,6 +2295,14 @@ test_error(__attribute__((unused)) const MunitParameter params[],
             "range('1');",
             OBJ_VAL(DaiObjError_Newf(&vm, "range() expected int arguments, but got string")),
         },
+        {
+            "for (var e in range(0, 1.5)) {}",
+            OBJ_VAL(DaiObjError_Newf(&vm, "range() expected int arguments, but got float")),
+        },
+        {
+            "for (var e in range(1, 2, 3, 4)) {}",
+            OBJ_VAL(DaiObjError_Newf(&vm, "range() expected 1-3 argument, but got 4")),
+        },
         {
             "math.sqrt(1, 1);",
             OBJ_VAL(DaiObjError_Newf(&vm, "math.sqrt() expected 1 argument, but got 2")),
@@ -2285,6 +2335,43 @@ test_error(__attribute__((unused)) const MunitParameter params[],
             "abs('1');",
             OBJ_VAL(DaiObjError_Newf(&vm, "abs() expected number arguments, but got string")),
         },
+        {
+            "StringBuilder(1, 2);",
+            OBJ_VAL(
+                DaiObjError_Newf(&vm, "StringBuilder() expected 0 or 1 arguments, but got 2")),
+        },
+        {
+            "StringBuilder(-1);",
+            OBJ_VAL(DaiObjError_Newf(
+                &vm, "StringBuilder() expected non-negative int arguments, but got int")),
+        },
+        {
+            "StringBuilder().writef(1);",
+            OBJ_VAL(DaiObjError_Newf(
+                &vm, "StringBuilder.writef() expected format string as first argument")),
+        },
+        {
+            "StringBuilder().writef('{} {}', 1);",
+            OBJ_VAL(DaiObjError_Newf(&vm, "StringBuilder.writef() not enough arguments")),
+        },
+        {
+            "StringBuilder().writef('a', 1);",
+            OBJ_VAL(DaiObjError_Newf(&vm, "StringBuilder.writef() too many arguments")),
+        },
+        {
+            "StringBuilder().writelines('a');",
+            OBJ_VAL(DaiObjError_Newf(
+                &vm, "StringBuilder.writelines() expected array arguments, but got string")),
+        },
+        {
+            "StringBuilder().build(1);",
+            OBJ_VAL(
+                DaiObjError_Newf(&vm, "StringBuilder.build() expected no arguments, but got 1")),
+        },
+        {
+            "StringBuilder().flush();",
+            OBJ_VAL(DaiObjError_Newf(&vm, "'StringBuilder' object has not property 'flush'")),
+        },
         // #endregion
 
         // 函数调用
@@ -2375,6 +2462,16 @@ test_error(__attribute__((unused)) const MunitParameter params[],
             "class F { con age; var name; }; var f = F(30, 'Bob'); f.age = 18;",
             OBJ_VAL(DaiObjError_Newf(&vm, "'F' object can not set const property 'age'")),
         },
+        {
+            "class F { var age; }; class G { con age; };\n"
+            "fn set(o) { o.age = 18; }; set(F(1)); set(G(2));",
+            OBJ_VAL(DaiObjError_Newf(&vm, "'G' object can not set const property 'age'")),
+        },
+        {
+            "class A { fn f() { return 1; } }; class B { fn f(a) { return a; } };\n"
+            "fn g(o) { return o.f(); }; g(A()); g(A()); g(B());",
+            OBJ_VAL(DaiObjError_Newf(&vm, "f() expected 1 arguments but got 0")),
+        },
         {
             "class F { class con age = 30; var name; }; var f = F('Bob'); f.__class__.age = 18;",
             OBJ_VAL(DaiObjError_Newf(&vm, "'class' object can not set const property 'age'")),
@@ -2514,7 +2611,7 @@ static MunitResult
 test_map(__attribute__((unused)) const MunitParameter params[],
          __attribute__((unused)) void* user_data) {
     DaiVM vm;
-    DaiVM_init(&vm);
+    test_vm_init(&vm);
     DaiObjArray* array1 = DaiObjArray_New(&vm, NULL, 0);
     DaiObjArray* array2 = DaiObjArray_New(&vm, NULL, 0);
     DaiObjArray_append2(&vm, array2, 1, INTEGER_VAL(1));
@@ -2658,15 +2755,15 @@ test_map(__attribute__((unused)) const MunitParameter params[],
             OBJ_VAL(array2),
         },
         {
-            "var m = {1: 1, 2: 2}; m.keys();",
+            "var m = {1: 1, 2: 2}; m.keys().sort(fn(a, b) { return m[a] - m[b]; });",
             OBJ_VAL(array3),
         },
         {
-            "var m = {1: 1, 2: 2, 3: 3}; m.keys();",
+            "var m = {1: 1, 2: 2, 3: 3}; m.keys().sort(fn(a, b) { return m[a] - m[b]; });",
             OBJ_VAL(array4),
         },
         {
-            "var m = {1: 1, 2: 2, 3: 3, 'four': 4}; m.keys();",
+            "var m = {1: 1, 2: 2, 3: 3, 'four': 4}; m.keys().sort(fn(a, b) { return m[a] - m[b]; });",
             OBJ_VAL(array5),
         },
 
@@ -2923,6 +3020,191 @@ test_vm_testcases(__attribute__((unused)) const MunitParameter params[],
     return MUNIT_OK;
 }
 
+extern MunitTest vm_tests[];
+
+// 开启 JIT 把上面的测试再跑一遍
+static MunitResult
+test_jit(const MunitParameter params[], void* user_data) {
+    test_with_jit = true;
+    for (MunitTest* test = vm_tests; test->test != test_jit; test++) {
+        munit_assert_int(test->test(params, user_data), ==, MUNIT_OK);
+    }
+    test_with_jit = false;
+    return MUNIT_OK;
+}
+
+// 开启增量回收把上面的测试（包括 JIT 测试）再跑一遍
+static MunitResult
+test_incremental_gc(const MunitParameter params[], void* user_data) {
+    test_with_incremental_gc = true;
+    for (MunitTest* test = vm_tests; test->test != test_incremental_gc; test++) {
+        munit_assert_int(test->test(params, user_data), ==, MUNIT_OK);
+    }
+    test_with_incremental_gc = false;
+    return MUNIT_OK;
+}
+
+// 使用多个线程进行完整回收，把上面的测试再跑一遍
+static MunitResult
+test_parallel_gc(const MunitParameter params[], void* user_data) {
+    test_with_parallel_gc = true;
+    for (MunitTest* test = vm_tests; test->test != test_incremental_gc; test++) {
+        munit_assert_int(test->test(params, user_data), ==, MUNIT_OK);
+    }
+    test_with_parallel_gc = false;
+    return MUNIT_OK;
+}
+
+// 堆超过上限时返回内存不足的错误，而不是一直增长
+static MunitResult
+test_heap_limit(__attribute__((unused)) const MunitParameter params[],
+                __attribute__((unused)) void* user_data) {
+    const char* inputs[] = {
+        // 循环回跳时检查
+        "var a = [];\n"
+        "while (true) {\n"
+        "    a.append([1, 2, 3]);\n"
+        "}\n",
+        // 内置函数返回时检查
+        "var a = [1, 2, 3, 4, 5, 6, 7, 8];\n"
+        "var i = 0;\n"
+        "while (i < 40) {\n"
+        "    a.extend(a);\n"
+        "    i = i + 1;\n"
+        "}\n",
+    };
+    for (int i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+        for (int jit = 0; jit < 2; jit++) {
+            DaiVM vm;
+            DaiVM_init(&vm);
+            if (jit && DaiVM_enableJIT(&vm)) {
+                vm.jit_threshold = 0;
+            }
+            DaiVM_setGCGrowFactor(&vm, 1.5);
+            DaiVM_setHeapLimit(&vm, 2 * 1024 * 1024);
+            DaiObjError* err = interpret(&vm, inputs[i], "<test-file>");
+            munit_assert_not_null(err);
+            munit_assert_int(strncmp(err->message, "out of memory", 13), ==, 0);
+            munit_assert_not_null(strstr(err->message, "the limit 2097152 bytes"));
+            munit_assert_false(vm.gcOutOfMemory);
+            DaiVM_reset(&vm);
+        }
+    }
+    return MUNIT_OK;
+}
+
+// 只有标识符、常量和显式驻留的字符串在字符串表中
+static MunitResult
+test_string_intern(__attribute__((unused)) const MunitParameter params[],
+                   __attribute__((unused)) void* user_data) {
+    DaiVM vm;
+    DaiVM_init(&vm);
+    interpret2(&vm,
+               "var parts = [];\n"
+               "var i = 0;\n"
+               "while (i < 1000) {\n"
+               "    parts.append(\"part{}\".format(i) + \"!\");\n"
+               "    i = i + 1;\n"
+               "}\n",
+               "<test-file>");
+    munit_assert_int(vm.strings.count, <, 1000);
+
+    DaiVM_pauseGC(&vm);
+    int count       = vm.strings.count;
+    DaiObjString* a = dai_copy_string(&vm, "zz", 2);
+    DaiObjString* b = dai_copy_string(&vm, "zz", 2);
+    munit_assert_false(DaiObjString_isInterned(a));
+    munit_assert_int(vm.strings.count, ==, count);
+    munit_assert_ptr_equal(dai_intern_string(&vm, a), a);
+    munit_assert_true(DaiObjString_isInterned(a));
+    munit_assert_ptr_equal(dai_intern_string(&vm, b), a);
+    munit_assert_ptr_equal(dai_copy_string_intern(&vm, "zz", 2), a);
+    munit_assert_int(vm.strings.count, ==, count + 1);
+    DaiVM_resumeGC(&vm);
+    DaiVM_reset(&vm);
+    return MUNIT_OK;
+}
+
+static MunitResult
+test_value_hash(__attribute__((unused)) const MunitParameter params[],
+                __attribute__((unused)) void* user_data) {
+    DaiVM vm;
+    DaiVM_init(&vm);
+    DaiVM_pauseGC(&vm);
+    uint64_t seed0, seed1;
+    DaiVM_getSeed2(&vm, &seed0, &seed1);
+#define HASH(v) dai_value_hash(v, seed0, seed1)
+    // 小数部分不同的浮点数
+    munit_assert_uint64(HASH(FLOAT_VAL(1.1)), !=, HASH(FLOAT_VAL(1.5)));
+    munit_assert_uint64(HASH(FLOAT_VAL(1.5)), !=, HASH(FLOAT_VAL(1.9)));
+    munit_assert_uint64(HASH(FLOAT_VAL(0.0)), ==, HASH(FLOAT_VAL(-0.0)));
+    munit_assert_uint64(HASH(FLOAT_VAL(NAN)), ==, HASH(FLOAT_VAL(-NAN)));
+    // 不同类型的值
+    munit_assert_uint64(HASH(INTEGER_VAL(1)), !=, HASH(dai_true));
+    munit_assert_uint64(HASH(INTEGER_VAL(0)), !=, HASH(NIL_VAL));
+    // 固定步长的整数低位也要分散开
+    int low_bits[64] = {0};
+    for (int i = 0; i < 64; i++) {
+        low_bits[HASH(INTEGER_VAL((int64_t)i * 4096)) & 63]++;
+    }
+    int used = 0;
+    for (int i = 0; i < 64; i++) {
+        used += low_bits[i] > 0;
+    }
+    munit_assert_int(used, >, 32);
+    // 种子不同，哈希值不同
+    munit_assert_uint64(dai_value_hash(INTEGER_VAL(42), seed0, seed1),
+                        !=,
+                        dai_value_hash(INTEGER_VAL(42), seed0 + 1, seed1));
+
+    // 元组按元素比较和哈希，修改元素之后重新计算
+    DaiObjTuple* a = DaiObjTuple_New(&vm);
+    DaiObjTuple* b = DaiObjTuple_New(&vm);
+    DaiObjTuple_append(a, INTEGER_VAL(1));
+    DaiObjTuple_append(a, OBJ_VAL(dai_copy_string(&vm, "dai", 3)));
+    DaiObjTuple_append(b, INTEGER_VAL(1));
+    DaiObjTuple_append(b, OBJ_VAL(dai_copy_string(&vm, "dai", 3)));
+    munit_assert_int(dai_value_equal(OBJ_VAL(a), OBJ_VAL(b)), ==, 1);
+    munit_assert_uint64(HASH(OBJ_VAL(a)), ==, HASH(OBJ_VAL(b)));
+    DaiObjTuple_set(b, 0, INTEGER_VAL(2));
+    munit_assert_int(dai_value_equal(OBJ_VAL(a), OBJ_VAL(b)), ==, 0);
+    munit_assert_uint64(HASH(OBJ_VAL(a)), !=, HASH(OBJ_VAL(b)));
+    DaiObjTuple_set(b, 0, OBJ_VAL(dai_copy_string(&vm, "dai", 3)));
+    DaiObjTuple_set(b, 1, INTEGER_VAL(1));
+    munit_assert_uint64(HASH(OBJ_VAL(a)), !=, HASH(OBJ_VAL(b)));
+
+    // 元组作为字典的键，浮点数元素和哈希值一样精确比较
+    DaiObjMap* map;
+    munit_assert_null(DaiObjMap_New(&vm, NULL, 0, &map));
+    DaiObjTuple* near1 = DaiObjTuple_New(&vm);
+    DaiObjTuple* near2 = DaiObjTuple_New(&vm);
+    DaiObjTuple_append(near1, FLOAT_VAL(1.0));
+    DaiObjTuple_append(near2, FLOAT_VAL(1.0 + 1e-12));
+    munit_assert_int(dai_value_equal(OBJ_VAL(near1), OBJ_VAL(near2)), ==, 0);
+    DaiObjMap_cset(map, OBJ_VAL(near1), INTEGER_VAL(1));
+    DaiObjMap_cset(map, OBJ_VAL(near2), INTEGER_VAL(2));
+    DaiValue got;
+    munit_assert_true(DaiObjMap_cget(map, OBJ_VAL(near1), &got));
+    munit_assert_int64(AS_INTEGER(got), ==, 1);
+    munit_assert_true(DaiObjMap_cget(map, OBJ_VAL(near2), &got));
+    munit_assert_int64(AS_INTEGER(got), ==, 2);
+    DaiObjTuple* nan1 = DaiObjTuple_New(&vm);
+    DaiObjTuple* nan2 = DaiObjTuple_New(&vm);
+    DaiObjTuple_append(nan1, FLOAT_VAL(NAN));
+    DaiObjTuple_append(nan1, FLOAT_VAL(-0.0));
+    DaiObjTuple_append(nan2, FLOAT_VAL(NAN));
+    DaiObjTuple_append(nan2, FLOAT_VAL(0.0));
+    munit_assert_int(dai_value_equal(OBJ_VAL(nan1), OBJ_VAL(nan2)), ==, 1);
+    munit_assert_uint64(HASH(OBJ_VAL(nan1)), ==, HASH(OBJ_VAL(nan2)));
+    DaiObjMap_cset(map, OBJ_VAL(nan1), INTEGER_VAL(3));
+    munit_assert_true(DaiObjMap_cget(map, OBJ_VAL(nan2), &got));
+    munit_assert_int64(AS_INTEGER(got), ==, 3);
+#undef HASH
+    DaiVM_resumeGC(&vm);
+    DaiVM_reset(&vm);
+    return MUNIT_OK;
+}
+
 MunitTest vm_tests[] = {
     {(char*)"/test_number_arithmetic",
      test_number_arithmetic,
@@ -3006,5 +3288,11 @@ MunitTest vm_tests[] = {
      MUNIT_TEST_OPTION_NONE,
      NULL},
     {"/test_vm_testcases", test_vm_testcases, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+    {"/test_jit", test_jit, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+    {"/test_incremental_gc", test_incremental_gc, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+    {"/test_parallel_gc", test_parallel_gc, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+    {"/test_heap_limit", test_heap_limit, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+    {"/test_string_intern", test_string_intern, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+    {"/test_value_hash", test_value_hash, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
     {NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
 };